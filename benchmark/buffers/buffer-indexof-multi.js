@@ -0,0 +1,46 @@
+'use strict';
+const common = require('../common.js');
+const fs = require('fs');
+const path = require('path');
+const Searcher = require('buffer').Searcher;
+
+const needles = ['Gryphon', 'Panther', 'Soo--oop', 'among mad people',
+                 '</i> to the Caterpillar', 'neighbouring pool',
+                 'Ou est ma chatte?', 'found it very'];
+
+const bench = common.createBenchmark(main, {
+  needles: [1, 2, 4, 8],
+  method: ['searcher', 'indexOf'],
+  iter: [1]
+});
+
+function main(conf) {
+  const iter = conf.iter * 10000;
+  const aliceBuffer = fs.readFileSync(
+    path.resolve(__dirname, '../fixtures/alice.html')
+  );
+  const list = needles.slice(0, conf.needles);
+  var i;
+
+  if (conf.method === 'searcher') {
+    const searcher = new Searcher(list);
+    bench.start();
+    for (i = 0; i < iter; i++) {
+      searcher.indexOf(aliceBuffer, 0);
+    }
+    bench.end(iter);
+    return;
+  }
+
+  // The leftmost match of any needle, the way it's done without a Searcher.
+  bench.start();
+  for (i = 0; i < iter; i++) {
+    var first = -1;
+    for (var j = 0; j < list.length; j++) {
+      const index = aliceBuffer.indexOf(list[j]);
+      if (index !== -1 && (first === -1 || index < first))
+        first = index;
+    }
+  }
+  bench.end(iter);
+}
@@ -2,6 +2,7 @@
 var common = require('../common.js');
 var fs = require('fs');
 const path = require('path');
+const Searcher = require('buffer').Searcher;
 
 var bench = common.createBenchmark(main, {
   search: ['@', 'SQ', '10x', '--l', 'Alice', 'Gryphon', 'Panther',
@@ -10,7 +11,7 @@ var bench = common.createBenchmark(main, {
            'venture to go near the house till she had brought herself down to',
            '</i> to the Caterpillar'],
   encoding: ['undefined', 'utf8', 'ucs2', 'binary'],
-  type: ['buffer', 'string'],
+  type: ['buffer', 'string', 'searcher'],
   iter: [1]
 });
 
@@ -34,8 +35,18 @@ function main(conf) {
     search = Buffer.from(Buffer.from(search).toString(), encoding);
   }
 
+  if (conf.type === 'searcher') {
+    var searcher = new Searcher(search, encoding);
+    bench.start();
+    for (var i = 0; i < iter; i++) {
+      searcher.indexOf(aliceBuffer, 0);
+    }
+    bench.end(iter);
+    return;
+  }
+
   bench.start();
-  for (var i = 0; i < iter; i++) {
+  for (i = 0; i < iter; i++) {
     aliceBuffer.indexOf(search, 0, encoding);
   }
   bench.end(iter);
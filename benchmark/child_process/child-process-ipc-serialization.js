@@ -0,0 +1,53 @@
+'use strict';
+// Compares the throughput of IPC messages with the 'json' and 'advanced'
+// serialization modes.
+if (process.argv[2] === 'child') {
+  const type = process.argv[3];
+  const len = +process.argv[4];
+  const message = type === 'buffer' ? {
+    id: 1,
+    data: Buffer.alloc(len, 'x')
+  } : {
+    id: 1,
+    name: 'x'.repeat(len),
+    list: [1, 2, 3, 4, 5, 6, 7, 8],
+    nested: { a: true, b: null, c: 'string' }
+  };
+
+  // Send in batches and wait for the last message of every batch to be
+  // written, which keeps the channel busy without buffering without bound.
+  (function send() {
+    for (var i = 0; i < 64; i++)
+      process.send(message);
+    process.send(message, send);
+  })();
+} else {
+  const common = require('../common.js');
+  const bench = common.createBenchmark(main, {
+    serialization: ['json', 'advanced'],
+    type: ['object', 'buffer'],
+    len: [64, 1024, 65536],
+    dur: [5]
+  });
+  const fork = require('child_process').fork;
+
+  function main(conf) {
+    const dur = +conf.dur;
+    const len = +conf.len;
+
+    const child = fork(__filename, ['child', conf.type, len], {
+      serialization: conf.serialization
+    });
+
+    var messages = 0;
+    child.on('message', function(msg) {
+      if (messages++ === 0)
+        bench.start();
+    });
+
+    setTimeout(function() {
+      child.kill();
+      bench.end(messages);
+    }, dur * 1000);
+  }
+}
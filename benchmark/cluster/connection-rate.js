@@ -0,0 +1,83 @@
+'use strict';
+// Measures how many connections per second a cluster accepts with each of the
+// scheduling policies. The clients run in processes of their own, so that
+// the master only does what the policy makes it do.
+const cluster = require('cluster');
+const child_process = require('child_process');
+const net = require('net');
+
+if (process.argv[2] === 'client') {
+  const port = +process.argv[3];
+  const concurrency = +process.argv[4];
+  var connections = 0;
+
+  const connect = () => {
+    net.connect(port, '127.0.0.1')
+      .on('error', connect)
+      .on('close', () => {
+        connections++;
+        connect();
+      })
+      .resume();
+  };
+  for (var i = 0; i < concurrency; i++)
+    connect();
+
+  process.on('message', () => {
+    process.send(connections);
+    process.exit();
+  });
+} else if (cluster.isWorker) {
+  net.createServer((socket) => socket.end()).listen(0);
+} else {
+  const common = require('../common.js');
+  const bench = common.createBenchmark(main, {
+    sched: ['rr', 'none', 'reuseport'],
+    workers: [1, 2, 4],
+    clients: [2],
+    c: [50],
+    dur: [5]
+  });
+
+  function main(conf) {
+    const workers = +conf.workers;
+    const policies = {
+      rr: cluster.SCHED_RR,
+      none: cluster.SCHED_NONE,
+      reuseport: cluster.SCHED_REUSEPORT
+    };
+    cluster.schedulingPolicy = policies[conf.sched];
+
+    var listening = 0;
+    cluster.on('listening', (worker, address) => {
+      if (++listening === workers)
+        run(address.port);
+    });
+    for (var i = 0; i < workers; i++)
+      cluster.fork();
+
+    function run(port) {
+      const clients = [];
+      for (var i = 0; i < +conf.clients; i++) {
+        clients.push(child_process.fork(__filename,
+                                        ['client', port, +conf.c]));
+      }
+
+      bench.start();
+      setTimeout(() => {
+        var connections = 0;
+        var pending = clients.length;
+        clients.forEach((client) => {
+          client.once('message', (n) => {
+            connections += n;
+            if (--pending === 0) {
+              bench.end(connections);
+              cluster.disconnect();
+            }
+          });
+          client.send('stop');
+        });
+      }, +conf.dur * 1000);
+    }
+  }
+}
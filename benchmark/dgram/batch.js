@@ -0,0 +1,81 @@
+// test UDP send/recv throughput with sendBatch() and recvBatchSize
+'use strict';
+
+const common = require('../common.js');
+const PORT = common.PORT;
+
+// `num` is the number of datagrams to queue up each time, `batch` is the
+// number of datagrams per sendBatch() call and the socket's recvBatchSize.
+// A `batch` of 1 sends every datagram with send().
+var bench = common.createBenchmark(main, {
+  len: [64, 1024],
+  num: [128],
+  batch: [1, 16, 64],
+  type: ['send', 'recv'],
+  dur: [5]
+});
+
+var dur;
+var len;
+var num;
+var batch;
+var type;
+var messages;
+
+function main(conf) {
+  dur = +conf.dur;
+  len = +conf.len;
+  num = +conf.num;
+  batch = +conf.batch;
+  type = conf.type;
+
+  messages = [];
+  for (var i = 0; i < batch; i++)
+    messages.push(Buffer.allocUnsafe(len));
+
+  server();
+}
+
+var dgram = require('dgram');
+
+function server() {
+  var sent = 0;
+  var received = 0;
+  var socket = dgram.createSocket({ type: 'udp4', recvBatchSize: batch });
+
+  var pending = 0;
+
+  function sendMore() {
+    for (var i = 0; i < num; i += batch) {
+      pending++;
+      if (batch === 1)
+        socket.send(messages[0], PORT, '127.0.0.1', onsend);
+      else
+        socket.sendBatch(messages, PORT, '127.0.0.1', onsend);
+    }
+  }
+
+  function onsend() {
+    sent += batch;
+    if (--pending === 0)
+      sendMore();
+  }
+
+  socket.on('listening', function() {
+    bench.start();
+    sendMore();
+
+    setTimeout(function() {
+      var bytes = (type === 'send' ? sent : received) * len;
+      var gbits = (bytes * 8) / (1024 * 1024 * 1024);
+      bench.end(gbits);
+      process.exit(0);
+    }, dur * 1000);
+  });
+
+  socket.on('message', function(buf, rinfo) {
+    received++;
+  });
+
+  socket.bind(PORT);
+}
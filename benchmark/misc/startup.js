@@ -5,11 +5,14 @@ var path = require('path');
 var emptyJsFile = path.resolve(__dirname, '../../test/fixtures/semicolon.js');
 
 var bench = common.createBenchmark(startNode, {
+  mode: ['file', 'eval'],
   dur: [1]
 });
 
 function startNode(conf) {
   var dur = +conf.dur;
+  // `node -e 0` measures the bootstrap alone, without loading a user module.
+  var args = conf.mode === 'eval' ? ['-e', '0'] : [emptyJsFile];
   var go = true;
   var starts = 0;
 
@@ -21,7 +24,7 @@ function startNode(conf) {
   start();
 
   function start() {
-    var node = spawn(process.execPath || process.argv[0], [emptyJsFile]);
+    var node = spawn(process.execPath || process.argv[0], args);
     node.on('exit', function(exitCode) {
       if (exitCode !== 0) {
         throw new Error('Error during node startup');
@@ -0,0 +1,66 @@
+// Measures how many connections per second a server accepts when the
+// clients connect as fast as they can. `batch` is the number of connections
+// that the server accepts per wakeup, 1 accepts them one at a time.
+'use strict';
+const child_process = require('child_process');
+const net = require('net');
+
+if (process.argv[2] === 'client') {
+  const port = +process.argv[3];
+  const concurrency = +process.argv[4];
+  var connections = 0;
+
+  const connect = () => {
+    net.connect(port, '127.0.0.1')
+      .on('error', connect)
+      .on('close', () => {
+        connections++;
+        connect();
+      })
+      .resume();
+  };
+  for (var i = 0; i < concurrency; i++)
+    connect();
+
+  process.on('message', () => {
+    process.send(connections);
+    process.exit();
+  });
+} else {
+  const common = require('../common.js');
+  const bench = common.createBenchmark(main, {
+    batch: [1, 64],
+    clients: [2],
+    c: [50, 500],
+    dur: [5]
+  });
+
+  function main(conf) {
+    const server = net.createServer({ acceptBatch: +conf.batch },
+                                    (socket) => socket.end());
+    server.listen(0, '127.0.0.1', () => {
+
+      const clients = [];
+      for (var i = 0; i < +conf.clients; i++) {
+        clients.push(child_process.fork(
+            __filename, ['client', server.address().port, +conf.c]));
+      }
+
+      bench.start();
+      setTimeout(() => {
+        var connections = 0;
+        var pending = clients.length;
+        clients.forEach((client) => {
+          client.once('message', (n) => {
+            connections += n;
+            if (--pending === 0) {
+              bench.end(connections);
+              server.close();
+            }
+          });
+          client.send('stop');
+        });
+      }, +conf.dur * 1000);
+    });
+  }
+}
@@ -0,0 +1,55 @@
+'use strict';
+
+var common = require('../common.js');
+var bench = common.createBenchmark(main, {
+  millions: [10],
+  type: ['breadth', 'depth']
+});
+
+process.maxTickDepth = Infinity;
+
+// Interleaves process.nextTick() with promise reactions, like a database
+// driver that resolves promises from nextTick callbacks.
+function main(conf) {
+  var N = +conf.millions * 1e6;
+  if (conf.type === 'breadth')
+    breadth(N);
+  else
+    depth(N);
+}
+
+function breadth(N) {
+  var n = 0;
+
+  function onResolve() {
+    if (++n === N)
+      bench.end(N / 1e6);
+  }
+
+  function cb() {
+    if (n % 8 === 0)
+      Promise.resolve().then(onResolve);
+    else
+      onResolve();
+  }
+
+  bench.start();
+  for (var i = 0; i < N; i++)
+    process.nextTick(cb);
+}
+
+function depth(N) {
+  var n = 0;
+
+  function cb() {
+    if (++n === N)
+      bench.end(N / 1e6);
+    else if (n % 8 === 0)
+      Promise.resolve().then(cb);
+    else
+      process.nextTick(cb);
+  }
+
+  bench.start();
+  process.nextTick(cb);
+}
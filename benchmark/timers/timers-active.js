@@ -0,0 +1,38 @@
+'use strict';
+var common = require('../common.js');
+var timers = require('timers');
+
+// Models sockets with idle timeouts: every "socket" re-arms its timer on
+// activity, the way net.Socket does with timers._unrefActive().
+var bench = common.createBenchmark(main, {
+  sockets: [1e3, 1e5],
+  durations: [1, 100],
+  millions: [2]
+});
+
+function main(conf) {
+  var sockets = +conf.sockets;
+  var durations = +conf.durations;
+  var n = +conf.millions * 1e6;
+  var items = new Array(sockets);
+  var i;
+
+  for (i = 0; i < sockets; i++) {
+    items[i] = {};
+    timers.enroll(items[i], 60000 + (i % durations) * 1000);
+    items[i]._onTimeout = onTimeout;
+    timers._unrefActive(items[i]);
+  }
+
+  bench.start();
+  for (i = 0; i < n; i++)
+    timers._unrefActive(items[i % sockets]);
+  bench.end(n / 1e6);
+
+  for (i = 0; i < sockets; i++)
+    timers.unenroll(items[i]);
+}
+
+function onTimeout() {
+  throw new Error('timer should not fire');
+}
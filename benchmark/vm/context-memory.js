@@ -0,0 +1,36 @@
+'use strict';
+// Reports the heap used per context, in bytes, instead of a rate.
+const common = require('../common.js');
+const v8 = require('v8');
+const vm = require('vm');
+
+const bench = common.createBenchmark(main, {
+  mode: ['normal', 'lightweight', 'pool'],
+  n: [200]
+});
+
+v8.setFlagsFromString('--expose_gc');
+const gc = vm.runInNewContext('gc');
+
+function main(conf) {
+  const n = conf.n | 0;
+  const pool = new vm.ContextPool();
+  const contexts = new Array(n);
+
+  gc();
+  const before = process.memoryUsage().heapUsed;
+  const start = process.hrtime();
+  for (var i = 0; i < n; i++) {
+    if (conf.mode === 'pool') {
+      contexts[i] = pool.acquire({ i: i });
+    } else {
+      contexts[i] = vm.createContext({ i: i },
+                                     { lightweight: conf.mode !== 'normal' });
+    }
+  }
+  const elapsed = process.hrtime(start);
+  gc();
+  const after = process.memoryUsage().heapUsed;
+
+  bench.report((after - before) / contexts.length, elapsed);
+}
@@ -0,0 +1,35 @@
+'use strict';
+const common = require('../common.js');
+const vm = require('vm');
+
+const bench = common.createBenchmark(main, {
+  mode: ['normal', 'lightweight', 'pool'],
+  n: [1000]
+});
+
+const script = new vm.Script('title + ": " + items.join(", ")');
+const sandbox = { title: 'List', items: ['a', 'b', 'c'] };
+
+function main(conf) {
+  const n = conf.n | 0;
+  const pool = new vm.ContextPool({ max: 1 });
+  var i;
+
+  // Warm up the pool so every acquire() in the timed loop is a reuse.
+  if (conf.mode === 'pool')
+    pool.release(pool.acquire());
+
+  bench.start();
+  for (i = 0; i < n; i++) {
+    if (conf.mode === 'pool') {
+      const context = pool.acquire(sandbox);
+      script.runInContext(context);
+      pool.release(context);
+    } else {
+      const context = vm.createContext(Object.assign({}, sandbox),
+                                       { lightweight: conf.mode !== 'normal' });
+      script.runInContext(context);
+    }
+  }
+  bench.end(n);
+}
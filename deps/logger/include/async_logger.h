@@ -0,0 +1,117 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include "ILogger.h"
+#include "log_ring.h"
+
+namespace node {
+namespace logger {
+
+  // Moves log records off the calling thread: callers append them to a
+  // LogRing and a background thread drains it into an ILogger or a file.
+  // Records that don't fit in the ring are dropped and counted.
+  class AsyncLogger {
+    public:
+      // Writes to |file| when it isn't nullptr, to |sink| otherwise.  Takes
+      // ownership of |file|.  |sink| is called from the background thread.
+      AsyncLogger(const ILogger* sink, FILE* file, size_t capacity);
+      // Writes out the records that are still queued.
+      ~AsyncLogger();
+
+      bool Append(ILogger::LogLevel level, const char* msg, size_t length);
+
+      // Like Append() for records that are written straight into the ring.
+      LogRecord* Claim(ILogger::LogLevel level,
+                       LogRecord::Kind kind,
+                       size_t size);
+      void Publish(LogRecord* record);
+
+      uint64_t Written() const { return written_; }
+      uint64_t Dropped() const { return dropped_; }
+
+      // Installs the process-wide instance.  Returns false and closes |file|
+      // if there already is one.
+      static bool Install(const ILogger* sink, FILE* file, size_t capacity);
+      // Removes the process-wide instance and deletes it once no Ref holds
+      // it anymore, which writes out the records that are still queued.
+      static void Uninstall();
+      static bool IsInstalled() { return s_current_ != nullptr; }
+
+      // Gives access to the process-wide instance, nullptr when there is
+      // none.  Uninstall() waits for every Ref to go away before it frees
+      // the instance, so a Ref must not outlive the log call it is used for.
+      class Ref {
+        public:
+          Ref();
+          ~Ref();
+          AsyncLogger* get() const { return logger_; }
+
+        private:
+          Ref(const Ref&) = delete;
+          Ref& operator=(const Ref&) = delete;
+
+          AsyncLogger* logger_;
+          int epoch_;
+      };
+
+    private:
+      AsyncLogger(const AsyncLogger&) = delete;
+      AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+      void Run();
+      void Write(const LogRecord& record);
+
+      LogRing ring_;
+      const ILogger* sink_;
+      FILE* file_;
+      std::string line_;
+
+      std::atomic<bool> stopping_;
+      std::atomic<bool> idle_;
+      std::atomic<uint64_t> written_;
+      std::atomic<uint64_t> dropped_;
+
+      std::mutex mutex_;
+      std::condition_variable wakeup_;
+      std::thread thread_;
+
+      static std::atomic<AsyncLogger*> s_current_;
+      // Live Refs, counted separately for the current and the previous
+      // epoch so that Uninstall() isn't held up by Refs taken after it
+      // started.
+      static std::atomic<int> s_epoch_;
+      static std::atomic<int> s_refs_[2];
+      static std::mutex s_installMutex_;
+  };
+
+}  // namespace logger
+}  // namespace node
@@ -0,0 +1,73 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace node {
+namespace logger {
+
+  // Structured log records are a format id followed by the arguments, each
+  // one a tag byte and a payload:
+  //
+  //   Number   8 byte double
+  //   Boolean  1 byte
+  //   String   4 byte length, UTF-8 bytes
+  //   Buffer   4 byte length, raw bytes
+  //   Null     no payload
+  //
+  // They are turned into text on the thread that writes them out.
+  enum class LogArgTag : uint8_t {
+    Number,
+    Boolean,
+    String,
+    Buffer,
+    Null
+  };
+
+  // Registers |format| and returns its id.  Formats are never unregistered.
+  // The text matches util.format(): %s is replaced with String(arg), %d with
+  // Number(arg), %% with a percent sign, and arguments left over are appended
+  // separated by spaces.  %i is Number(arg) truncated to an integer.
+  uint32_t RegisterLogFormat(const char* format);
+
+  // Whether |id| was returned by RegisterLogFormat()
+  bool IsLogFormat(uint32_t id);
+
+  // Helpers that write the parts of a record to |out| and return the
+  // position after them
+  char* EncodeLogFormatId(char* out, uint32_t id);
+  char* EncodeLogNumber(char* out, double value);
+  char* EncodeLogBoolean(char* out, bool value);
+  char* EncodeLogNull(char* out);
+  char* EncodeLogBytes(char* out, LogArgTag tag, size_t length);
+
+  // Turns the structured record in |data| into text
+  void FormatLogRecord(const char* data, size_t size, std::string* out);
+
+}  // namespace logger
+}  // namespace node
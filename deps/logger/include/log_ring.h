@@ -0,0 +1,92 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include "ILogger.h"
+
+namespace node {
+namespace logger {
+
+  // A log record in the ring.  Payloads of up to kInlineSize bytes are kept
+  // in the record itself, bigger ones are allocated on the heap.
+  struct LogRecord {
+    static const size_t kInlineSize = 232;
+
+    // Text records hold the message, Structured ones the encoding that is
+    // described in log_format.h.
+    enum Kind : uint8_t { Text, Structured };
+
+    ILogger::LogLevel level;
+    Kind kind;
+    size_t size;
+    char* data;
+    char inlineData[kInlineSize];
+    size_t position;  // Private to LogRing.
+  };
+
+  // Bounded multi-producer, single-consumer queue of log records.
+  // Producers claim a cell with a compare-and-swap on the write position and
+  // publish it through the cell's sequence number, so appending a record
+  // never takes a lock or waits for the consumer.
+  class LogRing {
+    public:
+      // |capacity| is rounded up to a power of two.
+      explicit LogRing(size_t capacity);
+      ~LogRing();
+
+      // Claims the next free record and sets it up for a payload of |size|
+      // bytes.  Returns nullptr when the ring is full.  The size of the
+      // record is 0 when the payload couldn't be allocated.  The record is
+      // not visible to the consumer until it is passed to Publish().
+      LogRecord* Claim(ILogger::LogLevel level,
+                       LogRecord::Kind kind,
+                       size_t size);
+      void Publish(LogRecord* record);
+
+      // Consumer side.  Front() returns the oldest published record or
+      // nullptr, Pop() releases it again.
+      LogRecord* Front();
+      void Pop();
+
+    private:
+      struct Cell {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+      };
+
+      LogRing(const LogRing&) = delete;
+      LogRing& operator=(const LogRing&) = delete;
+
+      Cell* cells_;
+      size_t mask_;
+      std::atomic<size_t> writePosition_;
+      size_t readPosition_;
+  };
+
+}  // namespace logger
+}  // namespace node
@@ -36,6 +36,13 @@ namespace logger {
 
   // Get the instance of the current logger
   const ILogger* GetLogger();
+
+  // Whether messages of |level| pass the level set with SetLogLevel()
+  bool IsLogLevelEnabled(ILogger::LogLevel level);
+
+  // Logs the null-terminated |msg| of |length| bytes, through the background
+  // thread when asynchronous logging is on and synchronously otherwise
+  void WriteLog(ILogger::LogLevel level, const char* msg, size_t length);
   
   void Initialize(v8::Handle<v8::Object> target);
 
@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include <string.h>
 #include "v8.h"
 #include "logger_wrap.h"
 
@@ -33,14 +34,25 @@ namespace node {
 namespace logger {
 
     #define NODE_LOGGER_LOG(logLevel, message) \
-    if (GetLogger() != nullptr) { \
-      GetLogger()->Log(logLevel, message); \
-    } \
+    node::logger::WriteLog(logLevel, message, strlen(message)); \
 
     V8_EXPORT void NODE_API LogVerbose(const char* msg);
     V8_EXPORT void NODE_API LogInfo(const char* msg);
     V8_EXPORT void NODE_API LogWarn(const char* msg);
     V8_EXPORT void NODE_API LogError(const char* msg);
 
+    // Drops messages below |level| before they are formatted or queued
+    V8_EXPORT void NODE_API SetLogLevel(ILogger::LogLevel level);
+
+    // Queues messages in a lock-free ring of |capacity| entries that a
+    // background thread writes to the file at |path|, or to the current
+    // logger when |path| is nullptr.  Messages that don't fit in the ring
+    // are dropped.  The logger is called from the background thread.
+    // These should be called from the main node JS thread.
+    V8_EXPORT bool NODE_API StartAsyncLogging(size_t capacity,
+                                              const char* path);
+    // Writes out the queued messages and stops the background thread
+    V8_EXPORT void NODE_API StopAsyncLogging();
+
 }  // namespace logger
 }  // namespace node
\ No newline at end of file
@@ -9,9 +9,15 @@
         '../chakrashim/include',
       ],
       'sources': [ 
+        'include/async_logger.h',
         'include/ILogger.h',
+        'include/log_format.h',
+        'include/log_ring.h',
         'include/logger_wrap.h',
         'include/node_logger.h',
+        'src/async_logger.cpp',
+        'src/log_format.cpp',
+        'src/log_ring.cpp',
         'src/logger_wrap.cpp', 
         'src/node_logger.cpp', 
       ],
@@ -0,0 +1,192 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "async_logger.h"
+#include "log_format.h"
+
+#include <chrono>
+#include <string.h>
+
+namespace node {
+namespace logger {
+
+  static const char* LevelName(ILogger::LogLevel level) {
+    switch (level) {
+      case ILogger::LogLevel::Verbose: return "verbose";
+      case ILogger::LogLevel::Info: return "info";
+      case ILogger::LogLevel::Warn: return "warn";
+      case ILogger::LogLevel::Error: return "error";
+    }
+    return "unknown";
+  }
+
+  std::atomic<AsyncLogger*> AsyncLogger::s_current_(nullptr);
+  std::atomic<int> AsyncLogger::s_epoch_(0);
+  std::atomic<int> AsyncLogger::s_refs_[2];
+  std::mutex AsyncLogger::s_installMutex_;
+
+  AsyncLogger::AsyncLogger(const ILogger* sink, FILE* file, size_t capacity)
+      : ring_(capacity),
+        sink_(sink),
+        file_(file),
+        stopping_(false),
+        idle_(false),
+        written_(0),
+        dropped_(0) {
+    thread_ = std::thread(&AsyncLogger::Run, this);
+  }
+
+  AsyncLogger::~AsyncLogger() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wakeup_.notify_one();
+    thread_.join();
+
+    if (file_ != nullptr) {
+      fclose(file_);
+    }
+  }
+
+  bool AsyncLogger::Install(const ILogger* sink, FILE* file, size_t capacity) {
+    std::lock_guard<std::mutex> lock(s_installMutex_);
+    if (s_current_ != nullptr) {
+      if (file != nullptr) {
+        fclose(file);
+      }
+      return false;
+    }
+    s_current_ = new AsyncLogger(sink, file, capacity);
+    return true;
+  }
+
+  void AsyncLogger::Uninstall() {
+    std::lock_guard<std::mutex> lock(s_installMutex_);
+    AsyncLogger* logger = s_current_.exchange(nullptr);
+    if (logger == nullptr) {
+      return;
+    }
+    // A Ref counts itself in the current epoch before it loads the
+    // instance.  Refs counted in the new epoch load the instance after the
+    // exchange above and can't see |logger|, so it is safe to free once the
+    // count of the old epoch drops to zero.
+    const int epoch = s_epoch_.load();
+    s_epoch_ = 1 - epoch;
+    while (s_refs_[epoch].load() != 0) {
+      std::this_thread::yield();
+    }
+    delete logger;
+  }
+
+  AsyncLogger::Ref::Ref() {
+    for (;;) {
+      epoch_ = s_epoch_.load();
+      s_refs_[epoch_].fetch_add(1);
+      if (s_epoch_.load() == epoch_) {
+        break;
+      }
+      // Raced with Uninstall() switching epochs.
+      s_refs_[epoch_].fetch_sub(1);
+    }
+    logger_ = s_current_.load();
+  }
+
+  AsyncLogger::Ref::~Ref() {
+    s_refs_[epoch_].fetch_sub(1);
+  }
+
+  bool AsyncLogger::Append(ILogger::LogLevel level,
+                           const char* msg,
+                           size_t length) {
+    LogRecord* record = Claim(level, LogRecord::Kind::Text, length);
+    if (record == nullptr) {
+      return false;
+    }
+    memcpy(record->data, msg, record->size);
+    Publish(record);
+    return true;
+  }
+
+  LogRecord* AsyncLogger::Claim(ILogger::LogLevel level,
+                                LogRecord::Kind kind,
+                                size_t size) {
+    LogRecord* record = ring_.Claim(level, kind, size);
+    if (record == nullptr) {
+      dropped_++;
+    }
+    return record;
+  }
+
+  void AsyncLogger::Publish(LogRecord* record) {
+    ring_.Publish(record);
+    // Producers only pay for a wakeup when the background thread sleeps.
+    if (idle_.load(std::memory_order_relaxed)) {
+      wakeup_.notify_one();
+    }
+  }
+
+  void AsyncLogger::Run() {
+    for (;;) {
+      LogRecord* record;
+      while ((record = ring_.Front()) != nullptr) {
+        Write(*record);
+        ring_.Pop();
+        written_++;
+      }
+
+      if (file_ != nullptr) {
+        fflush(file_);
+      }
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (stopping_ && ring_.Front() == nullptr) {
+        break;
+      }
+      // Producers don't take the mutex, so a wakeup can get lost between
+      // the check above and the wait.  The timeout bounds the delay.
+      idle_ = true;
+      if (ring_.Front() == nullptr) {
+        wakeup_.wait_for(lock, std::chrono::milliseconds(50));
+      }
+      idle_ = false;
+    }
+  }
+
+  void AsyncLogger::Write(const LogRecord& record) {
+    if (record.kind == LogRecord::Kind::Structured) {
+      FormatLogRecord(record.data, record.size, &line_);
+    } else {
+      line_.assign(record.data, record.size);
+    }
+
+    if (file_ != nullptr) {
+      fprintf(file_, "%s: %s\n", LevelName(record.level), line_.c_str());
+    } else if (sink_ != nullptr) {
+      sink_->Log(record.level, line_.c_str());
+    }
+  }
+
+}  // namespace logger
+}  // namespace node
@@ -0,0 +1,391 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "log_format.h"
+
+#include <atomic>
+#include <math.h>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace node {
+namespace logger {
+
+  // Buffers are shown like util.inspect() does, up to this many bytes
+  static const size_t kMaxBufferBytes = 50;
+
+  static std::mutex s_formatsMutex;
+  static std::vector<std::string> s_formats;
+  // Lets loggers check ids without taking the mutex
+  static std::atomic<uint32_t> s_formatCount(0);
+
+  uint32_t RegisterLogFormat(const char* format) {
+    std::lock_guard<std::mutex> lock(s_formatsMutex);
+    s_formats.push_back(format);
+    s_formatCount = static_cast<uint32_t>(s_formats.size());
+    return static_cast<uint32_t>(s_formats.size() - 1);
+  }
+
+  bool IsLogFormat(uint32_t id) {
+    return id < s_formatCount.load(std::memory_order_acquire);
+  }
+
+  char* EncodeLogFormatId(char* out, uint32_t id) {
+    memcpy(out, &id, sizeof(id));
+    return out + sizeof(id);
+  }
+
+  char* EncodeLogNumber(char* out, double value) {
+    *out++ = static_cast<char>(LogArgTag::Number);
+    memcpy(out, &value, sizeof(value));
+    return out + sizeof(value);
+  }
+
+  char* EncodeLogBoolean(char* out, bool value) {
+    *out++ = static_cast<char>(LogArgTag::Boolean);
+    *out++ = value ? 1 : 0;
+    return out;
+  }
+
+  char* EncodeLogNull(char* out) {
+    *out++ = static_cast<char>(LogArgTag::Null);
+    return out;
+  }
+
+  char* EncodeLogBytes(char* out, LogArgTag tag, size_t length) {
+    uint32_t length32 = static_cast<uint32_t>(length);
+    *out++ = static_cast<char>(tag);
+    memcpy(out, &length32, sizeof(length32));
+    return out + sizeof(length32);
+  }
+
+  // Reads one argument, returns false at the end of the record
+  class LogArgReader {
+    public:
+      LogArgReader(const char* data, const char* end)
+          : data_(data), end_(end) {}
+
+      bool Next(LogArgTag* tag, const char** payload, size_t* length) {
+        if (data_ >= end_) {
+          return false;
+        }
+
+        *tag = static_cast<LogArgTag>(*data_++);
+        switch (*tag) {
+          case LogArgTag::Number:
+            *length = sizeof(double);
+            break;
+          case LogArgTag::Boolean:
+            *length = 1;
+            break;
+          case LogArgTag::Null:
+            *length = 0;
+            break;
+          case LogArgTag::String:
+          case LogArgTag::Buffer: {
+            uint32_t length32;
+            if (end_ - data_ < static_cast<ptrdiff_t>(sizeof(length32))) {
+              return false;
+            }
+            memcpy(&length32, data_, sizeof(length32));
+            data_ += sizeof(length32);
+            *length = length32;
+            break;
+          }
+          default:
+            return false;
+        }
+
+        if (end_ - data_ < static_cast<ptrdiff_t>(*length)) {
+          return false;
+        }
+        *payload = data_;
+        data_ += *length;
+        return true;
+      }
+
+    private:
+      const char* data_;
+      const char* end_;
+  };
+
+  // How an argument is turned into text, after util.format()
+  enum class ArgStyle {
+    String,   // %s, String(arg)
+    Number,   // %d, Number(arg)
+    Integer,  // %i, Number(arg) without the fraction
+    Inspect   // Arguments left over, util.inspect(arg) for non-strings
+  };
+
+  static bool IsJSWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+           c == '\r';
+  }
+
+  // Number(str) for strings: surrounding whitespace is ignored, an empty
+  // string is 0, 0x, 0o and 0b prefixes select the radix and anything that
+  // isn't a complete number is NaN
+  static double StringToNumber(const char* str, size_t length) {
+    const char* begin = str;
+    const char* end = str + length;
+    while (begin < end && IsJSWhitespace(*begin)) {
+      begin++;
+    }
+    while (end > begin && IsJSWhitespace(end[-1])) {
+      end--;
+    }
+    if (begin == end) {
+      return 0;
+    }
+
+    const std::string s(begin, end);
+    if (s.size() > 2 && s[0] == '0') {
+      int radix = 0;
+      char prefix = static_cast<char>(s[1] | 0x20);
+      if (prefix == 'x') {
+        radix = 16;
+      } else if (prefix == 'o') {
+        radix = 8;
+      } else if (prefix == 'b') {
+        radix = 2;
+      }
+      if (radix != 0) {
+        double value = 0;
+        for (size_t i = 2; i < s.size(); i++) {
+          char c = static_cast<char>(s[i] | 0x20);
+          int digit = c >= '0' && c <= '9' ? c - '0' :
+                      c >= 'a' && c <= 'z' ? c - 'a' + 10 : radix;
+          if (digit >= radix) {
+            return NAN;
+          }
+          value = value * radix + digit;
+        }
+        return value;
+      }
+    }
+
+    size_t i = 0;
+    bool negative = false;
+    if (s[i] == '+' || s[i] == '-') {
+      negative = s[i] == '-';
+      i++;
+    }
+    if (s.compare(i, std::string::npos, "Infinity") == 0) {
+      return negative ? -INFINITY : INFINITY;
+    }
+
+    // strtod() also takes "inf", "nan" and hex floats, which Number() doesn't
+    size_t digits = 0;
+    while (i < s.size() && s[i] >= '0' && s[i] <= '9') {
+      i++;
+      digits++;
+    }
+    if (i < s.size() && s[i] == '.') {
+      i++;
+      while (i < s.size() && s[i] >= '0' && s[i] <= '9') {
+        i++;
+        digits++;
+      }
+    }
+    if (digits == 0) {
+      return NAN;
+    }
+    if (i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+      i++;
+      if (i < s.size() && (s[i] == '+' || s[i] == '-')) {
+        i++;
+      }
+      size_t exponent = 0;
+      while (i < s.size() && s[i] >= '0' && s[i] <= '9') {
+        i++;
+        exponent++;
+      }
+      if (exponent == 0) {
+        return NAN;
+      }
+    }
+    if (i != s.size()) {
+      return NAN;
+    }
+    return strtod(s.c_str(), nullptr);
+  }
+
+  // Prints |value| the way JS does for the common cases
+  static void AppendNumber(double value, ArgStyle style, std::string* out) {
+    if (isnan(value)) {
+      out->append("NaN");
+      return;
+    }
+    if (isinf(value)) {
+      out->append(value < 0 ? "-Infinity" : "Infinity");
+      return;
+    }
+
+    char buf[32];
+    if (style == ArgStyle::Integer) {
+      value = trunc(value);
+    }
+    if (value == 0) {
+      // String(-0) is "0", util.inspect(-0) is "-0"
+      out->append(style == ArgStyle::Inspect && signbit(value) ? "-0" : "0");
+      return;
+    }
+    if (value == trunc(value) && fabs(value) < 1e21) {
+      snprintf(buf, sizeof(buf), "%.0f", value);
+    } else {
+      // The shortest representation that reads back as the same number
+      snprintf(buf, sizeof(buf), "%.15g", value);
+      if (strtod(buf, nullptr) != value) {
+        snprintf(buf, sizeof(buf), "%.17g", value);
+      }
+    }
+    out->append(buf);
+  }
+
+  static void AppendArg(LogArgTag tag,
+                        const char* payload,
+                        size_t length,
+                        ArgStyle style,
+                        std::string* out) {
+    if (style == ArgStyle::Number || style == ArgStyle::Integer) {
+      double value = 0;
+      switch (tag) {
+        case LogArgTag::Number:
+          memcpy(&value, payload, sizeof(value));
+          break;
+        case LogArgTag::Boolean:
+          value = *payload ? 1 : 0;
+          break;
+        case LogArgTag::Null:
+          value = 0;
+          break;
+        case LogArgTag::String:
+        case LogArgTag::Buffer:
+          // Number(buffer) converts buffer.toString()
+          value = StringToNumber(payload, length);
+          break;
+      }
+      AppendNumber(value, style, out);
+      return;
+    }
+
+    switch (tag) {
+      case LogArgTag::Number: {
+        double value;
+        memcpy(&value, payload, sizeof(value));
+        AppendNumber(value, style, out);
+        break;
+      }
+      case LogArgTag::Boolean:
+        out->append(*payload ? "true" : "false");
+        break;
+      case LogArgTag::Null:
+        out->append("null");
+        break;
+      case LogArgTag::String:
+        out->append(payload, length);
+        break;
+      case LogArgTag::Buffer: {
+        // String(buffer) is its UTF-8 text, only inspect() shows the bytes
+        if (style == ArgStyle::String) {
+          out->append(payload, length);
+          break;
+        }
+        static const char hex[] = "0123456789abcdef";
+        out->append("<Buffer");
+        for (size_t i = 0; i < length && i < kMaxBufferBytes; i++) {
+          unsigned char c = static_cast<unsigned char>(payload[i]);
+          out->push_back(' ');
+          out->push_back(hex[c >> 4]);
+          out->push_back(hex[c & 15]);
+        }
+        if (length > kMaxBufferBytes) {
+          out->append(" ... ");
+        }
+        out->push_back('>');
+        break;
+      }
+    }
+  }
+
+  void FormatLogRecord(const char* data, size_t size, std::string* out) {
+    out->clear();
+
+    uint32_t id;
+    if (size < sizeof(id)) {
+      return;
+    }
+    memcpy(&id, data, sizeof(id));
+    LogArgReader reader(data + sizeof(id), data + size);
+
+    LogArgTag tag;
+    const char* payload;
+    size_t length;
+
+    {
+      std::lock_guard<std::mutex> lock(s_formatsMutex);
+      if (id >= s_formats.size()) {
+        out->append("<unknown log format>");
+      } else {
+        const std::string& format = s_formats[id];
+        for (size_t i = 0; i < format.size(); i++) {
+          char c = format[i];
+          if (c != '%' || i + 1 == format.size()) {
+            out->push_back(c);
+            continue;
+          }
+
+          char next = format[i + 1];
+          if (next == '%') {
+            out->push_back('%');
+            i++;
+          } else if (next == 's' || next == 'd' || next == 'i') {
+            if (reader.Next(&tag, &payload, &length)) {
+              ArgStyle style = next == 's' ? ArgStyle::String :
+                               next == 'd' ? ArgStyle::Number :
+                               ArgStyle::Integer;
+              AppendArg(tag, payload, length, style, out);
+            } else {
+              out->push_back('%');
+              out->push_back(next);
+            }
+            i++;
+          } else {
+            out->push_back(c);
+          }
+        }
+      }
+    }
+
+    while (reader.Next(&tag, &payload, &length)) {
+      out->push_back(' ');
+      AppendArg(tag, payload, length, ArgStyle::Inspect, out);
+    }
+  }
+
+}  // namespace logger
+}  // namespace node
@@ -0,0 +1,114 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "log_ring.h"
+
+#include <stdlib.h>
+
+namespace node {
+namespace logger {
+
+  LogRing::LogRing(size_t capacity) : writePosition_(0), readPosition_(0) {
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+
+    cells_ = new Cell[size];
+    mask_ = size - 1;
+    for (size_t i = 0; i < size; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  LogRing::~LogRing() {
+    while (Front() != nullptr) {
+      Pop();
+    }
+    delete[] cells_;
+  }
+
+  LogRecord* LogRing::Claim(ILogger::LogLevel level,
+                            LogRecord::Kind kind,
+                            size_t size) {
+    Cell* cell;
+    size_t position = writePosition_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &cells_[position & mask_];
+      size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+      if (diff == 0) {
+        if (writePosition_.compare_exchange_weak(position, position + 1,
+                                                 std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return nullptr;  // Full.
+      } else {
+        position = writePosition_.load(std::memory_order_relaxed);
+      }
+    }
+
+    LogRecord* record = &cell->record;
+    record->level = level;
+    record->kind = kind;
+    record->size = size;
+    record->data = record->inlineData;
+    record->position = position;
+    if (size > LogRecord::kInlineSize) {
+      record->data = static_cast<char*>(malloc(size));
+      if (record->data == nullptr) {
+        record->data = record->inlineData;
+        record->size = 0;
+      }
+    }
+    return record;
+  }
+
+  void LogRing::Publish(LogRecord* record) {
+    Cell* cell = &cells_[record->position & mask_];
+    cell->sequence.store(record->position + 1, std::memory_order_release);
+  }
+
+  LogRecord* LogRing::Front() {
+    Cell* cell = &cells_[readPosition_ & mask_];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    if (sequence != readPosition_ + 1) {
+      return nullptr;
+    }
+    return &cell->record;
+  }
+
+  void LogRing::Pop() {
+    Cell* cell = &cells_[readPosition_ & mask_];
+    if (cell->record.data != cell->record.inlineData) {
+      free(cell->record.data);
+    }
+    cell->sequence.store(readPosition_ + mask_ + 1, std::memory_order_release);
+    readPosition_++;
+  }
+
+}  // namespace logger
+}  // namespace node
@@ -22,8 +22,15 @@
     THE SOFTWARE.
 */
 
+#include <atomic>
+#include <string>
+#include <vector>
 #include "node.h"
+#include "node_buffer.h"
 #include "logger_wrap.h"
+#include "node_logger.h"
+#include "async_logger.h"
+#include "log_format.h"
 
 namespace node { 
 namespace logger {
@@ -31,6 +38,7 @@ namespace logger {
   using namespace v8;
 
   static const ILogger* s_logger = nullptr;
+  static std::atomic<int> s_minLevel(ILogger::LogLevel::Verbose);
 
   void SetLogger(const ILogger* logger) {
     s_logger = logger;
@@ -40,11 +48,54 @@ namespace logger {
     return s_logger;
   }
 
+  void NODE_API SetLogLevel(ILogger::LogLevel level) {
+    s_minLevel = level;
+  }
+
+  bool IsLogLevelEnabled(ILogger::LogLevel level) {
+    return level >= s_minLevel.load(std::memory_order_relaxed);
+  }
+
+  bool NODE_API StartAsyncLogging(size_t capacity, const char* path) {
+    if (AsyncLogger::IsInstalled() || capacity == 0) {
+      return false;
+    }
+
+    FILE* file = nullptr;
+    if (path != nullptr) {
+      file = fopen(path, "a");
+      if (file == nullptr) {
+        return false;
+      }
+    } else if (s_logger == nullptr) {
+      return false;
+    }
+
+    return AsyncLogger::Install(s_logger, file, capacity);
+  }
+
+  void NODE_API StopAsyncLogging() {
+    AsyncLogger::Uninstall();
+  }
+
+  void WriteLog(ILogger::LogLevel level, const char* msg, size_t length) {
+    if (!IsLogLevelEnabled(level)) {
+      return;
+    }
+
+    AsyncLogger::Ref asyncLogger;
+    if (asyncLogger.get() != nullptr) {
+      asyncLogger.get()->Append(level, msg, length);
+    } else if (s_logger != nullptr) {
+      s_logger->Log(level, msg);
+    }
+  }
+
   void Log(const FunctionCallbackInfo<Value>& args) {
     Isolate* isolate = Isolate::GetCurrent();
     HandleScope scope(isolate);
 
-    if (s_logger == nullptr) {
+    if (s_logger == nullptr && !AsyncLogger::IsInstalled()) {
       return;
     }
 
@@ -56,8 +107,180 @@ namespace logger {
     // get log level
     ILogger::LogLevel level = static_cast<ILogger::LogLevel>(args[0]->Int32Value());
 
+    // filter before paying for the string conversion
+    if (!IsLogLevelEnabled(level)) {
+      return;
+    }
+
     String::Utf8Value msgPtr(args[1]);
-    s_logger->Log(level, *msgPtr);
+    WriteLog(level, *msgPtr, msgPtr.length());
+  }
+
+  // arguments of logStructured() after the log level and the format id
+  static const int kMaxStructuredArgs = 32;
+
+  void RegisterFormat(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = Isolate::GetCurrent();
+    HandleScope scope(isolate);
+
+    if (args.Length() < 1 || ! args[0]->IsString()) {
+      isolate->ThrowException(Exception::Error(String::NewFromUtf8(isolate, "Invalid arguments, expected: [format : string]")));
+      return;
+    }
+
+    String::Utf8Value format(args[0]);
+    args.GetReturnValue().Set(RegisterLogFormat(*format));
+  }
+
+  // Writes the structured record for args[1..] to |out|, |strings| holds the
+  // arguments that are encoded as strings
+  static void EncodeStructured(const FunctionCallbackInfo<Value>& args,
+                               Local<String>* strings,
+                               char* out) {
+    out = EncodeLogFormatId(out, args[1]->Uint32Value());
+    for (int i = 2; i < args.Length(); i++) {
+      Local<Value> arg = args[i];
+      if (arg->IsNumber()) {
+        out = EncodeLogNumber(out, arg->NumberValue());
+      } else if (arg->IsBoolean()) {
+        out = EncodeLogBoolean(out, arg->IsTrue());
+      } else if (arg->IsNull()) {
+        out = EncodeLogNull(out);
+      } else if (Buffer::HasInstance(arg)) {
+        size_t length = Buffer::Length(arg);
+        out = EncodeLogBytes(out, LogArgTag::Buffer, length);
+        memcpy(out, Buffer::Data(arg), length);
+        out += length;
+      } else {
+        Local<String> str = strings[i - 2];
+        size_t length = str->Utf8Length();
+        out = EncodeLogBytes(out, LogArgTag::String, length);
+        out += str->WriteUtf8(out, static_cast<int>(length), nullptr, String::NO_NULL_TERMINATION);
+      }
+    }
+  }
+
+  // logStructured(level, formatId, ...args) stores the arguments in binary
+  // form, they are only turned into text when the record is written out
+  void LogStructured(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = Isolate::GetCurrent();
+    HandleScope scope(isolate);
+
+    if (s_logger == nullptr && !AsyncLogger::IsInstalled()) {
+      return;
+    }
+
+    if (args.Length() < 2 || ! args[0]->IsNumber() || ! args[1]->IsUint32()) {
+      isolate->ThrowException(Exception::Error(String::NewFromUtf8(isolate, "Invalid arguments, expected: [log level : number], [format id : number], [arguments...]")));
+      return;
+    }
+
+    ILogger::LogLevel level = static_cast<ILogger::LogLevel>(args[0]->Int32Value());
+    if (!IsLogLevelEnabled(level)) {
+      return;
+    }
+
+    if (!IsLogFormat(args[1]->Uint32Value())) {
+      isolate->ThrowException(Exception::Error(String::NewFromUtf8(isolate, "Unknown log format id")));
+      return;
+    }
+
+    if (args.Length() - 2 > kMaxStructuredArgs) {
+      isolate->ThrowException(Exception::Error(String::NewFromUtf8(isolate, "Too many arguments for a structured log record")));
+      return;
+    }
+
+    // numbers, booleans, null and buffers are stored as they are, everything
+    // else as a string
+    Local<String> strings[kMaxStructuredArgs];
+    size_t size = sizeof(uint32_t);
+    for (int i = 2; i < args.Length(); i++) {
+      Local<Value> arg = args[i];
+      if (arg->IsNumber()) {
+        size += 1 + sizeof(double);
+      } else if (arg->IsBoolean()) {
+        size += 2;
+      } else if (arg->IsNull()) {
+        size += 1;
+      } else if (Buffer::HasInstance(arg)) {
+        size += 1 + sizeof(uint32_t) + Buffer::Length(arg);
+      } else {
+        strings[i - 2] = arg->ToString(isolate);
+        size += 1 + sizeof(uint32_t) + strings[i - 2]->Utf8Length();
+      }
+    }
+
+    {
+      AsyncLogger::Ref asyncLogger;
+      if (asyncLogger.get() != nullptr) {
+        LogRecord* record = asyncLogger.get()->Claim(level, LogRecord::Kind::Structured, size);
+        if (record == nullptr) {
+          return;  // dropped
+        }
+        if (record->size == size) {
+          EncodeStructured(args, strings, record->data);
+        }
+        asyncLogger.get()->Publish(record);
+        return;
+      }
+    }
+
+    std::vector<char> data(size);
+    EncodeStructured(args, strings, data.data());
+    std::string text;
+    FormatLogRecord(data.data(), size, &text);
+    WriteLog(level, text.c_str(), text.size());
+  }
+
+  void SetLevel(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = Isolate::GetCurrent();
+    HandleScope scope(isolate);
+
+    if (args.Length() < 1 || ! args[0]->IsNumber()) {
+      isolate->ThrowException(Exception::Error(String::NewFromUtf8(isolate, "Invalid arguments, expected: [log level : number]")));
+      return;
+    }
+
+    SetLogLevel(static_cast<ILogger::LogLevel>(args[0]->Int32Value()));
+  }
+
+  void StartAsync(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = Isolate::GetCurrent();
+    HandleScope scope(isolate);
+
+    if (args.Length() < 1 || ! args[0]->IsUint32()) {
+      isolate->ThrowException(Exception::Error(String::NewFromUtf8(isolate, "Invalid arguments, expected: [capacity : number], [path : string]")));
+      return;
+    }
+
+    bool started;
+    if (args.Length() > 1 && args[1]->IsString()) {
+      String::Utf8Value path(args[1]);
+      started = StartAsyncLogging(args[0]->Uint32Value(), *path);
+    } else {
+      started = StartAsyncLogging(args[0]->Uint32Value(), nullptr);
+    }
+    args.GetReturnValue().Set(started);
+  }
+
+  void StopAsync(const FunctionCallbackInfo<Value>& args) {
+    StopAsyncLogging();
+  }
+
+  void GetStats(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = Isolate::GetCurrent();
+    HandleScope scope(isolate);
+
+    AsyncLogger::Ref asyncLogger;
+    if (asyncLogger.get() == nullptr) {
+      args.GetReturnValue().SetNull();
+      return;
+    }
+
+    Handle<Object> stats = Object::New(isolate);
+    stats->Set(String::NewFromUtf8(isolate, "written"), Number::New(isolate, static_cast<double>(asyncLogger.get()->Written())));
+    stats->Set(String::NewFromUtf8(isolate, "dropped"), Number::New(isolate, static_cast<double>(asyncLogger.get()->Dropped())));
+    args.GetReturnValue().Set(stats);
   }
   
   void Initialize(Handle<Object> target) {
@@ -66,6 +289,12 @@ namespace logger {
 
     Handle<Object> loggerObject = Object::New();
     loggerObject->Set(String::NewFromUtf8(isolate, "log"), FunctionTemplate::New(isolate, Log)->GetFunction());
+    loggerObject->Set(String::NewFromUtf8(isolate, "registerFormat"), FunctionTemplate::New(isolate, RegisterFormat)->GetFunction());
+    loggerObject->Set(String::NewFromUtf8(isolate, "logStructured"), FunctionTemplate::New(isolate, LogStructured)->GetFunction());
+    loggerObject->Set(String::NewFromUtf8(isolate, "setLevel"), FunctionTemplate::New(isolate, SetLevel)->GetFunction());
+    loggerObject->Set(String::NewFromUtf8(isolate, "startAsync"), FunctionTemplate::New(isolate, StartAsync)->GetFunction());
+    loggerObject->Set(String::NewFromUtf8(isolate, "stopAsync"), FunctionTemplate::New(isolate, StopAsync)->GetFunction());
+    loggerObject->Set(String::NewFromUtf8(isolate, "getStats"), FunctionTemplate::New(isolate, GetStats)->GetFunction());
 
     // init log level enum: Verbose, Info, Warn, Error
     Handle<Object> logLevelsObj = Object::New();
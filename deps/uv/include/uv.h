@@ -273,6 +273,7 @@ UV_EXTERN uv_loop_t* uv_loop_new(void);
 UV_EXTERN void uv_loop_delete(uv_loop_t*);
 UV_EXTERN size_t uv_loop_size(void);
 UV_EXTERN int uv_loop_alive(const uv_loop_t* loop);
+UV_EXTERN unsigned int uv_loop_active_reqs(const uv_loop_t* loop);
 UV_EXTERN int uv_loop_configure(uv_loop_t* loop, uv_loop_option option, ...);
 
 UV_EXTERN int uv_run(uv_loop_t*, uv_run_mode mode);
@@ -973,6 +974,34 @@ UV_EXTERN int uv_queue_work(uv_loop_t* loop,
                             uv_work_cb work_cb,
                             uv_after_work_cb after_work_cb);
 
+/*
+ * Classes of work the threadpool keeps separate wait time statistics for.
+ */
+typedef enum {
+  UV_WORK_KIND_CPU,      /* uv_queue_work() */
+  UV_WORK_KIND_FAST_IO,  /* file system requests */
+  UV_WORK_KIND_SLOW_IO,  /* uv_getaddrinfo(), uv_getnameinfo() */
+  UV_WORK_KIND_MAX
+} uv_work_kind;
+
+/*
+ * Number of buckets in each wait time histogram. Bucket `i` counts requests
+ * that waited in the queue for [2^i, 2^(i+1)) microseconds, bucket 0 also
+ * counts shorter waits and the last bucket also counts longer ones.
+ */
+#define UV_THREADPOOL_WAIT_BUCKETS 24
+
+typedef struct {
+  unsigned int min_threads;
+  unsigned int max_threads;
+  unsigned int threads;
+  unsigned int idle_threads;
+  unsigned int queued;
+  uint64_t wait_histogram[UV_WORK_KIND_MAX][UV_THREADPOOL_WAIT_BUCKETS];
+} uv_threadpool_stats_t;
+
+UV_EXTERN int uv_threadpool_stats(uv_threadpool_stats_t* stats);
+
 UV_EXTERN int uv_cancel(uv_req_t* req);
 
 
@@ -38,19 +38,48 @@ static void uv__req_init(uv_loop_t* loop,
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 
 #define MAX_THREADPOOL_SIZE 128
+#define DEFAULT_IDLE_TIMEOUT 5000  /* milliseconds */
+
+enum {
+  SLOT_FREE,
+  SLOT_RUNNING,
+  SLOT_EXITED
+};
+
+/* The kind and submit time of queued work is kept here rather than in
+ * struct uv__work, which is embedded in the public request types. The table
+ * is an open addressed hash keyed by the uv__work pointer and is only touched
+ * with the global mutex held.
+ */
+struct pending_work {
+  struct uv__work* w;
+  uint64_t submit_time;
+  unsigned int kind;
+};
 
 static uv_once_t once = UV_ONCE_INIT;
 static uv_cond_t cond;
 static uv_mutex_t mutex;
 static unsigned int idle_threads;
 static unsigned int nthreads;
+static unsigned int min_threads;
+static unsigned int max_threads;
+static unsigned int queued;
+static uint64_t idle_timeout;
 static uv_thread_t* threads;
+static unsigned char* slots;
 static uv_thread_t default_threads[4];
+static unsigned char default_slots[4];
+static uint64_t wait_histogram[UV_WORK_KIND_MAX][UV_THREADPOOL_WAIT_BUCKETS];
 static QUEUE exit_message;
 static QUEUE wq;
 static volatile int initialized;
+static struct pending_work* pending;
+static unsigned int pending_size;  /* Always a power of two, or zero. */
+static unsigned int pending_count;
 
 
 static void uv__cancelled(struct uv__work* w) {
@@ -58,22 +87,143 @@ static void uv__cancelled(struct uv__work* w) {
 }
 
 
+static unsigned int pending_slot(struct uv__work* w) {
+  return (unsigned int) (((uintptr_t) w >> 3) * 2654435761u) &
+         (pending_size - 1);
+}
+
+
+/* Must be called with the global mutex held. The statistics are best effort,
+ * work is still queued when the table can't grow.
+ */
+static void pending_insert(struct uv__work* w,
+                           unsigned int kind,
+                           uint64_t submit_time) {
+  struct pending_work* old;
+  unsigned int old_size;
+  unsigned int i;
+  unsigned int n;
+
+  if (2 * (pending_count + 1) > pending_size) {
+    old = pending;
+    old_size = pending_size;
+    n = old_size == 0 ? 64 : 2 * old_size;
+    pending = uv__calloc(n, sizeof(pending[0]));
+    if (pending == NULL) {
+      pending = old;
+      return;
+    }
+    pending_size = n;
+    for (i = 0; i < old_size; i++) {
+      if (old[i].w == NULL)
+        continue;
+      n = pending_slot(old[i].w);
+      while (pending[n].w != NULL)
+        n = (n + 1) & (pending_size - 1);
+      pending[n] = old[i];
+    }
+    uv__free(old);
+  }
+
+  i = pending_slot(w);
+  while (pending[i].w != NULL)
+    i = (i + 1) & (pending_size - 1);
+  pending[i].w = w;
+  pending[i].kind = kind;
+  pending[i].submit_time = submit_time;
+  pending_count += 1;
+}
+
+
+/* Must be called with the global mutex held. Returns 0 and fills in `entry`
+ * if `w` was found.
+ */
+static int pending_remove(struct uv__work* w, struct pending_work* entry) {
+  unsigned int hole;
+  unsigned int home;
+  unsigned int i;
+
+  if (pending_size == 0)
+    return -1;
+
+  for (i = pending_slot(w); pending[i].w != w; i = (i + 1) & (pending_size - 1))
+    if (pending[i].w == NULL)
+      return -1;
+
+  *entry = pending[i];
+  pending_count -= 1;
+
+  /* Shift the rest of the probe run back so lookups don't need tombstones. */
+  hole = i;
+  for (;;) {
+    i = (i + 1) & (pending_size - 1);
+    if (pending[i].w == NULL)
+      break;
+    home = pending_slot(pending[i].w);
+    if (((i - home) & (pending_size - 1)) <
+        ((i - hole) & (pending_size - 1)))
+      continue;
+    pending[hole] = pending[i];
+    hole = i;
+  }
+  pending[hole].w = NULL;
+
+  return 0;
+}
+
+
+/* Must be called with the global mutex held. */
+static void record_wait(struct uv__work* w) {
+  struct pending_work entry;
+  uint64_t wait;
+  unsigned int bucket;
+
+  if (pending_remove(w, &entry))
+    return;
+
+  wait = (uv_hrtime() - entry.submit_time) / 1000;
+  bucket = 0;
+  while (wait > 1 && bucket < UV_THREADPOOL_WAIT_BUCKETS - 1) {
+    wait >>= 1;
+    bucket++;
+  }
+
+  wait_histogram[entry.kind][bucket] += 1;
+}
+
+
 /* To avoid deadlock with uv_cancel() it's crucial that the worker
  * never holds the global mutex and the loop-local mutex at the same time.
  */
 static void worker(void* arg) {
   struct uv__work* w;
+  unsigned int slot;
+  int timedout;
   QUEUE* q;
 
-  (void) arg;
+  slot = (unsigned int) (uintptr_t) arg;
 
   for (;;) {
     uv_mutex_lock(&mutex);
 
     while (QUEUE_EMPTY(&wq)) {
       idle_threads += 1;
-      uv_cond_wait(&cond, &mutex);
+      timedout = 0;
+      if (nthreads > min_threads)
+        timedout = uv_cond_timedwait(&cond, &mutex, idle_timeout) != 0;
+      else
+        uv_cond_wait(&cond, &mutex);
       idle_threads -= 1;
+
+      /* Threads above the minimum retire after sitting idle for a while. The
+       * slot is reaped by the next thread that is started, or by cleanup().
+       */
+      if (timedout && QUEUE_EMPTY(&wq) && nthreads > min_threads) {
+        nthreads -= 1;
+        slots[slot] = SLOT_EXITED;
+        uv_mutex_unlock(&mutex);
+        return;
+      }
     }
 
     q = QUEUE_HEAD(&wq);
@@ -84,6 +234,8 @@ static void worker(void* arg) {
       QUEUE_REMOVE(q);
       QUEUE_INIT(q);  /* Signal uv_cancel() that the work req is
                              executing. */
+      queued -= 1;
+      record_wait(QUEUE_DATA(q, struct uv__work, wq));
     }
 
     uv_mutex_unlock(&mutex);
@@ -104,9 +256,43 @@ static void worker(void* arg) {
 }
 
 
-static void post(QUEUE* q) {
+/* Must be called with the global mutex held. Starts one more worker when
+ * there is a backlog that the idle threads can't absorb.
+ */
+static void maybe_grow(void) {
+  unsigned int i;
+  unsigned int slot;
+
+  if (queued <= idle_threads || nthreads >= max_threads)
+    return;
+
+  slot = max_threads;
+  for (i = 0; i < max_threads; i++) {
+    if (slots[i] == SLOT_EXITED) {
+      if (uv_thread_join(threads + i))
+        abort();
+      slots[i] = SLOT_FREE;
+    }
+    if (slots[i] == SLOT_FREE && slot == max_threads)
+      slot = i;
+  }
+
+  if (uv_thread_create(threads + slot, worker, (void*) (uintptr_t) slot))
+    return;  /* Not fatal, the existing threads will get to it. */
+
+  slots[slot] = SLOT_RUNNING;
+  nthreads += 1;
+}
+
+
+static void post(QUEUE* q, unsigned int kind, uint64_t submit_time) {
   uv_mutex_lock(&mutex);
   QUEUE_INSERT_TAIL(&wq, q);
+  if (q != &exit_message) {
+    pending_insert(QUEUE_DATA(q, struct uv__work, wq), kind, submit_time);
+    queued += 1;
+    maybe_grow();
+  }
   if (idle_threads > 0)
     uv_cond_signal(&cond);
   uv_mutex_unlock(&mutex);
@@ -120,48 +306,86 @@ UV_DESTRUCTOR(static void cleanup(void)) {
   if (initialized == 0)
     return;
 
-  post(&exit_message);
+  post(&exit_message, UV_WORK_KIND_MAX, 0);
 
-  for (i = 0; i < nthreads; i++)
-    if (uv_thread_join(threads + i))
-      abort();
+  for (i = 0; i < max_threads; i++)
+    if (slots[i] != SLOT_FREE)
+      if (uv_thread_join(threads + i))
+        abort();
 
-  if (threads != default_threads)
+  if (threads != default_threads) {
     uv__free(threads);
+    uv__free(slots);
+  }
+
+  uv__free(pending);
 
   uv_mutex_destroy(&mutex);
   uv_cond_destroy(&cond);
 
   threads = NULL;
+  slots = NULL;
+  pending = NULL;
+  pending_size = 0;
+  pending_count = 0;
   nthreads = 0;
   initialized = 0;
 }
 #endif
 
 
-static void init_once(void) {
-  unsigned int i;
+static unsigned int getenv_uint(const char* name, unsigned int def) {
   const char* val = NULL;
 
-  nthreads = ARRAY_SIZE(default_threads);
 #ifndef UWP_DLL
-  val = getenv("UV_THREADPOOL_SIZE");
+  val = getenv(name);
 #endif
-  if (val != NULL)
-    nthreads = atoi(val);
-  if (nthreads == 0)
-    nthreads = 1;
-  if (nthreads > MAX_THREADPOOL_SIZE)
-    nthreads = MAX_THREADPOOL_SIZE;
+  if (val == NULL)
+    return def;
+
+  return (unsigned int) atoi(val);
+}
+
+
+static void init_once(void) {
+  unsigned int i;
+
+  /* UV_THREADPOOL_SIZE is the number of threads that are always kept alive.
+   * Up to UV_THREADPOOL_MAX_SIZE threads are started when work backs up and
+   * the extra ones exit after UV_THREADPOOL_IDLE_TIMEOUT milliseconds without
+   * work. The maximum defaults to the minimum, i.e. a fixed size pool.
+   */
+  min_threads = getenv_uint("UV_THREADPOOL_SIZE", ARRAY_SIZE(default_threads));
+  if (min_threads == 0)
+    min_threads = 1;
+  if (min_threads > MAX_THREADPOOL_SIZE)
+    min_threads = MAX_THREADPOOL_SIZE;
+
+  max_threads = getenv_uint("UV_THREADPOOL_MAX_SIZE", min_threads);
+  if (max_threads < min_threads)
+    max_threads = min_threads;
+  if (max_threads > MAX_THREADPOOL_SIZE)
+    max_threads = MAX_THREADPOOL_SIZE;
+
+  idle_timeout = getenv_uint("UV_THREADPOOL_IDLE_TIMEOUT",
+                             DEFAULT_IDLE_TIMEOUT);
+  idle_timeout *= 1000000;  /* nanoseconds */
 
   threads = default_threads;
-  if (nthreads > ARRAY_SIZE(default_threads)) {
-    threads = uv__malloc(nthreads * sizeof(threads[0]));
-    if (threads == NULL) {
-      nthreads = ARRAY_SIZE(default_threads);
+  slots = default_slots;
+  if (max_threads > ARRAY_SIZE(default_threads)) {
+    threads = uv__malloc(max_threads * sizeof(threads[0]));
+    slots = uv__malloc(max_threads * sizeof(slots[0]));
+    if (threads == NULL || slots == NULL) {
+      uv__free(threads);
+      uv__free(slots);
+      min_threads = ARRAY_SIZE(default_threads);
+      max_threads = ARRAY_SIZE(default_threads);
       threads = default_threads;
+      slots = default_slots;
     }
   }
+  memset(slots, SLOT_FREE, max_threads * sizeof(slots[0]));
 
   if (uv_cond_init(&cond))
     abort();
@@ -171,8 +395,12 @@ static void init_once(void) {
 
   QUEUE_INIT(&wq);
 
-  for (i = 0; i < nthreads; i++)
-    if (uv_thread_create(threads + i, worker, NULL))
+  /* The workers read nthreads as soon as they start. */
+  nthreads = min_threads;
+  memset(slots, SLOT_RUNNING, min_threads * sizeof(slots[0]));
+
+  for (i = 0; i < min_threads; i++)
+    if (uv_thread_create(threads + i, worker, (void*) (uintptr_t) i))
       abort();
 
   initialized = 1;
@@ -181,25 +409,53 @@ static void init_once(void) {
 
 void uv__work_submit(uv_loop_t* loop,
                      struct uv__work* w,
+                     uv_work_kind kind,
                      void (*work)(struct uv__work* w),
                      void (*done)(struct uv__work* w, int status)) {
   uv_once(&once, init_once);
   w->loop = loop;
   w->work = work;
   w->done = done;
-  post(&w->wq);
+  post(&w->wq, kind, uv_hrtime());
+}
+
+
+int uv_threadpool_stats(uv_threadpool_stats_t* stats) {
+  if (stats == NULL)
+    return UV_EINVAL;
+
+  /* Don't start the threads just to report on them. */
+  if (initialized == 0) {
+    memset(stats, 0, sizeof(*stats));
+    return 0;
+  }
+
+  uv_mutex_lock(&mutex);
+  stats->min_threads = min_threads;
+  stats->max_threads = max_threads;
+  stats->threads = nthreads;
+  stats->idle_threads = idle_threads;
+  stats->queued = queued;
+  memcpy(stats->wait_histogram, wait_histogram, sizeof(wait_histogram));
+  uv_mutex_unlock(&mutex);
+
+  return 0;
 }
 
 
 static int uv__work_cancel(uv_loop_t* loop, uv_req_t* req, struct uv__work* w) {
+  struct pending_work entry;
   int cancelled;
 
   uv_mutex_lock(&mutex);
   uv_mutex_lock(&w->loop->wq_mutex);
 
   cancelled = !QUEUE_EMPTY(&w->wq) && w->work != NULL;
-  if (cancelled)
+  if (cancelled) {
     QUEUE_REMOVE(&w->wq);
+    queued -= 1;
+    pending_remove(w, &entry);
+  }
 
   uv_mutex_unlock(&w->loop->wq_mutex);
   uv_mutex_unlock(&mutex);
@@ -271,7 +527,11 @@ int uv_queue_work(uv_loop_t* loop,
   req->loop = loop;
   req->work_cb = work_cb;
   req->after_work_cb = after_work_cb;
-  uv__work_submit(loop, &req->work_req, uv__queue_work, uv__queue_done);
+  uv__work_submit(loop,
+                  &req->work_req,
+                  UV_WORK_KIND_CPU,
+                  uv__queue_work,
+                  uv__queue_done);
   return 0;
 }
 
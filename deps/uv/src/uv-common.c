@@ -635,6 +635,18 @@ int uv_loop_close(uv_loop_t* loop) {
 }
 
 
+unsigned int uv_loop_active_reqs(const uv_loop_t* loop) {
+  unsigned int count;
+  QUEUE* q;
+
+  count = 0;
+  QUEUE_FOREACH(q, &((uv_loop_t*) loop)->active_reqs)
+    count++;
+
+  return count;
+}
+
+
 void uv_loop_delete(uv_loop_t* loop) {
   uv_loop_t* default_loop;
   int err;
@@ -55,13 +55,16 @@ TEST_IMPL(loop_alive) {
   ASSERT(!uv_loop_alive(uv_default_loop()));
 
   /* loops with requests are alive */
+  ASSERT(uv_loop_active_reqs(uv_default_loop()) == 0);
   r = uv_queue_work(uv_default_loop(), &work_req, work_cb, after_work_cb);
   ASSERT(r == 0);
   ASSERT(uv_loop_alive(uv_default_loop()));
+  ASSERT(uv_loop_active_reqs(uv_default_loop()) == 1);
 
   r = uv_run(uv_default_loop(), UV_RUN_DEFAULT);
   ASSERT(r == 0);
   ASSERT(!uv_loop_alive(uv_default_loop()));
+  ASSERT(uv_loop_active_reqs(uv_default_loop()) == 0);
 
   return 0;
 }
@@ -22,10 +22,17 @@
 #include "uv.h"
 #include "task.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#define GROW_REQS 4
+
 static int work_cb_count;
 static int after_work_cb_count;
 static uv_work_t work_req;
 static char data;
+static uv_work_t grow_reqs[GROW_REQS];
+static uv_barrier_t grow_barrier;
 
 
 static void work_cb(uv_work_t* req) {
@@ -74,3 +81,101 @@ TEST_IMPL(threadpool_queue_work_einval) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+TEST_IMPL(threadpool_stats) {
+  uv_threadpool_stats_t stats;
+  uint64_t total;
+  int i;
+  int r;
+
+  ASSERT(uv_threadpool_stats(NULL) == UV_EINVAL);
+
+  /* Asking for the stats doesn't start the pool. */
+  memset(&stats, 0xff, sizeof(stats));
+  r = uv_threadpool_stats(&stats);
+  ASSERT(r == 0);
+  ASSERT(stats.min_threads == 0);
+  ASSERT(stats.max_threads == 0);
+  ASSERT(stats.threads == 0);
+  ASSERT(stats.queued == 0);
+  ASSERT(stats.wait_histogram[UV_WORK_KIND_CPU][0] == 0);
+
+  work_req.data = &data;
+  r = uv_queue_work(uv_default_loop(), &work_req, work_cb, after_work_cb);
+  ASSERT(r == 0);
+  uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+
+  ASSERT(work_cb_count == 1);
+  ASSERT(after_work_cb_count == 1);
+
+  r = uv_threadpool_stats(&stats);
+  ASSERT(r == 0);
+  ASSERT(stats.min_threads >= 1);
+  ASSERT(stats.max_threads >= stats.min_threads);
+  ASSERT(stats.threads >= stats.min_threads);
+  ASSERT(stats.threads <= stats.max_threads);
+  ASSERT(stats.idle_threads <= stats.threads);
+  ASSERT(stats.queued == 0);
+
+  total = 0;
+  for (i = 0; i < UV_THREADPOOL_WAIT_BUCKETS; i++)
+    total += stats.wait_histogram[UV_WORK_KIND_CPU][i];
+  ASSERT(total == 1);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void grow_work_cb(uv_work_t* req) {
+  /* Only returns once GROW_REQS threads are running at the same time. */
+  uv_barrier_wait(&grow_barrier);
+}
+
+
+static void grow_after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  after_work_cb_count++;
+}
+
+
+TEST_IMPL(threadpool_grow) {
+  uv_threadpool_stats_t stats;
+  uint64_t total;
+  int i;
+  int r;
+
+  ASSERT(0 == putenv("UV_THREADPOOL_SIZE=1"));
+  ASSERT(0 == putenv("UV_THREADPOOL_MAX_SIZE=4"));
+  ASSERT(0 == putenv("UV_THREADPOOL_IDLE_TIMEOUT=60000"));
+  ASSERT(0 == uv_barrier_init(&grow_barrier, GROW_REQS));
+
+  for (i = 0; i < GROW_REQS; i++) {
+    r = uv_queue_work(uv_default_loop(),
+                      grow_reqs + i,
+                      grow_work_cb,
+                      grow_after_work_cb);
+    ASSERT(r == 0);
+  }
+
+  uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+  ASSERT(after_work_cb_count == GROW_REQS);
+
+  r = uv_threadpool_stats(&stats);
+  ASSERT(r == 0);
+  ASSERT(stats.min_threads == 1);
+  ASSERT(stats.max_threads == GROW_REQS);
+  ASSERT(stats.threads == GROW_REQS);
+  ASSERT(stats.queued == 0);
+
+  total = 0;
+  for (i = 0; i < UV_THREADPOOL_WAIT_BUCKETS; i++)
+    total += stats.wait_histogram[UV_WORK_KIND_CPU][i];
+  ASSERT(total == GROW_REQS);
+
+  uv_barrier_destroy(&grow_barrier);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
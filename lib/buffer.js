@@ -671,6 +671,57 @@ Buffer.prototype.includes = function includes(val, byteOffset, encoding) {
 };
 
 
+// A search for one needle, or for any of an Array of needles, that is compiled
+// once and can then be run against many buffers.
+class Searcher {
+  constructor(needles, encoding) {
+    const list = Array.isArray(needles) ? needles : [needles];
+    if (list.length === 0)
+      throw new TypeError('"needles" argument must not be an empty Array');
+
+    const patterns = new Array(list.length);
+    for (var i = 0; i < list.length; i++) {
+      var needle = list[i];
+      if (typeof needle === 'string')
+        needle = Buffer.from(needle, encoding);
+      else if (!(needle instanceof Uint8Array))
+        throw new TypeError('"needle" argument must be a string, Buffer, ' +
+                            'or Uint8Array');
+      if (needle.length === 0)
+        throw new TypeError('"needle" argument must not be empty');
+      patterns[i] = needle;
+    }
+    this._handle = new binding.Searcher(patterns);
+  }
+
+  indexOf(buffer, byteOffset) {
+    if (!(buffer instanceof Uint8Array))
+      throw new TypeError('"buffer" argument must be a Buffer or Uint8Array');
+    if (byteOffset > 0x7fffffff)
+      byteOffset = 0x7fffffff;
+    else if (byteOffset < -0x80000000)
+      byteOffset = -0x80000000;
+    byteOffset = +byteOffset;  // Coerce to Number.
+    if (isNaN(byteOffset))
+      byteOffset = 0;
+    return this._handle.indexOf(buffer, byteOffset);
+  }
+
+  includes(buffer, byteOffset) {
+    return this.indexOf(buffer, byteOffset) !== -1;
+  }
+
+  search(buffer, byteOffset) {
+    const index = this.indexOf(buffer, byteOffset);
+    if (index === -1)
+      return null;
+    return { index: index, needle: this._handle.lastPattern() };
+  }
+}
+
+exports.Searcher = Searcher;
+
+
 // Usage:
 //    buffer.fill(number[, offset[, end]])
 //    buffer.fill(buffer[, offset[, end]])
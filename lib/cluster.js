@@ -9,8 +9,10 @@ const util = require('util');
 const internalUtil = require('internal/util');
 const SCHED_NONE = 1;
 const SCHED_RR = 2;
+const SCHED_REUSEPORT = 3;
 
 const uv = process.binding('uv');
+const TCPConstants = process.binding('tcp_wrap').constants;
 
 const cluster = new EventEmitter();
 module.exports = cluster;
@@ -111,6 +113,10 @@ SharedHandle.prototype.remove = function(worker) {
 };
 
 
+// Number of connections that the master hands off to a worker before it waits
+// for the worker to reply.  Every connection takes a slot in the free queue.
+const kMaxPendingHandoffs = 4;
+
 // Start a round-robin server. Master accepts connections and distributes
 // them over the workers.
 function RoundRobinHandle(key, address, port, addressType, backlog, fd) {
@@ -149,7 +155,9 @@ RoundRobinHandle.prototype.add = function(worker, send) {
     } else {
       send(null, null, null);  // UNIX socket.
     }
-    this.handoff(worker);  // In case there are connections pending.
+    // In case there are connections pending.
+    for (var i = 0; i < kMaxPendingHandoffs; i++)
+      this.handoff(worker);
   };
 
   if (this.server === null) return done();
@@ -167,8 +175,7 @@ RoundRobinHandle.prototype.add = function(worker, send) {
 RoundRobinHandle.prototype.remove = function(worker) {
   if (worker.id in this.all === false) return false;
   delete this.all[worker.id];
-  var index = this.free.indexOf(worker);
-  if (index !== -1) this.free.splice(index, 1);
+  this.free = this.free.filter((w) => w !== worker);
   if (Object.getOwnPropertyNames(this.all).length !== 0) return false;
   for (var handle; handle = this.handles.shift(); handle.close());
   this.handle.close();
@@ -203,6 +210,47 @@ RoundRobinHandle.prototype.handoff = function(worker) {
 };
 
 
+// Every worker listens on a socket of its own that is bound with SO_REUSEPORT
+// and the kernel balances the incoming connections across them.  The master
+// only keeps a bound but not listening socket, which reserves the address
+// (and the port that the kernel picked for port 0) without accepting any
+// connections.
+function ReusePortHandle(key, address, port, addressType, backlog, fd) {
+  this.key = key;
+  this.workers = [];
+  this.handle = null;
+  this.errno = 0;
+  this.address = address;
+  this.port = port;
+  this.addressType = addressType;
+
+  var rval = net._createServerHandle(address, port, addressType, fd,
+                                     TCPConstants.kBindReusePort);
+  if (typeof rval === 'number') {
+    this.errno = rval;
+    return;
+  }
+
+  var out = {};
+  this.handle = rval;
+  this.errno = rval.getsockname(out);
+  this.port = out.port;
+}
+
+ReusePortHandle.prototype.add = function(worker, send) {
+  assert(this.workers.indexOf(worker) === -1);
+  this.workers.push(worker);
+  send(this.errno, {
+    reusePort: true,
+    address: this.address,
+    port: this.port,
+    addressType: this.addressType
+  }, null);
+};
+
+ReusePortHandle.prototype.remove = SharedHandle.prototype.remove;
+
+
 if (cluster.isMaster)
   masterInit();
 else
@@ -217,7 +265,8 @@ function masterInit() {
   // XXX(bnoordhuis) Fold cluster.schedulingPolicy into cluster.settings?
   var schedulingPolicy = {
     'none': SCHED_NONE,
-    'rr': SCHED_RR
+    'rr': SCHED_RR,
+    'reuseport': SCHED_REUSEPORT
   }[process.env.NODE_CLUSTER_SCHED_POLICY];
 
   if (schedulingPolicy === undefined) {
@@ -229,6 +278,7 @@ function masterInit() {
   cluster.schedulingPolicy = schedulingPolicy;
   cluster.SCHED_NONE = SCHED_NONE;  // Leave it to the operating system.
   cluster.SCHED_RR = SCHED_RR;      // Master distributes connections.
+  cluster.SCHED_REUSEPORT = SCHED_REUSEPORT;  // Kernel balances connections.
 
   // Keyed on address:port:etc. When a worker dies, we walk over the handles
   // and remove() the worker from each one. remove() may do a linear scan
@@ -258,7 +308,9 @@ function masterInit() {
       return process.nextTick(setupSettingsNT, settings);
     initialized = true;
     schedulingPolicy = cluster.schedulingPolicy;  // Freeze policy.
-    assert(schedulingPolicy === SCHED_NONE || schedulingPolicy === SCHED_RR,
+    assert(schedulingPolicy === SCHED_NONE ||
+           schedulingPolicy === SCHED_RR ||
+           schedulingPolicy === SCHED_REUSEPORT,
            'Bad cluster.schedulingPolicy: ' + schedulingPolicy);
 
     var hasDebugArg = process.execArgv.some(function(argv) {
@@ -324,7 +376,8 @@ function masterInit() {
       execArgv: execArgv,
       stdio: cluster.settings.stdio,
       gid: cluster.settings.gid,
-      uid: cluster.settings.uid
+      uid: cluster.settings.uid,
+      serialization: cluster.settings.serialization
     });
   }
 
@@ -484,18 +537,33 @@ function masterInit() {
       // UDP is exempt from round-robin connection balancing for what should
       // be obvious reasons: it's connectionless. There is nothing to send to
       // the workers except raw datagrams and that's pointless.
-      if (schedulingPolicy !== SCHED_RR ||
+      if (schedulingPolicy === SCHED_NONE ||
           message.addressType === 'udp4' ||
           message.addressType === 'udp6') {
         constructor = SharedHandle;
+      } else if (schedulingPolicy === SCHED_REUSEPORT &&
+                 typeof message.port === 'number' &&
+                 message.port >= 0 &&
+                 !(message.fd >= 0)) {
+        constructor = ReusePortHandle;
+      }
+      handle = new constructor(key,
+                               message.address,
+                               message.port,
+                               message.addressType,
+                               message.backlog,
+                               message.fd,
+                               message.flags);
+      // SO_REUSEPORT is not available everywhere, fall back to round-robin.
+      if (constructor === ReusePortHandle && handle.errno === uv.UV_ENOTSUP) {
+        handle = new RoundRobinHandle(key,
+                                      message.address,
+                                      message.port,
+                                      message.addressType,
+                                      message.backlog,
+                                      message.fd);
       }
-      handles[key] = handle = new constructor(key,
-                                              message.address,
-                                              message.port,
-                                              message.addressType,
-                                              message.backlog,
-                                              message.fd,
-                                              message.flags);
+      handles[key] = handle;
     }
     if (!handle.data) handle.data = message.data;
 
@@ -592,6 +660,8 @@ function workerInit() {
 
       if (handle)
         shared(reply, handle, indexesKey, cb);  // Shared listen socket.
+      else if (reply.reusePort)
+        reusePort(reply, indexesKey, cb);       // Listen socket of our own.
       else
         rr(reply, indexesKey, cb);              // Round-robin.
     });
@@ -621,6 +691,24 @@ function workerInit() {
     cb(message.errno, handle);
   }
 
+  // SO_REUSEPORT. Bind our own socket to the address that the master reserved.
+  function reusePort(message, indexesKey, cb) {
+    if (message.errno)
+      return cb(message.errno, null);
+
+    var handle = net._createServerHandle(message.address,
+                                         message.port,
+                                         message.addressType,
+                                         undefined,
+                                         TCPConstants.kBindReusePort);
+    if (typeof handle === 'number') {
+      send({ act: 'close', key: message.key });
+      delete indexes[indexesKey];
+      return cb(handle, null);
+    }
+    shared(message, handle, indexesKey, cb);
+  }
+
   // Round-robin. Master distributes handles across workers.
   function rr(message, indexesKey, cb) {
     if (message.errno)
@@ -50,6 +50,7 @@ function newHandle(type) {
     handle.lookup = lookup6;
     handle.bind = handle.bind6;
     handle.send = handle.send6;
+    handle.sendBatch = handle.sendBatch6;
     return handle;
   }
 
@@ -95,6 +96,15 @@ function Socket(type, listener) {
   // If true - UV_UDP_REUSEADDR flag will be set
   this._reuseAddr = options && options.reuseAddr;
 
+  // Number of datagrams that are read per wakeup of the event loop.
+  this._recvBatchSize = 1;
+  if (options && options.recvBatchSize !== undefined) {
+    const size = options.recvBatchSize;
+    if (!Number.isInteger(size) || size < 1 || size > 64)
+      throw new RangeError('"recvBatchSize" must be an integer from 1 to 64');
+    this._recvBatchSize = size;
+  }
+
   if (typeof listener === 'function')
     this.on('message', listener);
 }
@@ -109,6 +119,12 @@ exports.createSocket = function(type, listener) {
 
 function startListening(socket) {
   socket._handle.onmessage = onMessage;
+  socket._handle.onmessages = onMessages;
+  if (socket._recvBatchSize > 1) {
+    const err = socket._handle.setRecvBatch(socket._recvBatchSize);
+    if (err)
+      throw errnoException(err, 'setRecvBatch');
+  }
   // Todo: handle errors
   socket._handle.recvStart();
   socket._receiving = true;
@@ -124,6 +140,7 @@ function replaceHandle(self, newHandle) {
   newHandle.lookup = self._handle.lookup;
   newHandle.bind = self._handle.bind;
   newHandle.send = self._handle.send;
+  newHandle.sendBatch = self._handle.sendBatch;
   newHandle.owner = self;
 
   // Replace the existing handle by the handle we got from master.
@@ -399,6 +416,91 @@ function doSend(ex, self, ip, list, address, port, callback) {
   }
 }
 
+// sendBatch(list, port, address, callback)
+// sendBatch(list, port, address)
+// sendBatch(list, port, callback)
+// sendBatch(list, port)
+Socket.prototype.sendBatch = function(messages, port, address, callback) {
+  const self = this;
+  var list;
+
+  if (!Array.isArray(messages))
+    throw new TypeError('First argument must be an array');
+  if (!(list = fixBufferList(messages)))
+    throw new TypeError('Batch elements must be buffers or strings');
+
+  port = port >>> 0;
+  if (port === 0 || port > 65535)
+    throw new RangeError('Port should be > 0 and < 65536');
+
+  if (typeof address === 'function') {
+    callback = address;
+    address = undefined;
+  }
+  if (typeof callback !== 'function')
+    callback = undefined;
+
+  self._healthCheck();
+
+  if (self._bindState == BIND_STATE_UNBOUND)
+    self.bind({port: 0, exclusive: true}, null);
+
+  if (list.length === 0) {
+    if (callback)
+      process.nextTick(callback, null, 0);
+    return;
+  }
+
+  if (self._bindState != BIND_STATE_BOUND) {
+    enqueue(self,
+            self.sendBatch.bind(self, list, port, address, callback));
+    return;
+  }
+
+  self._handle.lookup(address, function afterDns(ex, ip) {
+    doSendBatch(ex, self, ip, list, address, port, callback);
+  });
+};
+
+
+function doSendBatch(ex, self, ip, list, address, port, callback) {
+  if (ex) {
+    if (callback)
+      return callback(ex);
+    return self.emit('error', ex);
+  } else if (!self._handle) {
+    return;
+  }
+
+  var req = new SendWrap();
+  req.list = list;  // Keep reference alive.
+  req.address = address;
+  req.port = port;
+  if (callback) {
+    req.callback = callback;
+    req.oncomplete = afterSend;
+  }
+  var err = self._handle.sendBatch(req,
+                                   list,
+                                   list.length,
+                                   port,
+                                   ip,
+                                   !!callback);
+  if (err === 1) {
+    // Everything went out right away, there won't be an oncomplete().
+    if (callback) {
+      var sent = 0;
+      for (var i = 0; i < list.length; i++)
+        sent += list[i].length;
+      process.nextTick(callback, null, sent);
+    }
+  } else if (err && callback) {
+    // Some datagrams may have gone out before the error.
+    const ex = exceptionWithHostPort(err, 'send', address, port);
+    process.nextTick(callback, ex, req.bytes || 0);
+  }
+}
+
 function afterSend(err, sent) {
   if (err) {
     err = exceptionWithHostPort(err, 'send', this.address, this.port);
@@ -548,6 +650,29 @@ function onMessage(nread, handle, buf, rinfo) {
 }
 
 
+// Receives the datagrams of a batch in a single buffer.  |info| holds four
+// entries per datagram: its length, port, address family and the index of
+// its address in |addresses|.
+function onMessages(handle, buf, info, addresses) {
+  var self = handle.owner;
+  var offset = 0;
+  for (var i = 0; i < info.length; i += 4) {
+    // A listener may have closed the socket.
+    if (!self._receiving)
+      return;
+    const size = info[i];
+    const rinfo = {
+      address: addresses[info[i + 3]],
+      family: info[i + 2] === 6 ? 'IPv6' : 'IPv4',
+      port: info[i + 1],
+      size: size
+    };
+    self.emit('message', buf.slice(offset, offset + size), rinfo);
+    offset += size;
+  }
+}
+
+
 Socket.prototype.ref = function() {
   if (this._handle)
     this._handle.ref();
@@ -13,6 +13,14 @@ const QueryReqWrap = cares.QueryReqWrap;
 const isIP = cares.isIP;
 const isLegalPort = internalNet.isLegalPort;
 
+// The DnsCache that lookups and A/AAAA queries go through, null when caching
+// is disabled.
+var cache = null;
+
+// Whether lookup() uses getaddrinfo() on the threadpool or c-ares queries on
+// the event loop.
+var lookupMode = 'getaddrinfo';
+
 
 function errnoException(err, syscall, hostname) {
   // FIXME(bnoordhuis) Remove this backwards compatibility nonsense and pass
@@ -161,7 +169,27 @@ exports.lookup = function lookup(hostname, options, callback) {
   req.hostname = hostname;
   req.oncomplete = all ? onlookupall : onlookup;
 
-  var err = cares.getaddrinfo(req, hostname, family, hints);
+  if (cache !== null) {
+    const cached = cache.get(cares.DNS_CACHE_LOOKUP, hostname, family, hints);
+    if (cached !== undefined) {
+      completeFromCache(req, cached);
+      return req;
+    }
+    // Keeps the cache alive for as long as the request is in flight.
+    req.cache = cache;
+  }
+
+  var err;
+  if (lookupMode === 'cares') {
+    const addresses = cares.lookupHosts(hostname, family, hints);
+    if (addresses !== undefined) {
+      req.oncomplete(0, addresses);
+      return req;
+    }
+    err = cares.lookupAres(req, hostname, family, hints, req.cache);
+  } else {
+    err = cares.getaddrinfo(req, hostname, family, hints, req.cache);
+  }
   if (err) {
     callback(errnoException(err, 'getaddrinfo', hostname));
     return {};
@@ -219,7 +247,17 @@ function onresolve(err, result) {
 }
 
 
-function resolver(bindingName) {
+// Calls the oncomplete callback of |req| with the result in the cache, the
+// callback is made asynchronous by makeAsync().
+function completeFromCache(req, cached) {
+  if (Array.isArray(cached))
+    req.oncomplete(0, cached);
+  else
+    req.oncomplete(cached);
+}
+
+
+function resolver(bindingName, cacheKind) {
   var binding = cares[bindingName];
 
   return function query(name, callback) {
@@ -235,7 +273,17 @@ function resolver(bindingName) {
     req.callback = callback;
     req.hostname = name;
     req.oncomplete = onresolve;
-    var err = binding(req, name);
+
+    if (cache !== null && cacheKind !== undefined) {
+      const cached = cache.get(cacheKind, name, 0, 0);
+      if (cached !== undefined) {
+        completeFromCache(req, cached);
+        return req;
+      }
+      req.cache = cache;
+    }
+
+    var err = binding(req, name, req.cache);
     if (err) throw errnoException(err, bindingName);
     callback.immediately = true;
     return req;
@@ -244,8 +292,9 @@ function resolver(bindingName) {
 
 
 var resolveMap = Object.create(null);
-exports.resolve4 = resolveMap.A = resolver('queryA');
-exports.resolve6 = resolveMap.AAAA = resolver('queryAaaa');
+exports.resolve4 = resolveMap.A = resolver('queryA', cares.DNS_CACHE_A);
+exports.resolve6 = resolveMap.AAAA =
+    resolver('queryAaaa', cares.DNS_CACHE_AAAA);
 exports.resolveCname = resolveMap.CNAME = resolver('queryCname');
 exports.resolveMx = resolveMap.MX = resolver('queryMx');
 exports.resolveNs = resolveMap.NS = resolver('queryNs');
@@ -282,6 +331,15 @@ exports.getServers = function() {
 };
 
 
+function serverPort(port) {
+  if (port === undefined)
+    return 0;
+  if (!isLegalPort(port) || +port === 0)
+    throw new Error(`"port" should be > 0 and < 65536, got "${port}"`);
+  return +port;
+}
+
+
 exports.setServers = function(servers) {
   // cache the original servers because in the event of an error setting the
   // servers cares won't have any servers available for resolution
@@ -290,21 +348,22 @@ exports.setServers = function(servers) {
   const newSet = servers.map((serv) => {
     var ipVersion = isIP(serv);
     if (ipVersion !== 0)
-      return [ipVersion, serv];
+      return [ipVersion, serv, 0];
 
-    const match = serv.match(/\[(.*)\](:\d+)?/);
+    const match = serv.match(/\[(.*)\](?::(\d+))?/);
     // we have an IPv6 in brackets
     if (match) {
       ipVersion = isIP(match[1]);
       if (ipVersion !== 0)
-        return [ipVersion, match[1]];
+        return [ipVersion, match[1], serverPort(match[2])];
     }
 
-    const s = serv.split(/:\d+$/)[0];
+    const port = serv.match(/:(\d+)$/);
+    const s = port ? serv.slice(0, port.index) : serv;
     ipVersion = isIP(s);
 
     if (ipVersion !== 0)
-      return [ipVersion, s];
+      return [ipVersion, s, serverPort(port ? port[1] : undefined)];
 
     throw new Error(`IP address is not properly formatted: ${serv}`);
   });
@@ -318,6 +377,74 @@ exports.setServers = function(servers) {
     var err = cares.strerror(errorNumber);
     throw new Error(`c-ares failed to set servers: "${err}" [${servers}]`);
   }
+
+  // Answers from the old servers may not be valid for the new ones.
+  if (cache !== null)
+    cache.clear();
+};
+
+
+exports.setLookupMode = function(mode) {
+  if (mode !== 'getaddrinfo' && mode !== 'cares')
+    throw new TypeError('"mode" must be "getaddrinfo" or "cares"');
+  lookupMode = mode;
+};
+
+
+exports.getLookupMode = function() {
+  return lookupMode;
+};
+
+
+function cacheOption(options, name, defaultValue) {
+  const value = options[name];
+  if (value === undefined)
+    return defaultValue;
+  if (typeof value !== 'number' || !(value >= 0) || value % 1 !== 0)
+    throw new TypeError(`"${name}" must be a non-negative integer`);
+  return value;
+}
+
+
+exports.enableCache = function(options) {
+  if (options === undefined)
+    options = {};
+  else if (options === null || typeof options !== 'object')
+    throw new TypeError('"options" argument must be an object');
+
+  const maxEntries = cacheOption(options, 'maxEntries', 1000);
+  if (maxEntries > 0xffffffff)
+    throw new TypeError('"maxEntries" must be a non-negative integer');
+
+  cache = new cares.DnsCache(maxEntries,
+                             cacheOption(options, 'ttl', 1000),
+                             cacheOption(options, 'negativeTtl', 1000),
+                             cacheOption(options, 'maxTtl', 300000));
+};
+
+
+exports.disableCache = function() {
+  cache = null;
+};
+
+
+exports.clearCache = function() {
+  if (cache !== null)
+    cache.clear();
+};
+
+
+exports.getCacheStats = function() {
+  if (cache === null)
+    return null;
+  const stats = [];
+  cache.getStats(stats);
+  return {
+    hits: stats[0],
+    misses: stats[1],
+    coalesced: stats[2],
+    size: stats[3]
+  };
 };
 
 // uv_getaddrinfo flags
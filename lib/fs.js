@@ -255,23 +255,26 @@ fs.readFile = function(path, options, callback_) {
   if (!nullCheck(path, callback))
     return;
 
-  var context = new ReadFileContext(callback, encoding);
-  context.isUserFd = isFd(path); // file descriptor ownership
   var req = new FSReqWrap();
-  req.context = context;
-  req.oncomplete = readFileAfterOpen;
 
-  if (context.isUserFd) {
-    process.nextTick(function() {
-      req.oncomplete(null, path);
-    });
+  if (!isFd(path)) {
+    // Open, stat, read and close the file in a single threadpool job.
+    req.oncomplete = makeCallback(callback);
+    binding.readFile(pathModule._makeLong(path),
+                     stringToFlags(flag),
+                     encoding || 'buffer',
+                     req);
     return;
   }
 
-  binding.open(pathModule._makeLong(path),
-               stringToFlags(flag),
-               0o666,
-               req);
+  var context = new ReadFileContext(callback, encoding);
+  context.isUserFd = true; // file descriptor ownership
+  req.context = context;
+  req.oncomplete = readFileAfterOpen;
+
+  process.nextTick(function() {
+    req.oncomplete(null, path);
+  });
 };
 
 const kReadFileBufferLength = 8 * 1024;
@@ -521,6 +524,11 @@ fs.readFileSync = function(path, options) {
   return buffer;
 };
 
+fs.mapFileSync = function(path) {
+  nullCheck(path);
+  return binding.mapFile(pathModule._makeLong(path));
+};
+
 
 // Used by binding.open and friends
 function stringToFlags(flag) {
@@ -785,6 +793,33 @@ fs.renameSync = function(oldPath, newPath) {
                         pathModule._makeLong(newPath));
 };
 
+fs.copyFile = function(src, dest, flags, callback) {
+  if (typeof flags === 'function') {
+    callback = flags;
+    flags = 0;
+  } else if (typeof callback !== 'function') {
+    throw new TypeError('"callback" argument must be a function');
+  }
+
+  if (!nullCheck(src, callback)) return;
+  if (!nullCheck(dest, callback)) return;
+
+  var req = new FSReqWrap();
+  req.oncomplete = makeCallback(callback);
+  binding.copyFile(pathModule._makeLong(src),
+                   pathModule._makeLong(dest),
+                   flags | 0,
+                   req);
+};
+
+fs.copyFileSync = function(src, dest, flags) {
+  nullCheck(src);
+  nullCheck(dest);
+  binding.copyFile(pathModule._makeLong(src),
+                   pathModule._makeLong(dest),
+                   flags | 0);
+};
+
 fs.truncate = function(path, len, callback) {
   if (typeof path === 'number') {
     return fs.ftruncate(path, len, callback);
@@ -926,6 +961,91 @@ fs.readdirSync = function(path, options) {
   return binding.readdir(pathModule._makeLong(path), options.encoding);
 };
 
+// The result of fs.scandir(): entry names with their types and, if
+// requested, their lstat() results packed kStatsFields to an entry.
+const kStatsFields = 14;
+
+function DirEntries(result) {
+  this.names = result[0];
+  this.types = result[1];
+  this.stats = result[2];
+  this.length = this.names.length;
+}
+
+DirEntries.prototype.isFile = function(i) {
+  return this.types[i] === constants.UV_DIRENT_FILE;
+};
+
+DirEntries.prototype.isDirectory = function(i) {
+  return this.types[i] === constants.UV_DIRENT_DIR;
+};
+
+DirEntries.prototype.isSymbolicLink = function(i) {
+  return this.types[i] === constants.UV_DIRENT_LINK;
+};
+
+DirEntries.prototype.getStats = function(i) {
+  const stats = this.stats;
+  if (stats === undefined || !(i >= 0 && i < this.length))
+    return undefined;
+  const base = i * kStatsFields;
+  if (stats[base + 1] !== stats[base + 1])  // NaN, lstat() failed
+    return undefined;
+  const blksize = stats[base + 6];
+  const blocks = stats[base + 9];
+  return new fs.Stats(stats[base],
+                      stats[base + 1],
+                      stats[base + 2],
+                      stats[base + 3],
+                      stats[base + 4],
+                      stats[base + 5],
+                      blksize === blksize ? blksize : undefined,
+                      stats[base + 7],
+                      stats[base + 8],
+                      blocks === blocks ? blocks : undefined,
+                      stats[base + 10],
+                      stats[base + 11],
+                      stats[base + 12],
+                      stats[base + 13]);
+};
+
+function scandirOptions(options) {
+  options = options || {};
+  if (typeof options === 'string')
+    options = {encoding: options};
+  if (typeof options !== 'object')
+    throw new TypeError('"options" must be a string or an object');
+  return options;
+}
+
+fs.scandir = function(path, options, callback) {
+  if (typeof options === 'function') {
+    callback = options;
+    options = {};
+  }
+  options = scandirOptions(options);
+
+  callback = makeCallback(callback);
+  if (!nullCheck(path, callback)) return;
+  var req = new FSReqWrap();
+  req.oncomplete = function(err, result) {
+    if (err) return callback(err);
+    callback(null, new DirEntries(result));
+  };
+  binding.scandir(pathModule._makeLong(path),
+                  options.encoding,
+                  options.stats === true,
+                  req);
+};
+
+fs.scandirSync = function(path, options) {
+  options = scandirOptions(options);
+  nullCheck(path);
+  return new DirEntries(binding.scandir(pathModule._makeLong(path),
+                                        options.encoding,
+                                        options.stats === true));
+};
+
 fs.fstat = function(fd, callback) {
   var req = new FSReqWrap();
   req.oncomplete = makeCallback(callback);
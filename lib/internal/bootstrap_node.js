@@ -38,6 +38,8 @@
 
     _process.setup_hrtime();
     _process.setup_cpuUsage();
+    _process.setup_threadpoolUsage();
+    _process.setup_eventLoopHistograms();
     _process.setupConfig(NativeModule._source);
     NativeModule.require('internal/process/warning').setup();
     NativeModule.require('internal/process/next_tick').setup();
@@ -523,6 +525,8 @@
   }
 
   NativeModule._source = process.binding('natives');
+  // V8 code cache of the modules, empty unless built with `make code-cache`.
+  NativeModule._codeCache = process.binding('code_cache');
   NativeModule._cache = {};
 
   NativeModule.require = function(id) {
@@ -601,7 +605,8 @@
     var fn = runInThisContext(source, {
       filename: this.filename,
       lineOffset: 0,
-      displayErrors: true
+      displayErrors: true,
+      cachedData: NativeModule._codeCache[this.id]
     });
     fn(this.exports, NativeModule.require, this, this.filename);
 
@@ -17,8 +17,13 @@ const TTY = process.binding('tty_wrap').TTY;
 const TCP = process.binding('tcp_wrap').TCP;
 const UDP = process.binding('udp_wrap').UDP;
 const SocketList = require('internal/socket_list');
+const serialization = require('internal/child_process/serialization');
 
 const errnoException = util._errnoException;
+// Handles are sent back to back, without waiting for the receiver to
+// acknowledge each one, except on Windows where a duplicated socket has to
+// stay open in the sender until the receiver has imported it.
+const pipelineHandles = process.platform !== 'win32';
 const SocketListSend = SocketList.SocketListSend;
 const SocketListReceive = SocketList.SocketListReceive;
 
@@ -271,6 +276,10 @@ ChildProcess.prototype.spawn = function(options) {
   // If no `stdio` option was given - use default
   var stdio = options.stdio || 'pipe';
 
+  const serializationMode = options.serialization || 'json';
+  if (serializationMode !== 'json' && serializationMode !== 'advanced')
+    throw new TypeError('"serialization" must be "json" or "advanced"');
+
   stdio = _validateStdio(stdio, false);
 
   ipc = stdio.ipc;
@@ -281,6 +290,8 @@ ChildProcess.prototype.spawn = function(options) {
     // Let child process know about opened IPC channel
     options.envPairs = options.envPairs || [];
     options.envPairs.push('NODE_CHANNEL_FD=' + ipcFd);
+    options.envPairs.push('NODE_CHANNEL_SERIALIZATION_MODE=' +
+                          serializationMode);
   }
 
   this.spawnfile = options.file;
@@ -349,7 +360,7 @@ ChildProcess.prototype.spawn = function(options) {
   });
 
   // Add .send() method and start listening for IPC data
-  if (ipc !== undefined) setupChannel(this, ipc);
+  if (ipc !== undefined) setupChannel(this, ipc, serializationMode);
 
   return err;
 };
@@ -408,10 +419,12 @@ ChildProcess.prototype.unref = function() {
 };
 
 
-function setupChannel(target, channel) {
+function setupChannel(target, channel, serializationMode) {
+  const advanced = serializationMode === 'advanced';
   target._channel = channel;
   target._handleQueue = null;
   target._pendingHandle = null;
+  target._pendingHandleWrites = 0;
 
   const control = new class extends EventEmitter {
     constructor() {
@@ -432,12 +445,51 @@ function setupChannel(target, channel) {
     }
   };
 
+  function onChannelClose() {
+    channel.buffering = false;
+    target.disconnect();
+    channel.onread = nop;
+    channel.close();
+    target._channel = null;
+    maybeClose(target);
+  }
+
   var decoder = new StringDecoder('utf8');
   var jsonBuffer = '';
+  // Received handles, in the order of the NODE_HANDLE messages they belong
+  // to.  A handle arrives together with the start of its message, which can
+  // be completed by a later read when several handles are in flight.
+  const recvHandles = [];
   channel.buffering = false;
-  channel.onread = function(nread, pool, recvHandle) {
+
+  if (advanced) {
+    const err = channel.setMessageFraming();
+    if (err)
+      throw errnoException(err, 'setMessageFraming');
+  }
+
+  // With message framing, onread() receives an array of complete messages,
+  // and nread is the number of bytes of an incomplete one.
+  channel.onread = advanced ? function(nread, frames, recvHandle) {
+    if (!frames)
+      return onChannelClose();
+
+    if (recvHandle)
+      recvHandles.push(recvHandle);
+
+    for (var i = 0; i < frames.length; i++) {
+      const message = serialization.deserialize(frames[i]);
+      if (message && message.cmd === 'NODE_HANDLE')
+        handleMessage(target, message, recvHandles.shift());
+      else
+        handleMessage(target, message, undefined);
+    }
+    this.buffering = nread > 0;
+  } : function(nread, pool, recvHandle) {
     // TODO(bnoordhuis) Check that nread > 0.
     if (pool) {
+      if (recvHandle)
+        recvHandles.push(recvHandle);
       jsonBuffer += decoder.write(pool);
 
       var i, start = 0;
@@ -447,11 +499,8 @@ function setupChannel(target, channel) {
         var json = jsonBuffer.slice(start, i);
         var message = JSON.parse(json);
 
-        // There will be at most one NODE_HANDLE message in every chunk we
-        // read because SCM_RIGHTS messages don't get coalesced. Make sure
-        // that we deliver the handle with the right message however.
         if (message && message.cmd === 'NODE_HANDLE')
-          handleMessage(target, message, recvHandle);
+          handleMessage(target, message, recvHandles.shift());
         else
           handleMessage(target, message, undefined);
 
@@ -461,12 +510,7 @@ function setupChannel(target, channel) {
       this.buffering = jsonBuffer.length !== 0;
 
     } else {
-      this.buffering = false;
-      target.disconnect();
-      channel.onread = nop;
-      channel.close();
-      target._channel = null;
-      maybeClose(target);
+      onChannelClose();
     }
   };
 
@@ -477,12 +521,15 @@ function setupChannel(target, channel) {
   target.on('internalMessage', function(message, handle) {
     // Once acknowledged - continue sending handles.
     if (message.cmd === 'NODE_HANDLE_ACK') {
+      // Pipelined handles are acknowledged by older versions of Node.js too.
+      if (!target._handleQueue)
+        return;
+
       if (target._pendingHandle) {
         target._pendingHandle.close();
         target._pendingHandle = null;
       }
 
-      assert(Array.isArray(target._handleQueue));
       var queue = target._handleQueue;
       target._handleQueue = null;
 
@@ -499,11 +546,12 @@ function setupChannel(target, channel) {
 
     if (message.cmd !== 'NODE_HANDLE') return;
 
-    // Acknowledge handle receival. Don't emit error events (for example if
-    // the other side has disconnected) because this call to send() is not
-    // initiated by the user and it shouldn't be fatal to be unable to ACK
-    // a message.
-    target._send({ cmd: 'NODE_HANDLE_ACK' }, null, true);
+    // Acknowledge handle receival, unless the sender does not wait for it.
+    // Don't emit error events (for example if the other side has
+    // disconnected) because this call to send() is not initiated by the user
+    // and it shouldn't be fatal to be unable to ACK a message.
+    if (!message.pipelined)
+      target._send({ cmd: 'NODE_HANDLE_ACK' }, null, true);
 
     var obj = handleConversion[message.type];
 
@@ -563,7 +611,8 @@ function setupChannel(target, channel) {
       message = {
         cmd: 'NODE_HANDLE',
         type: null,
-        msg: message
+        msg: message,
+        pipelined: pipelineHandles
       };
 
       if (handle instanceof net.Socket) {
@@ -623,11 +672,21 @@ function setupChannel(target, channel) {
     var req = new WriteWrap();
     req.async = false;
 
-    var string = JSON.stringify(message) + '\n';
-    var err = channel.writeUtf8String(req, string, handle);
+    var err;
+    if (advanced) {
+      // The chunks are not copied, keep them alive until the write is done.
+      req._chunks = serialization.serialize(message);
+      err = channel.writev(req, req._chunks, handle);
+    } else {
+      var string = JSON.stringify(message) + '\n';
+      err = channel.writeUtf8String(req, string, handle);
+    }
 
     if (err === 0) {
-      if (handle) {
+      const pipelined = handle && pipelineHandles;
+      if (pipelined) {
+        target._pendingHandleWrites++;
+      } else if (handle) {
         if (!this._handleQueue)
           this._handleQueue = [];
         if (obj && obj.postSend)
@@ -637,6 +696,18 @@ function setupChannel(target, channel) {
       req.oncomplete = function() {
         if (this.async === true)
           control.unref();
+        if (pipelined) {
+          // The handle is in flight now, the receiver does not need ours.
+          if (obj && obj.postSend)
+            obj.postSend(handle, options);
+          // Process a pending disconnect (if any).
+          if (--target._pendingHandleWrites === 0 &&
+              !target.connected &&
+              target._channel &&
+              !target._handleQueue) {
+            target._disconnect();
+          }
+        }
         if (typeof callback === 'function')
           callback(null);
       };
@@ -687,7 +758,7 @@ function setupChannel(target, channel) {
     // If there are no queued messages, disconnect immediately. Otherwise,
     // postpone the disconnect so that it happens internally after the
     // queue is flushed.
-    if (!this._handleQueue)
+    if (!this._handleQueue && this._pendingHandleWrites === 0)
       this._disconnect();
   };
 
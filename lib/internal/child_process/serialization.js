@@ -0,0 +1,510 @@
+'use strict';
+
+// Binary serialization of IPC messages, used by child_process channels that
+// were created with `serialization: 'advanced'`.
+//
+// Values are encoded with a structured clone style format modelled on the
+// wire format of V8's ValueSerializer: every value starts with a one byte
+// tag, integers are zigzag encoded varints and objects that are seen more
+// than once, including cycles, are written as back references.  Strings are
+// stored as a uint32 byte length followed by UTF-8.
+//
+// A message is framed as a little endian uint32 length followed by the
+// encoded value; the framing is undone natively (see PipeWrap), so that
+// deserialize() is called once per complete message.  The contents of
+// Buffers and typed arrays are padded to an 8 byte boundary, which lets the
+// receiver create views on the message instead of copying them, and large
+// ones are copied into separate chunks of the same frame rather than into the
+// scratch buffer.  They are always copied, so that changes made to them
+// after send() returns can't end up in the message.
+
+const Buffer = require('buffer').Buffer;
+const kMaxLength = require('buffer').kMaxLength;
+
+const kVersion = 1;
+const kHeaderSize = 4;
+const kInitialSize = 16 * 1024;
+const kMaxIdleSize = 1024 * 1024;
+// Views of at least this many bytes get a chunk of their own.
+const kRawThreshold = 4096;
+// Short ASCII strings are copied into the message by hand, which is faster
+// than calling into the binding.
+const kShortString = 32;
+
+const kVersionTag = 0xff;
+const kUndefined = 0x5f;  // '_'
+const kNull = 0x30;  // '0'
+const kTrue = 0x54;  // 'T'
+const kFalse = 0x46;  // 'F'
+const kInt32 = 0x49;  // 'I'
+const kDouble = 0x4e;  // 'N'
+const kString = 0x53;  // 'S'
+const kBeginObject = 0x6f;  // 'o'
+const kEndObject = 0x7b;  // '{'
+const kBeginArray = 0x41;  // 'A'
+const kEndArray = 0x24;  // '$'
+const kHole = 0x2d;  // '-'
+const kDate = 0x44;  // 'D'
+const kRegExp = 0x52;  // 'R'
+const kBeginMap = 0x3b;  // ';'
+const kEndMap = 0x3a;  // ':'
+const kBeginSet = 0x27;  // '\''
+const kEndSet = 0x2c;  // ','
+const kArrayBuffer = 0x42;  // 'B'
+const kView = 0x56;  // 'V'
+const kObjectReference = 0x5e;  // '^'
+
+// Indexed by the type byte of kView.  Buffer has to stay last because it is
+// an instance of Uint8Array too.
+const viewTypes = [
+  Int8Array,
+  Uint8Array,
+  Uint8ClampedArray,
+  Int16Array,
+  Uint16Array,
+  Int32Array,
+  Uint32Array,
+  Float32Array,
+  Float64Array,
+  DataView,
+  Buffer
+];
+const kBufferType = viewTypes.length - 1;
+
+function Serializer() {
+  this.buffer = Buffer.allocUnsafe(kInitialSize);
+  this.pos = 0;
+  this.chunks = [];
+  this.size = 0;
+  this.refs = new Map();
+  this.busy = false;
+}
+
+Serializer.prototype.ensure = function(n) {
+  if (this.pos + n <= this.buffer.length)
+    return;
+  const size = Math.max(this.buffer.length * 2, this.pos + n);
+  const buffer = Buffer.allocUnsafe(size);
+  this.buffer.copy(buffer, 0, 0, this.pos);
+  this.buffer = buffer;
+};
+
+// Moves the bytes written so far out of the scratch buffer into a chunk of
+// their own.
+Serializer.prototype.flush = function() {
+  if (this.pos === 0)
+    return;
+  const chunk = Buffer.allocUnsafe(this.pos);
+  this.buffer.copy(chunk, 0, 0, this.pos);
+  this.chunks.push(chunk, 'buffer');
+  this.size += this.pos;
+  this.pos = 0;
+};
+
+Serializer.prototype.writeTag = function(tag) {
+  this.ensure(1);
+  this.buffer[this.pos++] = tag;
+};
+
+Serializer.prototype.writeVarint = function(n) {
+  this.ensure(5);
+  const buffer = this.buffer;
+  var pos = this.pos;
+  while (n >= 0x80) {
+    buffer[pos++] = (n & 0x7f) | 0x80;
+    n >>>= 7;
+  }
+  buffer[pos++] = n;
+  this.pos = pos;
+};
+
+Serializer.prototype.writeString = function(string) {
+  const length = string.length;
+  this.ensure(5 + length * 3);
+  const buffer = this.buffer;
+  const start = this.pos + 5;
+  var n = 0;
+  if (length <= kShortString) {
+    for (; n < length; n++) {
+      const c = string.charCodeAt(n);
+      if (c >= 0x80)
+        break;
+      buffer[start + n] = c;
+    }
+  }
+  if (n !== length)
+    n = buffer.write(string, start, 'utf8');
+  buffer[this.pos] = kString;
+  buffer.writeUInt32LE(n, this.pos + 1, true);
+  this.pos = start + n;
+};
+
+// Writes the payload of a view or ArrayBuffer, aligned to 8 bytes relative
+// to the start of the message.
+Serializer.prototype.writeBytes = function(bytes) {
+  const length = bytes.length;
+  this.writeVarint(length);
+  const offset = this.size + this.pos + 1 - kHeaderSize;
+  const padding = (8 - (offset & 7)) & 7;
+  this.ensure(1 + padding);
+  this.buffer[this.pos++] = padding;
+  this.buffer.fill(0, this.pos, this.pos + padding);
+  this.pos += padding;
+  if (length >= kRawThreshold) {
+    this.flush();
+    const chunk = Buffer.allocUnsafe(length);
+    bytes.copy(chunk, 0);
+    this.chunks.push(chunk, 'buffer');
+    this.size += length;
+  } else {
+    this.ensure(length);
+    this.pos += bytes.copy(this.buffer, this.pos);
+  }
+};
+
+Serializer.prototype.writeValue = function(value) {
+  switch (typeof value) {
+    case 'undefined':
+      this.writeTag(kUndefined);
+      return;
+    case 'boolean':
+      this.writeTag(value ? kTrue : kFalse);
+      return;
+    case 'number':
+      if ((value | 0) === value && (value !== 0 || 1 / value > 0)) {
+        this.writeTag(kInt32);
+        this.writeVarint(((value << 1) ^ (value >> 31)) >>> 0);
+      } else {
+        this.ensure(9);
+        this.buffer[this.pos] = kDouble;
+        this.buffer.writeDoubleLE(value, this.pos + 1, true);
+        this.pos += 9;
+      }
+      return;
+    case 'string':
+      this.writeString(value);
+      return;
+    case 'object':
+      if (value === null)
+        this.writeTag(kNull);
+      else
+        this.writeObject(value);
+      return;
+  }
+  throw new TypeError(`${typeof value} could not be cloned`);
+};
+
+Serializer.prototype.writeObject = function(object) {
+  const id = this.refs.get(object);
+  if (id !== undefined) {
+    this.writeTag(kObjectReference);
+    this.writeVarint(id);
+    return;
+  }
+  this.refs.set(object, this.refs.size);
+
+  var i;
+  if (Array.isArray(object)) {
+    const length = object.length;
+    this.writeTag(kBeginArray);
+    this.writeVarint(length);
+    for (i = 0; i < length; i++) {
+      if (i in object)
+        this.writeValue(object[i]);
+      else
+        this.writeTag(kHole);
+    }
+    this.writeTag(kEndArray);
+  } else if (ArrayBuffer.isView(object)) {
+    var type = kBufferType;
+    if (!Buffer.isBuffer(object)) {
+      for (type = 0; type < kBufferType; type++) {
+        if (object instanceof viewTypes[type])
+          break;
+      }
+    }
+    this.writeTag(kView);
+    this.writeTag(type);
+    this.writeBytes(Buffer.from(object.buffer,
+                                object.byteOffset,
+                                object.byteLength));
+  } else if (object instanceof ArrayBuffer) {
+    this.writeTag(kArrayBuffer);
+    this.writeBytes(Buffer.from(object));
+  } else if (object instanceof Date) {
+    this.ensure(9);
+    this.buffer[this.pos] = kDate;
+    this.buffer.writeDoubleLE(object.getTime(), this.pos + 1, true);
+    this.pos += 9;
+  } else if (object instanceof RegExp) {
+    this.writeTag(kRegExp);
+    this.writeString(object.source);
+    this.writeString(object.flags);
+  } else if (object instanceof Map) {
+    this.writeTag(kBeginMap);
+    for (const entry of object) {
+      this.writeValue(entry[0]);
+      this.writeValue(entry[1]);
+    }
+    this.writeTag(kEndMap);
+  } else if (object instanceof Set) {
+    this.writeTag(kBeginSet);
+    for (const value of object)
+      this.writeValue(value);
+    this.writeTag(kEndSet);
+  } else {
+    const keys = Object.keys(object);
+    this.writeTag(kBeginObject);
+    for (i = 0; i < keys.length; i++) {
+      this.writeString(keys[i]);
+      this.writeValue(object[keys[i]]);
+    }
+    this.writeTag(kEndObject);
+  }
+};
+
+// Returns the frame as an array of alternating chunks and encodings, in the
+// form that StreamBase::Writev() expects.
+Serializer.prototype.serialize = function(value) {
+  this.pos = kHeaderSize;
+  this.buffer[this.pos++] = kVersionTag;
+  this.buffer[this.pos++] = kVersion;
+  this.writeValue(value);
+  this.flush();
+
+  const chunks = this.chunks;
+  const length = this.size - kHeaderSize;
+  if (length > kMaxLength)
+    throw new RangeError('Message is too large to be sent');
+  chunks[0].writeUInt32LE(length, 0, true);
+  return chunks;
+};
+
+Serializer.prototype.reset = function() {
+  this.pos = 0;
+  this.chunks = [];
+  this.size = 0;
+  this.refs.clear();
+  if (this.buffer.length > kMaxIdleSize)
+    this.buffer = Buffer.allocUnsafe(kInitialSize);
+};
+
+var cachedSerializer = null;
+
+function serialize(value) {
+  // Getters can send messages while a message is being serialized.
+  var serializer = cachedSerializer;
+  if (serializer === null || serializer.busy)
+    serializer = new Serializer();
+  else
+    cachedSerializer = null;
+
+  serializer.busy = true;
+  try {
+    return serializer.serialize(value);
+  } finally {
+    serializer.reset();
+    serializer.busy = false;
+    cachedSerializer = serializer;
+  }
+}
+
+
+function Deserializer(buffer) {
+  this.buffer = buffer;
+  this.pos = 0;
+  this.refs = [];
+}
+
+function invalid() {
+  return new Error('Unable to deserialize cloned data');
+}
+
+Deserializer.prototype.readTag = function() {
+  if (this.pos >= this.buffer.length)
+    throw invalid();
+  return this.buffer[this.pos++];
+};
+
+Deserializer.prototype.readVarint = function() {
+  var n = 0;
+  var shift = 0;
+  var byte;
+  do {
+    if (shift > 28)
+      throw invalid();
+    byte = this.readTag();
+    n += (byte & 0x7f) * Math.pow(2, shift);
+    shift += 7;
+  } while (byte & 0x80);
+  return n;
+};
+
+Deserializer.prototype.readDouble = function() {
+  const value = this.buffer.readDoubleLE(this.pos);
+  this.pos += 8;
+  return value;
+};
+
+Deserializer.prototype.readString = function() {
+  const length = this.buffer.readUInt32LE(this.pos);
+  const start = this.pos + 4;
+  const end = start + length;
+  if (end > this.buffer.length)
+    throw invalid();
+  this.pos = end;
+  return this.buffer.utf8Slice(start, end);
+};
+
+// Returns the offset of the payload written by writeBytes().
+Deserializer.prototype.readBytes = function(length) {
+  const padding = this.readTag();
+  const start = this.pos + padding;
+  if (padding > 7 || start + length > this.buffer.length)
+    throw invalid();
+  this.pos = start + length;
+  return start;
+};
+
+Deserializer.prototype.readView = function() {
+  const type = this.readTag();
+  if (type >= viewTypes.length)
+    throw invalid();
+  const length = this.readVarint();
+  const start = this.readBytes(length);
+  const buffer = this.buffer;
+
+  if (type === kBufferType)
+    return buffer.slice(start, start + length);
+
+  const Ctor = viewTypes[type];
+  const byteOffset = buffer.byteOffset + start;
+  if (Ctor === DataView)
+    return new DataView(buffer.buffer, byteOffset, length);
+
+  const size = Ctor.BYTES_PER_ELEMENT;
+  if (length % size !== 0)
+    throw invalid();
+  if (byteOffset % size === 0)
+    return new Ctor(buffer.buffer, byteOffset, length / size);
+
+  const view = new Ctor(length / size);
+  buffer.copy(Buffer.from(view.buffer), 0, start, start + length);
+  return view;
+};
+
+Deserializer.prototype.readValue = function() {
+  const tag = this.readTag();
+  const refs = this.refs;
+  var value, i, length;
+
+  switch (tag) {
+    case kUndefined:
+      return undefined;
+    case kNull:
+      return null;
+    case kTrue:
+      return true;
+    case kFalse:
+      return false;
+    case kInt32:
+      value = this.readVarint();
+      return (value % 2 === 0 ? value / 2 : -(value + 1) / 2) | 0;
+    case kDouble:
+      return this.readDouble();
+    case kString:
+      return this.readString();
+    case kBeginObject:
+      value = {};
+      refs.push(value);
+      while ((i = this.readTag()) !== kEndObject) {
+        if (i !== kString)
+          throw invalid();
+        // Not value[key], which would run the __proto__ setter.
+        Object.defineProperty(value, this.readString(), {
+          value: this.readValue(),
+          writable: true,
+          enumerable: true,
+          configurable: true
+        });
+      }
+      return value;
+    case kBeginArray:
+      length = this.readVarint();
+      value = new Array(length);
+      refs.push(value);
+      for (i = 0; i < length; i++) {
+        if (this.buffer[this.pos] === kHole)
+          this.pos++;
+        else
+          value[i] = this.readValue();
+      }
+      if (this.readTag() !== kEndArray)
+        throw invalid();
+      return value;
+    case kDate:
+      value = new Date(this.readDouble());
+      refs.push(value);
+      return value;
+    case kRegExp:
+      i = refs.push(null) - 1;
+      if (this.readTag() !== kString)
+        throw invalid();
+      value = this.readString();
+      if (this.readTag() !== kString)
+        throw invalid();
+      value = refs[i] = new RegExp(value, this.readString());
+      return value;
+    case kBeginMap:
+      value = new Map();
+      refs.push(value);
+      while (this.buffer[this.pos] !== kEndMap) {
+        const key = this.readValue();
+        value.set(key, this.readValue());
+      }
+      this.pos++;
+      return value;
+    case kBeginSet:
+      value = new Set();
+      refs.push(value);
+      while (this.buffer[this.pos] !== kEndSet)
+        value.add(this.readValue());
+      this.pos++;
+      return value;
+    case kArrayBuffer:
+      length = this.readVarint();
+      i = this.readBytes(length) + this.buffer.byteOffset;
+      value = this.buffer.buffer.slice(i, i + length);
+      refs.push(value);
+      return value;
+    case kView:
+      i = refs.push(null) - 1;
+      value = refs[i] = this.readView();
+      return value;
+    case kObjectReference:
+      i = this.readVarint();
+      if (i >= refs.length || refs[i] === null)
+        throw invalid();
+      return refs[i];
+  }
+  throw invalid();
+};
+
+// Decodes a message without its length prefix.  Buffers and typed arrays in
+// the message share memory with |buffer|.
+function deserialize(buffer) {
+  const deserializer = new Deserializer(buffer);
+  if (deserializer.readTag() !== kVersionTag ||
+      deserializer.readTag() !== kVersion) {
+    throw invalid();
+  }
+  const value = deserializer.readValue();
+  if (deserializer.pos !== buffer.length)
+    throw invalid();
+  return value;
+}
+
+module.exports = {
+  serialize,
+  deserialize
+};
@@ -0,0 +1,199 @@
+'use strict';
+
+// Module bundles pack the sources of many modules, and optionally their V8
+// code cache, into a single file that is mapped into memory once instead of
+// opening and reading every module separately.
+//
+// Layout, with all integers stored as little endian uint32:
+//
+//   magic     'NODEMBDL'
+//   version   2
+//   count     number of entries
+//   entries   count times:
+//               name length, name (UTF-8, the absolute filename)
+//               source offset, source length
+//               code cache offset, code cache length (0 if none)
+//               mtime of the file in milliseconds (little endian double)
+//   data      sources and code caches, referenced by offset from the start
+//             of the file
+//
+// An entry is only used while the size and mtime of its file still match,
+// so that a file edited after the bundle was built is read from disk.
+
+const Buffer = require('buffer').Buffer;
+const fs = require('fs');
+const path = require('path');
+const vm = require('vm');
+const internalModule = require('internal/module');
+
+const kMagic = 'NODEMBDL';
+const kVersion = 2;
+const kHeaderSize = kMagic.length + 8;
+const kEntrySize = 24;
+
+function BundleEntry(buffer, sourceStart, sourceEnd, cacheStart, cacheEnd,
+                     mtime) {
+  this.buffer = buffer;
+  this.sourceStart = sourceStart;
+  this.sourceEnd = sourceEnd;
+  this.cacheStart = cacheStart;
+  this.cacheEnd = cacheEnd;
+  this.mtime = mtime;
+}
+
+// Returns true if |filename| still has the size and mtime it had when the
+// bundle was created.
+BundleEntry.prototype.isCurrent = function(filename) {
+  var stats;
+  try {
+    stats = fs.statSync(filename);
+  } catch (e) {
+    return false;
+  }
+  return stats.size === this.sourceEnd - this.sourceStart &&
+         stats.mtime.getTime() === this.mtime;
+};
+
+BundleEntry.prototype.source = function() {
+  return this.buffer.toString('utf8', this.sourceStart, this.sourceEnd);
+};
+
+BundleEntry.prototype.cachedData = function() {
+  if (this.cacheStart === this.cacheEnd)
+    return undefined;
+  return this.buffer.slice(this.cacheStart, this.cacheEnd);
+};
+
+function Bundle(filename, buffer) {
+  this.filename = filename;
+  this.entries = new Map();
+
+  const invalid = () => new Error(`Invalid module bundle: ${filename}`);
+
+  if (buffer.length < kHeaderSize ||
+      buffer.toString('latin1', 0, kMagic.length) !== kMagic ||
+      buffer.readUInt32LE(kMagic.length) !== kVersion) {
+    throw invalid();
+  }
+
+  const count = buffer.readUInt32LE(kMagic.length + 4);
+  var offset = kHeaderSize;
+  for (var i = 0; i < count; i++) {
+    if (offset + 4 > buffer.length)
+      throw invalid();
+    const nameLength = buffer.readUInt32LE(offset);
+    const nameEnd = offset + 4 + nameLength;
+    if (nameEnd + kEntrySize > buffer.length)
+      throw invalid();
+    const name = buffer.toString('utf8', offset + 4, nameEnd);
+    const sourceStart = buffer.readUInt32LE(nameEnd);
+    const sourceEnd = sourceStart + buffer.readUInt32LE(nameEnd + 4);
+    const cacheStart = buffer.readUInt32LE(nameEnd + 8);
+    const cacheEnd = cacheStart + buffer.readUInt32LE(nameEnd + 12);
+    const mtime = buffer.readDoubleLE(nameEnd + 16);
+    if (sourceEnd > buffer.length || cacheEnd > buffer.length)
+      throw invalid();
+    this.entries.set(name, new BundleEntry(buffer, sourceStart, sourceEnd,
+                                           cacheStart, cacheEnd, mtime));
+    offset = nameEnd + kEntrySize;
+  }
+}
+
+// Returns the entry for |filename|, or undefined if there is none or the file
+// has changed since the bundle was created.
+Bundle.prototype.get = function(filename) {
+  const entry = this.entries.get(filename);
+  if (entry === undefined || !entry.isCurrent(filename))
+    return undefined;
+  return entry;
+};
+
+function loadBundle(filename) {
+  var buffer;
+  try {
+    buffer = fs.mapFileSync(filename);
+  } catch (e) {
+    // Memory mapping is not available everywhere (e.g. UWP).
+    if (e.code !== 'ENOSYS')
+      throw e;
+    buffer = fs.readFileSync(filename);
+  }
+  return new Bundle(filename, buffer);
+}
+
+// Writes the files in |filenames| to the bundle |filename|.  Entries are
+// keyed by real path, which is what require() resolves to.  With
+// options.codeCache, the code cache of each .js module is included; it is
+// only used by the same version of node with the same V8 flags, otherwise V8
+// rejects it and compiles the source as usual.
+function createBundle(filename, filenames, options) {
+  if (!Array.isArray(filenames))
+    throw new TypeError('"filenames" argument must be an array');
+  options = options || {};
+
+  const wrap = require('module').wrap;
+  const entries = [];
+  var indexSize = kHeaderSize;
+  var dataSize = 0;
+
+  for (var i = 0; i < filenames.length; i++) {
+    const name = fs.realpathSync(path.resolve(filenames[i]));
+    const source = fs.readFileSync(name);
+    const mtime = fs.statSync(name).mtime.getTime();
+    var cachedData = null;
+
+    if (options.codeCache && path.extname(name) === '.js') {
+      // Must match what Module.prototype._compile() compiles.
+      const content = internalModule.stripShebang(
+          internalModule.stripBOM(source.toString('utf8')));
+      const script = new vm.Script(wrap(content), {
+        filename: name,
+        produceCachedData: true
+      });
+      if (script.cachedDataProduced)
+        cachedData = script.cachedData;
+    }
+
+    const nameBuffer = Buffer.from(name, 'utf8');
+    entries.push({ name: nameBuffer, source, cachedData, mtime });
+    indexSize += 4 + nameBuffer.length + kEntrySize;
+    dataSize += source.length + (cachedData ? cachedData.length : 0);
+  }
+
+  if (indexSize + dataSize > 0xffffffff)
+    throw new RangeError('Module bundle too large');
+
+  const buffer = Buffer.allocUnsafe(indexSize + dataSize);
+  buffer.write(kMagic, 0, kMagic.length, 'latin1');
+  buffer.writeUInt32LE(kVersion, kMagic.length);
+  buffer.writeUInt32LE(entries.length, kMagic.length + 4);
+
+  var offset = kHeaderSize;
+  var dataOffset = indexSize;
+  for (i = 0; i < entries.length; i++) {
+    const entry = entries[i];
+    offset = buffer.writeUInt32LE(entry.name.length, offset);
+    offset += entry.name.copy(buffer, offset);
+
+    offset = buffer.writeUInt32LE(dataOffset, offset);
+    offset = buffer.writeUInt32LE(entry.source.length, offset);
+    dataOffset += entry.source.copy(buffer, dataOffset);
+
+    if (entry.cachedData) {
+      offset = buffer.writeUInt32LE(dataOffset, offset);
+      offset = buffer.writeUInt32LE(entry.cachedData.length, offset);
+      dataOffset += entry.cachedData.copy(buffer, dataOffset);
+    } else {
+      offset = buffer.writeUInt32LE(0, offset);
+      offset = buffer.writeUInt32LE(0, offset);
+    }
+    offset = buffer.writeDoubleLE(entry.mtime, offset);
+  }
+
+  fs.writeFileSync(filename, buffer);
+}
+
+module.exports = {
+  createBundle,
+  loadBundle
+};
@@ -11,6 +11,8 @@ function lazyConstants() {
 
 exports.setup_cpuUsage = setup_cpuUsage;
 exports.setup_hrtime = setup_hrtime;
+exports.setup_threadpoolUsage = setup_threadpoolUsage;
+exports.setup_eventLoopHistograms = setup_eventLoopHistograms;
 exports.setupConfig = setupConfig;
 exports.setupKillAndExit = setupKillAndExit;
 exports.setupSignalHandlers = setupSignalHandlers;
@@ -99,6 +101,107 @@ function setup_hrtime() {
 }
 
 
+// Set up the process.threadpoolUsage() function.
+function setup_threadpoolUsage() {
+  const _threadpoolUsage = process.threadpoolUsage;
+
+  // In the order of uv_work_kind in uv.h.
+  const kWorkKinds = ['cpu', 'fastIO', 'slowIO'];
+  const kWaitBuckets = _threadpoolUsage.kWaitBuckets;
+  const tpValues =
+      new Float64Array(5 + _threadpoolUsage.kWorkKinds * kWaitBuckets);
+
+  process.threadpoolUsage = function threadpoolUsage() {
+    const errmsg = _threadpoolUsage(tpValues);
+    if (errmsg) {
+      throw new Error('unable to obtain threadpool usage: ' + errmsg);
+    }
+
+    const waitTime = {};
+    for (var i = 0; i < kWorkKinds.length; i++) {
+      const start = 5 + i * kWaitBuckets;
+      waitTime[kWorkKinds[i]] =
+          Array.from(tpValues.subarray(start, start + kWaitBuckets));
+    }
+
+    return {
+      minThreads: tpValues[0],
+      maxThreads: tpValues[1],
+      threads: tpValues[2],
+      idleThreads: tpValues[3],
+      activeThreads: tpValues[2] - tpValues[3],
+      queued: tpValues[4],
+      waitTime: waitTime
+    };
+  };
+}
+
+
+// Set up the process.eventLoopHistograms() function.
+function setup_eventLoopHistograms() {
+  const _eventLoopHistograms = process.eventLoopHistograms;
+
+  // Keep in sync with Environment::LoopHistogram in env.h and Histogram in
+  // histogram.h.
+  const kNames = ['iteration', 'pollWait', 'callback'];
+  const kSubBuckets = 8;
+  const kBucketCount = 304;
+  const kFieldCount = 4 + kBucketCount;
+  const values = new Float64Array(kNames.length * kFieldCount);
+
+  // The smallest value that is counted in each bucket.
+  const bucketBounds = new Array(kBucketCount);
+  for (var i = 0; i < kBucketCount; i++) {
+    if (i < 2 * kSubBuckets) {
+      bucketBounds[i] = i;
+    } else {
+      const shift = Math.floor(i / kSubBuckets) - 1;
+      bucketBounds[i] = (i - shift * kSubBuckets) * Math.pow(2, shift);
+    }
+  }
+
+  process.eventLoopHistograms = function eventLoopHistograms(reset) {
+    if (!_eventLoopHistograms(values, !!reset))
+      return null;
+
+    const result = {};
+    for (var i = 0; i < kNames.length; i++) {
+      const start = i * kFieldCount;
+      const count = values[start];
+      const min = values[start + 1];
+      const buckets =
+          Array.from(values.subarray(start + 4, start + kFieldCount));
+      result[kNames[i]] = {
+        count: count,
+        min: min,
+        max: values[start + 2],
+        mean: count > 0 ? values[start + 3] / count : 0,
+        p50: percentile(buckets, count, min, 0.5),
+        p90: percentile(buckets, count, min, 0.9),
+        p99: percentile(buckets, count, min, 0.99),
+        buckets: buckets
+      };
+    }
+    result.bucketBounds = bucketBounds.slice();
+    return result;
+  };
+
+  // Returns the lower bound of the bucket that holds the value of rank p.
+  function percentile(buckets, count, min, p) {
+    if (count === 0)
+      return 0;
+    const rank = Math.ceil(count * p);
+    var seen = 0;
+    for (var i = 0; i < buckets.length; i++) {
+      seen += buckets[i];
+      if (seen >= rank)
+        return Math.max(min, bucketBounds[i]);
+    }
+    return bucketBounds[buckets.length - 1];
+  }
+}
+
+
 function setupConfig(_source) {
   // NativeModule._source
   // used for `process.config`, but not a real module
@@ -229,8 +332,12 @@ function setupChannel() {
     var fd = parseInt(process.env.NODE_CHANNEL_FD, 10);
     assert(fd >= 0);
 
+    const serializationMode =
+        process.env.NODE_CHANNEL_SERIALIZATION_MODE || 'json';
+
     // Make sure it's not accidentally inherited by child processes.
     delete process.env.NODE_CHANNEL_FD;
+    delete process.env.NODE_CHANNEL_SERIALIZATION_MODE;
 
     var cp = require('child_process');
 
@@ -239,7 +346,7 @@ function setupChannel() {
     // FIXME is this really necessary?
     process.binding('tcp_wrap');
 
-    cp._forkChild(fd);
+    cp._forkChild(fd, serializationMode);
     assert(process.send);
   }
 }
@@ -2,18 +2,34 @@
 
 exports.setup = setupNextTick;
 
+// Initial and minimum capacity of the tick queue. Must be a power of two.
+const kInitialCapacity = 1024;
+// A drained queue that has grown beyond this is shrunk back to the initial
+// capacity, so that a burst of ticks does not pin its memory forever.
+const kMaxIdleCapacity = 64 * 1024;
+
 function setupNextTick() {
   const promises = require('internal/process/promises');
   const emitPendingUnhandledRejections = promises.setup(scheduleMicrotasks);
-  var nextTickQueue = [];
   var microtasksScheduled = false;
 
+  // The queue of pending ticks is a ring buffer of parallel arrays, so that
+  // queueing a tick does not allocate. `head` is the slot of the next tick to
+  // run, `queued` is the number of pending ticks. The capacity is always a
+  // power of two and doubles when the queue is full.
+  var capacity = kInitialCapacity;
+  var mask = capacity - 1;
+  var callbacks = new Array(capacity);
+  var argsList = new Array(capacity);
+  var domains = new Array(capacity);
+  var head = 0;
+  var queued = 0;
+
   // Used to run V8's micro task queue.
   var _runMicrotasks = {};
 
   // *Must* match Environment::TickInfo::Fields in src/env.h.
-  var kIndex = 0;
-  var kLength = 1;
+  var kLength = 0;
 
   process.nextTick = nextTick;
   // Needs to be accessible from beyond this scope.
@@ -22,34 +38,58 @@ function setupNextTick() {
 
   // This tickInfo thing is used so that the C++ code in src/node.cc
   // can have easy access to our nextTick state, and avoid unnecessary
-  // calls into JS land.
+  // calls into JS land. tickInfo[kLength] is updated whenever a tick is
+  // queued and when the queue is drained, it may overestimate the number of
+  // pending ticks in between but never underestimates it.
   const tickInfo = process._setupNextTick(_tickCallback, _runMicrotasks);
 
   _runMicrotasks = _runMicrotasks.runMicrotasks;
 
+  function push(callback, args, domain) {
+    if (queued === capacity)
+      grow();
+    const slot = (head + queued) & mask;
+    callbacks[slot] = callback;
+    argsList[slot] = args;
+    domains[slot] = domain;
+    tickInfo[kLength] = ++queued;
+  }
+
+  function grow() {
+    const newCallbacks = new Array(capacity * 2);
+    const newArgsList = new Array(capacity * 2);
+    const newDomains = new Array(capacity * 2);
+    for (var i = 0; i < queued; i++) {
+      const slot = (head + i) & mask;
+      newCallbacks[i] = callbacks[slot];
+      newArgsList[i] = argsList[slot];
+      newDomains[i] = domains[slot];
+    }
+    callbacks = newCallbacks;
+    argsList = newArgsList;
+    domains = newDomains;
+    capacity *= 2;
+    mask = capacity - 1;
+    head = 0;
+  }
+
   function tickDone() {
-    if (tickInfo[kLength] !== 0) {
-      if (tickInfo[kLength] <= tickInfo[kIndex]) {
-        nextTickQueue = [];
-        tickInfo[kLength] = 0;
-      } else {
-        nextTickQueue.splice(0, tickInfo[kIndex]);
-        tickInfo[kLength] = nextTickQueue.length;
-      }
+    tickInfo[kLength] = queued;
+    if (queued === 0 && capacity > kMaxIdleCapacity) {
+      capacity = kInitialCapacity;
+      mask = capacity - 1;
+      callbacks = new Array(capacity);
+      argsList = new Array(capacity);
+      domains = new Array(capacity);
+      head = 0;
     }
-    tickInfo[kIndex] = 0;
   }
 
   function scheduleMicrotasks() {
     if (microtasksScheduled)
       return;
 
-    nextTickQueue.push({
-      callback: runMicrotasksCallback,
-      domain: null
-    });
-
-    tickInfo[kLength]++;
+    push(runMicrotasksCallback, undefined, null);
     microtasksScheduled = true;
   }
 
@@ -57,8 +97,7 @@ function setupNextTick() {
     microtasksScheduled = false;
     _runMicrotasks();
 
-    if (tickInfo[kIndex] < tickInfo[kLength] ||
-        emitPendingUnhandledRejections())
+    if (queued !== 0 || emitPendingUnhandledRejections())
       scheduleMicrotasks();
   }
 
@@ -84,57 +123,58 @@ function setupNextTick() {
 
   // Run callbacks that have no domain.
   // Using domains will cause this to be overridden.
+  //
+  // The whole queue, including ticks that are queued while it is processed,
+  // runs before the microtask queue. The slot of each tick is released before
+  // its callback runs, so that processing resumes with the next tick if the
+  // callback throws.
   function _tickCallback() {
-    var callback, args, tock;
+    var callback, args, slot;
 
     do {
-      while (tickInfo[kIndex] < tickInfo[kLength]) {
-        tock = nextTickQueue[tickInfo[kIndex]++];
-        callback = tock.callback;
-        args = tock.args;
+      while (queued !== 0) {
+        slot = head;
+        callback = callbacks[slot];
+        args = argsList[slot];
+        callbacks[slot] = argsList[slot] = domains[slot] = undefined;
+        head = (slot + 1) & mask;
+        queued--;
         // Using separate callback execution functions allows direct
         // callback invocation with small numbers of arguments to avoid the
         // performance hit associated with using `fn.apply()`
         _combinedTickCallback(args, callback);
-        if (1e4 < tickInfo[kIndex])
-          tickDone();
       }
       tickDone();
       _runMicrotasks();
       emitPendingUnhandledRejections();
-    } while (tickInfo[kLength] !== 0);
+    } while (queued !== 0);
   }
 
   function _tickDomainCallback() {
-    var callback, domain, args, tock;
+    var callback, domain, args, slot;
 
     do {
-      while (tickInfo[kIndex] < tickInfo[kLength]) {
-        tock = nextTickQueue[tickInfo[kIndex]++];
-        callback = tock.callback;
-        domain = tock.domain;
-        args = tock.args;
+      while (queued !== 0) {
+        slot = head;
+        callback = callbacks[slot];
+        args = argsList[slot];
+        domain = domains[slot];
+        callbacks[slot] = argsList[slot] = domains[slot] = undefined;
+        head = (slot + 1) & mask;
+        queued--;
         if (domain)
           domain.enter();
         // Using separate callback execution functions allows direct
         // callback invocation with small numbers of arguments to avoid the
         // performance hit associated with using `fn.apply()`
         _combinedTickCallback(args, callback);
-        if (1e4 < tickInfo[kIndex])
-          tickDone();
         if (domain)
           domain.exit();
       }
       tickDone();
       _runMicrotasks();
       emitPendingUnhandledRejections();
-    } while (tickInfo[kLength] !== 0);
-  }
-
-  function TickObject(c, args) {
-    this.callback = c;
-    this.domain = process.domain || null;
-    this.args = args;
+    } while (queued !== 0);
   }
 
   function nextTick(callback) {
@@ -151,7 +191,6 @@ function setupNextTick() {
         args[i - 1] = arguments[i];
     }
 
-    nextTickQueue.push(new TickObject(callback, args));
-    tickInfo[kLength]++;
+    push(callback, args, process.domain || null);
   }
 }
@@ -3,6 +3,7 @@
 const NativeModule = require('native_module');
 const util = require('util');
 const internalModule = require('internal/module');
+const moduleBundle = require('internal/module_bundle');
 const internalUtil = require('internal/util');
 const vm = require('vm');
 const assert = require('assert').ok;
@@ -10,6 +11,11 @@ const fs = require('fs');
 const path = require('path');
 const internalModuleReadFile = process.binding('fs').internalModuleReadFile;
 const internalModuleStat = process.binding('fs').internalModuleStat;
+// The native resolver is not available on Windows.
+const internalModuleResolve = process.binding('fs').internalModuleResolve;
+const internalModuleStatCache = process.binding('fs').internalModuleStatCache;
+const internalModuleClearCache =
+    process.binding('fs').internalModuleClearCache;
 const preserveSymlinks = !!process.binding('config').preserveSymlinks;
 
 // If obj.hasOwnProperty has been overridden, then calling
@@ -33,6 +39,12 @@ function stat(filename) {
 }
 stat.cache = null;
 
+function setStatCache(enable) {
+  stat.cache = enable ? new Map() : null;
+  if (internalModuleStatCache !== undefined)
+    internalModuleStatCache(enable);
+}
+
 
 function Module(id, parent) {
   this.id = id;
@@ -49,7 +61,12 @@ function Module(id, parent) {
 module.exports = Module;
 
 Module._cache = {};
+// The module bundle that sources are read from, if any.
+var bundle = null;
 Module._pathCache = {};
+// Kept in Module._pathCache while the cache of the native resolver is valid.
+// JSON cache keys can't collide with it.
+const kNativeCacheMarker = '\u0000native';
 Module._extensions = {};
 var modulePaths = [];
 Module.globalPaths = [];
@@ -141,6 +158,25 @@ Module._findPath = function(request, paths, isMain) {
     return false;
   }
 
+  // The native resolver does everything below in one call, and gives up
+  // (returns undefined) on anything it can't reproduce exactly.  require('.')
+  // is left to the JS version for the deprecation warning.
+  if (internalModuleResolve !== undefined && request !== '.') {
+    // The resolver caches its results itself.  User land clears
+    // Module._pathCache to have modules resolved again, which drops the
+    // marker, so the native cache is cleared along with it.
+    if (Module._pathCache[kNativeCacheMarker] !== true) {
+      internalModuleClearCache();
+      Module._pathCache[kNativeCacheMarker] = true;
+    }
+    const filename = internalModuleResolve(request,
+                                           paths,
+                                           Object.keys(Module._extensions),
+                                           preserveSymlinks && !isMain);
+    if (filename !== undefined)
+      return filename;
+  }
+
   const cacheKey = JSON.stringify({request: request, paths: paths});
   if (Module._pathCache[cacheKey]) {
     return Module._pathCache[cacheKey];
@@ -497,34 +533,9 @@ var resolvedArgv;
 // the correct helper variables (require, module, exports) to
 // the file.
 // Returns exception, if any.
-Module.prototype._compile = function(content, filename) {
-  // Remove shebang
-  var contLen = content.length;
-  if (contLen >= 2) {
-    if (content.charCodeAt(0) === 35/*#*/ &&
-        content.charCodeAt(1) === 33/*!*/) {
-      if (contLen === 2) {
-        // Exact match
-        content = '';
-      } else {
-        // Find end of shebang line and slice it off
-        var i = 2;
-        for (; i < contLen; ++i) {
-          var code = content.charCodeAt(i);
-          if (code === 10/*\n*/ || code === 13/*\r*/)
-            break;
-        }
-        if (i === contLen)
-          content = '';
-        else {
-          // Note that this actually includes the newline character(s) in the
-          // new output. This duplicates the behavior of the regular expression
-          // that was previously used to replace the shebang line
-          content = content.slice(i);
-        }
-      }
-    }
-  }
+// |cachedData| is the V8 code cache for the wrapped |content|, if any.
+Module.prototype._compile = function(content, filename, cachedData) {
+  content = internalModule.stripShebang(content);
 
   // create wrapper function
   var wrapper = Module.wrap(content);
@@ -532,7 +543,8 @@ Module.prototype._compile = function(content, filename) {
   var compiledWrapper = vm.runInThisContext(wrapper, {
     filename: filename,
     lineOffset: 0,
-    displayErrors: true
+    displayErrors: true,
+    cachedData: cachedData
   });
 
   if (process._debugWaitConnect) {
@@ -556,15 +568,29 @@ Module.prototype._compile = function(content, filename) {
   var require = internalModule.makeRequireFunction.call(this);
   var args = [this.exports, require, this, filename, dirname];
   var depth = internalModule.requireDepth;
-  if (depth === 0) stat.cache = new Map();
-  var result = compiledWrapper.apply(this.exports, args);
-  if (depth === 0) stat.cache = null;
-  return result;
+  if (depth !== 0)
+    return compiledWrapper.apply(this.exports, args);
+  // The cache must not outlive a module that throws, or require.resolve()
+  // and later require() calls would see files as they were before.
+  setStatCache(true);
+  try {
+    return compiledWrapper.apply(this.exports, args);
+  } finally {
+    setStatCache(false);
+  }
 };
 
 
 // Native extension for .js
 Module._extensions['.js'] = function(module, filename) {
+  const entry = bundle !== null ? bundle.get(filename) : undefined;
+  if (entry !== undefined) {
+    module._compile(internalModule.stripBOM(entry.source()),
+                    filename,
+                    entry.cachedData());
+    return;
+  }
+
   var content = fs.readFileSync(filename, 'utf8');
   module._compile(internalModule.stripBOM(content), filename);
 };
@@ -572,7 +598,9 @@ Module._extensions['.js'] = function(module, filename) {
 
 // Native extension for .json
 Module._extensions['.json'] = function(module, filename) {
-  var content = fs.readFileSync(filename, 'utf8');
+  const entry = bundle !== null ? bundle.get(filename) : undefined;
+  var content = entry !== undefined ? entry.source() :
+                                      fs.readFileSync(filename, 'utf8');
   try {
     module.exports = JSON.parse(internalModule.stripBOM(content));
   } catch (err) {
@@ -659,5 +687,33 @@ Module._preloadModules = function(requests) {
 
 Module._initPaths();
 
+// Packs the given files into a module bundle.
+Module.createBundle = moduleBundle.createBundle;
+
+// Makes require() read the sources of the modules in the bundle |filename|
+// from the bundle rather than from their files.
+Module.loadBundle = function(filename) {
+  bundle = moduleBundle.loadBundle(path.resolve(filename));
+};
+
+if (process.env.NODE_MODULE_BUNDLE) {
+  try {
+    Module.loadBundle(process.env.NODE_MODULE_BUNDLE);
+  } catch (e) {
+    process.emitWarning(`Not using NODE_MODULE_BUNDLE: ${e.message}`);
+  }
+}
+
+// NODE_RESOLVE_MANIFEST names a file that the resolved module filenames are
+// loaded from on startup and saved to on exit, so that the next process can
+// skip most of the lookups.
+if (internalModuleResolve !== undefined) {
+  Module._pathCache[kNativeCacheMarker] = true;
+  if (process.env.NODE_RESOLVE_MANIFEST) {
+    const manifest = path.resolve(process.env.NODE_RESOLVE_MANIFEST);
+    process.binding('fs').internalModuleLoadManifest(manifest);
+  }
+}
+
 // backwards compatibility
 Module.Module = Module;
@@ -21,6 +21,7 @@ const WriteWrap = process.binding('stream_wrap').WriteWrap;
 
 
 var cluster;
+var fs;
 const errnoException = util._errnoException;
 const exceptionWithHostPort = util._exceptionWithHostPort;
 const isLegalPort = internalNet.isLegalPort;
@@ -115,6 +116,8 @@ function initSocketHandle(self) {
 
 
 const BYTES_READ = Symbol('bytesRead');
+const kSendFile = Symbol('sendFile');
+const kSendFileChunk = 64 * 1024;
 
 
 function Socket(options) {
@@ -161,6 +164,7 @@ function Socket(options) {
 
   this._pendingData = null;
   this._pendingEncoding = '';
+  this._sendFileReq = null;
 
   // handle strings directly
   this._writableState.decodeStrings = false;
@@ -488,6 +492,10 @@ Socket.prototype._destroy = function(exception, cb) {
     // `bytesRead` should be accessible after `.destroy()`
     this[BYTES_READ] = this._handle.bytesRead;
 
+    // A sendFile() in progress holds its own reference to the socket.
+    if (this._sendFileReq)
+      this._handle.abortSendFile();
+
     this._handle.close(() => {
       debug('emit close');
       this.emit('close', isException);
@@ -716,14 +724,165 @@ Socket.prototype._writeGeneric = function(writev, data, encoding, cb) {
 
 
 Socket.prototype._writev = function(chunks, cb) {
-  this._writeGeneric(true, chunks, '', cb);
+  // sendFile() requests are queued as empty marker buffers; write whatever
+  // precedes one, then the file, then recurse on whatever follows it.
+  var i = 0;
+  while (i < chunks.length && chunks[i].chunk[kSendFile] === undefined)
+    i++;
+
+  if (i === chunks.length) {
+    this._writeGeneric(true, chunks, '', cb);
+    return;
+  }
+
+  const info = chunks[i].chunk[kSendFile];
+  const rest = chunks.slice(i + 1);
+  const afterFile = rest.length === 0 ? cb : (err) => {
+    if (err) return cb(err);
+    this._writev(rest, cb);
+  };
+
+  if (i === 0) {
+    this._sendFile(info, afterFile);
+    return;
+  }
+
+  this._writeGeneric(true, chunks.slice(0, i), '', (err) => {
+    if (err) return afterFile(err);
+    this._sendFile(info, afterFile);
+  });
 };
 
 
 Socket.prototype._write = function(data, encoding, cb) {
-  this._writeGeneric(false, data, encoding, cb);
+  if (data[kSendFile] !== undefined)
+    this._sendFile(data[kSendFile], cb);
+  else
+    this._writeGeneric(false, data, encoding, cb);
+};
+
+
+Socket.prototype.sendFile = function(fd, offset, length, cb) {
+  if (typeof offset === 'function') {
+    cb = offset;
+    offset = length = undefined;
+  } else if (typeof length === 'function') {
+    cb = length;
+    length = undefined;
+  }
+
+  if (typeof fd !== 'number' || (fd | 0) !== fd || fd < 0)
+    throw new TypeError('"fd" argument must be a non-negative integer');
+
+  if (offset === undefined)
+    offset = 0;
+  else if (!Number.isSafeInteger(offset) || offset < 0)
+    throw new RangeError('"offset" argument must be a non-negative integer');
+
+  // The rest of the file is measured when the transfer starts, so that
+  // sendFile() never blocks on the file system.
+  if (length === undefined) {
+    length = -1;
+  } else if (!Number.isSafeInteger(length) || length < 0) {
+    throw new RangeError('"length" argument must be a non-negative integer');
+  }
+
+  // Queue the file like any other chunk so it is sent in order with the
+  // surrounding writes.
+  const marker = Buffer.alloc(0);
+  marker[kSendFile] = { fd, offset, length };
+  return this.write(marker, cb);
+};
+
+
+Socket.prototype._sendFile = function(info, cb) {
+  if (this.connecting) {
+    this.once('connect', function() {
+      this._sendFile(info, cb);
+    });
+    return;
+  }
+
+  this._unrefTimer();
+
+  if (!this._handle) {
+    this._destroy(new Error('This socket is closed'), cb);
+    return;
+  }
+
+  if (info.length === 0) {
+    cb();
+    return;
+  }
+
+  // TLS sockets, pipes and Windows don't have a native sendfile.
+  if (typeof this._handle.sendFile !== 'function') {
+    sendFileFallback(this, info, cb);
+    return;
+  }
+
+  var req = new WriteWrap();
+  req.handle = this._handle;
+  req.oncomplete = afterSendFile;
+  req.cb = cb;
+
+  var err = this._handle.sendFile(req, info.fd, info.offset, info.length);
+  if (err) {
+    this._destroy(errnoException(err, 'sendfile'), cb);
+    return;
+  }
+
+  this._sendFileReq = req;
 };
 
+
+function afterSendFile(status, bytes) {
+  var self = this.handle.owner;
+  debug('afterSendFile', status, bytes);
+
+  self._sendFileReq = null;
+
+  // callback may come after call to destroy.
+  if (self.destroyed) {
+    debug('afterSendFile destroyed');
+    return;
+  }
+
+  self._bytesDispatched += bytes;
+
+  if (status < 0) {
+    self._destroy(errnoException(status, 'sendfile'), this.cb);
+    return;
+  }
+
+  self._unrefTimer();
+  this.cb.call(self);
+}
+
+
+function sendFileFallback(self, info, cb) {
+  if (fs === undefined) fs = require('fs');
+
+  var position = info.offset;
+  var remaining = info.length < 0 ? Infinity : info.length;
+
+  function next(err) {
+    if (err) return cb(err);
+    if (remaining === 0) return cb();
+
+    const buffer = Buffer.allocUnsafe(Math.min(remaining, kSendFileChunk));
+    fs.read(info.fd, buffer, 0, buffer.length, position, (err, bytesRead) => {
+      if (err) return self._destroy(err, cb);
+      if (bytesRead === 0) return cb();  // EOF
+      position += bytesRead;
+      remaining -= bytesRead;
+      self._writeGeneric(false, buffer.slice(0, bytesRead), 'buffer', next);
+    });
+  }
+
+  next();
+}
+
 function createWriteReq(req, handle, data, encoding) {
   switch (encoding) {
     case 'latin1':
@@ -1135,6 +1294,14 @@ function Server(options, connectionListener) {
 
   this.allowHalfOpen = options.allowHalfOpen || false;
   this.pauseOnConnect = !!options.pauseOnConnect;
+
+  this._acceptBatch = 1;
+  if (options.acceptBatch !== undefined) {
+    const n = options.acceptBatch;
+    if (typeof n !== 'number' || n < 1 || n > 0xffffffff || n % 1 !== 0)
+      throw new RangeError('"acceptBatch" must be a positive integer');
+    this._acceptBatch = n;
+  }
 }
 util.inherits(Server, EventEmitter);
 exports.Server = Server;
@@ -1149,7 +1316,8 @@ function _listen(handle, backlog) {
   return handle.listen(backlog || 511);
 }
 
-function createServerHandle(address, port, addressType, fd) {
+// `flags` are passed to bind() and bind6() of TCP handles.
+function createServerHandle(address, port, addressType, fd, flags) {
   var err = 0;
   // assign handle in listen, and clean up if bind or listen fails
   var handle;
@@ -1184,16 +1352,17 @@ function createServerHandle(address, port, addressType, fd) {
     debug('bind to ' + (address || 'anycast'));
     if (!address) {
       // Try binding to ipv6 first
-      err = handle.bind6('::', port);
+      err = handle.bind6('::', port, flags);
       if (err) {
         handle.close();
         // Fallback to ipv4
-        return createServerHandle('0.0.0.0', port);
+        return createServerHandle('0.0.0.0', port, undefined, undefined,
+                                  flags);
       }
     } else if (addressType === 6) {
-      err = handle.bind6(address, port);
+      err = handle.bind6(address, port, flags);
     } else {
-      err = handle.bind(address, port);
+      err = handle.bind(address, port, flags);
     }
   }
 
@@ -1244,8 +1413,15 @@ Server.prototype._listen2 = function(address, port, addressType, backlog, fd) {
   }
 
   this._handle.onconnection = onconnection;
+  this._handle.onconnections = onconnections;
   this._handle.owner = this;
 
+  // Handles from the cluster master in round-robin mode are not real ones.
+  if (this._acceptBatch > 1 &&
+      typeof this._handle.setAcceptBatch === 'function') {
+    this._handle.setAcceptBatch(this._acceptBatch);
+  }
+
   var err = _listen(this._handle, backlog);
 
   if (err) {
@@ -1424,6 +1600,15 @@ Server.prototype.address = function() {
   }
 };
 
+// Called with up to `acceptBatch` connections that were accepted in one go.
+// Each one goes through the handle's onconnection, so code that replaces it
+// (like cluster's round-robin master) still sees every connection.
+function onconnections(clientHandles) {
+  for (var i = 0; i < clientHandles.length; i++)
+    this.onconnection(0, clientHandles[i]);
+}
+
+
 function onconnection(err, clientHandle) {
   var handle = this;
   var self = handle.owner;
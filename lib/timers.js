@@ -1,8 +1,9 @@
 'use strict';
 
-const TimerWrap = process.binding('timer_wrap').Timer;
+const binding = process.binding('timer_wrap');
+const TimerWrap = binding.Timer;
+const TimerWheel = binding.TimerWheel;
 const L = require('internal/linkedlist');
-const assert = require('assert');
 const util = require('util');
 const debug = util.debuglog('timer');
 const kOnTimeout = TimerWrap.kOnTimeout | 0;
@@ -20,11 +21,6 @@ const TIMEOUT_MAX = 2147483647; // 2^31-1
 // Therefore, it is very important that the timers implementation is performant
 // and efficient.
 //
-// Note: It is suggested you first read though the lib/internal/linkedlist.js
-// linked list implementation, since timers depend on it extensively. It can be
-// somewhat counter-intuitive at first, as it is not actually a class. Instead,
-// it is a set of helpers that operate on an existing object.
-//
 // In order to be as performant as possible, the architecture and data
 // structures are designed so that they are optimized to handle the following
 // use cases as efficiently as possible:
@@ -33,69 +29,47 @@ const TIMEOUT_MAX = 2147483647; // 2^31-1
 // - Removing an existing timer. (remove)
 // - Handling a timer timing out. (timeout)
 //
-// Whenever possible, the implementation tries to make the complexity of these
-// operations as close to constant-time as possible.
-// (So that performance is not impacted by the number of scheduled timers.)
+// All of these are constant-time operations, so that performance is not
+// impacted by the number of scheduled timers.
 //
-// Object maps are kept which contain linked lists keyed by their duration in
-// milliseconds.
-// The linked lists within also have some meta-properties, one of which is a
-// TimerWrap C++ handle, which makes the call after the duration to process the
-// list it is attached to.
+// The timers are kept in a hierarchical timing wheel that is implemented in
+// C++ (see TimerWheel in src/timer_wrap.cc) and driven by a single libuv
+// timer, no matter how many timers there are or how many different durations
+// they have.
 //
+// The wheel does not know about the JavaScript timer objects. Every scheduled
+// timer is given a small integer id that indexes `timerList`:
 //
-// ╔════ > Object Map
-// ║
-// ╠══
-// ║ refedLists: { '40': { }, '320': { etc } } (keys of millisecond duration)
-// ╚══          ┌─────────┘
-//              │
-// ╔══          │
-// ║ TimersList { _idleNext: { }, _idlePrev: (self), _timer: (TimerWrap) }
-// ║         ┌────────────────┘
-// ║    ╔══  │                              ^
-// ║    ║    { _idleNext: { },  _idlePrev: { }, _onTimeout: (callback) }
-// ║    ║      ┌───────────┘
-// ║    ║      │                                  ^
-// ║    ║      { _idleNext: { etc },  _idlePrev: { }, _onTimeout: (callback) }
-// ╠══  ╠══
-// ║    ║
-// ║    ╚════ >  Actual JavaScript timeouts
+// ╔════ > timerList: [ timer, timer, undefined, timer, ... ]
+// ║                      │
+// ║                      { _timerId: 0, _idleTimeout: 40, _onTimeout: (cb) }
 // ║
-// ╚════ > Linked List
+// ╚════ > wheel: TimerWheel { id 0 expires at 1040ms, id 1 at ... }
 //
+// Re-scheduling a timer, which happens every time a socket with a timeout
+// sees activity, moves it to another slot of the wheel and keeps its id.
+// Cancelling a timer removes it from the wheel and puts its id on a free list
+// for reuse.
 //
-// With this, virtually constant-time insertion (append), removal, and timeout
-// is possible in the JavaScript layer. Any one list of timers is able to be
-// sorted by just appending to it because all timers within share the same
-// duration. Therefore, any timer added later will always have been scheduled to
-// timeout later, thus only needing to be appended.
-// Removal from an object-property linked list is also virtually constant-time
-// as can be seen in the lib/internal/linkedlist.js implementation.
-// Timeouts only need to process any timers due to currently timeout, which will
-// always be at the beginning of the list for reasons stated above. Any timers
-// after the first one encountered that does not yet need to timeout will also
-// always be due to timeout at a later time.
-//
-// Less-than constant time operations are thus contained in two places:
-// TimerWrap's backing libuv timers implementation (a performant heap-based
-// queue), and the object map lookup of a specific list by the duration of
-// timers within (or creation of a new list).
-// However, these operations combined have shown to be trivial in comparison to
-// other alternative timers architectures.
+// When timers expire, the wheel calls `processTimers()` once with the ids of
+// all of them, in the order in which they are due. Timers that are due at the
+// same time run in the order in which they were scheduled.
 
 
-// Object maps containing linked lists of timers, keyed and sorted by their
-// duration in milliseconds.
-//
-// The difference between these two objects is that the former contains timers
-// that will keep the process open if they are the only thing left, while the
-// latter will not.
-//
-// - key = time in milliseconds
-// - value = linked list
-const refedLists = {};
-const unrefedLists = {};
+// Maps timer ids to timer objects.
+const timerList = [];
+// Ids that can be reused.
+const freeIds = [];
+
+// While a batch of expired timers is being processed, the ids of timers that
+// are cancelled or re-scheduled are not reused until the batch is done. That
+// way the ids that have yet to be processed keep referring to their timers,
+// or to nothing at all.
+var pendingBatches = 0;
+var releasedIds = [];
+
+const wheel = new TimerWheel();
+wheel[kOnTimeout] = processTimers;
 
 
 // Schedule or re-schedule a timer.
@@ -112,76 +86,54 @@ exports._unrefActive = function(item) {
 
 
 // The underlying logic for scheduling or re-scheduling a timer.
-//
-// Appends a timer onto the end of an existing timers list, or creates a new
-// TimerWrap backed list if one does not already exist for the specified timeout
-// duration.
 function insert(item, unrefed) {
   const msecs = item._idleTimeout;
   if (msecs < 0 || msecs === undefined) return;
 
-  item._idleStart = TimerWrap.now();
-
-  const lists = unrefed === true ? unrefedLists : refedLists;
-
-  // Use an existing list if there is one, otherwise we need to make a new one.
-  var list = lists[msecs];
-  if (!list) {
-    debug('no %d list was found in insert, creating a new one', msecs);
-    // Make a new linked list of timers, and create a TimerWrap to schedule
-    // processing for the list.
-    list = new TimersList(msecs, unrefed);
-    L.init(list);
-    list._timer._list = list;
-
-    if (unrefed === true) list._timer.unref();
-    list._timer.start(msecs);
-
-    lists[msecs] = list;
-    list._timer[kOnTimeout] = listOnTimeout;
+  var id = item._timerId;
+  if (id >= 0 && pendingBatches > 0) {
+    // The timer may have expired in the batch, give it a new id so that it
+    // is not mistaken for an expired timer.
+    wheel.cancel(id);
+    releaseId(item);
+    id = -1;
+  }
+  if (!(id >= 0)) {
+    id = freeIds.length > 0 ? freeIds.pop() : timerList.length;
+    timerList[id] = item;
+    item._timerId = id;
   }
 
-  L.append(list, item);
-  assert(!L.isEmpty(list)); // list is not empty
+  item._idleStart = wheel.insert(id, msecs, unrefed === true);
 }
 
-function TimersList(msecs, unrefed) {
-  this._idleNext = null; // Create the list with the linkedlist properties to
-  this._idlePrev = null; // prevent any unnecessary hidden class changes.
-  this._timer = new TimerWrap();
-  this._unrefed = unrefed;
-  this.msecs = msecs;
+function releaseId(item) {
+  const id = item._timerId;
+  timerList[id] = undefined;
+  item._timerId = -1;
+  if (pendingBatches > 0)
+    releasedIds.push(id);
+  else
+    freeIds.push(id);
 }
 
-function listOnTimeout() {
-  var list = this._list;
-  var msecs = list.msecs;
 
-  debug('timeout callback %d', msecs);
+// Called by the wheel with the ids of the timers that have expired and the
+// time at which they were collected.
+function processTimers(ids, now) {
+  debug('timeout callback, %d timers expired at %d', ids.length, now);
+  pendingBatches++;
+  runTimers(ids, 0);
+}
 
-  var now = TimerWrap.now();
-  debug('now: %d', now);
+function runTimers(ids, start) {
+  for (var i = start; i < ids.length; i++) {
+    const timer = timerList[ids[i]];
 
-  var diff, timer;
-  while (timer = L.peek(list)) {
-    diff = now - timer._idleStart;
+    // Cancelled or re-scheduled by a timer that ran earlier in the batch.
+    if (timer === undefined) continue;
 
-    // Check if this loop iteration is too early for the next timer.
-    // This happens if there are more timers scheduled for later in the list.
-    if (diff < msecs) {
-      var timeRemaining = msecs - (TimerWrap.now() - timer._idleStart);
-      if (timeRemaining < 0) {
-        timeRemaining = 0;
-      }
-      this.start(timeRemaining);
-      debug('%d list wait because diff is %d', msecs, diff);
-      return;
-    }
-
-    // The actual logic for when a timeout happens.
-
-    L.remove(timer);
-    assert(timer !== L.peek(list));
+    releaseId(timer);
 
     if (!timer._onTimeout) continue;
 
@@ -199,33 +151,23 @@ function listOnTimeout() {
       domain.enter();
     }
 
-    tryOnTimeout(timer, list);
+    tryOnTimeout(timer, ids, i + 1);
 
     if (domain)
       domain.exit();
   }
 
-  // If `L.peek(list)` returned nothing, the list was either empty or we have
-  // called all of the timer timeouts.
-  // As such, we can remove the list and clean up the TimerWrap C++ handle.
-  debug('%d list empty', msecs);
-  assert(L.isEmpty(list));
-  this.close();
-
-  // Either refedLists[msecs] or unrefedLists[msecs] may have been removed and
-  // recreated since the reference to `list` was created. Make sure they're
-  // the same instance of the list before destroying.
-  if (list._unrefed === true && list === unrefedLists[msecs]) {
-    delete unrefedLists[msecs];
-  } else if (list === refedLists[msecs]) {
-    delete refedLists[msecs];
+  if (--pendingBatches === 0 && releasedIds.length > 0) {
+    for (i = 0; i < releasedIds.length; i++)
+      freeIds.push(releasedIds[i]);
+    releasedIds = [];
   }
 }
 
 
 // An optimization so that the try/finally only de-optimizes (since at least v8
 // 4.7) what is in this smaller function.
-function tryOnTimeout(timer, list) {
+function tryOnTimeout(timer, ids, next) {
   timer._called = true;
   var threw = true;
   try {
@@ -239,46 +181,19 @@ function tryOnTimeout(timer, list) {
     // when the timeout threw its exception.
     const domain = process.domain;
     process.domain = null;
-    // If we threw, we need to process the rest of the list in nextTick.
-    process.nextTick(listOnTimeoutNT, list);
+    // If we threw, we need to process the rest of the batch in nextTick.
+    process.nextTick(runTimers, ids, next);
     process.domain = domain;
   }
 }
 
 
-function listOnTimeoutNT(list) {
-  list._timer[kOnTimeout]();
-}
-
-
-// A convenience function for re-using TimerWrap handles more easily.
-//
-// This mostly exists to fix https://github.com/nodejs/node/issues/1264.
-// Handles in libuv take at least one `uv_run` to be registered as unreferenced.
-// Re-using an existing handle allows us to skip that, so that a second `uv_run`
-// will return no active handles, even when running `setTimeout(fn).unref()`.
-function reuse(item) {
-  L.remove(item);
-
-  var list = refedLists[item._idleTimeout];
-  // if empty - reuse the watcher
-  if (list && L.isEmpty(list)) {
-    debug('reuse hit');
-    list._timer.stop();
-    delete refedLists[item._idleTimeout];
-    return list._timer;
-  }
-
-  return null;
-}
-
-
 // Remove a timer. Cancels the timeout and resets the relevant timer properties.
 const unenroll = exports.unenroll = function(item) {
-  var handle = reuse(item);
-  if (handle) {
-    debug('unenroll: list empty');
-    handle.close();
+  if (item._timerId >= 0) {
+    debug('unenroll: %d', item._timerId);
+    wheel.cancel(item._timerId);
+    releaseId(item);
   }
   // if active is called later, then we want to make sure not to insert again
   item._idleTimeout = -1;
@@ -298,9 +213,9 @@ exports.enroll = function(item, msecs) {
                          'a non-negative finite number');
   }
 
-  // if this item was already in a list somewhere
-  // then we should unenroll it from that
-  if (item._idleNext) unenroll(item);
+  // if this item was already scheduled
+  // then we should unenroll it first
+  if (item._timerId >= 0) unenroll(item);
 
   // Ensure that msecs fits into signed int32
   if (msecs > TIMEOUT_MAX) {
@@ -308,10 +223,8 @@ exports.enroll = function(item, msecs) {
   }
 
   item._idleTimeout = msecs;
-  L.init(item);
+  item._timerId = -1;
 };
-
-
 /*
  * DOM-style timers
  */
@@ -450,8 +363,7 @@ exports.clearInterval = function(timer) {
 function Timeout(after) {
   this._called = false;
   this._idleTimeout = after;
-  this._idlePrev = this;
-  this._idleNext = this;
+  this._timerId = -1;
   this._idleStart = null;
   this._onTimeout = null;
   this._repeat = null;
@@ -480,9 +392,14 @@ Timeout.prototype.unref = function() {
       return;
     }
 
-    var handle = reuse(this);
+    // Unreferenced timeouts get a handle of their own, so that they can be
+    // ref()'d again individually.
+    if (this._timerId >= 0) {
+      wheel.cancel(this._timerId);
+      releaseId(this);
+    }
 
-    this._handle = handle || new TimerWrap();
+    this._handle = new TimerWrap();
     this._handle.owner = this;
     this._handle[kOnTimeout] = unrefdHandle;
     this._handle.start(delay);
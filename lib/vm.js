@@ -10,6 +10,7 @@ const Script = binding.ContextifyScript;
 //   - runInThisContext({ displayErrors = true } = {})
 //   - runInContext(sandbox, { displayErrors = true, timeout = undefined } = {})
 // - makeContext(sandbox)
+// - makeLightweightContext()
 // - isContext(sandbox)
 // From this we build the entire documented API.
 
@@ -27,14 +28,22 @@ Script.prototype.runInThisContext = function(options) {
 };
 
 Script.prototype.runInContext = function(contextifiedSandbox, options) {
+  // Top-level let, const and class declarations of the script can't be
+  // removed from a pooled context again, see ContextPool.prototype.run().
+  if (pooledContexts.has(contextifiedSandbox))
+    dirtyContexts.add(contextifiedSandbox);
+  return runInContext(this, contextifiedSandbox, options);
+};
+
+function runInContext(script, contextifiedSandbox, options) {
   if (options && options.breakOnSigint) {
     return sigintHandlersWrap(() => {
-      return realRunInContext.call(this, contextifiedSandbox, options);
+      return realRunInContext.call(script, contextifiedSandbox, options);
     });
   } else {
-    return realRunInContext.call(this, contextifiedSandbox, options);
+    return realRunInContext.call(script, contextifiedSandbox, options);
   }
-};
+}
 
 Script.prototype.runInNewContext = function(sandbox, options) {
   var context = exports.createContext(sandbox);
@@ -47,17 +56,179 @@ exports.createScript = function(code, options) {
   return new Script(code, options);
 };
 
-exports.createContext = function(sandbox) {
+exports.createContext = function(sandbox, options) {
   if (sandbox === undefined) {
     sandbox = {};
   } else if (binding.isContext(sandbox)) {
     return sandbox;
   }
 
+  if (options && options.lightweight) {
+    if (sandbox === null || typeof sandbox !== 'object')
+      throw new TypeError('sandbox argument must be an object.');
+    const context = binding.makeLightweightContext();
+    copyProperties(sandbox, context);
+    return context;
+  }
+
   binding.makeContext(sandbox);
   return sandbox;
 };
 
+
+// Contexts created by a ContextPool, and those of them that a Script has run
+// in directly.
+const pooledContexts = new WeakSet();
+const dirtyContexts = new WeakSet();
+
+// A pool of lightweight contexts with frozen builtins.  Released contexts
+// are reset and handed out again by acquire(), which saves creating a new
+// context for every short-lived sandbox.
+class ContextPool {
+  constructor(options) {
+    var max = 16;
+    if (options && options.max !== undefined) {
+      max = options.max;
+      if (!Number.isInteger(max) || max < 0)
+        throw new RangeError('"max" must be a non-negative integer');
+    }
+    this.max = max;
+    this._free = [];
+    this._busy = new WeakSet();
+    this._builtins = null;
+    this._prototypes = new WeakMap();
+  }
+
+  get size() {
+    return this._free.length;
+  }
+
+  acquire(sandbox) {
+    if (sandbox !== undefined &&
+        (sandbox === null || typeof sandbox !== 'object')) {
+      throw new TypeError('sandbox argument must be an object.');
+    }
+
+    var context = this._free.pop();
+    if (context === undefined) {
+      context = binding.makeLightweightContext();
+      const builtins = freezeBuiltins(context);
+      if (this._builtins === null)
+        this._builtins = new Set(builtins);
+      this._prototypes.set(context, Object.getPrototypeOf(context));
+      pooledContexts.add(context);
+    }
+    if (sandbox !== undefined)
+      copyProperties(sandbox, context);
+    this._busy.add(context);
+    return context;
+  }
+
+  // Runs |code| as the body of a function in |context| and returns what it
+  // returns.  Its declarations stay local to the call, so the context can be
+  // reused afterwards.
+  run(code, context, options) {
+    if (!this._busy.has(context))
+      throw new TypeError('context argument must be in use from this pool');
+    code = `${code}`;
+    // Parsing |code| on its own first rejects code that would close the
+    // wrapper below and declare globals after it.
+    new context.Function(code);
+    const script = new Script(`(function() {${code}\n}).call(this)`, options);
+    return runInContext(script, context, options);
+  }
+
+  release(context) {
+    if (!this._busy.has(context))
+      throw new TypeError('context argument must be in use from this pool');
+    this._busy.delete(context);
+    // A context that still differs from a fresh one after the reset could
+    // leak data to, or break, its next user.
+    if (!dirtyContexts.has(context) &&
+        resetContext(context, this._builtins) &&
+        Object.isExtensible(context) &&
+        Object.getPrototypeOf(context) === this._prototypes.get(context) &&
+        this._free.length < this.max) {
+      this._free.push(context);
+    }
+  }
+}
+
+exports.ContextPool = ContextPool;
+
+
+// The copies are always plain data properties that can be deleted again,
+// whatever the attributes of the sandbox properties are.
+function copyProperties(source, target) {
+  const keys = Reflect.ownKeys(source);
+  for (var i = 0; i < keys.length; i++) {
+    Object.defineProperty(target, keys[i], {
+      value: source[keys[i]],
+      writable: true,
+      enumerable: true,
+      configurable: true
+    });
+  }
+}
+
+
+// Freezes the builtins of a lightweight context and makes the global bindings
+// to them read-only, so a script can't leave changes behind for the next user
+// of a pooled context.  Returns the names of the builtins.
+function freezeBuiltins(context) {
+  const names = Reflect.ownKeys(context);
+  for (var i = 0; i < names.length; i++) {
+    const desc = Reflect.getOwnPropertyDescriptor(context, names[i]);
+    if ('value' in desc) {
+      deepFreeze(desc.value, context);
+      Object.defineProperty(context, names[i],
+                            { writable: false, configurable: false });
+    } else {
+      deepFreeze(desc.get, context);
+      deepFreeze(desc.set, context);
+      Object.defineProperty(context, names[i], { configurable: false });
+    }
+  }
+  return names;
+}
+
+
+function deepFreeze(value, context) {
+  if (value === null ||
+      (typeof value !== 'object' && typeof value !== 'function') ||
+      value === context ||
+      Object.isFrozen(value)) {
+    return;
+  }
+
+  Object.freeze(value);
+  const keys = Reflect.ownKeys(value);
+  for (var i = 0; i < keys.length; i++) {
+    const desc = Reflect.getOwnPropertyDescriptor(value, keys[i]);
+    if ('value' in desc) {
+      deepFreeze(desc.value, context);
+    } else {
+      deepFreeze(desc.get, context);
+      deepFreeze(desc.set, context);
+    }
+  }
+  deepFreeze(Object.getPrototypeOf(value), context);
+}
+
+
+// Removes the globals that scripts and acquire() added to a pooled context.
+// Returns false if some of them can't be deleted, such as top-level var and
+// function declarations or properties defined as non-configurable.
+function resetContext(context, builtins) {
+  const keys = Reflect.ownKeys(context);
+  var clean = true;
+  for (var i = 0; i < keys.length; i++) {
+    if (!builtins.has(keys[i]) && !Reflect.deleteProperty(context, keys[i]))
+      clean = false;
+  }
+  return clean;
+}
+
 exports.runInDebugContext = function(code) {
   return binding.runInDebugContext(code);
 };
@@ -22,6 +22,7 @@
     'node_engine%': 'v8',
     'node_core_target_name%': 'node',
     'node_uwp_dll%': 'false',
+    'node_code_cache_path%': '',
     'library_files': [
       'lib/internal/bootstrap_node.js',
       'lib/_debug_agent.js',
@@ -77,12 +78,14 @@
       'lib/vm.js',
       'lib/zlib.js',
       'lib/internal/child_process.js',
+      'lib/internal/child_process/serialization.js',
       'lib/internal/cluster.js',
       'lib/internal/freelist.js',
       'lib/internal/fs.js',
       'lib/internal/linkedlist.js',
       'lib/internal/net.js',
       'lib/internal/module.js',
+      'lib/internal/module_bundle.js',
       'lib/internal/process/next_tick.js',
       'lib/internal/process/promises.js',
       'lib/internal/process/stdio.js',
@@ -189,9 +192,11 @@
         'src/env.h',
         'src/env-inl.h',
         'src/handle_wrap.h',
+        'src/histogram.h',
         'src/js_stream.h',
         'src/node.h',
         'src/node_buffer.h',
+        'src/node_code_cache.h',
         'src/node_constants.h',
         'src/node_file.h',
         'src/node_http_parser.h',
@@ -280,6 +285,12 @@
         [ 'node_v8_options!=""', {
           'defines': [ 'NODE_V8_OPTIONS="<(node_v8_options)"'],
         }],
+        # The code cache of the core modules, see `make code-cache`.
+        [ 'node_code_cache_path!=""', {
+          'sources': [ '<(node_code_cache_path)' ],
+        }, {
+          'sources': [ 'src/node_code_cache_stub.cc' ],
+        }],
         # No node_main.cc for anything except executable
         [ 'node_target_type!="executable"', {
           'sources!': [
@@ -459,13 +470,26 @@
         } ],
         [ 'node_use_perfctr=="true"', {
           'defines': [ 'HAVE_PERFCTR=1' ],
-          'dependencies': [ 'node_perfctr' ],
           'sources': [
-            'src/node_win32_perfctr_provider.h',
-            'src/node_win32_perfctr_provider.cc',
             'src/node_counters.cc',
             'src/node_counters.h',
-            'tools/msvs/genfiles/node_perfctr_provider.rc',
+          ],
+          'conditions': [
+            [ 'OS=="win"', {
+              'dependencies': [ 'node_perfctr' ],
+              'sources': [
+                'src/node_win32_perfctr_provider.h',
+                'src/node_win32_perfctr_provider.cc',
+                'tools/msvs/genfiles/node_perfctr_provider.rc',
+              ]
+            }],
+            [ 'OS=="linux"', {
+              'libraries': [ '-lrt' ],
+              'sources': [
+                'src/node_linux_perfctr_provider.h',
+                'src/node_linux_perfctr_provider.cc',
+              ]
+            }],
           ]
         } ],
         [ 'node_no_browser_globals=="true"', {
@@ -677,7 +701,7 @@
       'target_name': 'node_perfctr',
       'type': 'none',
       'conditions': [
-        [ 'node_use_perfctr=="true"', {
+        [ 'node_use_perfctr=="true" and OS=="win"', {
           'actions': [
             {
               'action_name': 'node_perfctr_man',
@@ -923,6 +947,7 @@
           'dependencies': [ 'deps/gtest/gtest.gyp:gtest' ],
           'include_dirs': [
             'src',
+            'deps/logger/include',
           ],
           'conditions': [
             [ 'node_engine=="v8"', {
@@ -993,6 +1018,11 @@
             'NODE_WANT_INTERNALS=1',
           ],
           'sources': [
+            'deps/logger/src/async_logger.cpp',
+            'deps/logger/src/log_format.cpp',
+            'deps/logger/src/log_ring.cpp',
+            'test/cctest/test_async_logger.cc',
+            'test/cctest/test_log_format.cc',
             'test/cctest/util.cc',
           ],
         }
@@ -155,6 +155,28 @@ static void SetupHooks(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+// Returns the Environment::MakeCallbackStats counters.
+static void GetCallbackStats(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Environment::MakeCallbackStats* stats = env->makecallback_stats();
+  Local<Object> obj = Object::New(env->isolate());
+
+#define V(name, field)                                                        \
+  obj->Set(env->context(),                                                    \
+           FIXED_ONE_BYTE_STRING(env->isolate(), name),                       \
+           Number::New(env->isolate(), static_cast<double>(                   \
+               stats->Get(Environment::MakeCallbackStats::field)))).FromJust();
+  V("fastPath", kFastPath)
+  V("slowPath", kSlowPath)
+  V("domainCallbacks", kDomainCallbacks)
+  V("hookCallbacks", kHookCallbacks)
+  V("tickCallbacks", kTickCallbacks)
+#undef V
+
+  args.GetReturnValue().Set(obj);
+}
+
+
 static void Initialize(Local<Object> target,
                 Local<Value> unused,
                 Local<Context> context) {
@@ -165,6 +187,7 @@ static void Initialize(Local<Object> target,
   env->SetMethod(target, "setupHooks", SetupHooks);
   env->SetMethod(target, "disable", DisableHooksJS);
   env->SetMethod(target, "enable", EnableHooksJS);
+  env->SetMethod(target, "getCallbackStats", GetCallbackStats);
 
   Local<Object> async_providers = Object::New(isolate);
 #define V(PROVIDER)                                                           \
@@ -196,6 +219,21 @@ Local<Value> AsyncWrap::MakeCallback(const Local<Function> cb,
                                      Local<Value>* argv) {
   CHECK(env()->context() == env()->isolate()->GetCurrentContext());
 
+  Environment::MakeCallbackStats* stats = env()->makecallback_stats();
+
+  if (env()->makecallback_fast_path()) {
+    stats->Increment(Environment::MakeCallbackStats::kFastPath);
+    Environment::AsyncCallbackScope callback_scope(env());
+    Local<Value> ret = cb->Call(object(), argc, argv);
+    if (ret.IsEmpty() || callback_scope.in_makecallback())
+      return ret;
+    if (!ProcessTicksAfterCallback(env()))
+      return Local<Value>();
+    return ret;
+  }
+
+  stats->Increment(Environment::MakeCallbackStats::kSlowPath);
+
   Local<Function> pre_fn = env()->async_hooks_pre_function();
   Local<Function> post_fn = env()->async_hooks_post_function();
   Local<Value> uid = Number::New(env()->isolate(), get_uid());
@@ -216,6 +254,7 @@ Local<Value> AsyncWrap::MakeCallback(const Local<Function> cb,
   }
 
   if (has_domain) {
+    stats->Increment(Environment::MakeCallbackStats::kDomainCallbacks);
     Local<Value> enter_v = domain->Get(env()->enter_string());
     if (enter_v->IsFunction()) {
       if (enter_v.As<Function>()->Call(domain, 0, nullptr).IsEmpty()) {
@@ -225,6 +264,9 @@ Local<Value> AsyncWrap::MakeCallback(const Local<Function> cb,
     }
   }
 
+  if (ran_init_callback() && (!pre_fn.IsEmpty() || !post_fn.IsEmpty()))
+    stats->Increment(Environment::MakeCallbackStats::kHookCallbacks);
+
   if (ran_init_callback() && !pre_fn.IsEmpty()) {
     TryCatch try_catch(env()->isolate());
     MaybeLocal<Value> ar = pre_fn->Call(env()->context(), context, 1, &uid);
@@ -268,20 +310,7 @@ Local<Value> AsyncWrap::MakeCallback(const Local<Function> cb,
     return ret;
   }
 
-  Environment::TickInfo* tick_info = env()->tick_info();
-
-  if (tick_info->length() == 0) {
-    env()->isolate()->RunMicrotasks();
-  }
-
-  Local<Object> process = env()->process_object();
-
-  if (tick_info->length() == 0) {
-    tick_info->set_index(0);
-    return ret;
-  }
-
-  if (env()->tick_callback_function()->Call(process, 0, nullptr).IsEmpty()) {
+  if (!ProcessTicksAfterCallback(env())) {
     return Local<Value>();
   }
 
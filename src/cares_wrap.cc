@@ -2,6 +2,8 @@
 #include "ares.h"
 #include "async-wrap.h"
 #include "async-wrap-inl.h"
+#include "base-object.h"
+#include "base-object-inl.h"
 #include "env.h"
 #include "env-inl.h"
 #include "node.h"
@@ -16,6 +18,12 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #if defined(__ANDROID__) || \
     defined(__MINGW32__) || \
     defined(__OpenBSD__) || \
@@ -42,16 +50,105 @@ using v8::HandleScope;
 using v8::Integer;
 using v8::Local;
 using v8::Null;
+using v8::Number;
 using v8::Object;
 using v8::String;
 using v8::Value;
 
 
+// Caches the results of dns.lookup() and of A and AAAA queries.  Answers from
+// c-ares are kept for as long as their TTL says, getaddrinfo() doesn't report
+// TTLs so its results are kept for a configurable time.  Names that don't
+// exist are cached too (negative caching).  Requests that arrive while an
+// identical request is in flight wait for its result instead of going out.
+class DnsCache : public BaseObject {
+ public:
+  enum Kind {
+    kLookup,
+    kQueryA,
+    kQueryAaaa
+  };
+
+  static void Initialize(Environment* env, Local<Object> target);
+
+  static std::string Key(Kind kind, const char* name, int family, int hints);
+
+  // Returns true when |wrap| has been queued behind an identical request
+  // that is in flight.  Otherwise |key| is marked in flight and the caller
+  // sends the request, then reports its result with Complete().
+  bool Join(const std::string& key, AsyncWrap* wrap);
+
+  static const uint64_t kUnknownTtl = static_cast<uint64_t>(-1);
+
+  // Stores the result of the request for |key| and passes it on to the
+  // requests that were waiting for it.  |ttl| is the TTL of the answer in
+  // milliseconds, kUnknownTtl for getaddrinfo() results.
+  void Complete(const std::string& key,
+                int status,
+                const std::vector<std::string>& addresses,
+                uint64_t ttl);
+
+ private:
+  // Completed entries by expiry time, so that eviction doesn't have to scan
+  // the whole cache.  The keys point into |entries_|, whose keys don't move.
+  typedef std::multimap<uint64_t, const std::string*> ExpiryIndex;
+
+  struct Entry {
+    bool pending = false;
+    int status = 0;
+    uint64_t expiry = 0;
+    std::vector<std::string> addresses;
+    std::vector<AsyncWrap*> waiters;
+    ExpiryIndex::iterator by_expiry;  // Only valid when !pending.
+  };
+
+  typedef std::unordered_map<std::string, Entry> EntryMap;
+
+  DnsCache(Environment* env,
+           Local<Object> object,
+           size_t max_entries,
+           uint64_t ttl,
+           uint64_t negative_ttl,
+           uint64_t max_ttl);
+
+  static void New(const FunctionCallbackInfo<Value>& args);
+  static void Get(const FunctionCallbackInfo<Value>& args);
+  static void Clear(const FunctionCallbackInfo<Value>& args);
+  static void GetStats(const FunctionCallbackInfo<Value>& args);
+
+  uint64_t TimeToLive(Kind kind, int status, uint64_t ttl) const;
+  Local<Value> Result(Kind kind, const Entry& entry);
+  EntryMap::iterator Erase(EntryMap::iterator it);
+  void Evict();
+
+  EntryMap entries_;
+  ExpiryIndex by_expiry_;
+  const size_t max_entries_;
+  const uint64_t ttl_;
+  const uint64_t negative_ttl_;
+  const uint64_t max_ttl_;
+  double hits_ = 0;
+  double misses_ = 0;
+  double coalesced_ = 0;
+};
+
+
 class GetAddrInfoReqWrap : public ReqWrap<uv_getaddrinfo_t> {
  public:
   GetAddrInfoReqWrap(Environment* env, Local<Object> req_wrap_obj);
 
   size_t self_size() const override { return sizeof(*this); }
+
+  DnsCache* cache() const { return cache_; }
+  const std::string& cache_key() const { return cache_key_; }
+  void set_cache(DnsCache* cache, const std::string& key) {
+    cache_ = cache;
+    cache_key_ = key;
+  }
+
+ private:
+  DnsCache* cache_ = nullptr;
+  std::string cache_key_;
 };
 
 GetAddrInfoReqWrap::GetAddrInfoReqWrap(Environment* env,
@@ -236,6 +333,299 @@ static Local<Array> HostentToAddresses(Environment* env, struct hostent* host) {
 }
 
 
+static std::vector<std::string> HostentToStrings(struct hostent* host) {
+  std::vector<std::string> addresses;
+  char ip[INET6_ADDRSTRLEN];
+  for (uint32_t i = 0; host->h_addr_list[i] != nullptr; ++i) {
+    uv_inet_ntop(host->h_addrtype, host->h_addr_list[i], ip, sizeof(ip));
+    addresses.push_back(ip);
+  }
+  return addresses;
+}
+
+
+static Local<Array> StringsToArray(Environment* env,
+                                   const std::vector<std::string>& strings) {
+  EscapableHandleScope scope(env->isolate());
+  Local<Array> array = Array::New(env->isolate(), strings.size());
+  for (uint32_t i = 0; i < strings.size(); ++i)
+    array->Set(i, OneByteString(env->isolate(), strings[i].c_str()));
+  return scope.Escape(array);
+}
+
+
+static Local<Value> AresErrorCode(Environment* env, int status) {
+  switch (status) {
+#define V(code)                                                               \
+    case ARES_ ## code:                                                       \
+      return FIXED_ONE_BYTE_STRING(env->isolate(), #code);
+    V(ENODATA)
+    V(EFORMERR)
+    V(ESERVFAIL)
+    V(ENOTFOUND)
+    V(ENOTIMP)
+    V(EREFUSED)
+    V(EBADQUERY)
+    V(EBADNAME)
+    V(EBADFAMILY)
+    V(EBADRESP)
+    V(ECONNREFUSED)
+    V(ETIMEOUT)
+    V(EOF)
+    V(EFILE)
+    V(ENOMEM)
+    V(EDESTRUCTION)
+    V(EBADSTR)
+    V(EBADFLAGS)
+    V(ENONAME)
+    V(EBADHINTS)
+    V(ENOTINITIALIZED)
+    V(ELOADIPHLPAPI)
+    V(EADDRGETNETWORKPARAMS)
+    V(ECANCELLED)
+#undef V
+    default:
+      return FIXED_ONE_BYTE_STRING(env->isolate(), "UNKNOWN_ARES_ERROR");
+  }
+}
+
+
+DnsCache::DnsCache(Environment* env,
+                   Local<Object> object,
+                   size_t max_entries,
+                   uint64_t ttl,
+                   uint64_t negative_ttl,
+                   uint64_t max_ttl)
+    : BaseObject(env, object),
+      max_entries_(max_entries),
+      ttl_(ttl),
+      negative_ttl_(negative_ttl),
+      max_ttl_(max_ttl) {
+  MakeWeak<DnsCache>(this);
+}
+
+
+void DnsCache::Initialize(Environment* env, Local<Object> target) {
+  Local<FunctionTemplate> t = env->NewFunctionTemplate(New);
+  t->InstanceTemplate()->SetInternalFieldCount(1);
+  t->SetClassName(FIXED_ONE_BYTE_STRING(env->isolate(), "DnsCache"));
+
+  env->SetProtoMethod(t, "get", Get);
+  env->SetProtoMethod(t, "clear", Clear);
+  env->SetProtoMethod(t, "getStats", GetStats);
+
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "DnsCache"),
+              t->GetFunction());
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "DNS_CACHE_LOOKUP"),
+              Integer::New(env->isolate(), kLookup));
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "DNS_CACHE_A"),
+              Integer::New(env->isolate(), kQueryA));
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "DNS_CACHE_AAAA"),
+              Integer::New(env->isolate(), kQueryAaaa));
+}
+
+
+std::string DnsCache::Key(Kind kind,
+                          const char* name,
+                          int family,
+                          int hints) {
+  std::string key;
+  key += static_cast<char>('0' + kind);
+  key += std::to_string(family);
+  key += ':';
+  key += std::to_string(hints);
+  key += ':';
+  key += name;
+  return key;
+}
+
+
+void DnsCache::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args.IsConstructCall());
+  CHECK(args[0]->IsUint32());
+  CHECK(args[1]->IsNumber());
+  CHECK(args[2]->IsNumber());
+  CHECK(args[3]->IsNumber());
+  new DnsCache(env,
+               args.This(),
+               args[0]->Uint32Value(),
+               static_cast<uint64_t>(args[1]->NumberValue()),
+               static_cast<uint64_t>(args[2]->NumberValue()),
+               static_cast<uint64_t>(args[3]->NumberValue()));
+}
+
+
+// get(kind, name, family, hints) returns the cached addresses, the cached
+// error or undefined when there is nothing (usable) in the cache.
+void DnsCache::Get(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  DnsCache* cache;
+  ASSIGN_OR_RETURN_UNWRAP(&cache, args.Holder());
+  CHECK(args[0]->IsInt32());
+  CHECK(args[1]->IsString());
+
+  Kind kind = static_cast<Kind>(args[0]->Int32Value());
+  node::Utf8Value name(env->isolate(), args[1]);
+  const std::string key =
+      Key(kind, *name, args[2]->Int32Value(), args[3]->Int32Value());
+
+  auto it = cache->entries_.find(key);
+  if (it == cache->entries_.end() || it->second.pending)
+    return;
+  if (it->second.expiry <= uv_now(env->event_loop())) {
+    cache->Erase(it);
+    return;
+  }
+
+  cache->hits_ += 1;
+  args.GetReturnValue().Set(cache->Result(kind, it->second));
+}
+
+
+void DnsCache::Clear(const FunctionCallbackInfo<Value>& args) {
+  DnsCache* cache;
+  ASSIGN_OR_RETURN_UNWRAP(&cache, args.Holder());
+  // Requests in flight still need their entries to find their waiters.
+  auto& entries = cache->entries_;
+  for (auto it = entries.begin(); it != entries.end();) {
+    if (it->second.pending)
+      ++it;
+    else
+      it = cache->Erase(it);
+  }
+}
+
+
+void DnsCache::GetStats(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  DnsCache* cache;
+  ASSIGN_OR_RETURN_UNWRAP(&cache, args.Holder());
+  CHECK(args[0]->IsArray());
+  Local<Array> stats = args[0].As<Array>();
+  Local<Context> context = env->context();
+  double values[] = {
+    cache->hits_,
+    cache->misses_,
+    cache->coalesced_,
+    static_cast<double>(cache->entries_.size())
+  };
+  for (uint32_t i = 0; i < arraysize(values); ++i)
+    stats->Set(context, i, Number::New(env->isolate(), values[i])).FromJust();
+}
+
+
+bool DnsCache::Join(const std::string& key, AsyncWrap* wrap) {
+  auto inserted = entries_.emplace(key, Entry());
+  Entry& entry = inserted.first->second;
+  if (entry.pending) {
+    entry.waiters.push_back(wrap);
+    coalesced_ += 1;
+    return true;
+  }
+  // A new entry, or an expired one that this request refreshes.
+  if (!inserted.second)
+    by_expiry_.erase(entry.by_expiry);
+  entry.pending = true;
+  misses_ += 1;
+  return false;
+}
+
+
+uint64_t DnsCache::TimeToLive(Kind kind, int status, uint64_t ttl) const {
+  if (kind == kLookup) {
+    if (status == 0)
+      return ttl == kUnknownTtl ? ttl_ : std::min(ttl, max_ttl_);
+    if (status == UV_EAI_NONAME || status == UV_EAI_NODATA)
+      return negative_ttl_;
+    return 0;
+  }
+  if (status == ARES_SUCCESS)
+    return std::min(ttl, max_ttl_);
+  if (status == ARES_ENOTFOUND || status == ARES_ENODATA)
+    return negative_ttl_;
+  return 0;
+}
+
+
+// Returns the value that the JS land callback takes for the error argument
+// when the entry is negative.
+Local<Value> DnsCache::Result(Kind kind, const Entry& entry) {
+  if (entry.status == 0)
+    return StringsToArray(env(), entry.addresses);
+  if (kind == kLookup)
+    return Integer::New(env()->isolate(), entry.status);
+  return AresErrorCode(env(), entry.status);
+}
+
+
+void DnsCache::Complete(const std::string& key,
+                        int status,
+                        const std::vector<std::string>& addresses,
+                        uint64_t ttl) {
+  auto it = entries_.find(key);
+  if (it == entries_.end())
+    return;
+
+  Kind kind = static_cast<Kind>(key[0] - '0');
+  Entry& entry = it->second;
+  std::vector<AsyncWrap*> waiters;
+  waiters.swap(entry.waiters);
+
+  ttl = TimeToLive(kind, status, ttl);
+  if (ttl == 0) {
+    entries_.erase(it);
+  } else {
+    entry.pending = false;
+    entry.status = status;
+    entry.expiry = uv_now(env()->event_loop()) + ttl;
+    entry.addresses = addresses;
+    entry.by_expiry = by_expiry_.emplace(entry.expiry, &it->first);
+    if (entries_.size() > max_entries_)
+      Evict();
+  }
+
+  // The callbacks can call into the cache again, |entry| is off limits now.
+  HandleScope handle_scope(env()->isolate());
+  Context::Scope context_scope(env()->context());
+  for (AsyncWrap* wrap : waiters) {
+    Local<Value> argv[] = {
+      Integer::New(env()->isolate(), status),
+      Null(env()->isolate())
+    };
+    int argc = arraysize(argv);
+    if (status == 0) {
+      argv[1] = StringsToArray(env(), addresses);
+    } else if (kind != kLookup) {
+      argv[0] = AresErrorCode(env(), status);
+      argc = 1;
+    }
+    wrap->MakeCallback(env()->oncomplete_string(), argc, argv);
+    delete wrap;
+  }
+}
+
+
+DnsCache::EntryMap::iterator DnsCache::Erase(EntryMap::iterator it) {
+  if (!it->second.pending)
+    by_expiry_.erase(it->second.by_expiry);
+  return entries_.erase(it);
+}
+
+
+// Drops the expired entries, then the ones that expire first until the cache
+// is back to its size.  Entries in flight are never evicted.
+void DnsCache::Evict() {
+  const uint64_t now = uv_now(env()->event_loop());
+  while (!by_expiry_.empty()) {
+    auto first = by_expiry_.begin();
+    if (first->first > now && entries_.size() <= max_entries_)
+      break;
+    Erase(entries_.find(*first->second));
+  }
+}
+
+
 static Local<Array> HostentToNames(Environment* env, struct hostent* host) {
   EscapableHandleScope scope(env->isolate());
   Local<Array> names = Array::New(env->isolate());
@@ -274,7 +664,28 @@ class QueryWrap : public AsyncWrap {
     return 0;
   }
 
+  // The kind of DnsCache entry that holds the answers, -1 if they are not
+  // cacheable.
+  virtual int cache_kind() const {
+    return -1;
+  }
+
+  void set_cache(DnsCache* cache, const std::string& key) {
+    cache_ = cache;
+    cache_key_ = key;
+  }
+
  protected:
+  void CompleteCache(int status,
+                     const std::vector<std::string>& addresses,
+                     uint64_t ttl) {
+    if (cache_ == nullptr)
+      return;
+    DnsCache* cache = cache_;
+    cache_ = nullptr;
+    cache->Complete(cache_key_, status, addresses, ttl);
+  }
+
   void* GetQueryArg() {
     return static_cast<void*>(this);
   }
@@ -330,42 +741,9 @@ class QueryWrap : public AsyncWrap {
     CHECK_NE(status, ARES_SUCCESS);
     HandleScope handle_scope(env()->isolate());
     Context::Scope context_scope(env()->context());
-    Local<Value> arg;
-    switch (status) {
-#define V(code)                                                               \
-      case ARES_ ## code:                                                     \
-        arg = FIXED_ONE_BYTE_STRING(env()->isolate(), #code);                 \
-        break;
-      V(ENODATA)
-      V(EFORMERR)
-      V(ESERVFAIL)
-      V(ENOTFOUND)
-      V(ENOTIMP)
-      V(EREFUSED)
-      V(EBADQUERY)
-      V(EBADNAME)
-      V(EBADFAMILY)
-      V(EBADRESP)
-      V(ECONNREFUSED)
-      V(ETIMEOUT)
-      V(EOF)
-      V(EFILE)
-      V(ENOMEM)
-      V(EDESTRUCTION)
-      V(EBADSTR)
-      V(EBADFLAGS)
-      V(ENONAME)
-      V(EBADHINTS)
-      V(ENOTINITIALIZED)
-      V(ELOADIPHLPAPI)
-      V(EADDRGETNETWORKPARAMS)
-      V(ECANCELLED)
-#undef V
-      default:
-        arg = FIXED_ONE_BYTE_STRING(env()->isolate(), "UNKNOWN_ARES_ERROR");
-        break;
-    }
+    Local<Value> arg = AresErrorCode(env(), status);
     MakeCallback(env()->oncomplete_string(), 1, &arg);
+    CompleteCache(status, std::vector<std::string>(), 0);
   }
 
   // Subclasses should implement the appropriate Parse method.
@@ -376,9 +754,23 @@ class QueryWrap : public AsyncWrap {
   virtual void Parse(struct hostent* host) {
     UNREACHABLE();
   }
+
+ private:
+  DnsCache* cache_ = nullptr;
+  std::string cache_key_;
 };
 
 
+// Returns the smallest TTL of the answers in milliseconds.
+template <typename T>
+static uint64_t MinTtl(const T* addrttls, int naddrttls) {
+  int ttl = naddrttls > 0 ? addrttls[0].ttl : 0;
+  for (int i = 1; i < naddrttls; i++)
+    ttl = std::min(ttl, addrttls[i].ttl);
+  return static_cast<uint64_t>(std::max(ttl, 0)) * 1000;
+}
+
+
 class QueryAWrap: public QueryWrap {
  public:
   QueryAWrap(Environment* env, Local<Object> req_wrap_obj)
@@ -395,6 +787,10 @@ class QueryAWrap: public QueryWrap {
     return 0;
   }
 
+  int cache_kind() const override {
+    return DnsCache::kQueryA;
+  }
+
   size_t self_size() const override { return sizeof(*this); }
 
  protected:
@@ -403,17 +799,20 @@ class QueryAWrap: public QueryWrap {
     Context::Scope context_scope(env()->context());
 
     struct hostent* host;
+    struct ares_addrttl addrttls[256];
+    int naddrttls = arraysize(addrttls);
 
-    int status = ares_parse_a_reply(buf, len, &host, nullptr, nullptr);
+    int status = ares_parse_a_reply(buf, len, &host, addrttls, &naddrttls);
     if (status != ARES_SUCCESS) {
       ParseError(status);
       return;
     }
 
-    Local<Array> addresses = HostentToAddresses(env(), host);
+    std::vector<std::string> addresses = HostentToStrings(host);
     ares_free_hostent(host);
 
-    this->CallOnComplete(addresses);
+    this->CallOnComplete(StringsToArray(env(), addresses));
+    CompleteCache(ARES_SUCCESS, addresses, MinTtl(addrttls, naddrttls));
   }
 };
 
@@ -434,6 +833,10 @@ class QueryAaaaWrap: public QueryWrap {
     return 0;
   }
 
+  int cache_kind() const override {
+    return DnsCache::kQueryAaaa;
+  }
+
   size_t self_size() const override { return sizeof(*this); }
 
  protected:
@@ -442,17 +845,20 @@ class QueryAaaaWrap: public QueryWrap {
     Context::Scope context_scope(env()->context());
 
     struct hostent* host;
+    struct ares_addr6ttl addrttls[256];
+    int naddrttls = arraysize(addrttls);
 
-    int status = ares_parse_aaaa_reply(buf, len, &host, nullptr, nullptr);
+    int status = ares_parse_aaaa_reply(buf, len, &host, addrttls, &naddrttls);
     if (status != ARES_SUCCESS) {
       ParseError(status);
       return;
     }
 
-    Local<Array> addresses = HostentToAddresses(env(), host);
+    std::vector<std::string> addresses = HostentToStrings(host);
     ares_free_hostent(host);
 
-    this->CallOnComplete(addresses);
+    this->CallOnComplete(StringsToArray(env(), addresses));
+    CompleteCache(ARES_SUCCESS, addresses, MinTtl(addrttls, naddrttls));
   }
 };
 
@@ -929,6 +1335,177 @@ class GetHostByNameWrap: public QueryWrap {
 };
 
 
+// Maps c-ares status codes to the getaddrinfo() errors that dns.lookup()
+// reports, so that both ways of looking names up fail the same way.
+static int AresToLookupStatus(int status) {
+  switch (status) {
+    case ARES_SUCCESS:
+      return 0;
+    case ARES_ENODATA:
+      return UV_EAI_NODATA;
+    case ARES_ENOTFOUND:
+    case ARES_EBADNAME:
+      return UV_EAI_NONAME;
+    case ARES_ENOMEM:
+      return UV_EAI_MEMORY;
+    case ARES_ECANCELLED:
+    case ARES_EDESTRUCTION:
+      return UV_EAI_CANCELED;
+    case ARES_ESERVFAIL:
+    case ARES_ETIMEOUT:
+    case ARES_ECONNREFUSED:
+    case ARES_EREFUSED:
+      return UV_EAI_AGAIN;
+    default:
+      return UV_EAI_FAIL;
+  }
+}
+
+
+// Resolves a name for dns.lookup() with A and AAAA queries on the event loop
+// instead of with getaddrinfo() on the threadpool.  The results are reported
+// the way AfterGetAddrInfo() reports them: IPv4 addresses first.
+class LookupWrap: public QueryWrap {
+ public:
+  LookupWrap(Environment* env,
+             Local<Object> req_wrap_obj,
+             int family,
+             int flags)
+      : QueryWrap(env, req_wrap_obj), family_(family), flags_(flags) {
+  }
+
+  int Send(const char* name) override {
+    const bool want_a = family_ != AF_INET6;
+    const bool want_aaaa = family_ != AF_INET;
+    name_ = name;
+    // The callbacks can run synchronously, count both queries up front.
+    pending_ = want_a + want_aaaa;
+    if (want_a)
+      Search(ns_t_a);
+    if (want_aaaa)
+      Search(ns_t_aaaa);
+    return 0;
+  }
+
+  size_t self_size() const override { return sizeof(*this); }
+
+ private:
+  void Search(int type) {
+    ares_search(env()->cares_channel(),
+                name_.c_str(),
+                ns_c_in,
+                type,
+                type == ns_t_a ? AfterA : AfterAaaa,
+                this);
+  }
+
+  static void AfterA(void* arg, int status, int timeouts,
+                     unsigned char* answer_buf, int answer_len) {
+    static_cast<LookupWrap*>(arg)->OnAnswer(ns_t_a,
+                                            status,
+                                            answer_buf,
+                                            answer_len);
+  }
+
+  static void AfterAaaa(void* arg, int status, int timeouts,
+                        unsigned char* answer_buf, int answer_len) {
+    static_cast<LookupWrap*>(arg)->OnAnswer(ns_t_aaaa,
+                                            status,
+                                            answer_buf,
+                                            answer_len);
+  }
+
+  void OnAnswer(int type, int status, unsigned char* buf, int len) {
+    if (status == ARES_SUCCESS)
+      status = ParseAnswer(type, buf, len);
+
+    // With V4MAPPED, names without IPv6 addresses resolve to their IPv4
+    // addresses as IPv4-mapped IPv6 addresses.
+    if ((status == ARES_ENODATA || status == ARES_ENOTFOUND) &&
+        type == ns_t_aaaa &&
+        family_ == AF_INET6 &&
+        (flags_ & AI_V4MAPPED)) {
+      mapped_ = true;
+      Search(ns_t_a);
+      return;
+    }
+
+    if (status_ == ARES_SUCCESS)
+      status_ = status;
+    if (--pending_ > 0)
+      return;
+
+    Finish();
+    delete this;
+  }
+
+  int ParseAnswer(int type, unsigned char* buf, int len) {
+    struct hostent* host;
+    int status;
+    uint64_t ttl;
+
+    if (type == ns_t_a) {
+      struct ares_addrttl addrttls[256];
+      int naddrttls = arraysize(addrttls);
+      status = ares_parse_a_reply(buf, len, &host, addrttls, &naddrttls);
+      ttl = MinTtl(addrttls, naddrttls);
+    } else {
+      struct ares_addr6ttl addrttls[256];
+      int naddrttls = arraysize(addrttls);
+      status = ares_parse_aaaa_reply(buf, len, &host, addrttls, &naddrttls);
+      ttl = MinTtl(addrttls, naddrttls);
+    }
+    if (status != ARES_SUCCESS)
+      return status;
+
+    for (const std::string& address : HostentToStrings(host)) {
+      if (type == ns_t_aaaa)
+        ipv6_.push_back(address);
+      else if (mapped_)
+        ipv6_.push_back("::ffff:" + address);
+      else
+        ipv4_.push_back(address);
+    }
+    ares_free_hostent(host);
+    ttl_ = std::min(ttl_, ttl);
+    return ARES_SUCCESS;
+  }
+
+  void Finish() {
+    HandleScope handle_scope(env()->isolate());
+    Context::Scope context_scope(env()->context());
+
+    std::vector<std::string> addresses(ipv4_);
+    addresses.insert(addresses.end(), ipv6_.begin(), ipv6_.end());
+
+    int status = 0;
+    if (addresses.empty())
+      status = AresToLookupStatus(status_ != ARES_SUCCESS ? status_
+                                                          : ARES_ENODATA);
+
+    Local<Value> argv[] = {
+      Integer::New(env()->isolate(), status),
+      Null(env()->isolate())
+    };
+    if (status == 0)
+      argv[1] = StringsToArray(env(), addresses);
+
+    MakeCallback(env()->oncomplete_string(), arraysize(argv), argv);
+    CompleteCache(status, addresses, ttl_);
+  }
+
+  const int family_;
+  const int flags_;
+  std::string name_;
+  int pending_ = 0;
+  int status_ = ARES_SUCCESS;
+  bool mapped_ = false;
+  uint64_t ttl_ = DnsCache::kUnknownTtl;
+  std::vector<std::string> ipv4_;
+  std::vector<std::string> ipv6_;
+};
+
+
 template <class Wrap>
 static void Query(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
@@ -942,9 +1519,26 @@ static void Query(const FunctionCallbackInfo<Value>& args) {
   Wrap* wrap = new Wrap(env, req_wrap_obj);
 
   node::Utf8Value name(env->isolate(), string);
+  DnsCache* cache = nullptr;
+  std::string key;
+  if (args[2]->IsObject() && wrap->cache_kind() != -1) {
+    cache = Unwrap<DnsCache>(args[2].As<Object>());
+    CHECK_NE(cache, nullptr);
+    key = DnsCache::Key(static_cast<DnsCache::Kind>(wrap->cache_kind()),
+                        *name,
+                        0,
+                        0);
+    if (cache->Join(key, wrap))
+      return args.GetReturnValue().Set(0);
+    wrap->set_cache(cache, key);
+  }
+
   int err = wrap->Send(*name);
-  if (err)
+  if (err) {
     delete wrap;
+    if (cache != nullptr)
+      cache->Complete(key, err, std::vector<std::string>(), 0);
+  }
 
   args.GetReturnValue().Set(err);
 }
@@ -962,21 +1556,18 @@ void AfterGetAddrInfo(uv_getaddrinfo_t* req, int status, struct addrinfo* res) {
     Null(env->isolate())
   };
 
+  std::vector<std::string> addresses;
+
   if (status == 0) {
     // Success
     struct addrinfo *address;
-    int n = 0;
-
-    // Create the response array.
-    Local<Array> results = Array::New(env->isolate());
 
     char ip[INET6_ADDRSTRLEN];
     const char *addr;
 
     // Iterate over the IPv4 responses again this time creating javascript
     // strings for each IP and filling the results array.
-    address = res;
-    while (address) {
+    for (address = res; address; address = address->ai_next) {
       CHECK_EQ(address->ai_socktype, SOCK_STREAM);
 
       // Ignore random ai_family types.
@@ -991,19 +1582,12 @@ void AfterGetAddrInfo(uv_getaddrinfo_t* req, int status, struct addrinfo* res) {
         if (err)
           continue;
 
-        // Create JavaScript string
-        Local<String> s = OneByteString(env->isolate(), ip);
-        results->Set(n, s);
-        n++;
+        addresses.push_back(ip);
       }
-
-      // Increment
-      address = address->ai_next;
     }
 
     // Iterate over the IPv6 responses putting them in the array.
-    address = res;
-    while (address) {
+    for (address = res; address; address = address->ai_next) {
       CHECK_EQ(address->ai_socktype, SOCK_STREAM);
 
       // Ignore random ai_family types.
@@ -1018,22 +1602,18 @@ void AfterGetAddrInfo(uv_getaddrinfo_t* req, int status, struct addrinfo* res) {
         if (err)
           continue;
 
-        // Create JavaScript string
-        Local<String> s = OneByteString(env->isolate(), ip);
-        results->Set(n, s);
-        n++;
+        addresses.push_back(ip);
       }
-
-      // Increment
-      address = address->ai_next;
     }
 
     // No responses were found to return
-    if (n == 0) {
-      argv[0] = Integer::New(env->isolate(), UV_EAI_NODATA);
+    if (addresses.empty()) {
+      status = UV_EAI_NODATA;
+      argv[0] = Integer::New(env->isolate(), status);
     }
 
-    argv[1] = results;
+    // Create the response array.
+    argv[1] = StringsToArray(env, addresses);
   }
 
   uv_freeaddrinfo(res);
@@ -1041,6 +1621,12 @@ void AfterGetAddrInfo(uv_getaddrinfo_t* req, int status, struct addrinfo* res) {
   // Make the callback into JavaScript
   req_wrap->MakeCallback(env->oncomplete_string(), arraysize(argv), argv);
 
+  if (req_wrap->cache() != nullptr)
+    req_wrap->cache()->Complete(req_wrap->cache_key(),
+                                status,
+                                addresses,
+                                DnsCache::kUnknownTtl);
+
   delete req_wrap;
 }
 
@@ -1111,6 +1697,21 @@ static void IsIPv6(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+static int ToAddressFamily(int family) {
+  switch (family) {
+  case 0:
+    return AF_UNSPEC;
+  case 4:
+    return AF_INET;
+  case 6:
+    return AF_INET6;
+  default:
+    CHECK(0 && "bad address family");
+    ABORT();
+  }
+}
+
+
 static void GetAddrInfo(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
@@ -1121,25 +1722,27 @@ static void GetAddrInfo(const FunctionCallbackInfo<Value>& args) {
   node::Utf8Value hostname(env->isolate(), args[1]);
 
   int32_t flags = (args[3]->IsInt32()) ? args[3]->Int32Value() : 0;
-  int family;
-
-  switch (args[2]->Int32Value()) {
-  case 0:
-    family = AF_UNSPEC;
-    break;
-  case 4:
-    family = AF_INET;
-    break;
-  case 6:
-    family = AF_INET6;
-    break;
-  default:
-    CHECK(0 && "bad address family");
-    ABORT();
-  }
+  int family = ToAddressFamily(args[2]->Int32Value());
 
   GetAddrInfoReqWrap* req_wrap = new GetAddrInfoReqWrap(env, req_wrap_obj);
 
+  // Identical lookups share the request that is in flight when cached.
+  DnsCache* cache = nullptr;
+  std::string key;
+  if (args[4]->IsObject()) {
+    cache = Unwrap<DnsCache>(args[4].As<Object>());
+    CHECK_NE(cache, nullptr);
+    key = DnsCache::Key(DnsCache::kLookup,
+                        *hostname,
+                        args[2]->Int32Value(),
+                        flags);
+    if (cache->Join(key, req_wrap)) {
+      req_wrap->Dispatched();
+      return args.GetReturnValue().Set(0);
+    }
+    req_wrap->set_cache(cache, key);
+  }
+
   struct addrinfo hints;
   memset(&hints, 0, sizeof(struct addrinfo));
   hints.ai_family = family;
@@ -1153,13 +1756,96 @@ static void GetAddrInfo(const FunctionCallbackInfo<Value>& args) {
                            nullptr,
                            &hints);
   req_wrap->Dispatched();
-  if (err)
+  if (err) {
     delete req_wrap;
+    if (cache != nullptr)
+      cache->Complete(key, err, std::vector<std::string>(), 0);
+  }
 
   args.GetReturnValue().Set(err);
 }
 
 
+// The same as GetAddrInfo() but with LookupWrap, for dns.lookup() in 'cares'
+// mode.
+static void LookupAres(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  CHECK(args[0]->IsObject());
+  CHECK(args[1]->IsString());
+  CHECK(args[2]->IsInt32());
+  Local<Object> req_wrap_obj = args[0].As<Object>();
+  node::Utf8Value hostname(env->isolate(), args[1]);
+
+  int32_t flags = (args[3]->IsInt32()) ? args[3]->Int32Value() : 0;
+  int family = ToAddressFamily(args[2]->Int32Value());
+
+  LookupWrap* wrap = new LookupWrap(env, req_wrap_obj, family, flags);
+
+  if (args[4]->IsObject()) {
+    DnsCache* cache = Unwrap<DnsCache>(args[4].As<Object>());
+    CHECK_NE(cache, nullptr);
+    const std::string key = DnsCache::Key(DnsCache::kLookup,
+                                          *hostname,
+                                          args[2]->Int32Value(),
+                                          flags);
+    if (cache->Join(key, wrap))
+      return args.GetReturnValue().Set(0);
+    wrap->set_cache(cache, key);
+  }
+
+  args.GetReturnValue().Set(wrap->Send(*hostname));
+}
+
+
+// Returns the addresses of a name in the hosts file, or undefined if the name
+// is not in there.
+static void LookupHosts(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  CHECK(args[0]->IsString());
+  CHECK(args[1]->IsInt32());
+  node::Utf8Value hostname(env->isolate(), args[0]);
+  int family = ToAddressFamily(args[1]->Int32Value());
+  int32_t flags = (args[2]->IsInt32()) ? args[2]->Int32Value() : 0;
+
+  std::vector<std::string> addresses;
+  struct hostent* host;
+
+  if (family != AF_INET6 &&
+      ares_gethostbyname_file(env->cares_channel(),
+                              *hostname,
+                              AF_INET,
+                              &host) == ARES_SUCCESS) {
+    addresses = HostentToStrings(host);
+    ares_free_hostent(host);
+  }
+
+  if (family != AF_INET &&
+      ares_gethostbyname_file(env->cares_channel(),
+                              *hostname,
+                              AF_INET6,
+                              &host) == ARES_SUCCESS) {
+    for (const std::string& address : HostentToStrings(host))
+      addresses.push_back(address);
+    ares_free_hostent(host);
+  }
+
+  if (addresses.empty() && family == AF_INET6 && (flags & AI_V4MAPPED) &&
+      ares_gethostbyname_file(env->cares_channel(),
+                              *hostname,
+                              AF_INET,
+                              &host) == ARES_SUCCESS) {
+    for (const std::string& address : HostentToStrings(host))
+      addresses.push_back("::ffff:" + address);
+    ares_free_hostent(host);
+  }
+
+  if (!addresses.empty())
+    args.GetReturnValue().Set(StringsToArray(env, addresses));
+}
+
+
 static void GetNameInfo(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
@@ -1194,12 +1880,12 @@ static void GetServers(const FunctionCallbackInfo<Value>& args) {
 
   Local<Array> server_array = Array::New(env->isolate());
 
-  ares_addr_node* servers;
+  ares_addr_port_node* servers;
 
-  int r = ares_get_servers(env->cares_channel(), &servers);
+  int r = ares_get_servers_ports(env->cares_channel(), &servers);
   CHECK_EQ(r, ARES_SUCCESS);
 
-  ares_addr_node* cur = servers;
+  ares_addr_port_node* cur = servers;
 
   for (uint32_t i = 0; cur != nullptr; ++i, cur = cur->next) {
     char ip[INET6_ADDRSTRLEN];
@@ -1208,7 +1894,15 @@ static void GetServers(const FunctionCallbackInfo<Value>& args) {
     int err = uv_inet_ntop(cur->family, caddr, ip, sizeof(ip));
     CHECK_EQ(err, 0);
 
-    Local<String> addr = OneByteString(env->isolate(), ip);
+    // The port is left out when it's the default one.
+    std::string server = ip;
+    if (cur->udp_port != 0 && cur->udp_port != NAMESERVER_PORT) {
+      if (cur->family == AF_INET6)
+        server = "[" + server + "]";
+      server += ":" + std::to_string(cur->udp_port);
+    }
+
+    Local<String> addr = OneByteString(env->isolate(), server.c_str());
     server_array->Set(i, addr);
   }
 
@@ -1228,12 +1922,12 @@ static void SetServers(const FunctionCallbackInfo<Value>& args) {
   uint32_t len = arr->Length();
 
   if (len == 0) {
-    int rv = ares_set_servers(env->cares_channel(), nullptr);
+    int rv = ares_set_servers_ports(env->cares_channel(), nullptr);
     return args.GetReturnValue().Set(rv);
   }
 
-  ares_addr_node* servers = new ares_addr_node[len];
-  ares_addr_node* last = nullptr;
+  ares_addr_port_node* servers = new ares_addr_port_node[len];
+  ares_addr_port_node* last = nullptr;
 
   int err;
 
@@ -1247,8 +1941,12 @@ static void SetServers(const FunctionCallbackInfo<Value>& args) {
 
     int fam = elm->Get(0)->Int32Value();
     node::Utf8Value ip(env->isolate(), elm->Get(1));
+    // 0 selects the default port.
+    int port = elm->Get(2)->Int32Value();
 
-    ares_addr_node* cur = &servers[i];
+    ares_addr_port_node* cur = &servers[i];
+    cur->udp_port = port;
+    cur->tcp_port = port;
 
     switch (fam) {
       case 4:
@@ -1276,7 +1974,7 @@ static void SetServers(const FunctionCallbackInfo<Value>& args) {
   }
 
   if (err == 0)
-    err = ares_set_servers(env->cares_channel(), &servers[0]);
+    err = ares_set_servers_ports(env->cares_channel(), &servers[0]);
   else
     err = ARES_EBADSTR;
 
@@ -1349,6 +2047,8 @@ static void Initialize(Local<Object> target,
 
   env->SetMethod(target, "getaddrinfo", GetAddrInfo);
   env->SetMethod(target, "getnameinfo", GetNameInfo);
+  env->SetMethod(target, "lookupAres", LookupAres);
+  env->SetMethod(target, "lookupHosts", LookupHosts);
   env->SetMethod(target, "isIP", IsIP);
   env->SetMethod(target, "isIPv4", IsIPv4);
   env->SetMethod(target, "isIPv6", IsIPv6);
@@ -1357,6 +2057,8 @@ static void Initialize(Local<Object> target,
   env->SetMethod(target, "getServers", GetServers);
   env->SetMethod(target, "setServers", SetServers);
 
+  DnsCache::Initialize(env, target);
+
   target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "AF_INET"),
               Integer::New(env->isolate(), AF_INET));
   target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "AF_INET6"),
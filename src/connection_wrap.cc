@@ -8,9 +8,18 @@
 #include "util.h"
 #include "util-inl.h"
 
+#ifndef _WIN32
+# include <errno.h>
+# include <fcntl.h>
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
 namespace node {
 
+using v8::Array;
 using v8::Context;
+using v8::FunctionCallbackInfo;
 using v8::HandleScope;
 using v8::Integer;
 using v8::Local;
@@ -27,7 +36,62 @@ ConnectionWrap<WrapType, UVType>::ConnectionWrap(Environment* env,
                  object,
                  reinterpret_cast<uv_stream_t*>(&handle_),
                  provider,
-                 parent) {}
+                 parent),
+      accept_batch_(1) {}
+
+
+template <typename WrapType, typename UVType>
+void ConnectionWrap<WrapType, UVType>::SetAcceptBatch(
+    const FunctionCallbackInfo<Value>& args) {
+  WrapType* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.Holder());
+  CHECK(args[0]->IsUint32());
+  wrap->accept_batch_ = args[0]->Uint32Value();
+}
+
+
+// Takes the next connection off the accept queue of |server| directly.
+// libuv accepts one connection per connection callback, this lets a batch
+// be accepted in one go.  Returns -1 when the queue is empty.
+static int AcceptPending(uv_stream_t* server) {
+#ifdef _WIN32
+  // Connections are accepted through IOCP.
+  return -1;
+#else
+  int fd;
+  if (uv_fileno(reinterpret_cast<uv_handle_t*>(server), &fd) != 0)
+    return -1;
+
+  int peer;
+  do {
+#if defined(__linux__) || defined(__FreeBSD__)
+    peer = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+    peer = accept(fd, nullptr, nullptr);
+#endif
+  } while (peer == -1 && errno == EINTR);
+
+#if !defined(__linux__) && !defined(__FreeBSD__)
+  // uv_*_open() makes the socket non-blocking.
+  if (peer != -1)
+    fcntl(peer, F_SETFD, FD_CLOEXEC);
+#endif
+
+  // Errors other than EAGAIN, like EMFILE, are left for libuv to report
+  // from its next accept().
+  return peer;
+#endif
+}
+
+
+static int OpenAccepted(uv_tcp_t* handle, int fd) {
+  return uv_tcp_open(handle, fd);
+}
+
+
+static int OpenAccepted(uv_pipe_t* handle, int fd) {
+  return uv_pipe_open(handle, fd);
+}
 
 
 template <typename WrapType, typename UVType>
@@ -50,6 +114,40 @@ void ConnectionWrap<WrapType, UVType>::OnConnection(uv_stream_t* handle,
     Undefined(env->isolate())
   };
 
+  if (status == 0 && wrap_data->accept_batch_ > 1) {
+    Local<Array> clients = Array::New(env->isolate());
+    uint32_t count = 0;
+
+    // The first connection was accepted by libuv already.
+    Local<Object> client_obj = WrapType::Instantiate(env, wrap_data);
+    WrapType* wrap;
+    ASSIGN_OR_RETURN_UNWRAP(&wrap, client_obj);
+    if (uv_accept(handle, reinterpret_cast<uv_stream_t*>(&wrap->handle_)) == 0)
+      clients->Set(count++, client_obj);
+
+    while (count < wrap_data->accept_batch_) {
+      int fd = AcceptPending(handle);
+      if (fd == -1)
+        break;
+      client_obj = WrapType::Instantiate(env, wrap_data);
+      ASSIGN_OR_RETURN_UNWRAP(&wrap, client_obj);
+      if (OpenAccepted(&wrap->handle_, fd) != 0) {
+#ifndef _WIN32
+        close(fd);
+#endif
+        break;
+      }
+      clients->Set(count++, client_obj);
+    }
+
+    if (count == 0)
+      return;
+
+    Local<Value> clients_arg = clients;
+    wrap_data->MakeCallback(env->onconnections_string(), 1, &clients_arg);
+    return;
+  }
+
   if (status == 0) {
     // Instantiate the client javascript object and handle.
     Local<Object> client_obj = WrapType::Instantiate(env, wrap_data);
@@ -86,6 +184,12 @@ template ConnectionWrap<TCPWrap, uv_tcp_t>::ConnectionWrap(
 template void ConnectionWrap<PipeWrap, uv_pipe_t>::OnConnection(
     uv_stream_t* handle, int status);
 
+template void ConnectionWrap<PipeWrap, uv_pipe_t>::SetAcceptBatch(
+    const FunctionCallbackInfo<Value>& args);
+
+template void ConnectionWrap<TCPWrap, uv_tcp_t>::SetAcceptBatch(
+    const FunctionCallbackInfo<Value>& args);
+
 template void ConnectionWrap<TCPWrap, uv_tcp_t>::OnConnection(
     uv_stream_t* handle, int status);
 
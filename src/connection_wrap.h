@@ -18,6 +18,11 @@ class ConnectionWrap : public StreamWrap {
 
   static void OnConnection(uv_stream_t* handle, int status);
 
+  // setAcceptBatch(n) makes OnConnection() accept up to n connections at a
+  // time and pass them to onconnections(clients) in a single array, instead
+  // of calling onconnection(err, client) once per connection.
+  static void SetAcceptBatch(const v8::FunctionCallbackInfo<v8::Value>& args);
+
  protected:
   ConnectionWrap(Environment* env,
                  v8::Local<v8::Object> object,
@@ -27,6 +32,7 @@ class ConnectionWrap : public StreamWrap {
   }
 
   UVType handle_;
+  uint32_t accept_batch_;
 };
 
 
@@ -81,11 +81,16 @@ inline void Environment::AsyncHooks::set_enable_callbacks(uint32_t flag) {
 
 inline Environment::AsyncCallbackScope::AsyncCallbackScope(Environment* env)
     : env_(env) {
-  env_->makecallback_cntr_++;
+  if (env_->makecallback_cntr_++ == 0 && env_->loop_histograms_ != nullptr)
+    env_->callback_start_time_ = uv_hrtime();
 }
 
 inline Environment::AsyncCallbackScope::~AsyncCallbackScope() {
-  env_->makecallback_cntr_--;
+  if (--env_->makecallback_cntr_ == 0 && env_->loop_histograms_ != nullptr) {
+    const uint64_t elapsed = uv_hrtime() - env_->callback_start_time_;
+    env_->poll_callback_time_ += elapsed;
+    env_->loop_histograms_[kLoopCallback].Record(elapsed / 1000);
+  }
 }
 
 inline bool Environment::AsyncCallbackScope::in_makecallback() {
@@ -121,16 +126,21 @@ inline int Environment::TickInfo::fields_count() const {
   return kFieldsCount;
 }
 
-inline uint32_t Environment::TickInfo::index() const {
-  return fields_[kIndex];
-}
-
 inline uint32_t Environment::TickInfo::length() const {
   return fields_[kLength];
 }
 
-inline void Environment::TickInfo::set_index(uint32_t value) {
-  fields_[kIndex] = value;
+inline Environment::MakeCallbackStats::MakeCallbackStats() {
+  for (int i = 0; i < kFieldsCount; ++i)
+    fields_[i] = 0;
+}
+
+inline void Environment::MakeCallbackStats::Increment(Fields field) {
+  fields_[field]++;
+}
+
+inline uint64_t Environment::MakeCallbackStats::Get(Fields field) const {
+  return fields_[field];
 }
 
 inline void Environment::AssignToContext(v8::Local<v8::Context> context) {
@@ -178,6 +188,7 @@ inline Environment::Environment(IsolateData* isolate_data,
 #endif
       handle_cleanup_waiting_(0),
       http_parser_buffer_(nullptr),
+      module_resolver_(nullptr),
       context_(context->GetIsolate(), context) {
   // We'll be creating new objects so make sure we've entered the context.
   v8::HandleScope handle_scope(isolate());
@@ -217,6 +228,8 @@ inline Environment::~Environment() {
   delete[] heap_statistics_buffer_;
   delete[] heap_space_statistics_buffer_;
   delete[] http_parser_buffer_;
+  delete[] loop_histograms_;
+  DeleteModuleResolver(module_resolver_);
 }
 
 inline v8::Isolate* Environment::isolate() const {
@@ -239,6 +252,10 @@ inline Environment* Environment::from_immediate_check_handle(
   return ContainerOf(&Environment::immediate_check_handle_, handle);
 }
 
+inline Histogram* Environment::loop_histograms() const {
+  return loop_histograms_;
+}
+
 inline uv_check_t* Environment::immediate_check_handle() {
   return &immediate_check_handle_;
 }
@@ -273,6 +290,10 @@ inline Environment::TickInfo* Environment::tick_info() {
   return &tick_info_;
 }
 
+inline Environment::MakeCallbackStats* Environment::makecallback_stats() {
+  return &makecallback_stats_;
+}
+
 inline uint64_t Environment::timer_base() const {
   return timer_base_;
 }
@@ -281,6 +302,12 @@ inline bool Environment::using_domains() const {
   return using_domains_;
 }
 
+inline bool Environment::makecallback_fast_path() const {
+  return !using_domains_ &&
+         async_hooks_pre_function().IsEmpty() &&
+         async_hooks_post_function().IsEmpty();
+}
+
 inline void Environment::set_using_domains(bool value) {
   using_domains_ = value;
 }
@@ -331,6 +358,15 @@ inline void Environment::set_http_parser_buffer(char* buffer) {
   http_parser_buffer_ = buffer;
 }
 
+inline ModuleResolver* Environment::module_resolver() const {
+  return module_resolver_;
+}
+
+inline void Environment::set_module_resolver(ModuleResolver* resolver) {
+  CHECK_EQ(module_resolver_, nullptr);  // Should be set only once.
+  module_resolver_ = resolver;
+}
+
 inline Environment* Environment::from_cares_timer_handle(uv_timer_t* handle) {
   return ContainerOf(&Environment::cares_timer_handle_, handle);
 }
@@ -51,6 +51,11 @@ void Environment::Start(int argc,
   uv_unref(reinterpret_cast<uv_handle_t*>(&idle_prepare_handle_));
   uv_unref(reinterpret_cast<uv_handle_t*>(&idle_check_handle_));
 
+  uv_prepare_init(event_loop(), &loop_prepare_handle_);
+  uv_check_init(event_loop(), &loop_check_handle_);
+  uv_unref(reinterpret_cast<uv_handle_t*>(&loop_prepare_handle_));
+  uv_unref(reinterpret_cast<uv_handle_t*>(&loop_check_handle_));
+
   auto close_and_finish = [](Environment* env, uv_handle_t* handle, void* arg) {
     handle->data = env;
 
@@ -75,6 +80,14 @@ void Environment::Start(int argc,
       reinterpret_cast<uv_handle_t*>(&idle_check_handle_),
       close_and_finish,
       nullptr);
+  RegisterHandleCleanup(
+      reinterpret_cast<uv_handle_t*>(&loop_prepare_handle_),
+      close_and_finish,
+      nullptr);
+  RegisterHandleCleanup(
+      reinterpret_cast<uv_handle_t*>(&loop_check_handle_),
+      close_and_finish,
+      nullptr);
 
   if (start_profiler_idle_notifier) {
     StartProfilerIdleNotifier();
@@ -108,6 +121,52 @@ void Environment::StopProfilerIdleNotifier() {
   uv_check_stop(&idle_check_handle_);
 }
 
+// libuv has no hooks for the loop phases so the loop monitor brackets the poll
+// phase with a prepare and a check watcher.  The time between the two, minus
+// the time spent in callbacks into JS land (see AsyncCallbackScope), is the
+// time the loop was blocked waiting for I/O.  Like the profiler idle notifier
+// above, it depends on the last started prepare or check watcher running
+// first; other check watchers, e.g. the one for setImmediate(), that run before
+// ours are counted as callback time, not as poll wait time.
+void Environment::StartLoopMonitor() {
+  if (loop_histograms_ != nullptr)
+    return;
+
+  loop_histograms_ = new Histogram[kLoopHistogramCount];
+  loop_prepare_time_ = uv_hrtime();
+  loop_check_time_ = 0;
+  callback_start_time_ = loop_prepare_time_;
+  poll_callback_time_ = 0;
+
+  uv_prepare_start(&loop_prepare_handle_, [](uv_prepare_t* handle) {
+    Environment* env = ContainerOf(&Environment::loop_prepare_handle_, handle);
+    env->loop_prepare_time_ = uv_hrtime();
+    env->poll_callback_time_ = 0;
+  });
+
+  uv_check_start(&loop_check_handle_, [](uv_check_t* handle) {
+    Environment* env = ContainerOf(&Environment::loop_check_handle_, handle);
+    const uint64_t now = uv_hrtime();
+    const uint64_t poll_time = now - env->loop_prepare_time_;
+    const uint64_t callback_time = env->poll_callback_time_;
+    const uint64_t wait_time =
+        poll_time > callback_time ? poll_time - callback_time : 0;
+    env->loop_histograms_[kLoopPollWait].Record(wait_time / 1000);
+    if (env->loop_check_time_ != 0) {
+      env->loop_histograms_[kLoopIteration].Record(
+          (now - env->loop_check_time_) / 1000);
+    }
+    env->loop_check_time_ = now;
+  });
+}
+
+void Environment::StopLoopMonitor() {
+  uv_prepare_stop(&loop_prepare_handle_);
+  uv_check_stop(&loop_check_handle_);
+  delete[] loop_histograms_;
+  loop_histograms_ = nullptr;
+}
+
 void Environment::PrintSyncTrace() const {
   if (!trace_sync_io_)
     return;
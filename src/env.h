@@ -9,6 +9,7 @@
 #include "inspector_agent.h"
 #endif
 #include "handle_wrap.h"
+#include "histogram.h"
 #include "req-wrap.h"
 #include "tree.h"
 #include "util.h"
@@ -145,12 +146,14 @@ namespace node {
   V(onclienthello_string, "onclienthello")                                    \
   V(oncomplete_string, "oncomplete")                                          \
   V(onconnection_string, "onconnection")                                      \
+  V(onconnections_string, "onconnections")                                    \
   V(ondone_string, "ondone")                                                  \
   V(onerror_string, "onerror")                                                \
   V(onexit_string, "onexit")                                                  \
   V(onhandshakedone_string, "onhandshakedone")                                \
   V(onhandshakestart_string, "onhandshakestart")                              \
   V(onmessage_string, "onmessage")                                            \
+  V(onmessages_string, "onmessages")                                          \
   V(onnewsession_string, "onnewsession")                                      \
   V(onnewsessiondone_string, "onnewsessiondone")                              \
   V(onocspresponse_string, "onocspresponse")                                  \
@@ -258,6 +261,10 @@ namespace node {
   V(write_wrap_constructor_function, v8::Function)                            \
 
 class Environment;
+class ModuleResolver;
+
+// Defined in node_file.cc, where ModuleResolver is.
+void DeleteModuleResolver(ModuleResolver* resolver);
 
 struct node_ares_task {
   Environment* env;
@@ -363,16 +370,13 @@ class Environment {
    public:
     inline uint32_t* fields();
     inline int fields_count() const;
-    inline uint32_t index() const;
     inline uint32_t length() const;
-    inline void set_index(uint32_t value);
 
    private:
     friend class Environment;  // So we can call the constructor.
     inline TickInfo();
 
     enum Fields {
-      kIndex,
       kLength,
       kFieldsCount
     };
@@ -382,6 +386,31 @@ class Environment {
     DISALLOW_COPY_AND_ASSIGN(TickInfo);
   };
 
+  // How often MakeCallback() took the fast path, which skips the domain and
+  // async hook handling, and how often it needed the slow path.
+  class MakeCallbackStats {
+   public:
+    enum Fields {
+      kFastPath,
+      kSlowPath,
+      kDomainCallbacks,  // Slow path callbacks that entered a domain.
+      kHookCallbacks,  // Slow path callbacks that ran async hooks.
+      kTickCallbacks,  // Callbacks that were followed by _tickCallback().
+      kFieldsCount
+    };
+
+    inline void Increment(Fields field);
+    inline uint64_t Get(Fields field) const;
+
+   private:
+    friend class Environment;  // So we can call the constructor.
+    inline MakeCallbackStats();
+
+    uint64_t fields_[kFieldsCount];
+
+    DISALLOW_COPY_AND_ASSIGN(MakeCallbackStats);
+  };
+
   typedef void (*HandleCleanupCb)(Environment* env,
                                   uv_handle_t* handle,
                                   void* arg);
@@ -424,6 +453,21 @@ class Environment {
   void StartProfilerIdleNotifier();
   void StopProfilerIdleNotifier();
 
+  // Event loop latency histograms, in microseconds.  They are only recorded
+  // while the loop monitor is running.
+  enum LoopHistogram {
+    kLoopIteration,  // Time between two consecutive iterations of the loop.
+    kLoopPollWait,   // Time spent waiting for I/O, minus the I/O callbacks.
+    kLoopCallback,   // Time spent in each top-level callback into JS land.
+    kLoopHistogramCount
+  };
+
+  void StartLoopMonitor();
+  void StopLoopMonitor();
+  // Returns kLoopHistogramCount histograms, or nullptr when the loop monitor
+  // isn't running.
+  inline Histogram* loop_histograms() const;
+
   inline v8::Isolate* isolate() const;
   inline uv_loop_t* event_loop() const;
   inline bool async_wrap_callbacks_enabled() const;
@@ -443,6 +487,7 @@ class Environment {
   inline AsyncHooks* async_hooks();
   inline DomainFlag* domain_flag();
   inline TickInfo* tick_info();
+  inline MakeCallbackStats* makecallback_stats();
   inline uint64_t timer_base() const;
 
   static inline Environment* from_cares_timer_handle(uv_timer_t* handle);
@@ -455,6 +500,10 @@ class Environment {
   inline bool using_domains() const;
   inline void set_using_domains(bool value);
 
+  // True while neither domains nor async hook pre/post callbacks are in use,
+  // in which case MakeCallback() can skip looking for them.
+  inline bool makecallback_fast_path() const;
+
   inline bool printed_error() const;
   inline void set_printed_error(bool value);
 
@@ -472,6 +521,9 @@ class Environment {
   inline char* http_parser_buffer() const;
   inline void set_http_parser_buffer(char* buffer);
 
+  inline ModuleResolver* module_resolver() const;
+  inline void set_module_resolver(ModuleResolver* resolver);
+
   inline void ThrowError(const char* errmsg);
   inline void ThrowTypeError(const char* errmsg);
   inline void ThrowRangeError(const char* errmsg);
@@ -552,9 +604,12 @@ class Environment {
   uv_idle_t immediate_idle_handle_;
   uv_prepare_t idle_prepare_handle_;
   uv_check_t idle_check_handle_;
+  uv_prepare_t loop_prepare_handle_;
+  uv_check_t loop_check_handle_;
   AsyncHooks async_hooks_;
   DomainFlag domain_flag_;
   TickInfo tick_info_;
+  MakeCallbackStats makecallback_stats_;
   const uint64_t timer_base_;
   uv_timer_t cares_timer_handle_;
   ares_channel cares_channel_;
@@ -578,7 +633,14 @@ class Environment {
   uint32_t* heap_statistics_buffer_ = nullptr;
   uint32_t* heap_space_statistics_buffer_ = nullptr;
 
+  Histogram* loop_histograms_ = nullptr;
+  uint64_t loop_prepare_time_ = 0;
+  uint64_t loop_check_time_ = 0;
+  uint64_t callback_start_time_ = 0;
+  uint64_t poll_callback_time_ = 0;
+
   char* http_parser_buffer_;
+  ModuleResolver* module_resolver_;
 
 #define V(PropertyName, TypeName)                                             \
   v8::Persistent<TypeName> PropertyName ## _;
@@ -0,0 +1,98 @@
+#ifndef SRC_HISTOGRAM_H_
+#define SRC_HISTOGRAM_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace node {
+
+// Counts values in log-linear buckets, like an HDR histogram: every power of
+// two is split into kSubBuckets buckets, so a bucket is never wider than
+// 1/kSubBuckets of its lower bound.  Values below kSubBuckets get a bucket
+// each and values of 2^kMaxBits and up are counted in the last bucket.
+class Histogram {
+ public:
+  static const int kSubBucketBits = 3;
+  static const int kSubBuckets = 1 << kSubBucketBits;
+  static const int kMaxBits = 40;
+  static const size_t kBucketCount = (kMaxBits - kSubBucketBits + 1) *
+                                     kSubBuckets;
+
+  Histogram() { Reset(); }
+
+  inline void Record(uint64_t value) {
+    if (count_ == 0 || value < min_)
+      min_ = value;
+    if (value > max_)
+      max_ = value;
+    count_ += 1;
+    sum_ += value;
+    buckets_[BucketIndex(value)] += 1;
+  }
+
+  inline void Reset() {
+    count_ = 0;
+    min_ = 0;
+    max_ = 0;
+    sum_ = 0;
+    memset(buckets_, 0, sizeof(buckets_));
+  }
+
+  // Writes count, min, max, sum and the buckets to |out|, which must have
+  // room for 4 + kBucketCount elements.
+  inline void Snapshot(double* out) const {
+    out[0] = static_cast<double>(count_);
+    out[1] = static_cast<double>(min_);
+    out[2] = static_cast<double>(max_);
+    out[3] = static_cast<double>(sum_);
+    for (size_t i = 0; i < kBucketCount; i++)
+      out[4 + i] = static_cast<double>(buckets_[i]);
+  }
+
+  static inline size_t BucketIndex(uint64_t value) {
+    if (value >= (uint64_t{1} << kMaxBits))
+      return kBucketCount - 1;
+    if (value < kSubBuckets)
+      return static_cast<size_t>(value);
+    const int shift = HighestBit(value) - kSubBucketBits;
+    return shift * kSubBuckets + static_cast<size_t>(value >> shift);
+  }
+
+  // The smallest value that is counted in bucket |index|.
+  static inline uint64_t BucketLowerBound(size_t index) {
+    if (index < 2 * kSubBuckets)
+      return index;
+    const int shift = static_cast<int>(index / kSubBuckets) - 1;
+    return static_cast<uint64_t>(index - shift * kSubBuckets) << shift;
+  }
+
+ private:
+  static inline int HighestBit(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;  // NOLINT(runtime/int)
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+  }
+
+  uint64_t count_;
+  uint64_t min_;
+  uint64_t max_;
+  uint64_t sum_;
+  uint64_t buckets_[kBucketCount];
+};
+
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_HISTOGRAM_H_
@@ -3,6 +3,7 @@
 #include "node_constants.h"
 #include "node_file.h"
 #include "node_http_parser.h"
+#include "node_code_cache.h"
 #include "node_javascript.h"
 #include "node_version.h"
 #include "node_internals.h"
@@ -1188,6 +1189,27 @@ Local<Value> MakeCallback(Environment* env,
   // If you hit this assertion, you forgot to enter the v8::Context first.
   CHECK_EQ(env->context(), env->isolate()->GetCurrentContext());
 
+  Environment::MakeCallbackStats* stats = env->makecallback_stats();
+
+  if (env->makecallback_fast_path()) {
+    stats->Increment(Environment::MakeCallbackStats::kFastPath);
+    Environment::AsyncCallbackScope callback_scope(env);
+    Local<Value> ret = callback->Call(recv, argc, argv);
+    if (ret.IsEmpty()) {
+      // NOTE: For backwards compatibility with public API we return
+      // Undefined() if the top level call threw.
+      return callback_scope.in_makecallback() ?
+          ret : Undefined(env->isolate()).As<Value>();
+    }
+    if (callback_scope.in_makecallback())
+      return ret;
+    if (!ProcessTicksAfterCallback(env))
+      return Undefined(env->isolate());
+    return ret;
+  }
+
+  stats->Increment(Environment::MakeCallbackStats::kSlowPath);
+
   Local<Function> pre_fn = env->async_hooks_pre_function();
   Local<Function> post_fn = env->async_hooks_post_function();
   Local<Object> object, domain;
@@ -1217,6 +1239,7 @@ Local<Value> MakeCallback(Environment* env,
   }
 
   if (has_domain) {
+    stats->Increment(Environment::MakeCallbackStats::kDomainCallbacks);
     Local<Value> enter_v = domain->Get(env->enter_string());
     if (enter_v->IsFunction()) {
       if (enter_v.As<Function>()->Call(domain, 0, nullptr).IsEmpty()) {
@@ -1226,6 +1249,9 @@ Local<Value> MakeCallback(Environment* env,
     }
   }
 
+  if (ran_init_callback && (!pre_fn.IsEmpty() || !post_fn.IsEmpty()))
+    stats->Increment(Environment::MakeCallbackStats::kHookCallbacks);
+
   if (ran_init_callback && !pre_fn.IsEmpty()) {
     TryCatch try_catch(env->isolate());
     MaybeLocal<Value> ar = pre_fn->Call(env->context(), object, 0, nullptr);
@@ -1275,23 +1301,29 @@ Local<Value> MakeCallback(Environment* env,
     return ret;
   }
 
+  if (!ProcessTicksAfterCallback(env)) {
+    return Undefined(env->isolate());
+  }
+
+  return ret;
+}
+
+
+bool ProcessTicksAfterCallback(Environment* env) {
   Environment::TickInfo* tick_info = env->tick_info();
 
+  // Only call into JS when there are ticks to run, microtasks alone are run
+  // natively.
   if (tick_info->length() == 0) {
     env->isolate()->RunMicrotasks();
+    if (tick_info->length() == 0)
+      return true;
   }
 
+  env->makecallback_stats()->Increment(
+      Environment::MakeCallbackStats::kTickCallbacks);
   Local<Object> process = env->process_object();
-
-  if (tick_info->length() == 0) {
-    tick_info->set_index(0);
-  }
-
-  if (env->tick_callback_function()->Call(process, 0, nullptr).IsEmpty()) {
-    return Undefined(env->isolate());
-  }
-
-  return ret;
+  return !env->tick_callback_function()->Call(process, 0, nullptr).IsEmpty();
 }
 
 
@@ -2222,7 +2254,13 @@ static void WaitForInspectorDisconnect(Environment* env) {
 
 
 void Exit(const FunctionCallbackInfo<Value>& args) {
-  WaitForInspectorDisconnect(Environment::GetCurrent(args));
+  Environment* env = Environment::GetCurrent(args);
+  WaitForInspectorDisconnect(env);
+  RunAtExit(env);
+#ifdef UWP_DLL
+  // Write out the messages that are still queued for the logger.
+  node::logger::StopAsyncLogging();
+#endif
   exit(args[0]->Int32Value());
 }
 
@@ -2332,6 +2370,74 @@ void CPUUsage(const FunctionCallbackInfo<Value>& args) {
   fields[1] = MICROS_PER_SEC * rusage.ru_stime.tv_sec + rusage.ru_stime.tv_usec;
 }
 
+// ThreadpoolUsage uses libuv's uv_threadpool_stats() to report the size of
+// the threadpool, its queue depth and the per work class queue wait time
+// histograms. The values are written to the Float64Array passed in, in the
+// order of the uv_threadpool_stats_t fields.
+void ThreadpoolUsage(const FunctionCallbackInfo<Value>& args) {
+  uv_threadpool_stats_t stats;
+
+  int err = uv_threadpool_stats(&stats);
+  if (err) {
+    Local<String> errmsg = OneByteString(args.GetIsolate(), uv_strerror(err));
+    args.GetReturnValue().Set(errmsg);
+    return;
+  }
+
+  const size_t kHistogramLength = UV_WORK_KIND_MAX * UV_THREADPOOL_WAIT_BUCKETS;
+
+  CHECK(args[0]->IsFloat64Array());
+  Local<Float64Array> array = args[0].As<Float64Array>();
+  CHECK_EQ(array->Length(), 5 + kHistogramLength);
+  Local<ArrayBuffer> ab = array->Buffer();
+  double* fields = static_cast<double*>(ab->GetContents().Data());
+
+  fields[0] = stats.min_threads;
+  fields[1] = stats.max_threads;
+  fields[2] = stats.threads;
+  fields[3] = stats.idle_threads;
+  fields[4] = stats.queued;
+
+  const uint64_t* histogram = &stats.wait_histogram[0][0];
+  for (size_t i = 0; i < kHistogramLength; i++)
+    fields[5 + i] = static_cast<double>(histogram[i]);
+}
+
+static void StartEventLoopMonitor(const FunctionCallbackInfo<Value>& args) {
+  Environment::GetCurrent(args)->StartLoopMonitor();
+}
+
+static void StopEventLoopMonitor(const FunctionCallbackInfo<Value>& args) {
+  Environment::GetCurrent(args)->StopLoopMonitor();
+}
+
+// EventLoopHistograms writes the count, min, max, sum and buckets of each of
+// the event loop histograms to the Float64Array passed in, see
+// Histogram::Snapshot(), and resets them when the second argument is true.
+// Returns false when the loop monitor isn't running.
+static void EventLoopHistograms(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  const size_t kFieldCount = 4 + Histogram::kBucketCount;
+
+  CHECK(args[0]->IsFloat64Array());
+  Local<Float64Array> array = args[0].As<Float64Array>();
+  CHECK_EQ(array->Length(), Environment::kLoopHistogramCount * kFieldCount);
+
+  Histogram* histograms = env->loop_histograms();
+  if (histograms == nullptr)
+    return args.GetReturnValue().Set(false);
+
+  Local<ArrayBuffer> ab = array->Buffer();
+  double* fields = static_cast<double*>(ab->GetContents().Data());
+  for (int i = 0; i < Environment::kLoopHistogramCount; i++) {
+    histograms[i].Snapshot(fields + i * kFieldCount);
+    if (args[1]->IsTrue())
+      histograms[i].Reset();
+  }
+
+  args.GetReturnValue().Set(true);
+}
+
 extern "C" void node_module_register(void* m) {
   struct node_module* mp = reinterpret_cast<struct node_module*>(m);
 
@@ -2604,6 +2710,10 @@ static void Binding(const FunctionCallbackInfo<Value>& args) {
     exports = Object::New(env->isolate());
     DefineJavaScript(env, exports);
     cache->Set(module, exports);
+  } else if (!strcmp(*module_v, "code_cache")) {
+    exports = Object::New(env->isolate());
+    DefineCodeCache(env, exports);
+    cache->Set(module, exports);
   } else {
     char errmsg[1024];
     snprintf(errmsg,
@@ -3347,6 +3457,22 @@ void SetupProcessObject(Environment* env,
   env->SetMethod(process, "uptime", Uptime);
   env->SetMethod(process, "memoryUsage", MemoryUsage);
 
+  env->SetMethod(process, "threadpoolUsage", ThreadpoolUsage);
+  {
+    Local<Object> threadpool_usage = process->Get(
+        FIXED_ONE_BYTE_STRING(env->isolate(), "threadpoolUsage")).As<Object>();
+    READONLY_PROPERTY(threadpool_usage,
+                      "kWaitBuckets",
+                      Integer::New(env->isolate(), UV_THREADPOOL_WAIT_BUCKETS));
+    READONLY_PROPERTY(threadpool_usage,
+                      "kWorkKinds",
+                      Integer::New(env->isolate(), UV_WORK_KIND_MAX));
+  }
+
+  env->SetMethod(process, "startEventLoopMonitor", StartEventLoopMonitor);
+  env->SetMethod(process, "stopEventLoopMonitor", StopEventLoopMonitor);
+  env->SetMethod(process, "eventLoopHistograms", EventLoopHistograms);
+
   env->SetMethod(process, "binding", Binding);
   env->SetMethod(process, "_linkedBinding", LinkedBinding);
 
@@ -4570,7 +4696,9 @@ int Start(int argc, char** argv) {
 #ifdef UWP_DLL
 int _cdecl Start(int argc, char *argv[], const logger::ILogger* logger) {
   node::logger::SetLogger(logger);
-  return Start(argc, argv);
+  int exit_code = Start(argc, argv);
+  node::logger::StopAsyncLogging();
+  return exit_code;
 }
 #endif
 
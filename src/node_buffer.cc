@@ -1,6 +1,8 @@
 #include "node.h"
 #include "node_buffer.h"
 
+#include "base-object.h"
+#include "base-object-inl.h"
 #include "env.h"
 #include "env-inl.h"
 #include "string_bytes.h"
@@ -13,6 +15,7 @@
 #include <string.h>
 #include <limits.h>
 #include <utility>
+#include <vector>
 
 #define BUFFER_ID 0xB0E4
 
@@ -91,11 +94,13 @@ bool zero_fill_all_buffers = false;
 
 namespace Buffer {
 
+using v8::Array;
 using v8::ArrayBuffer;
 using v8::ArrayBufferCreationMode;
 using v8::Context;
 using v8::EscapableHandleScope;
 using v8::FunctionCallbackInfo;
+using v8::FunctionTemplate;
 using v8::Integer;
 using v8::Isolate;
 using v8::Local;
@@ -457,6 +462,23 @@ MaybeLocal<Object> New(Environment* env, char* data, size_t length) {
 }
 
 
+MaybeLocal<Object> New(Environment* env,
+                       Local<ArrayBuffer> ab,
+                       size_t byte_offset,
+                       size_t length) {
+  EscapableHandleScope scope(env->isolate());
+
+  CHECK_LE(byte_offset + length, ab->ByteLength());
+
+  Local<Uint8Array> ui = Uint8Array::New(ab, byte_offset, length);
+  Maybe<bool> mb =
+      ui->SetPrototype(env->context(), env->buffer_prototype_object());
+  if (mb.FromMaybe(false))
+    return scope.Escape(ui);
+  return Local<Object>();
+}
+
+
 void CreateFromString(const FunctionCallbackInfo<Value>& args) {
   CHECK(args[0]->IsString());
   CHECK(args[1]->IsString());
@@ -1194,6 +1216,129 @@ void IndexOfNumber(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+// A search for one or more patterns that is prepared once and then run
+// against many buffers.  A single pattern keeps its own Boyer-Moore(-Horspool)
+// tables so they aren't rebuilt for every search; several patterns are
+// searched for together with an Aho-Corasick automaton.
+class Searcher : public BaseObject {
+ public:
+  static void Initialize(Environment* env, Local<Object> target);
+
+  ~Searcher() override {
+    delete search_;
+    delete multi_search_;
+  }
+
+ private:
+  Searcher(Environment* env, Local<Object> object)
+      : BaseObject(env, object) {
+    MakeWeak<Searcher>(this);
+  }
+
+  static void New(const FunctionCallbackInfo<Value>& args);
+  static void IndexOf(const FunctionCallbackInfo<Value>& args);
+  static void LastPattern(const FunctionCallbackInfo<Value>& args);
+
+  std::vector<uint8_t> pattern_;
+  stringsearch::StringSearchBase::Tables tables_;
+  stringsearch::StringSearch<uint8_t>* search_ = nullptr;
+  stringsearch::MultiStringSearch* multi_search_ = nullptr;
+  size_t last_pattern_ = 0;
+};
+
+
+void Searcher::Initialize(Environment* env, Local<Object> target) {
+  Local<FunctionTemplate> t = env->NewFunctionTemplate(New);
+  t->InstanceTemplate()->SetInternalFieldCount(1);
+  t->SetClassName(FIXED_ONE_BYTE_STRING(env->isolate(), "Searcher"));
+
+  env->SetProtoMethod(t, "indexOf", IndexOf);
+  env->SetProtoMethod(t, "lastPattern", LastPattern);
+
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "Searcher"),
+              t->GetFunction());
+}
+
+
+// new Searcher(patterns) takes an Array of non-empty Uint8Arrays.
+void Searcher::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args.IsConstructCall());
+  CHECK(args[0]->IsArray());
+  Local<Array> patterns = args[0].As<Array>();
+  CHECK_GT(patterns->Length(), 0);
+
+  Searcher* searcher = new Searcher(env, args.This());
+
+  if (patterns->Length() == 1) {
+    SPREAD_ARG(patterns->Get(env->context(), 0).ToLocalChecked(), pattern);
+    CHECK_GT(pattern_length, 0);
+    searcher->pattern_.assign(pattern_data, pattern_data + pattern_length);
+    searcher->search_ = new stringsearch::StringSearch<uint8_t>(
+        Vector<const uint8_t>(searcher->pattern_.data(),
+                              searcher->pattern_.size(),
+                              true),
+        &searcher->tables_);
+    return;
+  }
+
+  // The automaton doesn't hold on to the patterns.
+  std::vector<Vector<const uint8_t>> vectors;
+  vectors.reserve(patterns->Length());
+  for (uint32_t i = 0; i < patterns->Length(); i++) {
+    SPREAD_ARG(patterns->Get(env->context(), i).ToLocalChecked(), pattern);
+    CHECK_GT(pattern_length, 0);
+    vectors.emplace_back(reinterpret_cast<const uint8_t*>(pattern_data),
+                         pattern_length,
+                         true);
+  }
+  searcher->multi_search_ = new stringsearch::MultiStringSearch(vectors);
+}
+
+
+// indexOf(buffer, byteOffset) returns the position of the leftmost match
+// at or after byteOffset, or -1.
+void Searcher::IndexOf(const FunctionCallbackInfo<Value>& args) {
+  Searcher* searcher;
+  ASSIGN_OR_RETURN_UNWRAP(&searcher, args.Holder());
+  ASSERT(args[1]->IsNumber());
+  SPREAD_ARG(args[0], ts_obj);
+
+  int64_t opt_offset =
+      IndexOfOffset(ts_obj_length, args[1]->IntegerValue(), true);
+  if (opt_offset <= -1) {
+    return args.GetReturnValue().Set(-1);
+  }
+  const size_t offset = static_cast<size_t>(opt_offset);
+  const uint8_t* haystack = reinterpret_cast<const uint8_t*>(ts_obj_data);
+  size_t result = ts_obj_length;
+
+  if (searcher->search_ != nullptr) {
+    if (searcher->pattern_.size() <= ts_obj_length - offset) {
+      result = searcher->search_->Search(
+          Vector<const uint8_t>(haystack, ts_obj_length, true), offset);
+    }
+  } else {
+    result = searcher->multi_search_->Search(haystack,
+                                             ts_obj_length,
+                                             offset,
+                                             &searcher->last_pattern_);
+  }
+
+  args.GetReturnValue().Set(
+      result == ts_obj_length ? -1 : static_cast<int>(result));
+}
+
+
+// lastPattern() returns the index of the pattern that the last successful
+// indexOf() call found.
+void Searcher::LastPattern(const FunctionCallbackInfo<Value>& args) {
+  Searcher* searcher;
+  ASSIGN_OR_RETURN_UNWRAP(&searcher, args.Holder());
+  args.GetReturnValue().Set(static_cast<uint32_t>(searcher->last_pattern_));
+}
+
+
 void Swap16(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   THROW_AND_RETURN_UNLESS_BUFFER(env, args[0]);
@@ -1340,6 +1485,8 @@ void Initialize(Local<Object> target,
   env->SetMethod(target, "swap32", Swap32);
   env->SetMethod(target, "swap64", Swap64);
 
+  Searcher::Initialize(env, target);
+
   target->Set(env->context(),
               FIXED_ONE_BYTE_STRING(env->isolate(), "kMaxLength"),
               Integer::NewFromUnsigned(env->isolate(), kMaxLength)).FromJust();
@@ -0,0 +1,21 @@
+#ifndef SRC_NODE_CODE_CACHE_H_
+#define SRC_NODE_CODE_CACHE_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include "v8.h"
+#include "env.h"
+
+namespace node {
+
+// Sets target[id] to a Uint8Array with the V8 code cache of every core module
+// that has one.  Defined by the file that tools/generate_code_cache.js writes
+// when node is built with `make code-cache`, and by node_code_cache_stub.cc
+// otherwise.
+void DefineCodeCache(Environment* env, v8::Local<v8::Object> target);
+
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_NODE_CODE_CACHE_H_
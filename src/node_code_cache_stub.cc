@@ -0,0 +1,10 @@
+#include "node_code_cache.h"
+
+// The default, empty code cache, used when node is built without one.
+
+namespace node {
+
+void DefineCodeCache(Environment* env, v8::Local<v8::Object> target) {
+}
+
+}  // namespace node
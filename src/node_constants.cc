@@ -1,6 +1,7 @@
 #include "node_constants.h"
 #include "env.h"
 #include "env-inl.h"
+#include "node_file.h"
 
 #include "uv.h"
 #include "zlib.h"
@@ -1127,6 +1128,19 @@ void DefineSystemConstants(Local<Object> target) {
 #ifdef X_OK
   NODE_DEFINE_CONSTANT(target, X_OK);
 #endif
+
+  // fs.copyFile() flags
+  NODE_DEFINE_CONSTANT(target, COPYFILE_EXCL);
+
+  // fs.scandir() entry types
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_UNKNOWN);
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_FILE);
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_DIR);
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_LINK);
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_FIFO);
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_SOCKET);
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_CHAR);
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_BLOCK);
 }
 
 void DefineUVConstants(Local<Object> target) {
@@ -51,10 +51,16 @@ class ContextifyContext {
   enum { kSandboxObjectIndex = 1 };
 
   Environment* const env_;
+  // A lightweight context has no sandbox object and no interceptors.  Its
+  // global proxy is handed out in place of the sandbox instead.
+  const bool lightweight_;
   Persistent<Context> context_;
 
  public:
-  ContextifyContext(Environment* env, Local<Object> sandbox_obj) : env_(env) {
+  ContextifyContext(Environment* env,
+                    Local<Object> sandbox_obj,
+                    bool lightweight = false)
+      : env_(env), lightweight_(lightweight) {
     Local<Context> v8_context = CreateV8Context(env, sandbox_obj);
     context_.Reset(env->isolate(), v8_context);
 
@@ -86,6 +92,11 @@ class ContextifyContext {
   }
 
 
+  inline bool lightweight() const {
+    return lightweight_;
+  }
+
+
   inline Local<Object> sandbox() const {
     return Local<Object>::Cast(context()->GetEmbedderData(kSandboxObjectIndex));
   }
@@ -184,22 +195,26 @@ class ContextifyContext {
 
   Local<Context> CreateV8Context(Environment* env, Local<Object> sandbox_obj) {
     EscapableHandleScope scope(env->isolate());
-    Local<FunctionTemplate> function_template =
-        FunctionTemplate::New(env->isolate());
-    function_template->SetHiddenPrototype(true);
+    Local<ObjectTemplate> object_template;
+
+    if (!lightweight_) {
+      Local<FunctionTemplate> function_template =
+          FunctionTemplate::New(env->isolate());
+      function_template->SetHiddenPrototype(true);
 
-    function_template->SetClassName(sandbox_obj->GetConstructorName());
+      function_template->SetClassName(sandbox_obj->GetConstructorName());
 
-    Local<ObjectTemplate> object_template =
-        function_template->InstanceTemplate();
+      object_template = function_template->InstanceTemplate();
 
-    NamedPropertyHandlerConfiguration config(GlobalPropertyGetterCallback,
-                                             GlobalPropertySetterCallback,
-                                             GlobalPropertyQueryCallback,
-                                             GlobalPropertyDeleterCallback,
-                                             GlobalPropertyEnumeratorCallback,
-                                             CreateDataWrapper(env));
-    object_template->SetHandler(config);
+      NamedPropertyHandlerConfiguration config(
+          GlobalPropertyGetterCallback,
+          GlobalPropertySetterCallback,
+          GlobalPropertyQueryCallback,
+          GlobalPropertyDeleterCallback,
+          GlobalPropertyEnumeratorCallback,
+          CreateDataWrapper(env));
+      object_template->SetHandler(config);
+    }
 
     Local<Context> ctx = Context::New(env->isolate(), nullptr, object_template);
 
@@ -210,6 +225,12 @@ class ContextifyContext {
 
     ctx->SetSecurityToken(env->context()->GetSecurityToken());
 
+    if (lightweight_) {
+      ctx->SetEmbedderData(kSandboxObjectIndex, ctx->Global());
+      env->AssignToContext(ctx);
+      return scope.Escape(ctx);
+    }
+
     // We need to tie the lifetime of the sandbox object with the lifetime of
     // newly created context. We do this by making them hold references to each
     // other. The context can directly hold a reference to the sandbox as an
@@ -235,6 +256,7 @@ class ContextifyContext {
 
     env->SetMethod(target, "runInDebugContext", RunInDebugContext);
     env->SetMethod(target, "makeContext", MakeContext);
+    env->SetMethod(target, "makeLightweightContext", MakeLightweightContext);
     env->SetMethod(target, "isContext", IsContext);
   }
 
@@ -300,6 +322,32 @@ class ContextifyContext {
   }
 
 
+  // makeLightweightContext() returns the global proxy of a new context that
+  // doesn't forward to a sandbox object.  It's contextified like a sandbox.
+  static void MakeLightweightContext(const FunctionCallbackInfo<Value>& args) {
+    Environment* env = Environment::GetCurrent(args);
+
+    TryCatch try_catch(env->isolate());
+    ContextifyContext* context =
+        new ContextifyContext(env, Local<Object>(), true);
+
+    if (try_catch.HasCaught()) {
+      try_catch.ReThrow();
+      return;
+    }
+
+    if (context->context().IsEmpty())
+      return;
+
+    Local<Object> global_proxy = context->global_proxy();
+    global_proxy->SetPrivate(
+        env->context(),
+        env->contextify_context_private_symbol(),
+        External::New(env->isolate(), context));
+    args.GetReturnValue().Set(global_proxy);
+  }
+
+
   static void IsContext(const FunctionCallbackInfo<Value>& args) {
     Environment* env = Environment::GetCurrent(args);
 
@@ -621,7 +669,8 @@ class ContextifyScript : public BaseObject {
                       display_errors,
                       break_on_sigint,
                       args,
-                      &try_catch)) {
+                      &try_catch) &&
+          !contextify_context->lightweight()) {
         contextify_context->CopyProperties();
       }
 
@@ -102,9 +102,11 @@ void InitPerfCounters(Environment* env, Local<Object> target) {
     target->Set(key, val);
   }
 
-  // Only Windows performance counters supported
-  // To enable other OS, use conditional compilation here
+#if defined(_WIN32)
   InitPerfCountersWin32();
+#elif defined(__linux__)
+  InitPerfCountersLinux(env);
+#endif
 
   // init times for GC percent calculation and hook callbacks
   counter_gc_start_time = NODE_COUNT_GET_GC_RAWTIME();
@@ -116,9 +118,11 @@ void InitPerfCounters(Environment* env, Local<Object> target) {
 
 
 void TermPerfCounters(Local<Object> target) {
-  // Only Windows performance counters supported
-  // To enable other OS, use conditional compilation here
+#if defined(_WIN32)
   TermPerfCountersWin32();
+#elif defined(__linux__)
+  TermPerfCountersLinux();
+#endif
 }
 
 }  // namespace node
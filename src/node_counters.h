@@ -5,8 +5,10 @@
 
 #include "node.h"
 
-#ifdef HAVE_PERFCTR
+#if defined(HAVE_PERFCTR) && defined(_WIN32)
 #include "node_win32_perfctr_provider.h"
+#elif defined(HAVE_PERFCTR) && defined(__linux__)
+#include "node_linux_perfctr_provider.h"
 #else
 #define NODE_COUNTER_ENABLED() (false)
 #define NODE_COUNT_GC_PERCENTTIME(percent) do { } while (false)
@@ -22,22 +22,42 @@
 # include <io.h>
 #endif
 
+#ifdef __POSIX__
+# include <sys/mman.h>
+#endif
+
+#ifdef __linux__
+# include <sys/syscall.h>
+#endif
+
+#ifndef _WIN32
+# include <unistd.h>
+#endif
+
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace node {
 
 using v8::Array;
+using v8::ArrayBuffer;
 using v8::Context;
 using v8::EscapableHandleScope;
+using v8::Float64Array;
 using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
 using v8::HandleScope;
 using v8::Integer;
+using v8::Isolate;
 using v8::Local;
 using v8::Number;
 using v8::Object;
 using v8::String;
+using v8::Uint8Array;
 using v8::Value;
 
 #ifndef MIN
@@ -615,253 +635,954 @@ static void InternalModuleStat(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(rc);
 }
 
-static void Stat(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
+#ifndef _WIN32
+// Native implementation of Module._findPath() in lib/module.js.  It walks the
+// same candidates in the same order: for every lookup path, the file itself,
+// the package.json "main" of the directory, the file with every extension and
+// finally the directory's index file with every extension.  Doing it in one
+// call saves the JS <-> C++ transitions and the string juggling of the JS
+// version; a stat and realpath cache that lives for the duration of the
+// outermost require() call saves most of the system calls.
+//
+// Anything the resolver can't reproduce exactly, like a package.json that
+// doesn't parse, makes it give up and leave the request to the JS version,
+// which then reports the error like it always did.  Windows paths are not
+// handled at all.
+//
+// Resolved filenames are cached until lib/module.js clears the cache along
+// with Module._pathCache, and can be saved to a manifest file that seeds the
+// cache of the next process.  Filenames from the manifest are checked to still
+// be files when they are first used.  There is one resolver per Environment.
+class ModuleResolver {
+ public:
+  enum Status { kFound, kNotFound, kFallback };
 
-  if (args.Length() < 1)
-    return TYPE_ERROR("path required");
+  explicit ModuleResolver(uv_loop_t* loop)
+      : loop_(loop), stat_cache_enabled_(false), manifest_dirty_(false) {}
 
-  BufferValue path(env->isolate(), args[0]);
-  ASSERT_PATH(path)
+  Status Resolve(const std::string& request,
+                 const std::vector<std::string>& paths,
+                 const std::vector<std::string>& exts,
+                 bool preserve_symlinks,
+                 std::string* filename);
 
-  if (args[1]->IsObject()) {
-    ASYNC_CALL(stat, args[1], UTF8, *path)
-  } else {
-    SYNC_CALL(stat, *path, *path)
-    args.GetReturnValue().Set(
-        BuildStatsObject(env, static_cast<const uv_stat_t*>(SYNC_REQ.ptr)));
-  }
-}
+  void EnableStatCache(bool enable);
+  void ClearCache();
 
-static void LStat(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
+  // Loads the manifest at |path| and saves the cache back to it when the
+  // process exits.
+  bool LoadManifest(const char* path);
+  int SaveManifest();
 
-  if (args.Length() < 1)
-    return TYPE_ERROR("path required");
+ private:
+  struct PackageMain {
+    Status status;
+    std::string main;
+  };
 
-  BufferValue path(env->isolate(), args[0]);
-  ASSERT_PATH(path)
+  struct Resolution {
+    std::string filename;
+    bool verified;
+  };
 
-  if (args[1]->IsObject()) {
-    ASYNC_CALL(lstat, args[1], UTF8, *path)
-  } else {
-    SYNC_CALL(lstat, *path, *path)
-    args.GetReturnValue().Set(
-        BuildStatsObject(env, static_cast<const uv_stat_t*>(SYNC_REQ.ptr)));
-  }
+  static void SaveManifestAtExit(void* arg);
+
+  static bool ParsePackageMain(const char* data,
+                               size_t length,
+                               PackageMain* package);
+  static void NormalizePath(std::string* path);
+
+  bool ResolvePath(const std::string& from,
+                   const std::string& to,
+                   std::string* resolved);
+  int Stat(const std::string& path);
+  Status RealPath(const std::string& path, std::string* resolved);
+  PackageMain ReadPackageMain(const std::string& dir);
+
+  Status TryFile(const std::string& path, std::string* filename);
+  Status TryExtensions(const std::string& path, std::string* filename);
+  Status TryPackage(const std::string& dir, std::string* filename);
+  Status FindPath(const std::string& request,
+                  const std::vector<std::string>& paths,
+                  std::string* filename);
+
+  uv_loop_t* const loop_;
+  const std::vector<std::string>* exts_;
+  bool preserve_symlinks_;
+  bool stat_cache_enabled_;
+  bool manifest_dirty_;
+  std::string manifest_path_;
+  std::string cwd_;
+  std::unordered_map<std::string, int> stat_cache_;
+  std::unordered_map<std::string, std::string> realpath_cache_;
+  std::unordered_map<std::string, PackageMain> package_cache_;
+  std::unordered_map<std::string, Resolution> resolution_cache_;
+};
+
+
+static ModuleResolver* GetModuleResolver(Environment* env) {
+  if (env->module_resolver() == nullptr)
+    env->set_module_resolver(new ModuleResolver(env->event_loop()));
+  return env->module_resolver();
 }
 
-static void FStat(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
 
-  if (args.Length() < 1)
-    return TYPE_ERROR("fd is required");
-  if (!args[0]->IsInt32())
-    return TYPE_ERROR("fd must be a file descriptor");
+// A strict JSON scanner that finds the top-level "main" property without
+// building the whole document.  Returns false when the document is not valid
+// JSON (or too deeply nested for the scanner), in which case the caller
+// leaves it to JSON.parse() to produce the error.
+class PackageJsonScanner {
+ public:
+  PackageJsonScanner(const char* data, size_t length)
+      : p_(data), end_(data + length) {}
+
+  // Sets |main| and |has_main|, and |main_is_string| if its value is a
+  // string.  Other values of "main" are returned in |main| as raw JSON.
+  bool Scan(std::string* main, bool* has_main, bool* main_is_string) {
+    *has_main = false;
+    SkipWhitespace();
+    if (!Expect('{'))
+      return false;
+    SkipWhitespace();
+    if (!Accept('}')) {
+      do {
+        std::string key;
+        SkipWhitespace();
+        if (!String(&key))
+          return false;
+        SkipWhitespace();
+        if (!Expect(':'))
+          return false;
+        SkipWhitespace();
+        if (key == "main") {
+          *has_main = true;
+          *main_is_string = p_ < end_ && *p_ == '"';
+          main->clear();
+          if (*main_is_string) {
+            if (!String(main))
+              return false;
+          } else {
+            const char* start = p_;
+            if (!Value(1))
+              return false;
+            main->assign(start, p_);
+          }
+        } else if (!Value(1)) {
+          return false;
+        }
+        SkipWhitespace();
+      } while (Accept(','));
+      if (!Expect('}'))
+        return false;
+    }
+    SkipWhitespace();
+    return p_ == end_;
+  }
 
-  int fd = args[0]->Int32Value();
+ private:
+  static const int kMaxDepth = 512;
 
-  if (args[1]->IsObject()) {
-    ASYNC_CALL(fstat, args[1], UTF8, fd)
-  } else {
-    SYNC_CALL(fstat, 0, fd)
-    args.GetReturnValue().Set(
-        BuildStatsObject(env, static_cast<const uv_stat_t*>(SYNC_REQ.ptr)));
+  bool Accept(char c) {
+    if (p_ < end_ && *p_ == c) {
+      p_++;
+      return true;
+    }
+    return false;
   }
-}
 
-static void Symlink(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
+  bool Expect(char c) { return Accept(c); }
 
-  int len = args.Length();
-  if (len < 1)
-    return TYPE_ERROR("target path required");
-  if (len < 2)
-    return TYPE_ERROR("src path required");
+  void SkipWhitespace() {
+    while (p_ < end_ &&
+           (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+      p_++;
+    }
+  }
 
-  BufferValue target(env->isolate(), args[0]);
-  ASSERT_PATH(target)
-  BufferValue path(env->isolate(), args[1]);
-  ASSERT_PATH(path)
+  bool Literal(const char* literal) {
+    const size_t length = strlen(literal);
+    if (static_cast<size_t>(end_ - p_) < length ||
+        memcmp(p_, literal, length) != 0) {
+      return false;
+    }
+    p_ += length;
+    return true;
+  }
 
-  int flags = 0;
+  bool Digits() {
+    const char* start = p_;
+    while (p_ < end_ && *p_ >= '0' && *p_ <= '9')
+      p_++;
+    return p_ > start;
+  }
 
-  if (args[2]->IsString()) {
-    node::Utf8Value mode(env->isolate(), args[2]);
-    if (strcmp(*mode, "dir") == 0) {
-      flags |= UV_FS_SYMLINK_DIR;
-    } else if (strcmp(*mode, "junction") == 0) {
-      flags |= UV_FS_SYMLINK_JUNCTION;
-    } else if (strcmp(*mode, "file") != 0) {
-      return env->ThrowError("Unknown symlink type");
+  bool Number() {
+    Accept('-');
+    if (!Accept('0') && !Digits())
+      return false;
+    if (Accept('.') && !Digits())
+      return false;
+    if (Accept('e') || Accept('E')) {
+      if (!Accept('+'))
+        Accept('-');
+      if (!Digits())
+        return false;
     }
+    return true;
   }
 
-  if (args[3]->IsObject()) {
-    ASYNC_DEST_CALL(symlink, args[3], *path, UTF8, *target, *path, flags)
-  } else {
-    SYNC_DEST_CALL(symlink, *target, *path, *target, *path, flags)
+  bool Hex4(unsigned* value) {
+    if (end_ - p_ < 4)
+      return false;
+    *value = 0;
+    for (int i = 0; i < 4; i++) {
+      const char c = *p_++;
+      *value <<= 4;
+      if (c >= '0' && c <= '9')
+        *value |= c - '0';
+      else if (c >= 'a' && c <= 'f')
+        *value |= c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F')
+        *value |= c - 'A' + 10;
+      else
+        return false;
+    }
+    return true;
   }
-}
 
-static void Link(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
+  // Decodes a string into |out| as UTF-8.  Strings that can't be represented
+  // faithfully, i.e. that contain lone surrogates, are rejected.
+  bool String(std::string* out) {
+    if (!Expect('"'))
+      return false;
+    for (;;) {
+      if (p_ == end_)
+        return false;
+      const unsigned char c = *p_++;
+      if (c == '"')
+        return true;
+      if (c < 0x20)
+        return false;
+      if (c != '\\') {
+        out->push_back(c);
+        continue;
+      }
+      if (p_ == end_)
+        return false;
+      switch (*p_++) {
+        case '"': out->push_back('"'); break;
+        case '\\': out->push_back('\\'); break;
+        case '/': out->push_back('/'); break;
+        case 'b': out->push_back('\b'); break;
+        case 'f': out->push_back('\f'); break;
+        case 'n': out->push_back('\n'); break;
+        case 'r': out->push_back('\r'); break;
+        case 't': out->push_back('\t'); break;
+        case 'u': {
+          unsigned code;
+          if (!Hex4(&code))
+            return false;
+          if (code >= 0xDC00 && code <= 0xDFFF)
+            return false;
+          if (code >= 0xD800 && code <= 0xDBFF) {
+            unsigned low;
+            if (!Accept('\\') || !Accept('u') || !Hex4(&low) ||
+                low < 0xDC00 || low > 0xDFFF) {
+              return false;
+            }
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+          }
+          AppendUtf8(code, out);
+          break;
+        }
+        default:
+          return false;
+      }
+    }
+  }
 
-  int len = args.Length();
-  if (len < 1)
-    return TYPE_ERROR("src path required");
-  if (len < 2)
-    return TYPE_ERROR("dest path required");
+  bool Value(int depth) {
+    if (p_ == end_ || depth > kMaxDepth)
+      return false;
+    std::string ignored;
+    switch (*p_) {
+      case '"':
+        return String(&ignored);
+      case '{':
+        p_++;
+        SkipWhitespace();
+        if (Accept('}'))
+          return true;
+        do {
+          SkipWhitespace();
+          ignored.clear();
+          if (!String(&ignored))
+            return false;
+          SkipWhitespace();
+          if (!Expect(':'))
+            return false;
+          SkipWhitespace();
+          if (!Value(depth + 1))
+            return false;
+          SkipWhitespace();
+        } while (Accept(','));
+        return Expect('}');
+      case '[':
+        p_++;
+        SkipWhitespace();
+        if (Accept(']'))
+          return true;
+        do {
+          SkipWhitespace();
+          if (!Value(depth + 1))
+            return false;
+          SkipWhitespace();
+        } while (Accept(','));
+        return Expect(']');
+      case 't':
+        return Literal("true");
+      case 'f':
+        return Literal("false");
+      case 'n':
+        return Literal("null");
+      default:
+        return Number();
+    }
+  }
 
-  BufferValue src(env->isolate(), args[0]);
-  ASSERT_PATH(src)
+  static void AppendUtf8(unsigned code, std::string* out) {
+    if (code < 0x80) {
+      out->push_back(code);
+    } else if (code < 0x800) {
+      out->push_back(0xC0 | (code >> 6));
+      out->push_back(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+      out->push_back(0xE0 | (code >> 12));
+      out->push_back(0x80 | ((code >> 6) & 0x3F));
+      out->push_back(0x80 | (code & 0x3F));
+    } else {
+      out->push_back(0xF0 | (code >> 18));
+      out->push_back(0x80 | ((code >> 12) & 0x3F));
+      out->push_back(0x80 | ((code >> 6) & 0x3F));
+      out->push_back(0x80 | (code & 0x3F));
+    }
+  }
 
-  BufferValue dest(env->isolate(), args[1]);
-  ASSERT_PATH(dest)
+  const char* p_;
+  const char* const end_;
+};
 
-  if (args[2]->IsObject()) {
-    ASYNC_DEST_CALL(link, args[2], *dest, UTF8, *src, *dest)
-  } else {
-    SYNC_DEST_CALL(link, *src, *dest, *src, *dest)
+
+// Mirrors readPackage() in lib/module.js: |package| is kFound with the value
+// of "main" when it is a non-empty string, kNotFound when it is missing or
+// falsy and kFallback for anything else.
+bool ModuleResolver::ParsePackageMain(const char* data,
+                                      size_t length,
+                                      PackageMain* package) {
+  if (length >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+    data += 3;  // Skip UTF-8 BOM.
+    length -= 3;
   }
-}
 
-static void ReadLink(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
+  // JS reads the file as UTF-8 and replaces invalid sequences; leave the rare
+  // non-ASCII package.json to it rather than duplicate that logic.
+  for (size_t i = 0; i < length; i++) {
+    if (static_cast<unsigned char>(data[i]) >= 0x80)
+      return false;
+  }
 
-  const int argc = args.Length();
+  std::string main;
+  bool has_main;
+  bool main_is_string = false;
+  PackageJsonScanner scanner(data, length);
+  if (!scanner.Scan(&main, &has_main, &main_is_string))
+    return false;
+
+  if (!has_main || (main_is_string && main.empty()) ||
+      (!main_is_string && (main == "null" || main == "false"))) {
+    package->status = kNotFound;
+    return true;
+  }
 
-  if (argc < 1)
-    return TYPE_ERROR("path required");
+  // Leave other values, which are either falsy numbers or make
+  // path.resolve() throw, to the JS resolver.
+  if (!main_is_string || main.find('\0') != std::string::npos)
+    return false;
 
-  BufferValue path(env->isolate(), args[0]);
-  ASSERT_PATH(path)
+  package->status = kFound;
+  package->main = main;
+  return true;
+}
 
-  const enum encoding encoding = ParseEncoding(env->isolate(), args[1], UTF8);
 
-  Local<Value> callback = Null(env->isolate());
-  if (argc == 3)
-    callback = args[2];
+// Collapses "." and ".." segments and duplicate and trailing slashes in an
+// absolute path, like path.normalize() does.
+void ModuleResolver::NormalizePath(std::string* path) {
+  std::vector<std::pair<size_t, size_t>> segments;
+  const std::string& p = *path;
+  size_t i = 0;
+  while (i < p.size()) {
+    while (i < p.size() && p[i] == '/')
+      i++;
+    size_t j = i;
+    while (j < p.size() && p[j] != '/')
+      j++;
+    const size_t length = j - i;
+    if (length == 0 || (length == 1 && p[i] == '.')) {
+      // Skip.
+    } else if (length == 2 && p[i] == '.' && p[i + 1] == '.') {
+      if (!segments.empty())
+        segments.pop_back();
+    } else {
+      segments.push_back(std::make_pair(i, length));
+    }
+    i = j;
+  }
 
-  if (callback->IsObject()) {
-    ASYNC_CALL(readlink, callback, encoding, *path)
+  std::string normalized;
+  normalized.reserve(p.size());
+  for (size_t k = 0; k < segments.size(); k++) {
+    normalized += '/';
+    normalized.append(p, segments[k].first, segments[k].second);
+  }
+  if (normalized.empty())
+    normalized = "/";
+  path->swap(normalized);
+}
+
+
+// path.resolve(from, to).
+bool ModuleResolver::ResolvePath(const std::string& from,
+                                 const std::string& to,
+                                 std::string* resolved) {
+  if (!to.empty() && to[0] == '/') {
+    *resolved = to;
+  } else if (!from.empty() && from[0] == '/') {
+    *resolved = from + "/" + to;
   } else {
-    SYNC_CALL(readlink, *path, *path)
-    const char* link_path = static_cast<const char*>(SYNC_REQ.ptr);
-    Local<Value> rc = StringBytes::Encode(env->isolate(),
-                                          link_path,
-                                          encoding);
-    if (rc.IsEmpty()) {
-      return env->ThrowUVException(UV_EINVAL,
-                                   "readlink",
-                                   "Invalid character encoding for link",
-                                   *path);
+    // The working directory can change between require() calls, so it is
+    // cached along with the stat results.
+    if (cwd_.empty()) {
+      char buf[PATH_MAX];
+      size_t length = sizeof(buf);
+      if (uv_cwd(buf, &length) != 0)
+        return false;
+      *resolved = std::string(buf, length) + "/" + from + "/" + to;
+      if (stat_cache_enabled_)
+        cwd_.assign(buf, length);
+    } else {
+      *resolved = cwd_ + "/" + from + "/" + to;
     }
-    args.GetReturnValue().Set(rc);
   }
+  NormalizePath(resolved);
+  return true;
 }
 
-static void Rename(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
 
-  int len = args.Length();
-  if (len < 1)
-    return TYPE_ERROR("old path required");
-  if (len < 2)
-    return TYPE_ERROR("new path required");
+int ModuleResolver::Stat(const std::string& path) {
+  if (stat_cache_enabled_) {
+    auto it = stat_cache_.find(path);
+    if (it != stat_cache_.end())
+      return it->second;
+  }
 
-  BufferValue old_path(env->isolate(), args[0]);
-  ASSERT_PATH(old_path)
-  BufferValue new_path(env->isolate(), args[1]);
-  ASSERT_PATH(new_path)
+  uv_fs_t req;
+  int rc = uv_fs_stat(loop_, &req, path.c_str(), nullptr);
+  if (rc == 0) {
+    const uv_stat_t* const s = static_cast<const uv_stat_t*>(req.ptr);
+    rc = !!(s->st_mode & S_IFDIR);
+  }
+  uv_fs_req_cleanup(&req);
 
-  if (args[2]->IsObject()) {
-    ASYNC_DEST_CALL(rename, args[2], *new_path, UTF8, *old_path, *new_path)
-  } else {
-    SYNC_DEST_CALL(rename, *old_path, *new_path, *old_path, *new_path)
+  if (stat_cache_enabled_)
+    stat_cache_[path] = rc;
+  return rc;
+}
+
+
+ModuleResolver::Status ModuleResolver::RealPath(const std::string& path,
+                                                std::string* resolved) {
+  if (stat_cache_enabled_) {
+    auto it = realpath_cache_.find(path);
+    if (it != realpath_cache_.end()) {
+      *resolved = it->second;
+      return kFound;
+    }
   }
+
+  uv_fs_t req;
+  const int rc = uv_fs_realpath(loop_, &req, path.c_str(), nullptr);
+  if (rc == 0)
+    resolved->assign(static_cast<const char*>(req.ptr));
+  uv_fs_req_cleanup(&req);
+
+  // Let fs.realpathSync() throw the error.
+  if (rc != 0)
+    return kFallback;
+
+  if (stat_cache_enabled_)
+    realpath_cache_[path] = *resolved;
+  return kFound;
 }
 
-static void FTruncate(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
 
-  if (args.Length() < 2)
-    return TYPE_ERROR("fd and length are required");
-  if (!args[0]->IsInt32())
-    return TYPE_ERROR("fd must be a file descriptor");
+ModuleResolver::PackageMain ModuleResolver::ReadPackageMain(
+    const std::string& dir) {
+  auto it = package_cache_.find(dir);
+  if (it != package_cache_.end())
+    return it->second;
 
-  int fd = args[0]->Int32Value();
+  PackageMain package = { kNotFound, std::string() };
 
-  // FIXME(bnoordhuis) It's questionable to reject non-ints here but still
-  // allow implicit coercion from null or undefined to zero.  Probably best
-  // handled in lib/fs.js.
-  Local<Value> len_v(args[1]);
-  if (!len_v->IsUndefined() &&
-      !len_v->IsNull() &&
-      !IsInt64(len_v->NumberValue())) {
-    return env->ThrowTypeError("Not an integer");
+  const std::string json_path = dir == "/" ? "/package.json"
+                                           : dir + "/package.json";
+  uv_fs_t req;
+  const int fd = uv_fs_open(loop_, &req, json_path.c_str(), O_RDONLY, 0,
+                            nullptr);
+  uv_fs_req_cleanup(&req);
+  if (fd < 0) {
+    package_cache_[dir] = package;
+    return package;
   }
 
-  const int64_t len = len_v->IntegerValue();
+  std::vector<char> chars;
+  bool ok = true;
+  for (;;) {
+    const size_t kBlockSize = 32 << 10;
+    const size_t start = chars.size();
+    chars.resize(start + kBlockSize);
+    uv_buf_t buf = uv_buf_init(&chars[start], kBlockSize);
+    const int nread = uv_fs_read(loop_, &req, fd, &buf, 1, -1, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (nread < 0) {
+      ok = false;
+      break;
+    }
+    chars.resize(start + nread);
+    if (nread == 0)
+      break;
+  }
+  uv_fs_close(loop_, &req, fd, nullptr);
+  uv_fs_req_cleanup(&req);
 
-  if (args[2]->IsObject()) {
-    ASYNC_CALL(ftruncate, args[2], UTF8, fd, len)
-  } else {
-    SYNC_CALL(ftruncate, 0, fd, len)
+  // Read and parse errors are left to the JS resolver, which reports them;
+  // they are not cached so that happens on every attempt.
+  if (!ok || !ParsePackageMain(chars.data(), chars.size(), &package)) {
+    package.status = kFallback;
+    return package;
   }
+
+  package_cache_[dir] = package;
+  return package;
 }
 
-static void Fdatasync(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
 
-  if (args.Length() < 1)
-    return TYPE_ERROR("fd is required");
-  if (!args[0]->IsInt32())
-    return TYPE_ERROR("fd must be a file descriptor");
+// tryFile() in lib/module.js.
+ModuleResolver::Status ModuleResolver::TryFile(const std::string& path,
+                                               std::string* filename) {
+  if (Stat(path) != 0)
+    return kNotFound;
+  if (preserve_symlinks_)
+    return ResolvePath(std::string(), path, filename) ? kFound : kFallback;
+  return RealPath(path, filename);
+}
 
-  int fd = args[0]->Int32Value();
 
-  if (args[1]->IsObject()) {
-    ASYNC_CALL(fdatasync, args[1], UTF8, fd)
-  } else {
-    SYNC_CALL(fdatasync, 0, fd)
+// tryExtensions() in lib/module.js.
+ModuleResolver::Status ModuleResolver::TryExtensions(const std::string& path,
+                                                     std::string* filename) {
+  for (size_t i = 0; i < exts_->size(); i++) {
+    const Status status = TryFile(path + (*exts_)[i], filename);
+    if (status != kNotFound)
+      return status;
   }
+  return kNotFound;
 }
 
-static void Fsync(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
-
-  if (args.Length() < 1)
-    return TYPE_ERROR("fd is required");
-  if (!args[0]->IsInt32())
-    return TYPE_ERROR("fd must be a file descriptor");
 
-  int fd = args[0]->Int32Value();
+// tryPackage() in lib/module.js.
+ModuleResolver::Status ModuleResolver::TryPackage(const std::string& dir,
+                                                  std::string* filename) {
+  const PackageMain package = ReadPackageMain(dir);
+  if (package.status != kFound)
+    return package.status;
 
-  if (args[1]->IsObject()) {
-    ASYNC_CALL(fsync, args[1], UTF8, fd)
-  } else {
-    SYNC_CALL(fsync, 0, fd)
+  std::string main;
+  std::string index;
+  if (!ResolvePath(dir, package.main, &main) ||
+      !ResolvePath(main, "index", &index)) {
+    return kFallback;
   }
+
+  Status status = TryFile(main, filename);
+  if (status == kNotFound)
+    status = TryExtensions(main, filename);
+  if (status == kNotFound)
+    status = TryExtensions(index, filename);
+  return status;
 }
 
-static void Unlink(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
 
-  if (args.Length() < 1)
-    return TYPE_ERROR("path required");
+// The loop of Module._findPath() in lib/module.js.
+ModuleResolver::Status ModuleResolver::FindPath(
+    const std::string& request,
+    const std::vector<std::string>& paths,
+    std::string* filename) {
+  const bool trailing_slash = !request.empty() && request.back() == '/';
+
+  for (size_t i = 0; i < paths.size(); i++) {
+    const std::string& cur_path = paths[i];
+    if (!cur_path.empty() && Stat(cur_path) < 1)
+      continue;
+
+    std::string base_path;
+    if (!ResolvePath(cur_path, request, &base_path))
+      return kFallback;
+
+    Status status = kNotFound;
+    if (!trailing_slash) {
+      const int rc = Stat(base_path);
+      if (rc == 0) {  // File.
+        if (preserve_symlinks_) {
+          *filename = base_path;
+          status = kFound;
+        } else {
+          status = RealPath(base_path, filename);
+        }
+      } else if (rc == 1) {  // Directory.
+        status = TryPackage(base_path, filename);
+      }
 
-  BufferValue path(env->isolate(), args[0]);
-  ASSERT_PATH(path)
+      if (status == kNotFound)
+        status = TryExtensions(base_path, filename);
+    }
+
+    if (status == kNotFound)
+      status = TryPackage(base_path, filename);
+
+    if (status == kNotFound) {
+      std::string index;
+      if (!ResolvePath(base_path, "index", &index))
+        return kFallback;
+      status = TryExtensions(index, filename);
+    }
+
+    if (status != kNotFound)
+      return status;
+  }
+
+  return kNotFound;
+}
+
+
+ModuleResolver::Status ModuleResolver::Resolve(
+    const std::string& request,
+    const std::vector<std::string>& paths,
+    const std::vector<std::string>& exts,
+    bool preserve_symlinks,
+    std::string* filename) {
+  std::string key(request);
+  for (size_t i = 0; i < paths.size(); i++) {
+    key += '\0';
+    key += paths[i];
+  }
+  key += '\0';
+  key += preserve_symlinks ? '1' : '0';
+
+  auto it = resolution_cache_.find(key);
+  if (it != resolution_cache_.end()) {
+    // Entries from the manifest may be stale.
+    if (it->second.verified || Stat(it->second.filename) == 0) {
+      it->second.verified = true;
+      *filename = it->second.filename;
+      return kFound;
+    }
+    resolution_cache_.erase(it);
+    manifest_dirty_ = true;
+  }
+
+  exts_ = &exts;
+  preserve_symlinks_ = preserve_symlinks;
+  const Status status = FindPath(request, paths, filename);
+  exts_ = nullptr;
+
+  if (status == kFound) {
+    Resolution& resolution = resolution_cache_[key];
+    resolution.filename = *filename;
+    resolution.verified = true;
+    manifest_dirty_ = true;
+  }
+
+  return status;
+}
+
+
+void ModuleResolver::EnableStatCache(bool enable) {
+  // Also cleared when enabling, so that a cache that was never disabled
+  // doesn't carry stale results into the next top-level require().
+  stat_cache_enabled_ = enable;
+  stat_cache_.clear();
+  realpath_cache_.clear();
+  cwd_.clear();
+}
+
+
+void ModuleResolver::ClearCache() {
+  if (!resolution_cache_.empty())
+    manifest_dirty_ = true;
+  resolution_cache_.clear();
+}
+
+
+static const char kManifestMagic[] = "node-resolve-manifest 1\n";
+
+
+// The manifest is the magic string followed by (key, filename) records, each
+// string prefixed by its length as a native endian uint32_t.
+bool ModuleResolver::LoadManifest(const char* path) {
+  if (manifest_path_.empty())
+    AtExit(SaveManifestAtExit, this);
+  manifest_path_ = path;
+
+  uv_fs_t req;
+  const int fd = uv_fs_open(loop_, &req, path, O_RDONLY, 0, nullptr);
+  uv_fs_req_cleanup(&req);
+  if (fd < 0)
+    return false;
+
+  std::vector<char> data;
+  bool ok = true;
+  for (;;) {
+    const size_t kBlockSize = 64 << 10;
+    const size_t start = data.size();
+    data.resize(start + kBlockSize);
+    uv_buf_t buf = uv_buf_init(&data[start], kBlockSize);
+    const int nread = uv_fs_read(loop_, &req, fd, &buf, 1, -1, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (nread < 0) {
+      ok = false;
+      break;
+    }
+    data.resize(start + nread);
+    if (nread == 0)
+      break;
+  }
+  uv_fs_close(loop_, &req, fd, nullptr);
+  uv_fs_req_cleanup(&req);
+
+  const size_t magic_length = sizeof(kManifestMagic) - 1;
+  if (!ok || data.size() < magic_length ||
+      memcmp(data.data(), kManifestMagic, magic_length) != 0) {
+    return false;
+  }
+
+  std::vector<std::pair<std::string, std::string>> records;
+  size_t offset = magic_length;
+  while (offset < data.size()) {
+    std::string strings[2];
+    for (int i = 0; i < 2; i++) {
+      uint32_t length;
+      if (data.size() - offset < sizeof(length))
+        return false;
+      memcpy(&length, &data[offset], sizeof(length));
+      offset += sizeof(length);
+      if (data.size() - offset < length)
+        return false;
+      strings[i].assign(&data[offset], length);
+      offset += length;
+    }
+    records.push_back(std::make_pair(strings[0], strings[1]));
+  }
+
+  for (size_t i = 0; i < records.size(); i++) {
+    if (resolution_cache_.count(records[i].first) == 0) {
+      Resolution& resolution = resolution_cache_[records[i].first];
+      resolution.filename = records[i].second;
+      resolution.verified = false;
+    }
+  }
+
+  return true;
+}
+
+
+void ModuleResolver::SaveManifestAtExit(void* arg) {
+  static_cast<ModuleResolver*>(arg)->SaveManifest();
+}
+
+
+// Writes the manifest to a temporary file first and renames it into place,
+// so concurrent processes never see a partial manifest.
+int ModuleResolver::SaveManifest() {
+  if (!manifest_dirty_ || manifest_path_.empty())
+    return 0;
+
+  const char* path = manifest_path_.c_str();
+
+  std::string data(kManifestMagic);
+  for (auto it = resolution_cache_.begin();
+       it != resolution_cache_.end();
+       ++it) {
+    const std::string* strings[] = { &it->first, &it->second.filename };
+    for (int i = 0; i < 2; i++) {
+      const uint32_t length = strings[i]->size();
+      data.append(reinterpret_cast<const char*>(&length), sizeof(length));
+      data.append(*strings[i]);
+    }
+  }
+
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), ".%d.tmp", static_cast<int>(getpid()));
+  const std::string tmp_path = std::string(path) + suffix;
+
+  uv_fs_t req;
+  const int fd = uv_fs_open(loop_,
+                            &req,
+                            tmp_path.c_str(),
+                            O_WRONLY | O_CREAT | O_TRUNC,
+                            0666,
+                            nullptr);
+  uv_fs_req_cleanup(&req);
+  if (fd < 0)
+    return fd;
+
+  int err = 0;
+  size_t offset = 0;
+  while (offset < data.size()) {
+    uv_buf_t buf = uv_buf_init(&data[offset], data.size() - offset);
+    const int nwritten = uv_fs_write(loop_, &req, fd, &buf, 1, -1, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (nwritten < 0) {
+      err = nwritten;
+      break;
+    }
+    offset += nwritten;
+  }
+
+  const int rc = uv_fs_close(loop_, &req, fd, nullptr);
+  uv_fs_req_cleanup(&req);
+  if (err == 0)
+    err = rc;
+  if (err == 0) {
+    err = uv_fs_rename(loop_, &req, tmp_path.c_str(), path, nullptr);
+    uv_fs_req_cleanup(&req);
+  }
+  if (err != 0) {
+    uv_fs_unlink(loop_, &req, tmp_path.c_str(), nullptr);
+    uv_fs_req_cleanup(&req);
+    return err;
+  }
+
+  manifest_dirty_ = false;
+  return 0;
+}
+
+
+// filename = internalModuleResolve(request, paths, exts, preserveSymlinks)
+// Returns the resolved filename, false if the module was not found or
+// undefined if the JS resolver should take over.
+static void InternalModuleResolve(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  CHECK(args[0]->IsString());
+  CHECK(args[1]->IsArray());
+  CHECK(args[2]->IsArray());
+
+  node::Utf8Value request(env->isolate(), args[0]);
+
+  std::vector<std::string> paths;
+  Local<Array> paths_array = args[1].As<Array>();
+  for (uint32_t i = 0; i < paths_array->Length(); i++) {
+    Local<Value> value = paths_array->Get(env->context(), i).ToLocalChecked();
+    node::Utf8Value path(env->isolate(), value);
+    paths.push_back(std::string(*path, path.length()));
+  }
+
+  std::vector<std::string> exts;
+  Local<Array> exts_array = args[2].As<Array>();
+  for (uint32_t i = 0; i < exts_array->Length(); i++) {
+    Local<Value> value = exts_array->Get(env->context(), i).ToLocalChecked();
+    node::Utf8Value ext(env->isolate(), value);
+    exts.push_back(std::string(*ext, ext.length()));
+  }
+
+  std::string filename;
+  switch (GetModuleResolver(env)->Resolve(
+      std::string(*request, request.length()),
+      paths,
+      exts,
+      args[3]->IsTrue(),
+      &filename)) {
+    case ModuleResolver::kFound:
+      args.GetReturnValue().Set(
+          String::NewFromUtf8(env->isolate(),
+                              filename.data(),
+                              String::kNormalString,
+                              filename.size()));
+      break;
+    case ModuleResolver::kNotFound:
+      args.GetReturnValue().Set(false);
+      break;
+    case ModuleResolver::kFallback:
+      break;
+  }
+}
+
+
+// Enables the stat cache of the resolver for the duration of the outermost
+// require() call, like stat.cache in lib/module.js.
+static void InternalModuleStatCache(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  GetModuleResolver(env)->EnableStatCache(args[0]->IsTrue());
+}
+
+
+static void InternalModuleLoadManifest(
+    const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args[0]->IsString());
+  node::Utf8Value path(env->isolate(), args[0]);
+  args.GetReturnValue().Set(GetModuleResolver(env)->LoadManifest(*path));
+}
+
+
+// Drops the resolved filenames, lib/module.js calls this when it finds that
+// Module._pathCache was cleared.
+static void InternalModuleClearCache(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  GetModuleResolver(env)->ClearCache();
+}
+#endif  // _WIN32
+
+
+void DeleteModuleResolver(ModuleResolver* resolver) {
+#ifndef _WIN32
+  delete resolver;
+#else
+  CHECK_EQ(resolver, nullptr);
+#endif
+}
+
+
+static void Stat(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  if (args.Length() < 1)
+    return TYPE_ERROR("path required");
+
+  BufferValue path(env->isolate(), args[0]);
+  ASSERT_PATH(path)
 
   if (args[1]->IsObject()) {
-    ASYNC_CALL(unlink, args[1], UTF8, *path)
+    ASYNC_CALL(stat, args[1], UTF8, *path)
   } else {
-    SYNC_CALL(unlink, *path, *path)
+    SYNC_CALL(stat, *path, *path)
+    args.GetReturnValue().Set(
+        BuildStatsObject(env, static_cast<const uv_stat_t*>(SYNC_REQ.ptr)));
   }
 }
 
-static void RMDir(const FunctionCallbackInfo<Value>& args) {
+static void LStat(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
   if (args.Length() < 1)
@@ -871,33 +1592,90 @@ static void RMDir(const FunctionCallbackInfo<Value>& args) {
   ASSERT_PATH(path)
 
   if (args[1]->IsObject()) {
-    ASYNC_CALL(rmdir, args[1], UTF8, *path)
+    ASYNC_CALL(lstat, args[1], UTF8, *path)
   } else {
-    SYNC_CALL(rmdir, *path, *path)
+    SYNC_CALL(lstat, *path, *path)
+    args.GetReturnValue().Set(
+        BuildStatsObject(env, static_cast<const uv_stat_t*>(SYNC_REQ.ptr)));
   }
 }
 
-static void MKDir(const FunctionCallbackInfo<Value>& args) {
+static void FStat(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
-  if (args.Length() < 2)
-    return TYPE_ERROR("path and mode are required");
-  if (!args[1]->IsInt32())
-    return TYPE_ERROR("mode must be an integer");
+  if (args.Length() < 1)
+    return TYPE_ERROR("fd is required");
+  if (!args[0]->IsInt32())
+    return TYPE_ERROR("fd must be a file descriptor");
 
-  BufferValue path(env->isolate(), args[0]);
+  int fd = args[0]->Int32Value();
+
+  if (args[1]->IsObject()) {
+    ASYNC_CALL(fstat, args[1], UTF8, fd)
+  } else {
+    SYNC_CALL(fstat, 0, fd)
+    args.GetReturnValue().Set(
+        BuildStatsObject(env, static_cast<const uv_stat_t*>(SYNC_REQ.ptr)));
+  }
+}
+
+static void Symlink(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  int len = args.Length();
+  if (len < 1)
+    return TYPE_ERROR("target path required");
+  if (len < 2)
+    return TYPE_ERROR("src path required");
+
+  BufferValue target(env->isolate(), args[0]);
+  ASSERT_PATH(target)
+  BufferValue path(env->isolate(), args[1]);
   ASSERT_PATH(path)
 
-  int mode = static_cast<int>(args[1]->Int32Value());
+  int flags = 0;
+
+  if (args[2]->IsString()) {
+    node::Utf8Value mode(env->isolate(), args[2]);
+    if (strcmp(*mode, "dir") == 0) {
+      flags |= UV_FS_SYMLINK_DIR;
+    } else if (strcmp(*mode, "junction") == 0) {
+      flags |= UV_FS_SYMLINK_JUNCTION;
+    } else if (strcmp(*mode, "file") != 0) {
+      return env->ThrowError("Unknown symlink type");
+    }
+  }
+
+  if (args[3]->IsObject()) {
+    ASYNC_DEST_CALL(symlink, args[3], *path, UTF8, *target, *path, flags)
+  } else {
+    SYNC_DEST_CALL(symlink, *target, *path, *target, *path, flags)
+  }
+}
+
+static void Link(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  int len = args.Length();
+  if (len < 1)
+    return TYPE_ERROR("src path required");
+  if (len < 2)
+    return TYPE_ERROR("dest path required");
+
+  BufferValue src(env->isolate(), args[0]);
+  ASSERT_PATH(src)
+
+  BufferValue dest(env->isolate(), args[1]);
+  ASSERT_PATH(dest)
 
   if (args[2]->IsObject()) {
-    ASYNC_CALL(mkdir, args[2], UTF8, *path, mode)
+    ASYNC_DEST_CALL(link, args[2], *dest, UTF8, *src, *dest)
   } else {
-    SYNC_CALL(mkdir, *path, *path, mode)
+    SYNC_DEST_CALL(link, *src, *dest, *src, *dest)
   }
 }
 
-static void RealPath(const FunctionCallbackInfo<Value>& args) {
+static void ReadLink(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
   const int argc = args.Length();
@@ -915,51 +1693,222 @@ static void RealPath(const FunctionCallbackInfo<Value>& args) {
     callback = args[2];
 
   if (callback->IsObject()) {
-    ASYNC_CALL(realpath, callback, encoding, *path);
+    ASYNC_CALL(readlink, callback, encoding, *path)
   } else {
-    SYNC_CALL(realpath, *path, *path);
+    SYNC_CALL(readlink, *path, *path)
     const char* link_path = static_cast<const char*>(SYNC_REQ.ptr);
     Local<Value> rc = StringBytes::Encode(env->isolate(),
                                           link_path,
                                           encoding);
     if (rc.IsEmpty()) {
       return env->ThrowUVException(UV_EINVAL,
-                                   "realpath",
-                                   "Invalid character encoding for path",
+                                   "readlink",
+                                   "Invalid character encoding for link",
                                    *path);
     }
     args.GetReturnValue().Set(rc);
   }
 }
 
-static void ReadDir(const FunctionCallbackInfo<Value>& args) {
+static void Rename(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
-  const int argc = args.Length();
-
-  if (argc < 1)
-    return TYPE_ERROR("path required");
+  int len = args.Length();
+  if (len < 1)
+    return TYPE_ERROR("old path required");
+  if (len < 2)
+    return TYPE_ERROR("new path required");
 
-  BufferValue path(env->isolate(), args[0]);
-  ASSERT_PATH(path)
+  BufferValue old_path(env->isolate(), args[0]);
+  ASSERT_PATH(old_path)
+  BufferValue new_path(env->isolate(), args[1]);
+  ASSERT_PATH(new_path)
 
-  const enum encoding encoding = ParseEncoding(env->isolate(), args[1], UTF8);
+  if (args[2]->IsObject()) {
+    ASYNC_DEST_CALL(rename, args[2], *new_path, UTF8, *old_path, *new_path)
+  } else {
+    SYNC_DEST_CALL(rename, *old_path, *new_path, *old_path, *new_path)
+  }
+}
 
-  Local<Value> callback = Null(env->isolate());
-  if (argc == 3)
-    callback = args[2];
+static void FTruncate(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
 
-  if (callback->IsObject()) {
-    ASYNC_CALL(scandir, callback, encoding, *path, 0 /*flags*/)
-  } else {
-    SYNC_CALL(scandir, *path, *path, 0 /*flags*/)
+  if (args.Length() < 2)
+    return TYPE_ERROR("fd and length are required");
+  if (!args[0]->IsInt32())
+    return TYPE_ERROR("fd must be a file descriptor");
 
-    CHECK_GE(SYNC_REQ.result, 0);
-    int r;
-    Local<Array> names = Array::New(env->isolate(), 0);
-    Local<Function> fn = env->push_values_to_array_function();
-    Local<Value> name_v[NODE_PUSH_VAL_TO_ARRAY_MAX];
-    size_t name_idx = 0;
+  int fd = args[0]->Int32Value();
+
+  // FIXME(bnoordhuis) It's questionable to reject non-ints here but still
+  // allow implicit coercion from null or undefined to zero.  Probably best
+  // handled in lib/fs.js.
+  Local<Value> len_v(args[1]);
+  if (!len_v->IsUndefined() &&
+      !len_v->IsNull() &&
+      !IsInt64(len_v->NumberValue())) {
+    return env->ThrowTypeError("Not an integer");
+  }
+
+  const int64_t len = len_v->IntegerValue();
+
+  if (args[2]->IsObject()) {
+    ASYNC_CALL(ftruncate, args[2], UTF8, fd, len)
+  } else {
+    SYNC_CALL(ftruncate, 0, fd, len)
+  }
+}
+
+static void Fdatasync(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  if (args.Length() < 1)
+    return TYPE_ERROR("fd is required");
+  if (!args[0]->IsInt32())
+    return TYPE_ERROR("fd must be a file descriptor");
+
+  int fd = args[0]->Int32Value();
+
+  if (args[1]->IsObject()) {
+    ASYNC_CALL(fdatasync, args[1], UTF8, fd)
+  } else {
+    SYNC_CALL(fdatasync, 0, fd)
+  }
+}
+
+static void Fsync(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  if (args.Length() < 1)
+    return TYPE_ERROR("fd is required");
+  if (!args[0]->IsInt32())
+    return TYPE_ERROR("fd must be a file descriptor");
+
+  int fd = args[0]->Int32Value();
+
+  if (args[1]->IsObject()) {
+    ASYNC_CALL(fsync, args[1], UTF8, fd)
+  } else {
+    SYNC_CALL(fsync, 0, fd)
+  }
+}
+
+static void Unlink(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  if (args.Length() < 1)
+    return TYPE_ERROR("path required");
+
+  BufferValue path(env->isolate(), args[0]);
+  ASSERT_PATH(path)
+
+  if (args[1]->IsObject()) {
+    ASYNC_CALL(unlink, args[1], UTF8, *path)
+  } else {
+    SYNC_CALL(unlink, *path, *path)
+  }
+}
+
+static void RMDir(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  if (args.Length() < 1)
+    return TYPE_ERROR("path required");
+
+  BufferValue path(env->isolate(), args[0]);
+  ASSERT_PATH(path)
+
+  if (args[1]->IsObject()) {
+    ASYNC_CALL(rmdir, args[1], UTF8, *path)
+  } else {
+    SYNC_CALL(rmdir, *path, *path)
+  }
+}
+
+static void MKDir(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  if (args.Length() < 2)
+    return TYPE_ERROR("path and mode are required");
+  if (!args[1]->IsInt32())
+    return TYPE_ERROR("mode must be an integer");
+
+  BufferValue path(env->isolate(), args[0]);
+  ASSERT_PATH(path)
+
+  int mode = static_cast<int>(args[1]->Int32Value());
+
+  if (args[2]->IsObject()) {
+    ASYNC_CALL(mkdir, args[2], UTF8, *path, mode)
+  } else {
+    SYNC_CALL(mkdir, *path, *path, mode)
+  }
+}
+
+static void RealPath(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  const int argc = args.Length();
+
+  if (argc < 1)
+    return TYPE_ERROR("path required");
+
+  BufferValue path(env->isolate(), args[0]);
+  ASSERT_PATH(path)
+
+  const enum encoding encoding = ParseEncoding(env->isolate(), args[1], UTF8);
+
+  Local<Value> callback = Null(env->isolate());
+  if (argc == 3)
+    callback = args[2];
+
+  if (callback->IsObject()) {
+    ASYNC_CALL(realpath, callback, encoding, *path);
+  } else {
+    SYNC_CALL(realpath, *path, *path);
+    const char* link_path = static_cast<const char*>(SYNC_REQ.ptr);
+    Local<Value> rc = StringBytes::Encode(env->isolate(),
+                                          link_path,
+                                          encoding);
+    if (rc.IsEmpty()) {
+      return env->ThrowUVException(UV_EINVAL,
+                                   "realpath",
+                                   "Invalid character encoding for path",
+                                   *path);
+    }
+    args.GetReturnValue().Set(rc);
+  }
+}
+
+static void ReadDir(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  const int argc = args.Length();
+
+  if (argc < 1)
+    return TYPE_ERROR("path required");
+
+  BufferValue path(env->isolate(), args[0]);
+  ASSERT_PATH(path)
+
+  const enum encoding encoding = ParseEncoding(env->isolate(), args[1], UTF8);
+
+  Local<Value> callback = Null(env->isolate());
+  if (argc == 3)
+    callback = args[2];
+
+  if (callback->IsObject()) {
+    ASYNC_CALL(scandir, callback, encoding, *path, 0 /*flags*/)
+  } else {
+    SYNC_CALL(scandir, *path, *path, 0 /*flags*/)
+
+    CHECK_GE(SYNC_REQ.result, 0);
+    int r;
+    Local<Array> names = Array::New(env->isolate(), 0);
+    Local<Function> fn = env->push_values_to_array_function();
+    Local<Value> name_v[NODE_PUSH_VAL_TO_ARRAY_MAX];
+    size_t name_idx = 0;
 
     for (int i = 0; ; i++) {
       uv_dirent_t ent;
@@ -1024,229 +1973,1047 @@ static void Open(const FunctionCallbackInfo<Value>& args) {
     SYNC_CALL(open, *path, *path, flags, mode)
     args.GetReturnValue().Set(SYNC_RESULT);
   }
-}
+}
+
+
+// Wrapper for write(2).
+//
+// bytesWritten = write(fd, buffer, offset, length, position, callback)
+// 0 fd        integer. file descriptor
+// 1 buffer    the data to write
+// 2 offset    where in the buffer to start from
+// 3 length    how much to write
+// 4 position  if integer, position to write at in the file.
+//             if null, write from the current position
+static void WriteBuffer(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  if (!args[0]->IsInt32())
+    return env->ThrowTypeError("First argument must be file descriptor");
+
+  CHECK(Buffer::HasInstance(args[1]));
+
+  int fd = args[0]->Int32Value();
+  Local<Object> obj = args[1].As<Object>();
+  const char* buf = Buffer::Data(obj);
+  size_t buffer_length = Buffer::Length(obj);
+  size_t off = args[2]->Uint32Value();
+  size_t len = args[3]->Uint32Value();
+  int64_t pos = GET_OFFSET(args[4]);
+  Local<Value> req = args[5];
+
+  if (off > buffer_length)
+    return env->ThrowRangeError("offset out of bounds");
+  if (len > buffer_length)
+    return env->ThrowRangeError("length out of bounds");
+  if (off + len < off)
+    return env->ThrowRangeError("off + len overflow");
+  if (!Buffer::IsWithinBounds(off, len, buffer_length))
+    return env->ThrowRangeError("off + len > buffer.length");
+
+  buf += off;
+
+  uv_buf_t uvbuf = uv_buf_init(const_cast<char*>(buf), len);
+
+  if (req->IsObject()) {
+    ASYNC_CALL(write, req, UTF8, fd, &uvbuf, 1, pos)
+    return;
+  }
+
+  SYNC_CALL(write, nullptr, fd, &uvbuf, 1, pos)
+  args.GetReturnValue().Set(SYNC_RESULT);
+}
+
+
+// Wrapper for writev(2).
+//
+// bytesWritten = writev(fd, chunks, position, callback)
+// 0 fd        integer. file descriptor
+// 1 chunks    array of buffers to write
+// 2 position  if integer, position to write at in the file.
+//             if null, write from the current position
+static void WriteBuffers(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  CHECK(args[0]->IsInt32());
+  CHECK(args[1]->IsArray());
+
+  int fd = args[0]->Int32Value();
+  Local<Array> chunks = args[1].As<Array>();
+  int64_t pos = GET_OFFSET(args[2]);
+  Local<Value> req = args[3];
+
+  MaybeStackBuffer<uv_buf_t> iovs(chunks->Length());
+
+  for (uint32_t i = 0; i < iovs.length(); i++) {
+    Local<Value> chunk = chunks->Get(i);
+
+    if (!Buffer::HasInstance(chunk))
+      return env->ThrowTypeError("Array elements all need to be buffers");
+
+    iovs[i] = uv_buf_init(Buffer::Data(chunk), Buffer::Length(chunk));
+  }
+
+  if (req->IsObject()) {
+    ASYNC_CALL(write, req, UTF8, fd, *iovs, iovs.length(), pos)
+    return;
+  }
+
+  SYNC_CALL(write, nullptr, fd, *iovs, iovs.length(), pos)
+  args.GetReturnValue().Set(SYNC_RESULT);
+}
+
+
+// Wrapper for write(2).
+//
+// bytesWritten = write(fd, string, position, enc, callback)
+// 0 fd        integer. file descriptor
+// 1 string    non-buffer values are converted to strings
+// 2 position  if integer, position to write at in the file.
+//             if null, write from the current position
+// 3 enc       encoding of string
+static void WriteString(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  if (!args[0]->IsInt32())
+    return env->ThrowTypeError("First argument must be file descriptor");
+
+  Local<Value> req;
+  Local<Value> string = args[1];
+  int fd = args[0]->Int32Value();
+  char* buf = nullptr;
+  int64_t pos;
+  size_t len;
+  FSReqWrap::Ownership ownership = FSReqWrap::COPY;
+
+  // will assign buf and len if string was external
+  if (!StringBytes::GetExternalParts(env->isolate(),
+                                     string,
+                                     const_cast<const char**>(&buf),
+                                     &len)) {
+    enum encoding enc = ParseEncoding(env->isolate(), args[3], UTF8);
+    len = StringBytes::StorageSize(env->isolate(), string, enc);
+    buf = new char[len];
+    // StorageSize may return too large a char, so correct the actual length
+    // by the write size
+    len = StringBytes::Write(env->isolate(), buf, len, args[1], enc);
+    ownership = FSReqWrap::MOVE;
+  }
+  pos = GET_OFFSET(args[2]);
+  req = args[4];
+
+  uv_buf_t uvbuf = uv_buf_init(const_cast<char*>(buf), len);
+
+  if (!req->IsObject()) {
+    // SYNC_CALL returns on error.  Make sure to always free the memory.
+    struct Delete {
+      inline explicit Delete(char* pointer) : pointer_(pointer) {}
+      inline ~Delete() { delete[] pointer_; }
+      char* const pointer_;
+    };
+    Delete delete_on_return(ownership == FSReqWrap::MOVE ? buf : nullptr);
+    SYNC_CALL(write, nullptr, fd, &uvbuf, 1, pos)
+    return args.GetReturnValue().Set(SYNC_RESULT);
+  }
+
+  FSReqWrap* req_wrap =
+      FSReqWrap::New(env, req.As<Object>(), "write", buf, UTF8, ownership);
+  int err = uv_fs_write(env->event_loop(),
+                        &req_wrap->req_,
+                        fd,
+                        &uvbuf,
+                        1,
+                        pos,
+                        After);
+  req_wrap->Dispatched();
+  if (err < 0) {
+    uv_fs_t* uv_req = &req_wrap->req_;
+    uv_req->result = err;
+    uv_req->path = nullptr;
+    After(uv_req);
+    return;
+  }
+
+  return args.GetReturnValue().Set(req_wrap->persistent());
+}
+
+
+/*
+ * Wrapper for read(2).
+ *
+ * bytesRead = fs.read(fd, buffer, offset, length, position)
+ *
+ * 0 fd        integer. file descriptor
+ * 1 buffer    instance of Buffer
+ * 2 offset    integer. offset to start reading into inside buffer
+ * 3 length    integer. length to read
+ * 4 position  file position - null for current position
+ *
+ */
+static void Read(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  if (args.Length() < 2)
+    return TYPE_ERROR("fd and buffer are required");
+  if (!args[0]->IsInt32())
+    return TYPE_ERROR("fd must be a file descriptor");
+  if (!Buffer::HasInstance(args[1]))
+    return TYPE_ERROR("Second argument needs to be a buffer");
+
+  int fd = args[0]->Int32Value();
+
+  Local<Value> req;
+
+  size_t len;
+  int64_t pos;
+
+  char * buf = nullptr;
+
+  Local<Object> buffer_obj = args[1]->ToObject(env->isolate());
+  char *buffer_data = Buffer::Data(buffer_obj);
+  size_t buffer_length = Buffer::Length(buffer_obj);
+
+  size_t off = args[2]->Int32Value();
+  if (off >= buffer_length) {
+    return env->ThrowError("Offset is out of bounds");
+  }
+
+  len = args[3]->Int32Value();
+  if (!Buffer::IsWithinBounds(off, len, buffer_length))
+    return env->ThrowRangeError("Length extends beyond buffer");
+
+  pos = GET_OFFSET(args[4]);
+
+  buf = buffer_data + off;
+
+  uv_buf_t uvbuf = uv_buf_init(const_cast<char*>(buf), len);
+
+  req = args[5];
+
+  if (req->IsObject()) {
+    ASYNC_CALL(read, req, UTF8, fd, &uvbuf, 1, pos);
+  } else {
+    SYNC_CALL(read, 0, fd, &uvbuf, 1, pos)
+    args.GetReturnValue().Set(SYNC_RESULT);
+  }
+}
+
+
+// Base class for fs operations that are made up of several blocking uv_fs_*
+// calls and run as a single threadpool job, or synchronously.  The blocking
+// uv_fs_* calls don't touch the event loop so they are safe to make from a
+// worker thread.
+class FSWorkWrap : public ReqWrap<uv_work_t> {
+ public:
+  FSWorkWrap(Environment* env, Local<Object> req)
+      : ReqWrap(env, req, AsyncWrap::PROVIDER_FSREQWRAP),
+        err_(0),
+        syscall_(nullptr) {
+    Wrap(object(), this);
+  }
+
+  // Queues |req_wrap| on the threadpool when |req| is an object and calls
+  // its oncomplete method when done, otherwise runs it synchronously and
+  // returns the result or throws.
+  static void Dispatch(const FunctionCallbackInfo<Value>& args,
+                       Local<Value> req,
+                       FSWorkWrap* req_wrap);
+
+  static Local<Object> NewSyncReq(Environment* env, Local<Value> req) {
+    return req->IsObject() ? req.As<Object>() : env->NewInternalFieldObject();
+  }
+
+  size_t self_size() const override { return sizeof(*this); }
+
+ protected:
+  // Runs on the threadpool.  Sets err_ and syscall_ on failure.
+  virtual void Work(uv_loop_t* loop) = 0;
+  // Returns the error, or null on success with the result in |result|.
+  virtual Local<Value> Result(Local<Value>* result) = 0;
+
+  int err_;
+  const char* syscall_;
+
+ private:
+  static void DoWork(uv_work_t* req);
+  static void AfterWork(uv_work_t* req, int status);
+};
+
+
+void FSWorkWrap::Dispatch(const FunctionCallbackInfo<Value>& args,
+                          Local<Value> req,
+                          FSWorkWrap* req_wrap) {
+  Environment* env = req_wrap->env();
+  req_wrap->Dispatched();
+
+  if (req->IsObject()) {
+    int err = uv_queue_work(env->event_loop(),
+                            &req_wrap->req_,
+                            DoWork,
+                            AfterWork);
+    CHECK_EQ(err, 0);
+    args.GetReturnValue().Set(req_wrap->persistent());
+    return;
+  }
+
+  env->PrintSyncTrace();
+  req_wrap->Work(env->event_loop());
+
+  Local<Value> result = Undefined(env->isolate());
+  Local<Value> err = req_wrap->Result(&result);
+  delete req_wrap;
+
+  if (!err->IsNull())
+    env->isolate()->ThrowException(err);
+  else
+    args.GetReturnValue().Set(result);
+}
+
+
+void FSWorkWrap::DoWork(uv_work_t* req) {
+  FSWorkWrap* req_wrap = ContainerOf(&FSWorkWrap::req_, req);
+  req_wrap->Work(req->loop);
+}
+
+
+void FSWorkWrap::AfterWork(uv_work_t* req, int status) {
+  CHECK_EQ(status, 0);
+  FSWorkWrap* req_wrap = ContainerOf(&FSWorkWrap::req_, req);
+  Environment* env = req_wrap->env();
+  HandleScope handle_scope(env->isolate());
+  Context::Scope context_scope(env->context());
+
+  Local<Value> argv[2] = { Null(env->isolate()), Undefined(env->isolate()) };
+  argv[0] = req_wrap->Result(&argv[1]);
+  int argc = argv[0]->IsNull() && !argv[1]->IsUndefined() ? 2 : 1;
+  req_wrap->MakeCallback(env->oncomplete_string(), argc, argv);
+
+  delete req_wrap;
+}
+
+
+// Reads a whole file in one go: open, fstat, read and close.  Regular files
+// are read into one allocation of the size fstat reports, other files (and
+// files whose size the kernel lies about) are read in growing chunks until
+// EOF.
+class ReadFileWrap : public FSWorkWrap {
+ public:
+  ReadFileWrap(Environment* env,
+               Local<Object> req,
+               const char* path,
+               int flags,
+               enum encoding encoding)
+      : FSWorkWrap(env, req),
+        path_(path),
+        flags_(flags),
+        encoding_(encoding),
+        data_(nullptr),
+        length_(0) {
+  }
+
+  ~ReadFileWrap() override { free(data_); }
+
+  size_t self_size() const override { return sizeof(*this); }
+
+ protected:
+  void Work(uv_loop_t* loop) override;
+  Local<Value> Result(Local<Value>* result) override;
+
+ private:
+  int Read(uv_loop_t* loop, int fd);
+
+  const std::string path_;
+  const int flags_;
+  const enum encoding encoding_;
+  char* data_;
+  size_t length_;
+};
+
+
+void ReadFileWrap::Work(uv_loop_t* loop) {
+  uv_fs_t req;
+
+  const int fd = uv_fs_open(loop, &req, path_.c_str(), flags_, 0666, nullptr);
+  uv_fs_req_cleanup(&req);
+  if (fd < 0) {
+    err_ = fd;
+    syscall_ = "open";
+    return;
+  }
+
+  err_ = Read(loop, fd);
+
+  const int rc = uv_fs_close(loop, &req, fd, nullptr);
+  uv_fs_req_cleanup(&req);
+  if (rc < 0 && err_ == 0) {
+    err_ = rc;
+    syscall_ = "close";
+  }
+}
+
+
+int ReadFileWrap::Read(uv_loop_t* loop, int fd) {
+  const size_t kChunkSize = 8 * 1024;
+  uv_fs_t req;
+  size_t size = 0;
+
+  int rc = uv_fs_fstat(loop, &req, fd, nullptr);
+  if (rc == 0) {
+    const uv_stat_t* const s = static_cast<const uv_stat_t*>(req.ptr);
+    if ((s->st_mode & S_IFMT) == S_IFREG)
+      size = s->st_size;
+  }
+  uv_fs_req_cleanup(&req);
+  if (rc < 0) {
+    syscall_ = "fstat";
+    return rc;
+  }
+
+  syscall_ = "read";
+  if (size > Buffer::kMaxLength)
+    return UV_EFBIG;
+
+  size_t capacity = size > 0 ? size : kChunkSize;
+  data_ = static_cast<char*>(node::Malloc(capacity));
+  if (data_ == nullptr)
+    return UV_ENOMEM;
+
+  for (;;) {
+    if (length_ == capacity) {
+      // Size unknown or the file grew, keep going until EOF.
+      if (capacity == Buffer::kMaxLength)
+        return UV_EFBIG;
+      capacity = MIN(2 * capacity, Buffer::kMaxLength);
+      char* data = static_cast<char*>(node::Realloc(data_, capacity));
+      if (data == nullptr)
+        return UV_ENOMEM;
+      data_ = data;
+    }
+
+    uv_buf_t buf = uv_buf_init(data_ + length_, capacity - length_);
+    const int nread = uv_fs_read(loop, &req, fd, &buf, 1, -1, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (nread < 0)
+      return nread;
+    if (nread == 0)
+      break;
+
+    length_ += nread;
+    if (size > 0 && length_ == size)
+      break;
+  }
+
+  return 0;
+}
+
+
+Local<Value> ReadFileWrap::Result(Local<Value>* result) {
+  Isolate* isolate = env()->isolate();
+
+  if (err_ == UV_EFBIG) {
+    char message[64];
+    snprintf(message, sizeof(message),
+             "File size is greater than possible Buffer: 0x%x bytes",
+             Buffer::kMaxLength);
+    return v8::Exception::RangeError(OneByteString(isolate, message));
+  }
+
+  if (err_ < 0)
+    return UVException(isolate, err_, syscall_, nullptr, path_.c_str());
+
+  if (encoding_ == BUFFER) {
+    // Hand the allocation over to the Buffer, trimmed to what was read.
+    // Empty files don't hold on to the initial chunk.
+    char* data = nullptr;
+    if (length_ > 0) {
+      data = static_cast<char*>(node::Realloc(data_, length_));
+      if (data == nullptr)
+        data = data_;
+    } else {
+      free(data_);
+    }
+    data_ = nullptr;
+    *result = Buffer::New(env(), data, length_).ToLocalChecked();
+  } else {
+    *result = StringBytes::Encode(isolate, data_, length_, encoding_);
+    if (result->IsEmpty()) {
+      return v8::Exception::Error(
+          FIXED_ONE_BYTE_STRING(isolate, "\"toString()\" failed"));
+    }
+  }
+
+  return Null(isolate);
+}
+
+
+// Wrapper for fs.readFile() on paths.  Asynchronous only, fs.readFileSync()
+// keeps going through fs.openSync() and friends.
+//
+// readFile(path, flags, encoding, req)
+// 0 path      the file to read
+// 1 flags     integer. flags for open(2)
+// 2 encoding  encoding of the returned string, or 'buffer'
+// 3 req       FSReqWrap
+static void ReadFile(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  if (args.Length() < 4)
+    return TYPE_ERROR("path, flags, encoding and req are required");
+  if (!args[1]->IsInt32())
+    return TYPE_ERROR("flags must be an int");
+  CHECK(args[3]->IsObject());
+
+  BufferValue path(env->isolate(), args[0]);
+  ASSERT_PATH(path)
+
+  const int flags = args[1]->Int32Value();
+  const enum encoding encoding = ParseEncoding(env->isolate(), args[2], BUFFER);
+
+  FSWorkWrap::Dispatch(args, args[3],
+                       new ReadFileWrap(env,
+                                        args[3].As<Object>(),
+                                        *path,
+                                        flags,
+                                        encoding));
+}
+
+
+// Copies a file: open both files, then let the kernel move the data with
+// copy_file_range(2) where available, or sendfile(2), falling back to a
+// read/write loop where neither works (see uv_fs_sendfile().)
+class CopyFileWrap : public FSWorkWrap {
+ public:
+  CopyFileWrap(Environment* env,
+               Local<Object> req,
+               const char* src,
+               const char* dest,
+               int flags)
+      : FSWorkWrap(env, req),
+        src_(src),
+        dest_(dest),
+        flags_(flags) {
+  }
+
+  size_t self_size() const override { return sizeof(*this); }
+
+ protected:
+  void Work(uv_loop_t* loop) override;
+  Local<Value> Result(Local<Value>* result) override;
+
+ private:
+  int Copy(uv_loop_t* loop, int in, int out, uint64_t size);
+
+  const std::string src_;
+  const std::string dest_;
+  const int flags_;
+};
+
+
+void CopyFileWrap::Work(uv_loop_t* loop) {
+  uv_fs_t req;
+  uint64_t size = 0;
+  uint64_t dev = 0;
+  uint64_t ino = 0;
+  int mode = 0;
+
+  const int in = uv_fs_open(loop, &req, src_.c_str(), O_RDONLY, 0, nullptr);
+  uv_fs_req_cleanup(&req);
+  if (in < 0) {
+    err_ = in;
+    syscall_ = "open";
+    return;
+  }
+
+  err_ = uv_fs_fstat(loop, &req, in, nullptr);
+  if (err_ == 0) {
+    const uv_stat_t* const s = static_cast<const uv_stat_t*>(req.ptr);
+    size = s->st_size;
+    mode = s->st_mode;
+    dev = s->st_dev;
+    ino = s->st_ino;
+  }
+  uv_fs_req_cleanup(&req);
+  if (err_ < 0) {
+    syscall_ = "fstat";
+  } else if ((mode & S_IFMT) == S_IFDIR) {
+    err_ = UV_EISDIR;
+    syscall_ = "copyfile";
+  }
+
+  int out = -1;
+  if (err_ == 0) {
+    int flags = O_WRONLY | O_CREAT;
+    if (flags_ & COPYFILE_EXCL)
+      flags |= O_EXCL;
+    out = uv_fs_open(loop, &req, dest_.c_str(), flags, mode & 0777, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (out < 0) {
+      err_ = out;
+      syscall_ = "open";
+    }
+  }
+
+  // Copying a file onto itself is a no-op, don't truncate it first.
+  bool same_file = false;
+  if (err_ == 0) {
+    err_ = uv_fs_fstat(loop, &req, out, nullptr);
+    if (err_ == 0) {
+      const uv_stat_t* const s = static_cast<const uv_stat_t*>(req.ptr);
+      same_file = s->st_dev == dev && s->st_ino == ino;
+    }
+    uv_fs_req_cleanup(&req);
+    if (err_ < 0)
+      syscall_ = "fstat";
+  }
 
+  if (err_ == 0 && !same_file) {
+    err_ = uv_fs_ftruncate(loop, &req, out, 0, nullptr);
+    uv_fs_req_cleanup(&req);
+    syscall_ = "ftruncate";
+    if (err_ == 0) {
+      err_ = Copy(loop, in, out, size);
+      syscall_ = "copyfile";
+    }
+  }
 
-// Wrapper for write(2).
-//
-// bytesWritten = write(fd, buffer, offset, length, position, callback)
-// 0 fd        integer. file descriptor
-// 1 buffer    the data to write
-// 2 offset    where in the buffer to start from
-// 3 length    how much to write
-// 4 position  if integer, position to write at in the file.
-//             if null, write from the current position
-static void WriteBuffer(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
+  if (out >= 0) {
+    const int rc = uv_fs_close(loop, &req, out, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (rc < 0 && err_ == 0) {
+      err_ = rc;
+      syscall_ = "close";
+    }
+  }
 
-  if (!args[0]->IsInt32())
-    return env->ThrowTypeError("First argument must be file descriptor");
+  uv_fs_close(loop, &req, in, nullptr);
+  uv_fs_req_cleanup(&req);
+}
 
-  CHECK(Buffer::HasInstance(args[1]));
 
-  int fd = args[0]->Int32Value();
-  Local<Object> obj = args[1].As<Object>();
-  const char* buf = Buffer::Data(obj);
-  size_t buffer_length = Buffer::Length(obj);
-  size_t off = args[2]->Uint32Value();
-  size_t len = args[3]->Uint32Value();
-  int64_t pos = GET_OFFSET(args[4]);
-  Local<Value> req = args[5];
+int CopyFileWrap::Copy(uv_loop_t* loop, int in, int out, uint64_t size) {
+  // Files that report a size of 0 may still have contents (e.g. in /proc),
+  // copy those until EOF.
+  const size_t kMaxChunk = 1 << 30;
+  uint64_t offset = 0;
+  bool until_eof = size == 0;
+
+#if defined(__linux__) && defined(__NR_copy_file_range)
+  while (!until_eof && offset < size) {
+    const size_t chunk = static_cast<size_t>(MIN(size - offset, kMaxChunk));
+    ssize_t n;
+    do
+      n = syscall(__NR_copy_file_range, in, nullptr, out, nullptr, chunk, 0);
+    while (n == -1 && errno == EINTR);
+
+    if (n == -1) {
+      // Not supported by the kernel or across these file systems, let
+      // sendfile() take over from the current position.
+      if (errno == ENOSYS || errno == EXDEV || errno == EINVAL ||
+          errno == EOPNOTSUPP || errno == EBADF) {
+        break;
+      }
+      return -errno;
+    }
+    if (n == 0)  // File shrunk.
+      return 0;
+    offset += n;
+  }
+#endif
 
-  if (off > buffer_length)
-    return env->ThrowRangeError("offset out of bounds");
-  if (len > buffer_length)
-    return env->ThrowRangeError("length out of bounds");
-  if (off + len < off)
-    return env->ThrowRangeError("off + len overflow");
-  if (!Buffer::IsWithinBounds(off, len, buffer_length))
-    return env->ThrowRangeError("off + len > buffer.length");
+  while (until_eof || offset < size) {
+    const size_t chunk = until_eof ?
+        kMaxChunk : static_cast<size_t>(MIN(size - offset, kMaxChunk));
+    uv_fs_t req;
+    const int n = uv_fs_sendfile(loop, &req, out, in, offset, chunk, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (n < 0)
+      return n;
+    if (n == 0)
+      break;
+    offset += n;
+  }
 
-  buf += off;
+  return 0;
+}
 
-  uv_buf_t uvbuf = uv_buf_init(const_cast<char*>(buf), len);
 
-  if (req->IsObject()) {
-    ASYNC_CALL(write, req, UTF8, fd, &uvbuf, 1, pos)
-    return;
+Local<Value> CopyFileWrap::Result(Local<Value>* result) {
+  if (err_ < 0) {
+    return UVException(env()->isolate(),
+                       err_,
+                       syscall_,
+                       nullptr,
+                       src_.c_str(),
+                       dest_.c_str());
   }
-
-  SYNC_CALL(write, nullptr, fd, &uvbuf, 1, pos)
-  args.GetReturnValue().Set(SYNC_RESULT);
+  return Null(env()->isolate());
 }
 
 
-// Wrapper for writev(2).
+// Wrapper for fs.copyFile().
 //
-// bytesWritten = writev(fd, chunks, position, callback)
-// 0 fd        integer. file descriptor
-// 1 chunks    array of buffers to write
-// 2 position  if integer, position to write at in the file.
-//             if null, write from the current position
-static void WriteBuffers(const FunctionCallbackInfo<Value>& args) {
+// copyFile(src, dest, flags, req)
+// 0 src       the file to copy
+// 1 dest      the file to create or overwrite
+// 2 flags     integer. COPYFILE_EXCL fails if dest exists
+// 3 req       FSReqWrap for asynchronous calls
+static void CopyFile(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
-  CHECK(args[0]->IsInt32());
-  CHECK(args[1]->IsArray());
+  if (args.Length() < 3)
+    return TYPE_ERROR("src, dest and flags are required");
+  if (!args[2]->IsInt32())
+    return TYPE_ERROR("flags must be an int");
 
-  int fd = args[0]->Int32Value();
-  Local<Array> chunks = args[1].As<Array>();
-  int64_t pos = GET_OFFSET(args[2]);
-  Local<Value> req = args[3];
+  BufferValue src(env->isolate(), args[0]);
+  ASSERT_PATH(src)
+  BufferValue dest(env->isolate(), args[1]);
+  ASSERT_PATH(dest)
 
-  MaybeStackBuffer<uv_buf_t> iovs(chunks->Length());
+  const int flags = args[2]->Int32Value();
 
-  for (uint32_t i = 0; i < iovs.length(); i++) {
-    Local<Value> chunk = chunks->Get(i);
+  FSWorkWrap::Dispatch(args, args[3],
+                       new CopyFileWrap(env,
+                                        FSWorkWrap::NewSyncReq(env, args[3]),
+                                        *src,
+                                        *dest,
+                                        flags));
+}
 
-    if (!Buffer::HasInstance(chunk))
-      return env->ThrowTypeError("Array elements all need to be buffers");
 
-    iovs[i] = uv_buf_init(Buffer::Data(chunk), Buffer::Length(chunk));
+// Lists a directory together with the type of each entry and, optionally,
+// the lstat() result of each entry, all in one threadpool job.  Types come
+// from the dirents where the file system provides them; entries of unknown
+// type are lstat()ed to find out.  Stats are packed into one Float64Array
+// with kStatsFields values per entry, in the order of the fs.Stats
+// constructor arguments; entries that vanished before they could be
+// lstat()ed are all NaN.
+class ScanDirWrap : public FSWorkWrap {
+ public:
+  static const int kStatsFields = 14;
+
+  ScanDirWrap(Environment* env,
+              Local<Object> req,
+              const char* path,
+              enum encoding encoding,
+              bool with_stats)
+      : FSWorkWrap(env, req),
+        path_(path),
+        encoding_(encoding),
+        with_stats_(with_stats) {
   }
 
-  if (req->IsObject()) {
-    ASYNC_CALL(write, req, UTF8, fd, *iovs, iovs.length(), pos)
-    return;
+  size_t self_size() const override { return sizeof(*this); }
+
+ protected:
+  void Work(uv_loop_t* loop) override;
+  Local<Value> Result(Local<Value>* result) override;
+
+ private:
+  static uint8_t TypeFromMode(uint64_t mode);
+  void FillStats(size_t index, const uv_stat_t* s);
+
+  const std::string path_;
+  const enum encoding encoding_;
+  const bool with_stats_;
+  std::vector<std::string> names_;
+  std::vector<uint8_t> types_;
+  std::vector<double> stats_;
+};
+
+
+uint8_t ScanDirWrap::TypeFromMode(uint64_t mode) {
+  switch (mode & S_IFMT) {
+    case S_IFREG: return UV_DIRENT_FILE;
+    case S_IFDIR: return UV_DIRENT_DIR;
+    case S_IFCHR: return UV_DIRENT_CHAR;
+#ifdef S_IFLNK
+    case S_IFLNK: return UV_DIRENT_LINK;
+#endif
+#ifdef S_IFIFO
+    case S_IFIFO: return UV_DIRENT_FIFO;
+#endif
+#ifdef S_IFSOCK
+    case S_IFSOCK: return UV_DIRENT_SOCKET;
+#endif
+#ifdef S_IFBLK
+    case S_IFBLK: return UV_DIRENT_BLOCK;
+#endif
+    default: return UV_DIRENT_UNKNOWN;
   }
+}
 
-  SYNC_CALL(write, nullptr, fd, *iovs, iovs.length(), pos)
-  args.GetReturnValue().Set(SYNC_RESULT);
+
+void ScanDirWrap::FillStats(size_t index, const uv_stat_t* s) {
+  double* const fields = &stats_[index * kStatsFields];
+
+  // Must encode every field like BuildStatsObject(), which passes these
+  // through Integer::New() and therefore truncates them to int32.
+#define X(index, name)                                                        \
+  fields[index] = static_cast<double>(static_cast<int32_t>(s->st_##name));
+  X(0, dev)
+  X(1, mode)
+  X(2, nlink)
+  X(3, uid)
+  X(4, gid)
+  X(5, rdev)
+#if defined(__POSIX__)
+  X(6, blksize)
+#else
+  fields[6] = std::numeric_limits<double>::quiet_NaN();
+#endif
+#undef X
+  fields[7] = static_cast<double>(s->st_ino);
+  fields[8] = static_cast<double>(s->st_size);
+#if defined(__POSIX__)
+  fields[9] = static_cast<double>(s->st_blocks);
+#else
+  fields[9] = std::numeric_limits<double>::quiet_NaN();
+#endif
+#define X(index, name)                                                        \
+  fields[index] = (static_cast<double>(s->st_##name.tv_sec) * 1000) +         \
+                  (static_cast<double>(s->st_##name.tv_nsec / 1000000));
+  X(10, atim)
+  X(11, mtim)
+  X(12, ctim)
+  X(13, birthtim)
+#undef X
 }
 
 
-// Wrapper for write(2).
-//
-// bytesWritten = write(fd, string, position, enc, callback)
-// 0 fd        integer. file descriptor
-// 1 string    non-buffer values are converted to strings
-// 2 position  if integer, position to write at in the file.
-//             if null, write from the current position
-// 3 enc       encoding of string
-static void WriteString(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
+void ScanDirWrap::Work(uv_loop_t* loop) {
+  uv_fs_t req;
 
-  if (!args[0]->IsInt32())
-    return env->ThrowTypeError("First argument must be file descriptor");
+  const int rc = uv_fs_scandir(loop, &req, path_.c_str(), 0, nullptr);
+  if (rc < 0) {
+    uv_fs_req_cleanup(&req);
+    err_ = rc;
+    syscall_ = "scandir";
+    return;
+  }
 
-  Local<Value> req;
-  Local<Value> string = args[1];
-  int fd = args[0]->Int32Value();
-  char* buf = nullptr;
-  int64_t pos;
-  size_t len;
-  FSReqWrap::Ownership ownership = FSReqWrap::COPY;
+  uv_dirent_t ent;
+  int r;
+  while ((r = uv_fs_scandir_next(&req, &ent)) == 0) {
+    names_.push_back(ent.name);
+    types_.push_back(static_cast<uint8_t>(ent.type));
+  }
+  uv_fs_req_cleanup(&req);
+  if (r != UV_EOF) {
+    err_ = r;
+    syscall_ = "scandir";
+    return;
+  }
 
-  // will assign buf and len if string was external
-  if (!StringBytes::GetExternalParts(env->isolate(),
-                                     string,
-                                     const_cast<const char**>(&buf),
-                                     &len)) {
-    enum encoding enc = ParseEncoding(env->isolate(), args[3], UTF8);
-    len = StringBytes::StorageSize(env->isolate(), string, enc);
-    buf = new char[len];
-    // StorageSize may return too large a char, so correct the actual length
-    // by the write size
-    len = StringBytes::Write(env->isolate(), buf, len, args[1], enc);
-    ownership = FSReqWrap::MOVE;
+  if (with_stats_)
+    stats_.resize(names_.size() * kStatsFields,
+                  std::numeric_limits<double>::quiet_NaN());
+
+#ifdef _WIN32
+  const char kSeparator = '\\';
+#else
+  const char kSeparator = '/';
+#endif
+  std::string entry_path(path_);
+  if (entry_path.empty() || entry_path.back() != kSeparator)
+    entry_path += kSeparator;
+  const size_t dirname_length = entry_path.size();
+
+  for (size_t i = 0; i < names_.size(); i++) {
+    if (!with_stats_ && types_[i] != UV_DIRENT_UNKNOWN)
+      continue;
+
+    entry_path.resize(dirname_length);
+    entry_path += names_[i];
+
+    // Errors are not fatal, the entry may have been removed in the meantime.
+    if (uv_fs_lstat(loop, &req, entry_path.c_str(), nullptr) == 0) {
+      const uv_stat_t* const s = static_cast<const uv_stat_t*>(req.ptr);
+      if (types_[i] == UV_DIRENT_UNKNOWN)
+        types_[i] = TypeFromMode(s->st_mode);
+      if (with_stats_)
+        FillStats(i, s);
+    }
+    uv_fs_req_cleanup(&req);
   }
-  pos = GET_OFFSET(args[2]);
-  req = args[4];
+}
 
-  uv_buf_t uvbuf = uv_buf_init(const_cast<char*>(buf), len);
 
-  if (!req->IsObject()) {
-    // SYNC_CALL returns on error.  Make sure to always free the memory.
-    struct Delete {
-      inline explicit Delete(char* pointer) : pointer_(pointer) {}
-      inline ~Delete() { delete[] pointer_; }
-      char* const pointer_;
-    };
-    Delete delete_on_return(ownership == FSReqWrap::MOVE ? buf : nullptr);
-    SYNC_CALL(write, nullptr, fd, &uvbuf, 1, pos)
-    return args.GetReturnValue().Set(SYNC_RESULT);
+Local<Value> ScanDirWrap::Result(Local<Value>* result) {
+  Isolate* isolate = env()->isolate();
+
+  if (err_ < 0)
+    return UVException(isolate, err_, syscall_, nullptr, path_.c_str());
+
+  const size_t count = names_.size();
+  Local<Array> names = Array::New(isolate, count);
+  for (size_t i = 0; i < count; i++) {
+    Local<Value> filename = StringBytes::Encode(isolate,
+                                                names_[i].c_str(),
+                                                encoding_);
+    if (filename.IsEmpty()) {
+      return UVException(isolate,
+                         UV_EINVAL,
+                         "scandir",
+                         "Invalid character encoding for filename",
+                         path_.c_str());
+    }
+    names->Set(env()->context(), i, filename).FromJust();
   }
 
-  FSReqWrap* req_wrap =
-      FSReqWrap::New(env, req.As<Object>(), "write", buf, UTF8, ownership);
-  int err = uv_fs_write(env->event_loop(),
-                        &req_wrap->req_,
-                        fd,
-                        &uvbuf,
-                        1,
-                        pos,
-                        After);
-  req_wrap->Dispatched();
-  if (err < 0) {
-    uv_fs_t* uv_req = &req_wrap->req_;
-    uv_req->result = err;
-    uv_req->path = nullptr;
-    After(uv_req);
-    return;
+  Local<ArrayBuffer> types_ab = ArrayBuffer::New(isolate, count);
+  if (count > 0)
+    memcpy(types_ab->GetContents().Data(), types_.data(), count);
+
+  Local<Array> out = Array::New(isolate, 3);
+  out->Set(env()->context(), 0, names).FromJust();
+  out->Set(env()->context(), 1, Uint8Array::New(types_ab, 0, count))
+      .FromJust();
+
+  if (with_stats_) {
+    const size_t length = stats_.size();
+    Local<ArrayBuffer> stats_ab =
+        ArrayBuffer::New(isolate, length * sizeof(double));
+    if (length > 0) {
+      memcpy(stats_ab->GetContents().Data(),
+             stats_.data(),
+             length * sizeof(double));
+    }
+    out->Set(env()->context(), 2, Float64Array::New(stats_ab, 0, length))
+        .FromJust();
   }
 
-  return args.GetReturnValue().Set(req_wrap->persistent());
+  *result = out;
+  return Null(isolate);
 }
 
 
-/*
- * Wrapper for read(2).
- *
- * bytesRead = fs.read(fd, buffer, offset, length, position)
- *
- * 0 fd        integer. file descriptor
- * 1 buffer    instance of Buffer
- * 2 offset    integer. offset to start reading into inside buffer
- * 3 length    integer. length to read
- * 4 position  file position - null for current position
- *
- */
-static void Read(const FunctionCallbackInfo<Value>& args) {
+// Wrapper for fs.scandir().
+//
+// [names, types, stats] = scandir(path, encoding, withStats, req)
+// 0 path       the directory to list
+// 1 encoding   encoding of the returned names
+// 2 withStats  whether to lstat() each entry
+// 3 req        FSReqWrap for asynchronous calls
+static void ScanDir(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
-  if (args.Length() < 2)
-    return TYPE_ERROR("fd and buffer are required");
-  if (!args[0]->IsInt32())
-    return TYPE_ERROR("fd must be a file descriptor");
-  if (!Buffer::HasInstance(args[1]))
-    return TYPE_ERROR("Second argument needs to be a buffer");
+  if (args.Length() < 1)
+    return TYPE_ERROR("path required");
 
-  int fd = args[0]->Int32Value();
+  BufferValue path(env->isolate(), args[0]);
+  ASSERT_PATH(path)
 
-  Local<Value> req;
+  const enum encoding encoding = ParseEncoding(env->isolate(), args[1], UTF8);
+  const bool with_stats = args[2]->IsTrue();
+
+  FSWorkWrap::Dispatch(args, args[3],
+                       new ScanDirWrap(env,
+                                       FSWorkWrap::NewSyncReq(env, args[3]),
+                                       *path,
+                                       encoding,
+                                       with_stats));
+}
 
-  size_t len;
-  int64_t pos;
 
-  char * buf = nullptr;
+static void UnmapFile(char* data, void* hint) {
+#ifdef _WIN32
+  UnmapViewOfFile(data);
+#else
+  munmap(data, reinterpret_cast<size_t>(hint));
+#endif
+}
 
-  Local<Object> buffer_obj = args[1]->ToObject(env->isolate());
-  char *buffer_data = Buffer::Data(buffer_obj);
-  size_t buffer_length = Buffer::Length(buffer_obj);
 
-  size_t off = args[2]->Int32Value();
-  if (off >= buffer_length) {
-    return env->ThrowError("Offset is out of bounds");
-  }
+// Maps a file into memory and returns it as a Buffer that is unmapped when
+// it is garbage collected.  The mapping is private: pages are shared with the
+// page cache (and thus with other processes mapping the same file) until they
+// are written to, and writes never reach the file.
+//
+// buffer = mapFile(path)
+// 0 path      the file to map
+static void MapFile(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
 
-  len = args[3]->Int32Value();
-  if (!Buffer::IsWithinBounds(off, len, buffer_length))
-    return env->ThrowRangeError("Length extends beyond buffer");
+  if (args.Length() < 1)
+    return TYPE_ERROR("path required");
 
-  pos = GET_OFFSET(args[4]);
+  BufferValue path(env->isolate(), args[0]);
+  ASSERT_PATH(path)
 
-  buf = buffer_data + off;
+#ifdef UWP_DLL
+  return env->ThrowUVException(UV_ENOSYS, "mmap", nullptr, *path);
+#else
+  env->PrintSyncTrace();
 
-  uv_buf_t uvbuf = uv_buf_init(const_cast<char*>(buf), len);
+  uv_fs_t req;
+  const int fd =
+      uv_fs_open(env->event_loop(), &req, *path, O_RDONLY, 0, nullptr);
+  uv_fs_req_cleanup(&req);
+  if (fd < 0)
+    return env->ThrowUVException(fd, "open", nullptr, *path);
 
-  req = args[5];
+  int err = uv_fs_fstat(env->event_loop(), &req, fd, nullptr);
+  const uint64_t st_size =
+      err == 0 ? static_cast<const uv_stat_t*>(req.ptr)->st_size : 0;
+  const size_t size = static_cast<size_t>(st_size);
+  uv_fs_req_cleanup(&req);
 
-  if (req->IsObject()) {
-    ASYNC_CALL(read, req, UTF8, fd, &uvbuf, 1, pos);
-  } else {
-    SYNC_CALL(read, 0, fd, &uvbuf, 1, pos)
-    args.GetReturnValue().Set(SYNC_RESULT);
+  char* data = nullptr;
+  if (err < 0) {
+    env->ThrowUVException(err, "fstat", nullptr, *path);
+  } else if (st_size > Buffer::kMaxLength) {
+    env->ThrowRangeError("File size is greater than possible Buffer");
+  } else if (size > 0) {
+#ifdef _WIN32
+    HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    HANDLE mapping =
+        CreateFileMappingW(handle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    DWORD error = ERROR_SUCCESS;
+    if (mapping == nullptr) {
+      error = GetLastError();
+    } else {
+      data = static_cast<char*>(
+          MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, size));
+      // Read the error before CloseHandle() can overwrite it.
+      if (data == nullptr)
+        error = GetLastError();
+      CloseHandle(mapping);  // The view keeps the mapping alive.
+    }
+    if (data == nullptr) {
+      env->isolate()->ThrowException(
+          WinapiErrnoException(env->isolate(), error, "mmap", nullptr, *path));
+    }
+#else
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                      fd, 0);
+    if (addr == MAP_FAILED)
+      env->ThrowErrnoException(errno, "mmap", nullptr, *path);
+    else
+      data = static_cast<char*>(addr);
+#endif
+  }
+
+  uv_fs_close(env->event_loop(), &req, fd, nullptr);
+  uv_fs_req_cleanup(&req);
+
+  if (err < 0 || st_size > Buffer::kMaxLength || (size > 0 && data == nullptr))
+    return;
+
+  if (size == 0) {
+    // Empty files can't be mapped.
+    args.GetReturnValue().Set(Buffer::New(env, 0).ToLocalChecked());
+    return;
   }
+
+  Local<Object> buffer;
+  if (!Buffer::New(env->isolate(), data, size, UnmapFile,
+                   reinterpret_cast<void*>(size)).ToLocal(&buffer)) {
+    UnmapFile(data, reinterpret_cast<void*>(size));
+    return;
+  }
+  args.GetReturnValue().Set(buffer);
+#endif  // UWP_DLL
 }
 
 
@@ -1498,6 +3265,9 @@ void InitFs(Local<Object> target,
   env->SetMethod(target, "close", Close);
   env->SetMethod(target, "open", Open);
   env->SetMethod(target, "read", Read);
+  env->SetMethod(target, "readFile", ReadFile);
+  env->SetMethod(target, "mapFile", MapFile);
+  env->SetMethod(target, "copyFile", CopyFile);
   env->SetMethod(target, "fdatasync", Fdatasync);
   env->SetMethod(target, "fsync", Fsync);
   env->SetMethod(target, "rename", Rename);
@@ -1505,8 +3275,17 @@ void InitFs(Local<Object> target,
   env->SetMethod(target, "rmdir", RMDir);
   env->SetMethod(target, "mkdir", MKDir);
   env->SetMethod(target, "readdir", ReadDir);
+  env->SetMethod(target, "scandir", ScanDir);
   env->SetMethod(target, "internalModuleReadFile", InternalModuleReadFile);
   env->SetMethod(target, "internalModuleStat", InternalModuleStat);
+#ifndef _WIN32
+  env->SetMethod(target, "internalModuleResolve", InternalModuleResolve);
+  env->SetMethod(target, "internalModuleStatCache", InternalModuleStatCache);
+  env->SetMethod(target,
+                 "internalModuleLoadManifest",
+                 InternalModuleLoadManifest);
+  env->SetMethod(target, "internalModuleClearCache", InternalModuleClearCache);
+#endif
   env->SetMethod(target, "stat", Stat);
   env->SetMethod(target, "lstat", LStat);
   env->SetMethod(target, "fstat", FStat);
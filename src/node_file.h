@@ -8,6 +8,11 @@
 
 namespace node {
 
+// Flags for fs.copyFile().
+enum CopyFileFlags {
+  COPYFILE_EXCL = 1
+};
+
 void InitFs(v8::Local<v8::Object> target);
 
 }  // namespace node
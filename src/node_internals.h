@@ -69,6 +69,10 @@ v8::Local<v8::Value> MakeCallback(Environment* env,
                                    int argc = 0,
                                    v8::Local<v8::Value>* argv = nullptr);
 
+// Runs the microtask queue and the nextTick queue at the end of a top-level
+// MakeCallback().  Returns false if a callback threw.
+bool ProcessTicksAfterCallback(Environment* env);
+
 // Convert a struct sockaddr to a { address: '1.2.3.4', port: 1234 } JS object.
 // Sets address and port properties on the info object and returns it.
 // If |info| is omitted, a new object is returned.
@@ -287,6 +291,11 @@ v8::MaybeLocal<v8::Object> New(Environment* env,
 // because ArrayBufferAllocator::Free() deallocates it again with free().
 // Mixing operator new and free() is undefined behavior so don't do that.
 v8::MaybeLocal<v8::Object> New(Environment* env, char* data, size_t length);
+// A buffer over |length| bytes of |ab|, starting at |byte_offset|.
+v8::MaybeLocal<v8::Object> New(Environment* env,
+                               v8::Local<v8::ArrayBuffer> ab,
+                               size_t byte_offset,
+                               size_t length);
 }  // namespace Buffer
 
 }  // namespace node
@@ -0,0 +1,179 @@
+#include "node_counters.h"
+#include "env.h"
+#include "env-inl.h"
+#include "uv.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace node {
+
+NodeCounters* node_counters;
+
+static const char kSegmentPrefix[] = "node-perfctr.";
+static char segment_name[32];
+// Heap allocated, so that Init can start a new timer while the old one is
+// still being closed.
+static uv_timer_t* sample_timer;
+static uint64_t last_sample_time;
+
+
+static void UnlinkSegment() {
+  if (segment_name[0] != '\0')
+    shm_unlink(segment_name);
+}
+
+
+// atexit() doesn't run when node is killed by a signal, so segments of
+// processes that are gone are removed by the next node that starts.
+static void ReapStaleSegments() {
+  DIR* dir = opendir("/dev/shm");
+  if (dir == nullptr)
+    return;
+
+  const size_t prefix_len = sizeof(kSegmentPrefix) - 1;
+  while (dirent* ent = readdir(dir)) {
+    if (strncmp(ent->d_name, kSegmentPrefix, prefix_len) != 0)
+      continue;
+
+    char* end;
+    const char* digits = ent->d_name + prefix_len;
+    long pid = strtol(digits, &end, 10);
+    if (end == digits || *end != '\0' || pid <= 0)
+      continue;
+
+    if (kill(pid, 0) == 0 || errno != ESRCH)
+      continue;  // Still running, or owned by someone else.
+
+    char name[sizeof(segment_name)];
+    snprintf(name, sizeof(name), "/%s%ld", kSegmentPrefix, pid);
+    shm_unlink(name);
+  }
+
+  closedir(dir);
+}
+
+
+static void SampleCounters(uv_timer_t* handle) {
+  const uint64_t now = uv_hrtime();
+  const uint64_t interval = kNodeCountersSampleInterval * 1000;  // In us.
+
+  // How much later than scheduled the timer fired.
+  const uint64_t elapsed = (now - last_sample_time) / 1000;
+  const uint64_t lag = elapsed > interval ? elapsed - interval : 0;
+  last_sample_time = now;
+
+  node_counters->event_loop_lag = lag;
+  if (lag > node_counters->event_loop_lag_max)
+    node_counters->event_loop_lag_max = lag;
+
+  // Reports zeros without starting the threadpool when nothing has used it.
+  uv_threadpool_stats_t stats;
+  if (uv_threadpool_stats(&stats) == 0) {
+    node_counters->threadpool_threads = stats.threads;
+    node_counters->threadpool_idle_threads = stats.idle_threads;
+    node_counters->threadpool_queued = stats.queued;
+  }
+
+  // The sample timer is unref'd, so it doesn't count as an active handle.
+  uv_loop_t* loop = handle->loop;
+  node_counters->active_handles = loop->active_handles;
+  node_counters->active_requests = uv_loop_active_reqs(loop);
+  node_counters->sample_time = now;
+}
+
+
+void InitPerfCountersLinux(Environment* env) {
+  // Already running.  node_counters is only set together with sample_timer.
+  if (node_counters != nullptr)
+    return;
+  CHECK_EQ(sample_timer, nullptr);
+
+  ReapStaleSegments();
+
+  snprintf(segment_name,
+           sizeof(segment_name),
+           "/%s%d",
+           kSegmentPrefix,
+           getpid());
+
+  // Readable by the user that runs node only, agents run as the same user
+  // or as root.
+  int fd = shm_open(segment_name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (fd == -1) {
+    segment_name[0] = '\0';
+    return;
+  }
+
+  void* addr = MAP_FAILED;
+  if (ftruncate(fd, sizeof(NodeCounters)) == 0) {
+    addr = mmap(nullptr,
+                sizeof(NodeCounters),
+                PROT_READ | PROT_WRITE,
+                MAP_SHARED,
+                fd,
+                0);
+  }
+  close(fd);
+
+  if (addr == MAP_FAILED) {
+    UnlinkSegment();
+    segment_name[0] = '\0';
+    return;
+  }
+
+  node_counters = static_cast<NodeCounters*>(addr);
+  memset(node_counters, 0, sizeof(*node_counters));
+  node_counters->version = kNodeCountersVersion;
+  node_counters->size = sizeof(*node_counters);
+  node_counters->pid = getpid();
+  // Written last so that agents that see the magic see the rest as well.
+  __atomic_store_n(&node_counters->magic,
+                   kNodeCountersMagic,
+                   __ATOMIC_RELEASE);
+
+  // process.exit() doesn't return to main(), atexit() handlers run either
+  // way.
+  atexit(UnlinkSegment);
+
+  last_sample_time = uv_hrtime();
+  sample_timer = new uv_timer_t;
+  uv_timer_init(env->event_loop(), sample_timer);
+  uv_timer_start(sample_timer,
+                 SampleCounters,
+                 kNodeCountersSampleInterval,
+                 kNodeCountersSampleInterval);
+  uv_unref(reinterpret_cast<uv_handle_t*>(sample_timer));
+}
+
+
+static void OnSampleTimerClose(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_timer_t*>(handle);
+}
+
+
+void TermPerfCountersLinux() {
+  if (node_counters == nullptr)
+    return;
+
+  uv_close(reinterpret_cast<uv_handle_t*>(sample_timer), OnSampleTimerClose);
+  sample_timer = nullptr;
+  munmap(node_counters, sizeof(*node_counters));
+  node_counters = nullptr;
+  UnlinkSegment();
+  segment_name[0] = '\0';
+}
+
+
+uint64_t NODE_COUNT_GET_GC_RAWTIME() {
+  return uv_hrtime();
+}
+
+}  // namespace node
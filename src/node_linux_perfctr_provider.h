@@ -0,0 +1,122 @@
+#ifndef SRC_NODE_LINUX_PERFCTR_PROVIDER_H_
+#define SRC_NODE_LINUX_PERFCTR_PROVIDER_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <stdint.h>
+
+namespace node {
+
+class Environment;
+
+// The layout of the shared memory segment that the counters are published
+// in.  The segment is named /node-perfctr.<pid>, which is where shm_open()
+// puts /dev/shm/node-perfctr.<pid>, and is removed again when node exits.
+// Segments left behind by a node that was killed are removed by the next
+// node that starts.
+// Agents map it read-only and can read it at any time: only the main thread
+// writes to it and every field is naturally aligned, so values are never
+// torn.  Fields are only ever added at the end, |size| tells readers which
+// ones are there.
+struct NodeCounters {
+  uint32_t magic;  // kNodeCountersMagic
+  uint32_t version;
+  uint32_t size;
+  uint32_t pid;
+
+  uint64_t http_server_requests;
+  uint64_t http_server_responses;
+  uint64_t http_client_requests;
+  uint64_t http_client_responses;
+  uint64_t server_connections;  // Currently open.
+  uint64_t net_bytes_sent;
+  uint64_t net_bytes_recv;
+  uint64_t pipe_bytes_sent;
+  uint64_t pipe_bytes_recv;
+  uint64_t gc_percent_time;  // Of the time since the previous GC.
+
+  // Sampled once per kNodeCountersSampleInterval milliseconds.
+  uint64_t sample_time;  // uv_hrtime() of the last sample.
+  uint64_t event_loop_lag;  // In microseconds.
+  uint64_t event_loop_lag_max;  // In microseconds.
+  uint64_t threadpool_threads;
+  uint64_t threadpool_idle_threads;
+  uint64_t threadpool_queued;
+  uint64_t active_handles;
+  uint64_t active_requests;
+};
+
+static const uint32_t kNodeCountersMagic = 0x6e6f6463;  // "nodc"
+static const uint32_t kNodeCountersVersion = 1;
+static const uint64_t kNodeCountersSampleInterval = 1000;
+
+// nullptr when the segment couldn't be set up.
+extern NodeCounters* node_counters;
+
+inline bool NODE_COUNTER_ENABLED() { return node_counters != nullptr; }
+
+inline void NODE_COUNT_HTTP_SERVER_REQUEST() {
+  if (node_counters != nullptr)
+    node_counters->http_server_requests++;
+}
+
+inline void NODE_COUNT_HTTP_SERVER_RESPONSE() {
+  if (node_counters != nullptr)
+    node_counters->http_server_responses++;
+}
+
+inline void NODE_COUNT_HTTP_CLIENT_REQUEST() {
+  if (node_counters != nullptr)
+    node_counters->http_client_requests++;
+}
+
+inline void NODE_COUNT_HTTP_CLIENT_RESPONSE() {
+  if (node_counters != nullptr)
+    node_counters->http_client_responses++;
+}
+
+inline void NODE_COUNT_SERVER_CONN_OPEN() {
+  if (node_counters != nullptr)
+    node_counters->server_connections++;
+}
+
+inline void NODE_COUNT_SERVER_CONN_CLOSE() {
+  if (node_counters != nullptr && node_counters->server_connections > 0)
+    node_counters->server_connections--;
+}
+
+inline void NODE_COUNT_NET_BYTES_SENT(int bytes) {
+  if (node_counters != nullptr)
+    node_counters->net_bytes_sent += bytes;
+}
+
+inline void NODE_COUNT_NET_BYTES_RECV(int bytes) {
+  if (node_counters != nullptr)
+    node_counters->net_bytes_recv += bytes;
+}
+
+inline void NODE_COUNT_PIPE_BYTES_SENT(int bytes) {
+  if (node_counters != nullptr)
+    node_counters->pipe_bytes_sent += bytes;
+}
+
+inline void NODE_COUNT_PIPE_BYTES_RECV(int bytes) {
+  if (node_counters != nullptr)
+    node_counters->pipe_bytes_recv += bytes;
+}
+
+inline void NODE_COUNT_GC_PERCENTTIME(unsigned int percent) {
+  if (node_counters != nullptr)
+    node_counters->gc_percent_time = percent;
+}
+
+uint64_t NODE_COUNT_GET_GC_RAWTIME();
+
+void InitPerfCountersLinux(Environment* env);
+void TermPerfCountersLinux();
+
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_NODE_LINUX_PERFCTR_PROVIDER_H_
@@ -23,6 +23,7 @@ using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
 using v8::HandleScope;
+using v8::Array;
 using v8::Integer;
 using v8::Local;
 using v8::Object;
@@ -55,12 +56,15 @@ void PipeWrap::Initialize(Local<Object> target,
   env->SetProtoMethod(t, "ref", HandleWrap::Ref);
   env->SetProtoMethod(t, "hasRef", HandleWrap::HasRef);
 
+  // Only IPC pipes get writev(), see the constructor.
   StreamWrap::AddMethods(env, t);
 
   env->SetProtoMethod(t, "bind", Bind);
   env->SetProtoMethod(t, "listen", Listen);
+  env->SetProtoMethod(t, "setAcceptBatch", SetAcceptBatch);
   env->SetProtoMethod(t, "connect", Connect);
   env->SetProtoMethod(t, "open", Open);
+  env->SetProtoMethod(t, "setMessageFraming", SetMessageFraming);
 
 #ifdef _WIN32
   env->SetProtoMethod(t, "setPendingInstances", SetPendingInstances);
@@ -103,11 +107,139 @@ PipeWrap::PipeWrap(Environment* env,
     : ConnectionWrap(env,
                      object,
                      AsyncWrap::PROVIDER_PIPEWRAP,
-                     parent) {
+                     parent),
+      frame_header_length_(0),
+      frame_data_(nullptr),
+      frame_size_(0),
+      frame_offset_(0),
+      frame_capacity_(0) {
   int r = uv_pipe_init(env->event_loop(), &handle_, ipc);
   CHECK_EQ(r, 0);  // How do we proxy this error up to javascript?
                    // Suggestion: uv_pipe_init() returns void.
   UpdateWriteQueueSize();
+
+  // IPC channels send each message, and the handle that goes with it, in a
+  // single write.  Other pipes keep writing chunk by chunk like they always
+  // did.
+  if (ipc)
+    env->SetMethod(object, "writev", JSMethod<PipeWrap, &PipeWrap::Writev>);
+}
+
+
+PipeWrap::~PipeWrap() {
+  ResetFrame();
+}
+
+
+void PipeWrap::ResetFrame() {
+  free(frame_data_);
+  frame_data_ = nullptr;
+  frame_header_length_ = 0;
+  frame_size_ = 0;
+  frame_offset_ = 0;
+  frame_capacity_ = 0;
+}
+
+
+void PipeWrap::GrowFrame(size_t needed) {
+  size_t capacity =
+      frame_capacity_ == 0 ? kMinFrameCapacity : frame_capacity_ * 2;
+  if (capacity < needed)
+    capacity = needed;
+  if (capacity > frame_size_)
+    capacity = frame_size_;
+  char* data = static_cast<char*>(node::Realloc(frame_data_, capacity));
+  if (data == nullptr)
+    FatalError("node::PipeWrap::GrowFrame()", "Out Of Memory");
+  frame_data_ = data;
+  frame_capacity_ = capacity;
+}
+
+
+void PipeWrap::SetMessageFraming(const FunctionCallbackInfo<Value>& args) {
+  PipeWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.Holder());
+  if (!wrap->is_named_pipe_ipc())
+    return args.GetReturnValue().Set(UV_EINVAL);
+  wrap->set_read_cb({ OnFramedRead, wrap });
+  args.GetReturnValue().Set(0);
+}
+
+
+void PipeWrap::OnFramedRead(ssize_t nread,
+                            const uv_buf_t* buf,
+                            uv_handle_type pending,
+                            void* ctx) {
+  PipeWrap* wrap = static_cast<PipeWrap*>(ctx);
+  Environment* env = wrap->env();
+  HandleScope handle_scope(env->isolate());
+  Context::Scope context_scope(env->context());
+
+  if (nread <= 0) {
+    free(buf->base);
+    if (nread < 0) {
+      wrap->ResetFrame();
+      wrap->EmitData(nread, Local<Object>(), Local<Object>());
+    }
+    return;
+  }
+
+  Local<Object> pending_obj = wrap->AcceptPendingHandle(pending);
+  Local<Array> frames = Array::New(env->isolate());
+  uint32_t count = 0;
+  const char* data = buf->base;
+  size_t length = static_cast<size_t>(nread);
+
+  while (length > 0) {
+    if (wrap->frame_header_length_ < kFrameHeaderSize) {
+      size_t n = kFrameHeaderSize - wrap->frame_header_length_;
+      if (n > length)
+        n = length;
+      memcpy(wrap->frame_header_ + wrap->frame_header_length_, data, n);
+      wrap->frame_header_length_ += n;
+      data += n;
+      length -= n;
+      if (wrap->frame_header_length_ < kFrameHeaderSize)
+        break;
+
+      const uint8_t* h = reinterpret_cast<uint8_t*>(wrap->frame_header_);
+      wrap->frame_size_ = h[0] | (h[1] << 8) | (h[2] << 16) |
+                          (static_cast<size_t>(h[3]) << 24);
+      if (wrap->frame_size_ > Buffer::kMaxLength) {
+        free(buf->base);
+        wrap->ResetFrame();
+        wrap->EmitData(UV_EPROTO, Local<Object>(), pending_obj);
+        return;
+      }
+    }
+
+    size_t n = wrap->frame_size_ - wrap->frame_offset_;
+    if (n > length)
+      n = length;
+    if (wrap->frame_offset_ + n > wrap->frame_capacity_)
+      wrap->GrowFrame(wrap->frame_offset_ + n);
+    if (n > 0)
+      memcpy(wrap->frame_data_ + wrap->frame_offset_, data, n);
+    wrap->frame_offset_ += n;
+    data += n;
+    length -= n;
+
+    if (wrap->frame_offset_ == wrap->frame_size_) {
+      Local<Object> frame =
+          Buffer::New(env, wrap->frame_data_, wrap->frame_size_)
+              .ToLocalChecked();
+      frames->Set(count++, frame);
+      wrap->frame_data_ = nullptr;
+      wrap->ResetFrame();
+    }
+  }
+
+  free(buf->base);
+
+  // Report how much of an incomplete message is buffered so that JS land
+  // knows if a disconnect has to wait for it.
+  size_t buffered = wrap->frame_header_length_ + wrap->frame_offset_;
+  wrap->EmitData(buffered, frames, pending_obj);
 }
 
 
@@ -23,6 +23,7 @@ class PipeWrap : public ConnectionWrap<PipeWrap, uv_pipe_t> {
            v8::Local<v8::Object> object,
            bool ipc,
            AsyncWrap* parent);
+  ~PipeWrap();
 
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Bind(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -36,6 +37,32 @@ class PipeWrap : public ConnectionWrap<PipeWrap, uv_pipe_t> {
 #endif
 
   static void AfterConnect(uv_connect_t* req, int status);
+
+  // Length-prefixed message framing for IPC channels.  Every message is a
+  // little endian uint32 length followed by that many bytes.  With framing
+  // enabled, onread(nread, frames, handle) is called with an array of the
+  // messages completed by a read, and nread is the number of bytes of an
+  // incomplete message that is still being buffered.
+  static void SetMessageFraming(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void OnFramedRead(ssize_t nread,
+                           const uv_buf_t* buf,
+                           uv_handle_type pending,
+                           void* ctx);
+  void ResetFrame();
+  void GrowFrame(size_t needed);
+
+  static const size_t kFrameHeaderSize = 4;
+  // The frame buffer starts at this size and doubles as data arrives, so a
+  // peer can't make us allocate more than it actually sends.
+  static const size_t kMinFrameCapacity = 64 * 1024;
+
+  char frame_header_[kFrameHeaderSize];
+  size_t frame_header_length_;
+  char* frame_data_;
+  size_t frame_size_;
+  size_t frame_offset_;
+  size_t frame_capacity_;
 };
 
 
@@ -99,6 +99,14 @@ int StreamBase::Writev(const FunctionCallbackInfo<Value>& args) {
 
   Local<Object> req_wrap_obj = args[0].As<Object>();
   Local<Array> chunks = args[1].As<Array>();
+  Local<Object> send_handle_obj;
+  uv_handle_t* send_handle = nullptr;
+  if (args[2]->IsObject() && IsIPCPipe()) {
+    HandleWrap* wrap;
+    send_handle_obj = args[2].As<Object>();
+    ASSIGN_OR_RETURN_UNWRAP(&wrap, send_handle_obj, UV_EINVAL);
+    send_handle = wrap->GetHandle();
+  }
 
   size_t count = chunks->Length() >> 1;
 
@@ -174,7 +182,14 @@ int StreamBase::Writev(const FunctionCallbackInfo<Value>& args) {
     bytes += str_size;
   }
 
-  int err = DoWrite(req_wrap, bufs, count, nullptr);
+  // Keep the handle alive until AfterWrite() is called.
+  if (send_handle != nullptr)
+    req_wrap->object()->Set(env->handle_string(), send_handle_obj);
+
+  int err = DoWrite(req_wrap,
+                    bufs,
+                    count,
+                    reinterpret_cast<uv_stream_t*>(send_handle));
 
   // Deallocate space
   if (bufs != bufs_)
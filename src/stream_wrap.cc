@@ -180,6 +180,18 @@ static Local<Object> AcceptHandle(Environment* env, StreamWrap* parent) {
 }
 
 
+Local<Object> StreamWrap::AcceptPendingHandle(uv_handle_type pending) {
+  if (pending == UV_TCP)
+    return AcceptHandle<TCPWrap, uv_tcp_t>(env(), this);
+  if (pending == UV_NAMED_PIPE)
+    return AcceptHandle<PipeWrap, uv_pipe_t>(env(), this);
+  if (pending == UV_UDP)
+    return AcceptHandle<UDPWrap, uv_udp_t>(env(), this);
+  CHECK_EQ(pending, UV_UNKNOWN_HANDLE);
+  return Local<Object>();
+}
+
+
 void StreamWrap::OnReadImpl(ssize_t nread,
                             const uv_buf_t* buf,
                             uv_handle_type pending,
@@ -207,15 +219,7 @@ void StreamWrap::OnReadImpl(ssize_t nread,
   char* base = static_cast<char*>(node::Realloc(buf->base, nread));
   CHECK_LE(static_cast<size_t>(nread), buf->len);
 
-  if (pending == UV_TCP) {
-    pending_obj = AcceptHandle<TCPWrap, uv_tcp_t>(env, wrap);
-  } else if (pending == UV_NAMED_PIPE) {
-    pending_obj = AcceptHandle<PipeWrap, uv_pipe_t>(env, wrap);
-  } else if (pending == UV_UDP) {
-    pending_obj = AcceptHandle<UDPWrap, uv_udp_t>(env, wrap);
-  } else {
-    CHECK_EQ(pending, UV_UNKNOWN_HANDLE);
-  }
+  pending_obj = wrap->AcceptPendingHandle(pending);
 
   Local<Object> obj = Buffer::New(env, base, nread).ToLocalChecked();
   wrap->EmitData(nread, obj, pending_obj);
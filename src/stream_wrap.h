@@ -69,6 +69,11 @@ class StreamWrap : public HandleWrap, public StreamBase {
   AsyncWrap* GetAsyncWrap() override;
   void UpdateWriteQueueSize();
 
+  // Accepts the handle of type |pending| that was received together with
+  // the data passed to the read callback.  Returns an empty handle when
+  // |pending| is UV_UNKNOWN_HANDLE.
+  v8::Local<v8::Object> AcceptPendingHandle(uv_handle_type pending);
+
   static void AddMethods(Environment* env,
                          v8::Local<v8::FunctionTemplate> target,
                          int flags = StreamBase::kFlagNone);
@@ -3,9 +3,110 @@
 namespace node {
 namespace stringsearch {
 
-int StringSearchBase::kBadCharShiftTable[kUC16AlphabetSize];
-int StringSearchBase::kGoodSuffixShiftTable[kBMMaxShift + 1];
-int StringSearchBase::kSuffixTable[kBMMaxShift + 1];
+StringSearchBase::Tables StringSearchBase::kSharedTables;
+
+
+MultiStringSearch::MultiStringSearch(
+    const std::vector<Vector<const uint8_t>>& patterns)
+    : class_count_(1), max_length_(0) {
+  CHECK_GT(patterns.size(), 0);
+
+  memset(classes_, 0, sizeof(classes_));
+  for (const auto& pattern : patterns) {
+    CHECK(pattern.forward());
+    for (size_t i = 0; i < pattern.length(); i++) {
+      if (classes_[pattern[i]] == 0)
+        classes_[pattern[i]] = static_cast<uint8_t>(class_count_++);
+    }
+  }
+  // When all 256 byte values occur in the patterns, the last one numbered
+  // wraps around to class 0, which no other byte uses then.
+  if (class_count_ > 256) {
+    class_count_ = 256;
+  }
+
+  // Build the trie.  kNone marks a transition that doesn't exist yet.
+  const uint32_t kNone = static_cast<uint32_t>(-1);
+  transitions_.assign(class_count_, kNone);
+  match_length_.assign(1, 0);
+  match_index_.assign(1, 0);
+  for (size_t p = 0; p < patterns.size(); p++) {
+    const Vector<const uint8_t>& pattern = patterns[p];
+    CHECK_GT(pattern.length(), 0);
+    uint32_t state = 0;
+    for (size_t i = 0; i < pattern.length(); i++) {
+      uint32_t* next = &transitions_[state * class_count_ +
+                                     classes_[pattern[i]]];
+      if (*next == kNone) {
+        *next = static_cast<uint32_t>(match_length_.size());
+        transitions_.resize(transitions_.size() + class_count_, kNone);
+        match_length_.push_back(0);
+        match_index_.push_back(0);
+        next = &transitions_[state * class_count_ + classes_[pattern[i]]];
+      }
+      state = *next;
+    }
+    // A duplicate keeps the index of the first copy.
+    if (match_length_[state] == 0) {
+      match_length_[state] = static_cast<uint32_t>(pattern.length());
+      match_index_[state] = static_cast<uint32_t>(p);
+    }
+    max_length_ = Max(max_length_, pattern.length());
+  }
+
+  // Turn the trie into a DFA in breadth-first order, so the state a failure
+  // link points to is always complete before it is used.  A state that isn't
+  // the end of a pattern takes over the longest match of its failure state.
+  std::vector<uint32_t> failure(match_length_.size(), 0);
+  std::vector<uint32_t> queue;
+  queue.reserve(match_length_.size());
+  queue.push_back(0);
+  for (size_t q = 0; q < queue.size(); q++) {
+    const uint32_t state = queue[q];
+    for (size_t c = 0; c < class_count_; c++) {
+      uint32_t* next = &transitions_[state * class_count_ + c];
+      const uint32_t fallback =
+          state == 0 ? 0 : transitions_[failure[state] * class_count_ + c];
+      if (*next == kNone) {
+        *next = fallback;
+        continue;
+      }
+      failure[*next] = fallback;
+      if (match_length_[*next] == 0) {
+        match_length_[*next] = match_length_[fallback];
+        match_index_[*next] = match_index_[fallback];
+      }
+      queue.push_back(*next);
+    }
+  }
+}
+
+
+size_t MultiStringSearch::Search(const uint8_t* subject,
+                                 size_t subject_length,
+                                 size_t index,
+                                 size_t* pattern_index) const {
+  const uint32_t* transitions = transitions_.data();
+  size_t best = subject_length;
+  uint32_t state = 0;
+  for (size_t i = index; i < subject_length; i++) {
+    state = transitions[state * class_count_ + classes_[subject[i]]];
+    const uint32_t length = match_length_[state];
+    if (length != 0) {
+      // The longest pattern that ends here is the one that starts first.
+      const size_t start = i + 1 - length;
+      if (best == subject_length || start < best ||
+          (start == best && match_index_[state] < *pattern_index)) {
+        best = start;
+        *pattern_index = match_index_[state];
+      }
+    }
+    // Matches that end after this point start after |best|.
+    if (best != subject_length && i + 1 >= best + max_length_)
+      break;
+  }
+  return best;
+}
 
 }  // namespace stringsearch
 }  // namespace node
@@ -9,6 +9,22 @@
 
 #include "node.h"
 #include <string.h>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NODE_STRING_SEARCH_AVX2 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NODE_STRING_SEARCH_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace node {
 namespace stringsearch {
@@ -62,6 +78,9 @@ class Vector {
 // Class holding constants and methods that apply to all string search variants,
 // independently of subject and pattern char size.
 class StringSearchBase {
+ public:
+  struct Tables;
+
  protected:
   // Cap on the maximal shift in the Boyer-Moore implementation. By setting a
   // limit, we can fix the size of tables. For a needle longer than this limit,
@@ -84,26 +103,53 @@ class StringSearchBase {
   // to compensate for the algorithmic overhead compared to simple brute force.
   static const int kBMMinPatternLength = 8;
 
+  // Patterns up to this length are searched for with FirstByteSearch and
+  // FirstLastByteSearch when the CPU supports it.
+  static const int kSimdMaxPatternLength = 32;
+
+  // The cost of a candidate position that FirstByteSearch has to check but
+  // that doesn't match, in bytes that memchr() has to skip to make up for it.
+  static const int kFalseCandidateCost = 32;
+
+  // Tables shared by all search objects that don't bring their own.
+  static Tables kSharedTables;
+};
+
+// Store for the Boyer-Moore(-Horspool) tables.  A search object that is kept
+// around to search for the same pattern many times should own one of these,
+// the shared set is overwritten by the next search that needs it.
+struct StringSearchBase::Tables {
   // Store for the BoyerMoore(Horspool) bad char shift table.
-  static int kBadCharShiftTable[kUC16AlphabetSize];
+  int bad_char_shift[kUC16AlphabetSize];
   // Store for the BoyerMoore good suffix shift table.
-  static int kGoodSuffixShiftTable[kBMMaxShift + 1];
+  int good_suffix_shift[kBMMaxShift + 1];
   // Table used temporarily while building the BoyerMoore good suffix
   // shift table.
-  static int kSuffixTable[kBMMaxShift + 1];
+  int suffix[kBMMaxShift + 1];
 };
 
 template <typename Char>
 class StringSearch : private StringSearchBase {
  public:
   explicit StringSearch(Vector<const Char> pattern)
-      : pattern_(pattern), start_(0) {
+      : StringSearch(pattern, &kSharedTables) {}
+
+  // |tables| must outlive the search object.
+  StringSearch(Vector<const Char> pattern, Tables* tables)
+      : pattern_(pattern), tables_(tables), start_(0) {
     if (pattern.length() >= kBMMaxShift) {
       start_ = pattern.length() - kBMMaxShift;
     }
 
     size_t pattern_length = pattern_.length();
     CHECK_GT(pattern_length, 0);
+#if defined(NODE_STRING_SEARCH_SSE2)
+    if (sizeof(Char) == 1 && pattern.forward() && pattern_length > 1 &&
+        pattern_length <= kSimdMaxPatternLength) {
+      strategy_ = &FirstByteSearch;
+      return;
+    }
+#endif
     if (pattern_length < kBMMinPatternLength) {
       if (pattern_length == 1) {
         strategy_ = &SingleCharSearch;
@@ -147,6 +193,14 @@ class StringSearch : private StringSearchBase {
                              Vector<const Char> subject,
                              size_t start_index);
 
+  static size_t FirstByteSearch(StringSearch<Char>* search,
+                                Vector<const Char> subject,
+                                size_t start_index);
+
+  static size_t FirstLastByteSearch(StringSearch<Char>* search,
+                                    Vector<const Char> subject,
+                                    size_t start_index);
+
   static size_t InitialSearch(StringSearch<Char>* search,
                               Vector<const Char> subject,
                               size_t start_index);
@@ -177,27 +231,29 @@ class StringSearch : private StringSearchBase {
   // Store for the BoyerMoore(Horspool) bad char shift table.
   // Return a table covering the last kBMMaxShift+1 positions of
   // pattern.
-  int* bad_char_table() { return kBadCharShiftTable; }
+  int* bad_char_table() { return tables_->bad_char_shift; }
 
   // Store for the BoyerMoore good suffix shift table.
   int* good_suffix_shift_table() {
     // Return biased pointer that maps the range  [start_..pattern_.length()
-    // to the kGoodSuffixShiftTable array.
-    return kGoodSuffixShiftTable - start_;
+    // to the good_suffix_shift array.
+    return tables_->good_suffix_shift - start_;
   }
 
   // Table used temporarily while building the BoyerMoore good suffix
   // shift table.
   int* suffix_table() {
     // Return biased pointer that maps the range  [start_..pattern_.length()
-    // to the kSuffixTable array.
-    return kSuffixTable - start_;
+    // to the suffix array.
+    return tables_->suffix - start_;
   }
 
   // The pattern to search for.
   Vector<const Char> pattern_;
   // Pointer to implementation of the search.
   SearchFunction strategy_;
+  // The Boyer-Moore(-Horspool) tables.
+  Tables* tables_;
   // Cache value of Max(0, pattern_length() - kBMMaxShift)
   size_t start_;
 };
@@ -358,6 +414,142 @@ size_t StringSearch<Char>::LinearSearch(
   return subject.length();
 }
 
+//---------------------------------------------------------------------
+// SIMD first and last byte filter search
+//---------------------------------------------------------------------
+
+#if defined(NODE_STRING_SEARCH_SSE2)
+inline unsigned CountTrailingZeros(uint32_t value) {
+#if defined(_MSC_VER)
+  unsigned long index;  // NOLINT(runtime/int)
+  _BitScanForward(&index, value);
+  return index;
+#else
+  return __builtin_ctz(value);
+#endif
+}
+
+// Compares the first and the last byte of the pattern against 16 (SSE2) or
+// 32 (AVX2) positions of the subject at once and only compares the rest of
+// the pattern where both match.  Short patterns don't let Boyer-Moore skip
+// far enough to win, while this filter rarely has false positives because
+// it looks at two bytes that are pattern_length - 1 apart.
+// Returns subject_length if the pattern is not found.
+inline size_t SimdFirstLastByteSearch(const uint8_t* subject,
+                                      size_t subject_length,
+                                      const uint8_t* pattern,
+                                      size_t pattern_length,
+                                      size_t index) {
+  CHECK_GT(pattern_length, 1);
+  const size_t last_offset = pattern_length - 1;
+  const uint8_t first = pattern[0];
+  const uint8_t last = pattern[last_offset];
+  size_t i = index;
+
+#if defined(NODE_STRING_SEARCH_AVX2)
+  const __m256i first32 = _mm256_set1_epi8(static_cast<char>(first));
+  const __m256i last32 = _mm256_set1_epi8(static_cast<char>(last));
+  for (; i + last_offset + 32 <= subject_length; i += 32) {
+    const __m256i block_first = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(subject + i));
+    const __m256i block_last = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(subject + i + last_offset));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(first32, block_first),
+                         _mm256_cmpeq_epi8(last32, block_last))));
+    while (mask != 0) {
+      const size_t pos = i + CountTrailingZeros(mask);
+      if (memcmp(subject + pos + 1, pattern + 1, pattern_length - 2) == 0)
+        return pos;
+      mask &= mask - 1;
+    }
+  }
+#endif
+
+  const __m128i first16 = _mm_set1_epi8(static_cast<char>(first));
+  const __m128i last16 = _mm_set1_epi8(static_cast<char>(last));
+  for (; i + last_offset + 16 <= subject_length; i += 16) {
+    const __m128i block_first = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(subject + i));
+    const __m128i block_last = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(subject + i + last_offset));
+    uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(first16, block_first),
+                      _mm_cmpeq_epi8(last16, block_last))));
+    while (mask != 0) {
+      const size_t pos = i + CountTrailingZeros(mask);
+      if (memcmp(subject + pos + 1, pattern + 1, pattern_length - 2) == 0)
+        return pos;
+      mask &= mask - 1;
+    }
+  }
+
+  for (; i + last_offset < subject_length; i++) {
+    if (subject[i] == first && subject[i + last_offset] == last &&
+        memcmp(subject + i + 1, pattern + 1, pattern_length - 2) == 0) {
+      return i;
+    }
+  }
+  return subject_length;
+}
+#endif  // defined(NODE_STRING_SEARCH_SSE2)
+
+// Linear search for short one-byte patterns.  memchr() is much faster than
+// the SIMD filter when the first byte of the pattern is rare, so start with
+// it and switch to FirstLastByteSearch when it keeps stopping at positions
+// that don't match.
+template <typename Char>
+size_t StringSearch<Char>::FirstByteSearch(
+    StringSearch<Char>* search,
+    Vector<const Char> subject,
+    size_t index) {
+  Vector<const Char> pattern = search->pattern_;
+  const size_t pattern_length = pattern.length();
+  const size_t n = subject.length() - pattern_length;
+  // Every byte memchr() skips makes up for some of the false candidates.
+  int64_t badness = -8 * kFalseCandidateCost;
+  for (size_t i = index; i <= n; i++) {
+    const size_t pos = FindFirstCharacter(pattern, subject, i);
+    if (pos == subject.length())
+      return subject.length();
+    ASSERT_LE(pos, n);
+    size_t j = 1;
+    while (j < pattern_length && pattern[j] == subject[pos + j])
+      j++;
+    if (j == pattern_length)
+      return pos;
+    badness += kFalseCandidateCost - static_cast<int64_t>(pos - i);
+    if (badness > 0) {
+      search->strategy_ = &FirstLastByteSearch;
+      return FirstLastByteSearch(search, subject, pos + 1);
+    }
+    i = pos;
+  }
+  return subject.length();
+}
+
+// Only selected for forward searches of one-byte patterns, see the
+// StringSearch constructor.
+template <typename Char>
+size_t StringSearch<Char>::FirstLastByteSearch(
+    StringSearch<Char>* search,
+    Vector<const Char> subject,
+    size_t index) {
+#if defined(NODE_STRING_SEARCH_SSE2)
+  Vector<const Char> pattern = search->pattern_;
+  CHECK_EQ(sizeof(Char), 1);
+  CHECK(subject.forward());
+  return SimdFirstLastByteSearch(
+      reinterpret_cast<const uint8_t*>(subject.start()),
+      subject.length(),
+      reinterpret_cast<const uint8_t*>(pattern.start()),
+      pattern.length(),
+      index);
+#else
+  return LinearSearch(search, subject, index);
+#endif
+}
+
 //---------------------------------------------------------------------
 // Boyer-Moore string search
 //---------------------------------------------------------------------
@@ -623,6 +815,41 @@ size_t SearchString(Vector<const Char> subject,
   StringSearch<Char> search(pattern);
   return search.Search(subject, start_index);
 }
+
+//---------------------------------------------------------------------
+// Multiple pattern search
+//---------------------------------------------------------------------
+
+// Aho-Corasick automaton that finds the leftmost occurrence of any of a set of
+// byte patterns in one pass over the subject.  The bytes that occur in the
+// patterns are numbered; all other bytes share class 0.  That keeps the
+// transition table at (number of distinct bytes + 1) entries per state.
+class MultiStringSearch {
+ public:
+  // The automaton doesn't hold on to the patterns.  None may be empty.
+  explicit MultiStringSearch(
+      const std::vector<Vector<const uint8_t>>& patterns);
+
+  // Returns the position of the leftmost match at or after |index|, or
+  // subject_length if there is none, and stores the index of the pattern
+  // that matched in |pattern_index|.  If several patterns match at that
+  // position, the one that comes first in the list wins.
+  size_t Search(const uint8_t* subject,
+                size_t subject_length,
+                size_t index,
+                size_t* pattern_index) const;
+
+ private:
+  uint8_t classes_[256];
+  size_t class_count_;
+  size_t max_length_;
+  // Transitions from state s are at s * class_count_.  State 0 is the root.
+  std::vector<uint32_t> transitions_;
+  // Length and index of the longest pattern that ends in each state, the
+  // length is 0 if no pattern does.
+  std::vector<uint32_t> match_length_;
+  std::vector<uint32_t> match_index_;
+};
 }  // namespace stringsearch
 }  // namespace node
 
@@ -7,12 +7,21 @@
 #include "node_buffer.h"
 #include "node_wrap.h"
 #include "connect_wrap.h"
+#include "req-wrap.h"
+#include "req-wrap-inl.h"
 #include "stream_wrap.h"
 #include "util.h"
 #include "util-inl.h"
 
 #include <stdlib.h>
 
+#ifndef _WIN32
+# include <errno.h>
+# include <sys/socket.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
 
 namespace node {
 
@@ -26,6 +35,7 @@ using v8::FunctionTemplate;
 using v8::HandleScope;
 using v8::Integer;
 using v8::Local;
+using v8::Number;
 using v8::Object;
 using v8::String;
 using v8::Value;
@@ -75,6 +85,7 @@ void TCPWrap::Initialize(Local<Object> target,
   env->SetProtoMethod(t, "open", Open);
   env->SetProtoMethod(t, "bind", Bind);
   env->SetProtoMethod(t, "listen", Listen);
+  env->SetProtoMethod(t, "setAcceptBatch", SetAcceptBatch);
   env->SetProtoMethod(t, "connect", Connect);
   env->SetProtoMethod(t, "bind6", Bind6);
   env->SetProtoMethod(t, "connect6", Connect6);
@@ -85,6 +96,11 @@ void TCPWrap::Initialize(Local<Object> target,
   env->SetProtoMethod(t, "setNoDelay", SetNoDelay);
   env->SetProtoMethod(t, "setKeepAlive", SetKeepAlive);
 
+#ifndef _WIN32
+  env->SetProtoMethod(t, "sendFile", SendFile);
+  env->SetProtoMethod(t, "abortSendFile", AbortSendFile);
+#endif
+
 #ifdef _WIN32
   env->SetProtoMethod(t, "setSimultaneousAccepts", SetSimultaneousAccepts);
 #endif
@@ -92,6 +108,11 @@ void TCPWrap::Initialize(Local<Object> target,
   target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "TCP"), t->GetFunction());
   env->set_tcp_constructor_template(t);
 
+  // Flags for bind() and bind6().
+  Local<Object> constants = Object::New(env->isolate());
+  NODE_DEFINE_CONSTANT(constants, kBindReusePort);
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "constants"), constants);
+
   // Create FunctionTemplate for TCPConnectWrap.
   auto constructor = [](const FunctionCallbackInfo<Value>& args) {
     CHECK(args.IsConstructCall());
@@ -186,6 +207,41 @@ void TCPWrap::Open(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+// Sets SO_REUSEPORT on the socket of |handle|, creating the socket first if
+// it does not exist yet.  Every socket that is bound to the same address with
+// SO_REUSEPORT gets its own accept queue and the kernel spreads incoming
+// connections across them.  Only Linux balances the load, other platforms
+// hand all connections to one of the sockets, so they are not supported.
+int TCPWrap::SetReusePort(int domain) {
+#if defined(__linux__) && defined(SO_REUSEPORT)
+  int fd;
+  int err = uv_fileno(reinterpret_cast<uv_handle_t*>(&handle_), &fd);
+  bool created = false;
+
+  if (err == UV_EBADF) {
+    fd = socket(domain, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+      return -errno;
+    created = true;
+  } else if (err != 0) {
+    return err;
+  }
+
+  int on = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0)
+    err = -errno;
+  else if (created)
+    err = uv_tcp_open(&handle_, fd);
+
+  if (err != 0 && created)
+    close(fd);
+  return err;
+#else
+  return UV_ENOTSUP;
+#endif
+}
+
+
 void TCPWrap::Bind(const FunctionCallbackInfo<Value>& args) {
   TCPWrap* wrap;
   ASSIGN_OR_RETURN_UNWRAP(&wrap,
@@ -193,8 +249,11 @@ void TCPWrap::Bind(const FunctionCallbackInfo<Value>& args) {
                           args.GetReturnValue().Set(UV_EBADF));
   node::Utf8Value ip_address(args.GetIsolate(), args[0]);
   int port = args[1]->Int32Value();
+  int flags = args[2]->Int32Value();
   sockaddr_in addr;
   int err = uv_ip4_addr(*ip_address, port, &addr);
+  if (err == 0 && (flags & kBindReusePort))
+    err = wrap->SetReusePort(AF_INET);
   if (err == 0) {
     err = uv_tcp_bind(&wrap->handle_,
                       reinterpret_cast<const sockaddr*>(&addr),
@@ -211,8 +270,11 @@ void TCPWrap::Bind6(const FunctionCallbackInfo<Value>& args) {
                           args.GetReturnValue().Set(UV_EBADF));
   node::Utf8Value ip6_address(args.GetIsolate(), args[0]);
   int port = args[1]->Int32Value();
+  int flags = args[2]->Int32Value();
   sockaddr_in6 addr;
   int err = uv_ip6_addr(*ip6_address, port, &addr);
+  if (err == 0 && (flags & kBindReusePort))
+    err = wrap->SetReusePort(AF_INET6);
   if (err == 0) {
     err = uv_tcp_bind(&wrap->handle_,
                       reinterpret_cast<const sockaddr*>(&addr),
@@ -333,6 +395,200 @@ void TCPWrap::Connect6(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+#ifndef _WIN32
+// Sends part of a file over a socket with non-blocking sendfile(2) calls made
+// on the event loop whenever a uv_poll_t reports that the socket is writable,
+// so that a slow peer never ties up a threadpool thread.  The poll handle
+// watches a dup() of the socket so that closing the TCP handle can't leave it
+// writing to a recycled file descriptor; the transfer is cut short with
+// AbortSendFile() instead.
+class SendFileWrap : public AsyncWrap {
+ public:
+  SendFileWrap(Environment* env,
+               Local<Object> req,
+               int out,
+               int in,
+               int64_t offset,
+               int64_t length)
+      : AsyncWrap(env, req, AsyncWrap::PROVIDER_WRITEWRAP),
+        out_(out),
+        in_(in),
+        offset_(offset),
+        length_(length),
+        sent_(0) {
+    Wrap(object(), this);
+  }
+
+  ~SendFileWrap() override {
+    close(out_);
+    ClearWrap(object());
+    persistent().Reset();
+  }
+
+  int Start();
+
+  size_t self_size() const override { return sizeof(*this); }
+
+ private:
+  void Done(int err);
+
+  static void OnWritable(uv_poll_t* handle, int status, int events);
+  static void OnClose(uv_handle_t* handle);
+
+  uv_poll_t poll_;
+  const int out_;
+  const int in_;
+  const int64_t offset_;
+  const int64_t length_;
+  int64_t sent_;
+};
+
+
+// Deletes the request if the transfer can't be started.
+int SendFileWrap::Start() {
+  int err = uv_poll_init(env()->event_loop(), &poll_, out_);
+  if (err) {
+    delete this;
+    return err;
+  }
+  err = uv_poll_start(&poll_, UV_WRITABLE, OnWritable);
+  if (err)
+    uv_close(reinterpret_cast<uv_handle_t*>(&poll_), OnClose);
+  return err;
+}
+
+
+void SendFileWrap::OnWritable(uv_poll_t* handle, int status, int events) {
+  SendFileWrap* req_wrap = ContainerOf(&SendFileWrap::poll_, handle);
+  // Bounds the time spent on the loop per wakeup when the peer keeps up.
+  const int64_t kMaxChunk = 4 << 20;
+  int64_t budget = kMaxChunk;
+
+  if (status < 0) {
+    req_wrap->Done(status);
+    return;
+  }
+
+  while (req_wrap->sent_ < req_wrap->length_ && budget > 0) {
+    const int64_t remaining = req_wrap->length_ - req_wrap->sent_;
+    uv_fs_t fs_req;
+    const int n = uv_fs_sendfile(handle->loop,
+                                 &fs_req,
+                                 req_wrap->out_,
+                                 req_wrap->in_,
+                                 req_wrap->offset_ + req_wrap->sent_,
+                                 remaining < budget ? remaining : budget,
+                                 nullptr);
+    uv_fs_req_cleanup(&fs_req);
+
+    if (n == UV_EAGAIN)
+      return;  // Wait for the send buffer to drain.
+
+    if (n < 0) {
+      req_wrap->Done(n);
+      return;
+    }
+
+    if (n == 0)  // EOF
+      break;
+
+    req_wrap->sent_ += n;
+    budget -= n;
+  }
+
+  if (budget > 0)
+    req_wrap->Done(0);
+}
+
+
+void SendFileWrap::Done(int err) {
+  uv_poll_stop(&poll_);
+
+  Environment* env = this->env();
+  HandleScope handle_scope(env->isolate());
+  Context::Scope context_scope(env->context());
+
+  Local<Value> argv[] = {
+    Integer::New(env->isolate(), err),
+    Number::New(env->isolate(), static_cast<double>(sent_))
+  };
+  MakeCallback(env->oncomplete_string(), arraysize(argv), argv);
+
+  uv_close(reinterpret_cast<uv_handle_t*>(&poll_), OnClose);
+}
+
+
+void SendFileWrap::OnClose(uv_handle_t* handle) {
+  uv_poll_t* poll = reinterpret_cast<uv_poll_t*>(handle);
+  SendFileWrap* req_wrap = ContainerOf(&SendFileWrap::poll_, poll);
+  delete req_wrap;
+}
+
+
+// err = sendFile(req, fd, offset, length)
+// Calls req.oncomplete(status, bytesSent) when done.  A negative length sends
+// the rest of the file.  Must only be used while the write queue of the handle
+// is empty.
+void TCPWrap::SendFile(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  TCPWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap,
+                          args.Holder(),
+                          args.GetReturnValue().Set(UV_EBADF));
+
+  CHECK(args[0]->IsObject());
+  CHECK(args[1]->IsInt32());
+  CHECK(args[2]->IsNumber());
+  CHECK(args[3]->IsNumber());
+
+  Local<Object> req_wrap_obj = args[0].As<Object>();
+  const int in = args[1]->Int32Value();
+  const int64_t offset = args[2]->IntegerValue();
+  int64_t length = args[3]->IntegerValue();
+
+  if (length < 0) {
+    struct stat s;
+    if (fstat(in, &s) == -1)
+      return args.GetReturnValue().Set(-errno);
+    length = s.st_size > offset ? s.st_size - offset : 0;
+  }
+
+  int fd;
+  int err = uv_fileno(reinterpret_cast<uv_handle_t*>(&wrap->handle_), &fd);
+  if (err == 0) {
+    const int out = dup(fd);
+    if (out == -1) {
+      err = -errno;
+    } else {
+      SendFileWrap* req_wrap =
+          new SendFileWrap(env, req_wrap_obj, out, in, offset, length);
+      err = req_wrap->Start();
+    }
+  }
+
+  args.GetReturnValue().Set(err);
+}
+
+
+// Shuts the socket down so a sendFile() in progress fails fast, rather than
+// running to completion on the dup()ed descriptor after the handle is closed.
+void TCPWrap::AbortSendFile(const FunctionCallbackInfo<Value>& args) {
+  TCPWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap,
+                          args.Holder(),
+                          args.GetReturnValue().Set(UV_EBADF));
+
+  int fd;
+  int err = uv_fileno(reinterpret_cast<uv_handle_t*>(&wrap->handle_), &fd);
+  if (err == 0 && shutdown(fd, SHUT_RDWR) == -1)
+    err = -errno;
+
+  args.GetReturnValue().Set(err);
+}
+#endif  // _WIN32
+
+
 // also used by udp_wrap.cc
 Local<Object> AddressToJS(Environment* env,
                           const sockaddr* addr,
@@ -18,6 +18,10 @@ class TCPWrap : public ConnectionWrap<TCPWrap, uv_tcp_t> {
 
   size_t self_size() const override { return sizeof(*this); }
 
+  enum BindFlags {
+    kBindReusePort = 1
+  };
+
  private:
   typedef uv_tcp_t HandleType;
 
@@ -38,6 +42,13 @@ class TCPWrap : public ConnectionWrap<TCPWrap, uv_tcp_t> {
   static void Connect6(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Open(const v8::FunctionCallbackInfo<v8::Value>& args);
 
+  int SetReusePort(int domain);
+
+#ifndef _WIN32
+  static void SendFile(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void AbortSendFile(const v8::FunctionCallbackInfo<v8::Value>& args);
+#endif
+
 #ifdef _WIN32
   static void SetSimultaneousAccepts(
       const v8::FunctionCallbackInfo<v8::Value>& args);
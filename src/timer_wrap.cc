@@ -6,20 +6,421 @@
 #include "util.h"
 #include "util-inl.h"
 
+#include <math.h>
 #include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
 
 namespace node {
 
+using v8::ArrayBuffer;
 using v8::Context;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
 using v8::HandleScope;
 using v8::Integer;
 using v8::Local;
+using v8::Number;
 using v8::Object;
+using v8::Uint32Array;
 using v8::Value;
 
 const uint32_t kOnTimeout = 0;
+// Same limit as in lib/timers.js.  The wheel covers 2^32 milliseconds, a
+// timer that is due later would be re-linked into the same slot forever.
+const double kTimeoutMax = 2147483647.0;
+
+// All timers created by lib/timers.js live in a hierarchical timing wheel
+// (Varghese & Lauck) that is driven by a single uv_timer_t, instead of one
+// TimerWrap handle per distinct timeout duration.
+//
+// The wheel has kLevels levels of kSlots slots with a resolution of one
+// millisecond.  A timer that is due in less than kSlots milliseconds goes into
+// a slot of level 0, a timer that is due later goes into the level whose slots
+// are wide enough to hold it.  Whenever the wheel passes the start of the time
+// range of a slot on a higher level, that slot is cascaded, i.e. its timers
+// are moved to the lower levels.  Inserting and cancelling a timer is O(1).
+//
+// Timers are identified by small integer ids that are allocated by JS.  When
+// timers expire, JS is called once with the ids of all of them, in the order
+// in which they are due.
+class TimerWheel : public HandleWrap {
+ public:
+  static void Initialize(Environment* env, Local<Object> target) {
+    Local<FunctionTemplate> constructor = env->NewFunctionTemplate(New);
+    constructor->InstanceTemplate()->SetInternalFieldCount(1);
+    constructor->SetClassName(
+        FIXED_ONE_BYTE_STRING(env->isolate(), "TimerWheel"));
+
+    env->SetProtoMethod(constructor, "insert", Insert);
+    env->SetProtoMethod(constructor, "cancel", Cancel);
+
+    target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "TimerWheel"),
+                constructor->GetFunction());
+  }
+
+  size_t self_size() const override { return sizeof(*this); }
+
+ private:
+  static const unsigned kBits = 8;
+  static const unsigned kSlots = 1 << kBits;
+  static const unsigned kLevels = 4;
+  static const uint32_t kNil = 0xffffffff;
+  static const uint16_t kUnlinked = 0xffff;
+
+  struct Timer {
+    Timer() : expiry(0), seq(0), prev(kNil), next(kNil), slot(kUnlinked),
+              unrefed(false) {}
+
+    uint64_t expiry;
+    uint64_t seq;
+    uint32_t prev;
+    uint32_t next;
+    uint16_t slot;  // level * kSlots + index, or kUnlinked.
+    bool unrefed;
+  };
+
+  static void New(const FunctionCallbackInfo<Value>& args) {
+    CHECK(args.IsConstructCall());
+    Environment* env = Environment::GetCurrent(args);
+    new TimerWheel(env, args.This());
+  }
+
+  TimerWheel(Environment* env, Local<Object> object)
+      : HandleWrap(env,
+                   object,
+                   reinterpret_cast<uv_handle_t*>(&handle_),
+                   AsyncWrap::PROVIDER_TIMERWRAP),
+        current_(uv_now(env->event_loop())),
+        seq_(0),
+        count_(0),
+        refed_count_(0),
+        armed_(false),
+        armed_at_(0),
+        dispatching_(false) {
+    int r = uv_timer_init(env->event_loop(), &handle_);
+    CHECK_EQ(r, 0);
+    // Only referenced while it holds timers that keep the loop alive.
+    uv_unref(reinterpret_cast<uv_handle_t*>(&handle_));
+    for (size_t i = 0; i < arraysize(heads_); i++)
+      heads_[i] = kNil;
+    memset(bitmap_, 0, sizeof(bitmap_));
+  }
+
+  // insert(id, msecs, unrefed) schedules timer |id| to expire in |msecs|
+  // milliseconds, re-scheduling it if it is already in the wheel.  Returns
+  // the current time, in the same time base as Timer.now().
+  static void Insert(const FunctionCallbackInfo<Value>& args) {
+    TimerWheel* wheel = Unwrap<TimerWheel>(args.Holder());
+    CHECK(HandleWrap::IsAlive(wheel));
+    CHECK(args[0]->IsUint32());
+
+    const uint32_t id = args[0]->Uint32Value();
+    double msecs = args[1]->NumberValue();
+    if (!(msecs > 0))
+      msecs = 0;
+    else if (msecs > kTimeoutMax)
+      msecs = kTimeoutMax;
+
+    uv_loop_t* loop = wheel->env()->event_loop();
+    uv_update_time(loop);
+    const uint64_t now = uv_now(loop);
+
+    wheel->Add(id, now, now + static_cast<uint64_t>(ceil(msecs)),
+               args[2]->IsTrue());
+
+    CHECK(now >= wheel->env()->timer_base());
+    const uint64_t rel = now - wheel->env()->timer_base();
+    if (rel <= 0xfffffff)
+      args.GetReturnValue().Set(static_cast<uint32_t>(rel));
+    else
+      args.GetReturnValue().Set(static_cast<double>(rel));
+  }
+
+  // cancel(id) removes timer |id| from the wheel, if it is in it.
+  static void Cancel(const FunctionCallbackInfo<Value>& args) {
+    TimerWheel* wheel = Unwrap<TimerWheel>(args.Holder());
+    CHECK(HandleWrap::IsAlive(wheel));
+    CHECK(args[0]->IsUint32());
+
+    const uint32_t id = args[0]->Uint32Value();
+    if (id >= wheel->timers_.size() ||
+        wheel->timers_[id].slot == kUnlinked) {
+      return;
+    }
+    wheel->Remove(id);
+    if (!wheel->dispatching_) {
+      if (wheel->count_ == 0)
+        wheel->Disarm();
+      wheel->UpdateRef();
+    }
+  }
+
+  void Add(uint32_t id, uint64_t now, uint64_t expiry, bool unrefed) {
+    if (id >= timers_.size())
+      timers_.resize(id + 1);
+    if (timers_[id].slot != kUnlinked)
+      Remove(id);
+
+    // Nothing is due before the time the handle is armed for, so the wheel
+    // can skip ahead.  That keeps new timers on the lowest possible level.
+    if (count_ == 0 && !dispatching_)
+      current_ = now;
+    else if (armed_ && now < armed_at_ && current_ < now)
+      current_ = now;
+
+    Timer* timer = &timers_[id];
+    timer->expiry = expiry < current_ ? current_ : expiry;
+    timer->seq = seq_++;
+    timer->unrefed = unrefed;
+    Link(id);
+    count_++;
+    if (!unrefed)
+      refed_count_++;
+
+    if (dispatching_)
+      return;  // OnTimeout() re-arms the handle when JS returns.
+    const uint64_t when = DueTick(timer->slot);
+    if (!armed_ || when < armed_at_)
+      Arm(when);
+    UpdateRef();
+  }
+
+  void Remove(uint32_t id) {
+    Unlink(id);
+    count_--;
+    if (!timers_[id].unrefed)
+      refed_count_--;
+  }
+
+  void Link(uint32_t id) {
+    Timer* timer = &timers_[id];
+    const uint64_t delta = timer->expiry - current_;
+    unsigned level = 0;
+    while (level < kLevels - 1 && (delta >> (kBits * (level + 1))) != 0)
+      level++;
+    const unsigned index = (timer->expiry >> (kBits * level)) & (kSlots - 1);
+    const uint16_t slot = level * kSlots + index;
+
+    timer->slot = slot;
+    uint32_t head = heads_[slot];
+    if (head == kNil) {
+      heads_[slot] = id;
+      timer->prev = timer->next = id;
+      bitmap_[slot / 64] |= uint64_t(1) << (slot % 64);
+    } else {
+      uint32_t tail = timers_[head].prev;
+      timer->prev = tail;
+      timer->next = head;
+      timers_[tail].next = id;
+      timers_[head].prev = id;
+    }
+  }
+
+  void Unlink(uint32_t id) {
+    Timer* timer = &timers_[id];
+    const uint16_t slot = timer->slot;
+    if (timer->next == id) {
+      heads_[slot] = kNil;
+      bitmap_[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+    } else {
+      timers_[timer->prev].next = timer->next;
+      timers_[timer->next].prev = timer->prev;
+      if (heads_[slot] == id)
+        heads_[slot] = timer->next;
+    }
+    timer->slot = kUnlinked;
+  }
+
+  // Detaches the list of |slot| from the wheel and returns its first timer.
+  uint32_t TakeSlot(uint16_t slot) {
+    const uint32_t head = heads_[slot];
+    heads_[slot] = kNil;
+    bitmap_[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+    return head;
+  }
+
+  // The tick at which |slot| must be processed: the expiry time of its timers
+  // on level 0, the start of its time range on the other levels.
+  uint64_t DueTick(uint16_t slot) const {
+    const unsigned level = slot / kSlots;
+    const uint64_t index = slot % kSlots;
+    const uint64_t span = uint64_t(1) << (kBits * level);
+    const uint64_t first = (current_ + span - 1) & ~(span - 1);
+    const uint64_t first_index = (first >> (kBits * level)) & (kSlots - 1);
+    return first + ((index - first_index) & (kSlots - 1)) * span;
+  }
+
+  // The first non-empty slot of |level| at or after |index|, wrapping around.
+  int FindSlot(unsigned level, unsigned index) const {
+    const uint64_t* words = bitmap_ + level * (kSlots / 64);
+    for (unsigned i = 0; i <= kSlots / 64; i++) {
+      const unsigned word = ((index / 64) + i) % (kSlots / 64);
+      uint64_t bits = words[word];
+      if (i == 0)
+        bits &= ~uint64_t(0) << (index % 64);
+      else if (i == kSlots / 64)
+        bits &= (uint64_t(1) << (index % 64)) - 1;
+      if (bits != 0)
+        return word * 64 + CountTrailingZeros(bits);
+    }
+    return -1;
+  }
+
+  static unsigned CountTrailingZeros(uint64_t bits) {
+    unsigned n = 0;
+    while ((bits & 1) == 0) {
+      bits >>= 1;
+      n++;
+    }
+    return n;
+  }
+
+  // The first tick at which a timer expires or a slot must be cascaded.
+  uint64_t NextTick() const {
+    uint64_t next = std::numeric_limits<uint64_t>::max();
+    for (unsigned level = 0; level < kLevels; level++) {
+      // Slots are due in order, starting with the one that starts next.
+      const uint64_t span = uint64_t(1) << (kBits * level);
+      const uint64_t first = (current_ + span - 1) & ~(span - 1);
+      const int index =
+          FindSlot(level, (first >> (kBits * level)) & (kSlots - 1));
+      if (index < 0)
+        continue;
+      const uint64_t tick = DueTick(level * kSlots + index);
+      if (tick < next)
+        next = tick;
+    }
+    return next;
+  }
+
+  // Moves the timers of all slots that start at |tick| to lower levels and
+  // appends the timers that expire at |tick| to |expired_|.
+  void ProcessTick(uint64_t tick) {
+    current_ = tick;
+    for (unsigned level = kLevels - 1; level > 0; level--) {
+      if ((tick & ((uint64_t(1) << (kBits * level)) - 1)) != 0)
+        continue;
+      const unsigned index = (tick >> (kBits * level)) & (kSlots - 1);
+      uint32_t id = TakeSlot(level * kSlots + index);
+      if (id == kNil)
+        continue;
+      // The list is circular, break it up before re-linking its timers.
+      timers_[timers_[id].prev].next = kNil;
+      while (id != kNil) {
+        const uint32_t next = timers_[id].next;
+        Link(id);
+        id = next;
+      }
+    }
+
+    uint32_t id = TakeSlot(tick & (kSlots - 1));
+    if (id == kNil)
+      return;
+    const size_t first = expired_.size();
+    const uint32_t head = id;
+    do {
+      Timer* timer = &timers_[id];
+      timer->slot = kUnlinked;
+      expired_.push_back(id);
+      count_--;
+      if (!timer->unrefed)
+        refed_count_--;
+      id = timer->next;
+    } while (id != head);
+
+    // Cascaded timers are appended after timers that were inserted directly
+    // into level 0, restore the insertion order.
+    std::sort(expired_.begin() + first, expired_.end(),
+              [this](uint32_t a, uint32_t b) {
+                return timers_[a].seq < timers_[b].seq;
+              });
+  }
+
+  void Arm(uint64_t tick) {
+    const uint64_t now = uv_now(env()->event_loop());
+    uv_timer_start(&handle_, OnTimeout, tick > now ? tick - now : 0, 0);
+    armed_ = true;
+    armed_at_ = tick;
+  }
+
+  void Disarm() {
+    uv_timer_stop(&handle_);
+    armed_ = false;
+  }
+
+  void UpdateRef() {
+    uv_handle_t* handle = reinterpret_cast<uv_handle_t*>(&handle_);
+    if (refed_count_ > 0 && !uv_has_ref(handle))
+      uv_ref(handle);
+    else if (refed_count_ == 0 && uv_has_ref(handle))
+      uv_unref(handle);
+  }
+
+  static void OnTimeout(uv_timer_t* handle) {
+    TimerWheel* wheel = static_cast<TimerWheel*>(handle->data);
+    Environment* env = wheel->env();
+    const uint64_t now = uv_now(env->event_loop());
+
+    wheel->armed_ = false;
+    wheel->expired_.clear();
+    while (wheel->count_ > 0) {
+      const uint64_t tick = wheel->NextTick();
+      if (tick > now)
+        break;
+      wheel->ProcessTick(tick);
+    }
+    if (wheel->current_ <= now)
+      wheel->current_ = now + 1;
+
+    if (!wheel->expired_.empty()) {
+      HandleScope handle_scope(env->isolate());
+      Context::Scope context_scope(env->context());
+
+      const size_t length = wheel->expired_.size();
+      Local<ArrayBuffer> buffer =
+          ArrayBuffer::New(env->isolate(), length * sizeof(uint32_t));
+      memcpy(buffer->GetContents().Data(),
+             wheel->expired_.data(),
+             length * sizeof(uint32_t));
+      Local<Value> argv[] = {
+        Uint32Array::New(buffer, 0, length),
+        Number::New(env->isolate(),
+                    static_cast<double>(now - env->timer_base()))
+      };
+
+      wheel->dispatching_ = true;
+      wheel->MakeCallback(kOnTimeout, arraysize(argv), argv);
+      wheel->dispatching_ = false;
+    }
+
+    if (!HandleWrap::IsAlive(wheel))
+      return;
+    if (wheel->count_ > 0)
+      wheel->Arm(wheel->NextTick());
+    else
+      wheel->Disarm();
+    wheel->UpdateRef();
+  }
+
+  uv_timer_t handle_;
+  std::vector<Timer> timers_;
+  std::vector<uint32_t> expired_;
+  uint32_t heads_[kLevels * kSlots];
+  uint64_t bitmap_[kLevels * kSlots / 64];
+  uint64_t current_;  // The first tick that has not been processed yet.
+  uint64_t seq_;
+  uint32_t count_;
+  uint32_t refed_count_;
+  bool armed_;
+  uint64_t armed_at_;
+  bool dispatching_;
+};
+
+
 
 class TimerWrap : public HandleWrap {
  public:
@@ -45,6 +446,8 @@ class TimerWrap : public HandleWrap {
 
     target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "Timer"),
                 constructor->GetFunction());
+
+    TimerWheel::Initialize(env, target);
   }
 
   size_t self_size() const override { return sizeof(*this); }
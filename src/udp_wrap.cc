@@ -8,12 +8,16 @@
 #include "util.h"
 #include "util-inl.h"
 
+#include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 namespace node {
 
 using v8::Array;
+using v8::ArrayBuffer;
+using v8::ArrayBufferCreationMode;
 using v8::Context;
 using v8::EscapableHandleScope;
 using v8::External;
@@ -26,21 +30,42 @@ using v8::Object;
 using v8::PropertyAttribute;
 using v8::PropertyCallbackInfo;
 using v8::String;
+using v8::Uint32Array;
 using v8::Undefined;
 using v8::Value;
 
+// Enough for the largest UDP payload.  The size of the receive slab and of
+// every slot of the batch slab.
+static const size_t kRecvSlotSize = 64 * 1024;
+static const unsigned int kMaxRecvBatch = 64;
+// Same as Buffer.poolSize in lib/buffer.js.  Datagrams of up to half of it
+// are copied into the pool, bigger ones get a buffer of their own.
+static const size_t kRecvPoolSize = 8 * 1024;
+
 
 class SendWrap : public ReqWrap<uv_udp_send_t> {
  public:
   SendWrap(Environment* env, Local<Object> req_wrap_obj, bool have_callback);
   inline bool have_callback() const;
   size_t msg_size;
+  // For batches: the datagrams still in flight, the first error of the ones
+  // that completed and the bytes of the ones that went out.
+  unsigned int batch_pending = 0;
+  int batch_status = 0;
+  size_t batch_sent = 0;
   size_t self_size() const override { return sizeof(*this); }
  private:
   const bool have_callback_;
 };
 
 
+// One datagram of a batch that goes through libuv.
+struct BatchSendReq {
+  uv_udp_send_t req;
+  size_t length;
+};
+
+
 SendWrap::SendWrap(Environment* env,
                    Local<Object> req_wrap_obj,
                    bool have_callback)
@@ -64,12 +89,24 @@ UDPWrap::UDPWrap(Environment* env, Local<Object> object, AsyncWrap* parent)
     : HandleWrap(env,
                  object,
                  reinterpret_cast<uv_handle_t*>(&handle_),
-                 AsyncWrap::PROVIDER_UDPWRAP) {
+                 AsyncWrap::PROVIDER_UDPWRAP),
+      recv_batch_(1),
+      batch_slab_(nullptr),
+      recv_slab_(nullptr),
+      recv_pool_data_(nullptr),
+      recv_pool_offset_(0) {
   int r = uv_udp_init(env->event_loop(), &handle_);
   CHECK_EQ(r, 0);  // can't fail anyway
 }
 
 
+UDPWrap::~UDPWrap() {
+  free(batch_slab_);
+  free(recv_slab_);
+  recv_pool_.Reset();
+}
+
+
 void UDPWrap::Initialize(Local<Object> target,
                          Local<Value> unused,
                          Local<Context> context) {
@@ -92,9 +129,12 @@ void UDPWrap::Initialize(Local<Object> target,
   env->SetProtoMethod(t, "send", Send);
   env->SetProtoMethod(t, "bind6", Bind6);
   env->SetProtoMethod(t, "send6", Send6);
+  env->SetProtoMethod(t, "sendBatch", SendBatch);
+  env->SetProtoMethod(t, "sendBatch6", SendBatch6);
   env->SetProtoMethod(t, "close", Close);
   env->SetProtoMethod(t, "recvStart", RecvStart);
   env->SetProtoMethod(t, "recvStop", RecvStop);
+  env->SetProtoMethod(t, "setRecvBatch", SetRecvBatch);
   env->SetProtoMethod(t, "getsockname",
                       GetSockOrPeerName<UDPWrap, uv_udp_getsockname>);
   env->SetProtoMethod(t, "addMembership", AddMembership);
@@ -341,6 +381,198 @@ void UDPWrap::Send6(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+int UDPWrap::TrySendBatch(const uv_buf_t* bufs,
+                          unsigned int count,
+                          const struct sockaddr* addr) {
+  // Datagrams that libuv has queued have to go out first.
+  if (handle_.send_queue_count > 0)
+    return 0;
+
+#if defined(__linux__)
+  uv_os_fd_t fd;
+  int err = uv_fileno(reinterpret_cast<uv_handle_t*>(&handle_), &fd);
+  if (err)
+    return err;
+
+  const socklen_t addrlen = addr->sa_family == AF_INET6 ?
+      sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+  unsigned int sent = 0;
+  while (sent < count) {
+    struct mmsghdr msgs[64];
+    struct iovec iovs[arraysize(msgs)];
+    unsigned int n = count - sent;
+    if (n > arraysize(msgs))
+      n = arraysize(msgs);
+
+    memset(msgs, 0, n * sizeof(msgs[0]));
+    for (unsigned int i = 0; i < n; i++) {
+      iovs[i].iov_base = bufs[sent + i].base;
+      iovs[i].iov_len = bufs[sent + i].len;
+      msgs[i].msg_hdr.msg_name = const_cast<struct sockaddr*>(addr);
+      msgs[i].msg_hdr.msg_namelen = addrlen;
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int r;
+    do
+      r = sendmmsg(fd, msgs, n, 0);
+    while (r == -1 && errno == EINTR);
+
+    if (r == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS)
+        break;
+      // Let libuv report the errors of the datagrams after the first one.
+      if (sent == 0)
+        return -errno;
+      break;
+    }
+
+    sent += r;
+    if (static_cast<unsigned int>(r) < n)
+      break;
+  }
+  return sent;
+#else
+  unsigned int sent = 0;
+  while (sent < count) {
+    int err = uv_udp_try_send(&handle_, &bufs[sent], 1, addr);
+    if (err < 0) {
+      if (sent == 0 && err != UV_EAGAIN && err != UV_ENOSYS)
+        return err;
+      break;
+    }
+    sent++;
+  }
+  return sent;
+#endif
+}
+
+
+// sendBatch(req, list, count, port, address, hasCallback) sends every
+// element of |list| as a datagram of its own.  It returns 1 when all of them
+// went out right away, in which case oncomplete() is not called, 0 when
+// oncomplete(status, bytes) will be called, or an error code when no datagram
+// was queued.  An error after some datagrams went out or were queued is
+// reported to oncomplete(), or with the error code, and req.bytes is the
+// number of bytes that went out.
+void UDPWrap::DoSendBatch(const FunctionCallbackInfo<Value>& args,
+                          int family) {
+  Environment* env = Environment::GetCurrent(args);
+
+  UDPWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap,
+                          args.Holder(),
+                          args.GetReturnValue().Set(UV_EBADF));
+
+  CHECK(args[0]->IsObject());
+  CHECK(args[1]->IsArray());
+  CHECK(args[2]->IsUint32());
+  CHECK(args[3]->IsUint32());
+  CHECK(args[4]->IsString());
+  CHECK(args[5]->IsBoolean());
+
+  Local<Object> req_wrap_obj = args[0].As<Object>();
+  Local<Array> chunks = args[1].As<Array>();
+  const unsigned int count = args[2]->Uint32Value();
+  const unsigned short port = args[3]->Uint32Value();
+  node::Utf8Value address(env->isolate(), args[4]);
+  const bool have_callback = args[5]->IsTrue();
+
+  CHECK_GT(count, 0);
+
+  char addr[sizeof(sockaddr_in6)];
+  int err;
+
+  switch (family) {
+  case AF_INET:
+    err = uv_ip4_addr(*address, port, reinterpret_cast<sockaddr_in*>(&addr));
+    break;
+  case AF_INET6:
+    err = uv_ip6_addr(*address, port, reinterpret_cast<sockaddr_in6*>(&addr));
+    break;
+  default:
+    CHECK(0 && "unexpected address family");
+    ABORT();
+  }
+
+  if (err)
+    return args.GetReturnValue().Set(err);
+
+  uv_buf_t bufs_[16];
+  uv_buf_t* bufs = bufs_;
+
+  if (arraysize(bufs_) < count)
+    bufs = new uv_buf_t[count];
+
+  size_t msg_size = 0;
+  for (unsigned int i = 0; i < count; i++) {
+    Local<Value> chunk = chunks->Get(i);
+    size_t length = Buffer::Length(chunk);
+    bufs[i] = uv_buf_init(Buffer::Data(chunk), length);
+    msg_size += length;
+  }
+
+  const sockaddr* sa = reinterpret_cast<const sockaddr*>(&addr);
+  int sent = wrap->TrySendBatch(bufs, count, sa);
+
+  if (sent < 0 || static_cast<unsigned int>(sent) == count) {
+    if (bufs != bufs_)
+      delete[] bufs;
+    return args.GetReturnValue().Set(sent < 0 ? sent : 1);
+  }
+
+  size_t sent_bytes = 0;
+  for (int i = 0; i < sent; i++)
+    sent_bytes += bufs[i].len;
+
+  SendWrap* req_wrap = new SendWrap(env, req_wrap_obj, have_callback);
+  req_wrap->msg_size = msg_size;
+  req_wrap->batch_sent = sent_bytes;
+  req_wrap->Dispatched();
+
+  // The rest goes through libuv one datagram at a time.  A failure, e.g.
+  // ENOMEM, stops the batch; the datagrams queued before it still complete
+  // and the last of them reports the error.
+  unsigned int queued = 0;
+  for (unsigned int i = sent; i < count; i++) {
+    BatchSendReq* req = new BatchSendReq;
+    req->req.data = req_wrap;
+    req->length = bufs[i].len;
+    err = uv_udp_send(&req->req, &wrap->handle_, &bufs[i], 1, sa, OnBatchSend);
+    if (err) {
+      delete req;
+      break;
+    }
+    queued++;
+  }
+
+  if (bufs != bufs_)
+    delete[] bufs;
+
+  if (queued == 0) {
+    req_wrap_obj->Set(env->bytes_string(),
+                      Integer::NewFromUnsigned(env->isolate(), sent_bytes));
+    delete req_wrap;
+    return args.GetReturnValue().Set(err);
+  }
+
+  req_wrap->batch_pending = queued;
+  req_wrap->batch_status = err;
+  args.GetReturnValue().Set(0);
+}
+
+
+void UDPWrap::SendBatch(const FunctionCallbackInfo<Value>& args) {
+  DoSendBatch(args, AF_INET);
+}
+
+
+void UDPWrap::SendBatch6(const FunctionCallbackInfo<Value>& args) {
+  DoSendBatch(args, AF_INET6);
+}
+
+
 void UDPWrap::RecvStart(const FunctionCallbackInfo<Value>& args) {
   UDPWrap* wrap;
   ASSIGN_OR_RETURN_UNWRAP(&wrap,
@@ -364,6 +596,30 @@ void UDPWrap::RecvStop(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+void UDPWrap::SetRecvBatch(const FunctionCallbackInfo<Value>& args) {
+  UDPWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap,
+                          args.Holder(),
+                          args.GetReturnValue().Set(UV_EBADF));
+  CHECK(args[0]->IsUint32());
+  const unsigned int batch = args[0]->Uint32Value();
+  if (batch < 1 || batch > kMaxRecvBatch)
+    return args.GetReturnValue().Set(UV_EINVAL);
+
+  char* slab = nullptr;
+  if (batch > 1) {
+    slab = static_cast<char*>(node::Malloc((batch - 1) * kRecvSlotSize));
+    if (slab == nullptr)
+      return args.GetReturnValue().Set(UV_ENOMEM);
+  }
+
+  free(wrap->batch_slab_);
+  wrap->batch_slab_ = slab;
+  wrap->recv_batch_ = batch;
+  args.GetReturnValue().Set(0);
+}
+
+
 // TODO(bnoordhuis) share with StreamWrap::AfterWrite() in stream_wrap.cc
 void UDPWrap::OnSend(uv_udp_send_t* req, int status) {
   SendWrap* req_wrap = static_cast<SendWrap*>(req->data);
@@ -381,16 +637,87 @@ void UDPWrap::OnSend(uv_udp_send_t* req, int status) {
 }
 
 
+// Completes one datagram of a batch, the last one to complete reports the
+// first error and the bytes that went out.
+void UDPWrap::OnBatchSend(uv_udp_send_t* uv_req, int status) {
+  BatchSendReq* req = ContainerOf(&BatchSendReq::req, uv_req);
+  SendWrap* req_wrap = static_cast<SendWrap*>(req->req.data);
+  const size_t length = req->length;
+  delete req;
+
+  if (status == 0)
+    req_wrap->batch_sent += length;
+  else if (req_wrap->batch_status == 0)
+    req_wrap->batch_status = status;
+
+  if (--req_wrap->batch_pending > 0)
+    return;
+
+  if (req_wrap->have_callback()) {
+    Environment* env = req_wrap->env();
+    HandleScope handle_scope(env->isolate());
+    Context::Scope context_scope(env->context());
+    Local<Value> arg[] = {
+      Integer::New(env->isolate(), req_wrap->batch_status),
+      Integer::NewFromUnsigned(env->isolate(), req_wrap->batch_sent),
+    };
+    req_wrap->MakeCallback(env->oncomplete_string(), 2, arg);
+  }
+  delete req_wrap;
+}
+
+
+// libuv has at most one read in flight per handle and hands the buffer back
+// in OnRecv() before it asks for the next one, so the slab can be reused for
+// every datagram.
 void UDPWrap::OnAlloc(uv_handle_t* handle,
                       size_t suggested_size,
                       uv_buf_t* buf) {
-  buf->base = static_cast<char*>(node::Malloc(suggested_size));
-  buf->len = suggested_size;
+  UDPWrap* wrap = static_cast<UDPWrap*>(handle->data);
 
-  if (buf->base == nullptr && suggested_size > 0) {
-    FatalError("node::UDPWrap::OnAlloc(uv_handle_t*, size_t, uv_buf_t*)",
-               "Out Of Memory");
+  if (wrap->recv_slab_ == nullptr) {
+    wrap->recv_slab_ = static_cast<char*>(node::Malloc(kRecvSlotSize));
+    if (wrap->recv_slab_ == nullptr) {
+      FatalError("node::UDPWrap::OnAlloc(uv_handle_t*, size_t, uv_buf_t*)",
+                 "Out Of Memory");
+    }
   }
+
+  buf->base = wrap->recv_slab_;
+  buf->len = kRecvSlotSize;
+}
+
+
+Local<Object> UDPWrap::CopyDatagram(const char* data, size_t length) {
+  Environment* env = this->env();
+
+  if (length > kRecvPoolSize / 2)
+    return Buffer::Copy(env, data, length).ToLocalChecked();
+
+  Local<ArrayBuffer> pool;
+  if (recv_pool_.IsEmpty() || recv_pool_offset_ + length > kRecvPoolSize) {
+    recv_pool_data_ = static_cast<char*>(node::Malloc(kRecvPoolSize));
+    if (recv_pool_data_ == nullptr) {
+      FatalError("node::UDPWrap::CopyDatagram(const char*, size_t)",
+                 "Out Of Memory");
+    }
+    // Slices that are still alive keep the old pool alive.
+    pool = ArrayBuffer::New(env->isolate(),
+                            recv_pool_data_,
+                            kRecvPoolSize,
+                            ArrayBufferCreationMode::kInternalized);
+    recv_pool_.Reset(env->isolate(), pool);
+    recv_pool_offset_ = 0;
+  } else {
+    pool = PersistentToLocal(env->isolate(), recv_pool_);
+  }
+
+  memcpy(recv_pool_data_ + recv_pool_offset_, data, length);
+  Local<Object> buffer =
+      Buffer::New(env, pool, recv_pool_offset_, length).ToLocalChecked();
+  // Keep the slices 8-byte aligned, like lib/buffer.js does.
+  recv_pool_offset_ = (recv_pool_offset_ + length + 7) & ~7;
+  return buffer;
 }
 
 
@@ -399,11 +726,9 @@ void UDPWrap::OnRecv(uv_udp_t* handle,
                      const uv_buf_t* buf,
                      const struct sockaddr* addr,
                      unsigned int flags) {
-  if (nread == 0 && addr == nullptr) {
-    if (buf->base != nullptr)
-      free(buf->base);
+  // Nothing to do, the slab is reused for the next datagram.
+  if (nread == 0 && addr == nullptr)
     return;
-  }
 
   UDPWrap* wrap = static_cast<UDPWrap*>(handle->data);
   Environment* env = wrap->env();
@@ -420,19 +745,173 @@ void UDPWrap::OnRecv(uv_udp_t* handle,
   };
 
   if (nread < 0) {
-    if (buf->base != nullptr)
-      free(buf->base);
     wrap->MakeCallback(env->onmessage_string(), arraysize(argv), argv);
     return;
   }
 
-  char* base = static_cast<char*>(node::Realloc(buf->base, nread));
-  argv[2] = Buffer::New(env, base, nread).ToLocalChecked();
+  if (wrap->recv_batch_ > 1)
+    return wrap->OnRecvBatch(nread, buf, addr);
+
+  argv[2] = wrap->CopyDatagram(buf->base, nread);
   argv[3] = AddressToJS(env, addr);
   wrap->MakeCallback(env->onmessage_string(), arraysize(argv), argv);
 }
 
 
+unsigned int UDPWrap::DrainDatagrams(unsigned int max,
+                                     size_t* lengths,
+                                     struct sockaddr_storage* addrs) {
+#if defined(_WIN32)
+  // libuv reads with overlapped I/O, the socket can't be read from here.
+  return 0;
+#else
+  uv_os_fd_t fd;
+  if (uv_fileno(reinterpret_cast<uv_handle_t*>(&handle_), &fd))
+    return 0;
+
+#if defined(__linux__)
+  struct mmsghdr msgs[kMaxRecvBatch];
+  struct iovec iovs[kMaxRecvBatch];
+
+  memset(msgs, 0, max * sizeof(msgs[0]));
+  for (unsigned int i = 0; i < max; i++) {
+    iovs[i].iov_base = batch_slab_ + i * kRecvSlotSize;
+    iovs[i].iov_len = kRecvSlotSize;
+    msgs[i].msg_hdr.msg_name = &addrs[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  int n;
+  do
+    n = recvmmsg(fd, msgs, max, MSG_DONTWAIT, nullptr);
+  while (n == -1 && errno == EINTR);
+
+  // Errors other than EAGAIN show up again when libuv reads next.
+  if (n <= 0)
+    return 0;
+
+  for (int i = 0; i < n; i++)
+    lengths[i] = msgs[i].msg_len;
+  return n;
+#else
+  unsigned int n = 0;
+  while (n < max) {
+    socklen_t addrlen = sizeof(addrs[n]);
+    ssize_t r;
+    do
+      r = recvfrom(fd,
+                   batch_slab_ + n * kRecvSlotSize,
+                   kRecvSlotSize,
+                   MSG_DONTWAIT,
+                   reinterpret_cast<struct sockaddr*>(&addrs[n]),
+                   &addrlen);
+    while (r == -1 && errno == EINTR);
+    if (r == -1)
+      break;
+    lengths[n++] = r;
+  }
+  return n;
+#endif
+#endif  // defined(_WIN32)
+}
+
+
+static bool IsSameAddress(const struct sockaddr* a, const struct sockaddr* b) {
+  if (a->sa_family != b->sa_family)
+    return false;
+  if (a->sa_family == AF_INET6) {
+    return memcmp(&reinterpret_cast<const sockaddr_in6*>(a)->sin6_addr,
+                  &reinterpret_cast<const sockaddr_in6*>(b)->sin6_addr,
+                  sizeof(in6_addr)) == 0;
+  }
+  return memcmp(&reinterpret_cast<const sockaddr_in*>(a)->sin_addr,
+                &reinterpret_cast<const sockaddr_in*>(b)->sin_addr,
+                sizeof(in_addr)) == 0;
+}
+
+
+// Passes the datagram that libuv has read, together with the ones that are
+// waiting behind it, to onmessages(handle, buffer, info, addresses).  The
+// datagrams are copied back to back into |buffer|.  |info| holds the length,
+// port, address family and index into |addresses| of every datagram.
+// Consecutive datagrams from the same address share an |addresses| entry.
+void UDPWrap::OnRecvBatch(ssize_t nread,
+                          const uv_buf_t* buf,
+                          const struct sockaddr* addr) {
+  Environment* env = this->env();
+
+  size_t lengths[kMaxRecvBatch];
+  struct sockaddr_storage addrs[kMaxRecvBatch];
+  lengths[0] = nread;
+  memcpy(&addrs[0],
+         addr,
+         addr->sa_family == AF_INET6 ? sizeof(sockaddr_in6)
+                                     : sizeof(sockaddr_in));
+  const unsigned int count =
+      1 + DrainDatagrams(recv_batch_ - 1, &lengths[1], &addrs[1]);
+
+  size_t total = 0;
+  for (unsigned int i = 0; i < count; i++)
+    total += lengths[i];
+
+  char* data = static_cast<char*>(node::Malloc(total));
+  if (data == nullptr && total > 0) {
+    FatalError("node::UDPWrap::OnRecvBatch()", "Out Of Memory");
+  }
+
+  memcpy(data, buf->base, nread);
+  for (unsigned int i = 1, offset = nread; i < count; i++) {
+    memcpy(data + offset, batch_slab_ + (i - 1) * kRecvSlotSize, lengths[i]);
+    offset += lengths[i];
+  }
+
+  Local<ArrayBuffer> info_buffer =
+      ArrayBuffer::New(env->isolate(), count * 4 * sizeof(uint32_t));
+  uint32_t* info = static_cast<uint32_t*>(info_buffer->GetContents().Data());
+  Local<Array> addresses = Array::New(env->isolate());
+  uint32_t address_count = 0;
+
+  for (unsigned int i = 0; i < count; i++) {
+    const sockaddr* sa = reinterpret_cast<const sockaddr*>(&addrs[i]);
+    char ip[INET6_ADDRSTRLEN];
+    int family;
+    int port;
+
+    if (sa->sa_family == AF_INET6) {
+      const sockaddr_in6* a6 = reinterpret_cast<const sockaddr_in6*>(sa);
+      uv_inet_ntop(AF_INET6, &a6->sin6_addr, ip, sizeof(ip));
+      family = 6;
+      port = ntohs(a6->sin6_port);
+    } else {
+      const sockaddr_in* a4 = reinterpret_cast<const sockaddr_in*>(sa);
+      uv_inet_ntop(AF_INET, &a4->sin_addr, ip, sizeof(ip));
+      family = 4;
+      port = ntohs(a4->sin_port);
+    }
+
+    if (i == 0 ||
+        !IsSameAddress(sa, reinterpret_cast<const sockaddr*>(&addrs[i - 1]))) {
+      addresses->Set(address_count++, OneByteString(env->isolate(), ip));
+    }
+
+    info[i * 4] = lengths[i];
+    info[i * 4 + 1] = port;
+    info[i * 4 + 2] = family;
+    info[i * 4 + 3] = address_count - 1;
+  }
+
+  Local<Value> argv[] = {
+    object(),
+    Buffer::New(env, data, total).ToLocalChecked(),
+    Uint32Array::New(info_buffer, 0, count * 4),
+    addresses
+  };
+  MakeCallback(env->onmessages_string(), arraysize(argv), argv);
+}
+
+
 Local<Object> UDPWrap::Instantiate(Environment* env, AsyncWrap* parent) {
   EscapableHandleScope scope(env->isolate());
   // If this assert fires then Initialize hasn't been called yet.
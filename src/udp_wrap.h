@@ -25,8 +25,11 @@ class UDPWrap: public HandleWrap {
   static void Send(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Bind6(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Send6(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SendBatch(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SendBatch6(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void RecvStart(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void RecvStop(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SetRecvBatch(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void GetSockName(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void AddMembership(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void DropMembership(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -49,11 +52,14 @@ class UDPWrap: public HandleWrap {
   friend void GetSockOrPeerName(const v8::FunctionCallbackInfo<v8::Value>&);
 
   UDPWrap(Environment* env, v8::Local<v8::Object> object, AsyncWrap* parent);
+  ~UDPWrap() override;
 
   static void DoBind(const v8::FunctionCallbackInfo<v8::Value>& args,
                      int family);
   static void DoSend(const v8::FunctionCallbackInfo<v8::Value>& args,
                      int family);
+  static void DoSendBatch(const v8::FunctionCallbackInfo<v8::Value>& args,
+                          int family);
   static void SetMembership(const v8::FunctionCallbackInfo<v8::Value>& args,
                             uv_membership membership);
 
@@ -61,13 +67,40 @@ class UDPWrap: public HandleWrap {
                       size_t suggested_size,
                       uv_buf_t* buf);
   static void OnSend(uv_udp_send_t* req, int status);
+  static void OnBatchSend(uv_udp_send_t* req, int status);
   static void OnRecv(uv_udp_t* handle,
                      ssize_t nread,
                      const uv_buf_t* buf,
                      const struct sockaddr* addr,
                      unsigned int flags);
 
+  // Sends as many datagrams as the socket takes right away, returns their
+  // number or a negative error code.
+  int TrySendBatch(const uv_buf_t* bufs,
+                   unsigned int count,
+                   const struct sockaddr* addr);
+  // Receives up to |max| datagrams that are waiting in the receive queue
+  // into the batch slab, without blocking.  Returns their number.
+  unsigned int DrainDatagrams(unsigned int max,
+                              size_t* lengths,
+                              struct sockaddr_storage* addrs);
+  void OnRecvBatch(ssize_t nread,
+                   const uv_buf_t* buf,
+                   const struct sockaddr* addr);
+  // Copies a datagram out of the receive slab into a new buffer.
+  v8::Local<v8::Object> CopyDatagram(const char* data, size_t length);
+
   uv_udp_t handle_;
+  // The number of datagrams to pass to JS land per onmessages() call, 1
+  // passes them to onmessage() one by one.
+  unsigned int recv_batch_;
+  char* batch_slab_;
+  // libuv reads every datagram into the receive slab.  Small datagrams are
+  // then copied into the receive pool and passed to JS land as slices of it.
+  char* recv_slab_;
+  v8::Persistent<v8::ArrayBuffer> recv_pool_;
+  char* recv_pool_data_;
+  size_t recv_pool_offset_;
 };
 
 }  // namespace node
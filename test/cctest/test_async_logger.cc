@@ -0,0 +1,73 @@
+#include "async_logger.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using node::logger::AsyncLogger;
+using node::logger::ILogger;
+
+namespace {
+
+class CountingLogger : public ILogger {
+ public:
+  CountingLogger() : count_(0) {}
+  void Log(LogLevel logLevel, const char* str) const override { count_++; }
+  uint64_t count() const { return count_; }
+
+ private:
+  mutable std::atomic<uint64_t> count_;
+};
+
+}  // anonymous namespace
+
+TEST(AsyncLoggerTest, InstallTwice) {
+  CountingLogger sink;
+  EXPECT_TRUE(AsyncLogger::Install(&sink, nullptr, 16));
+  EXPECT_FALSE(AsyncLogger::Install(&sink, nullptr, 16));
+  EXPECT_TRUE(AsyncLogger::IsInstalled());
+  AsyncLogger::Uninstall();
+  EXPECT_FALSE(AsyncLogger::IsInstalled());
+  AsyncLogger::Uninstall();  // No-op.
+}
+
+// Producers keep logging while the instance is swapped out underneath them.
+// Every record that was accepted must be written out by the instance that
+// accepted it, and no producer may touch an instance after it is freed.
+TEST(AsyncLoggerTest, StartStopWhileLogging) {
+  const int kThreads = 4;
+  const int kRestarts = 100;
+  CountingLogger sink;
+  std::atomic<bool> done(false);
+  std::atomic<uint64_t> accepted(0);
+
+  std::vector<std::thread> producers;
+  for (int i = 0; i < kThreads; i++) {
+    producers.emplace_back([&]() {
+      static const char kMessage[] = "message";
+      while (!done) {
+        AsyncLogger::Ref logger;
+        if (logger.get() != nullptr &&
+            logger.get()->Append(ILogger::Info, kMessage,
+                                 sizeof(kMessage) - 1)) {
+          accepted++;
+        }
+      }
+    });
+  }
+
+  for (int i = 0; i < kRestarts; i++) {
+    EXPECT_TRUE(AsyncLogger::Install(&sink, nullptr, 64));
+    std::this_thread::yield();
+    AsyncLogger::Uninstall();
+  }
+
+  done = true;
+  for (std::thread& producer : producers)
+    producer.join();
+
+  EXPECT_FALSE(AsyncLogger::IsInstalled());
+  EXPECT_EQ(accepted.load(), sink.count());
+}
@@ -0,0 +1,190 @@
+#include "log_format.h"
+
+#include "gtest/gtest.h"
+
+#include <math.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using node::logger::EncodeLogBoolean;
+using node::logger::EncodeLogBytes;
+using node::logger::EncodeLogFormatId;
+using node::logger::EncodeLogNull;
+using node::logger::EncodeLogNumber;
+using node::logger::FormatLogRecord;
+using node::logger::IsLogFormat;
+using node::logger::LogArgTag;
+using node::logger::RegisterLogFormat;
+
+namespace {
+
+// Builds a structured record the way logStructured() does.
+class Record {
+ public:
+  explicit Record(uint32_t id) : data_(64) {
+    end_ = EncodeLogFormatId(data_.data(), id);
+  }
+
+  Record& Number(double value) {
+    Reserve(1 + sizeof(value));
+    end_ = EncodeLogNumber(end_, value);
+    return *this;
+  }
+
+  Record& Boolean(bool value) {
+    Reserve(2);
+    end_ = EncodeLogBoolean(end_, value);
+    return *this;
+  }
+
+  Record& Null() {
+    Reserve(1);
+    end_ = EncodeLogNull(end_);
+    return *this;
+  }
+
+  Record& String(const std::string& value) {
+    return Bytes(LogArgTag::String, value);
+  }
+
+  Record& Buffer(const std::string& value) {
+    return Bytes(LogArgTag::Buffer, value);
+  }
+
+  std::string Format() const {
+    std::string text;
+    FormatLogRecord(data_.data(), end_ - data_.data(), &text);
+    return text;
+  }
+
+ private:
+  Record& Bytes(LogArgTag tag, const std::string& value) {
+    Reserve(1 + sizeof(uint32_t) + value.size());
+    end_ = EncodeLogBytes(end_, tag, value.size());
+    memcpy(end_, value.data(), value.size());
+    end_ += value.size();
+    return *this;
+  }
+
+  void Reserve(size_t n) {
+    size_t used = end_ - data_.data();
+    if (used + n > data_.size())
+      data_.resize(used + n);
+    end_ = data_.data() + used;
+  }
+
+  std::vector<char> data_;
+  char* end_;
+};
+
+}  // anonymous namespace
+
+TEST(LogFormatTest, RegisterFormat) {
+  uint32_t first = RegisterLogFormat("first");
+  uint32_t second = RegisterLogFormat("second");
+  EXPECT_NE(first, second);
+  EXPECT_TRUE(IsLogFormat(first));
+  EXPECT_TRUE(IsLogFormat(second));
+  EXPECT_FALSE(IsLogFormat(second + 1));
+  EXPECT_EQ("<unknown log format>", Record(second + 1).Format());
+}
+
+TEST(LogFormatTest, Placeholders) {
+  uint32_t id = RegisterLogFormat("%s is %d%% done, %s left");
+  EXPECT_EQ("upload is 50% done, true left",
+            Record(id).String("upload").Number(50).Boolean(true).Format());
+
+  // Missing arguments leave the placeholders alone.
+  EXPECT_EQ("upload is %d% done, %s left",
+            Record(id).String("upload").Format());
+
+  // Arguments left over are appended.
+  EXPECT_EQ("a is 1% done, b left c 2 false null",
+            Record(id).String("a").Number(1).String("b").String("c")
+                .Number(2).Boolean(false).Null().Format());
+}
+
+// %d follows util.format(), which prints Number(arg).
+TEST(LogFormatTest, NumberConversion) {
+  uint32_t id = RegisterLogFormat("%d");
+  EXPECT_EQ("42", Record(id).Number(42).Format());
+  EXPECT_EQ("1.5", Record(id).Number(1.5).Format());
+  EXPECT_EQ("0", Record(id).Number(-0.0).Format());
+  EXPECT_EQ("NaN", Record(id).Number(NAN).Format());
+  EXPECT_EQ("-Infinity", Record(id).Number(-INFINITY).Format());
+  EXPECT_EQ("1e+21", Record(id).Number(1e21).Format());
+  EXPECT_EQ("0.1", Record(id).Number(0.1).Format());
+
+  EXPECT_EQ("1", Record(id).Boolean(true).Format());
+  EXPECT_EQ("0", Record(id).Boolean(false).Format());
+  EXPECT_EQ("0", Record(id).Null().Format());
+
+  EXPECT_EQ("NaN", Record(id).String("abc").Format());
+  EXPECT_EQ("NaN", Record(id).String("undefined").Format());
+  EXPECT_EQ("NaN", Record(id).String("12px").Format());
+  EXPECT_EQ("NaN", Record(id).String("inf").Format());
+  EXPECT_EQ("NaN", Record(id).String("0x").Format());
+  EXPECT_EQ("NaN", Record(id).String("1e").Format());
+  EXPECT_EQ("NaN", Record(id).String(".").Format());
+  EXPECT_EQ("0", Record(id).String("").Format());
+  EXPECT_EQ("0", Record(id).String(" \t\n").Format());
+  EXPECT_EQ("12", Record(id).String(" 12 ").Format());
+  EXPECT_EQ("-3.25", Record(id).String("-3.25").Format());
+  EXPECT_EQ("0.5", Record(id).String(".5").Format());
+  EXPECT_EQ("1500", Record(id).String("1.5e3").Format());
+  EXPECT_EQ("255", Record(id).String("0xff").Format());
+  EXPECT_EQ("8", Record(id).String("0o10").Format());
+  EXPECT_EQ("5", Record(id).String("0b101").Format());
+  EXPECT_EQ("Infinity", Record(id).String("+Infinity").Format());
+
+  // Number(buffer) converts the buffer's text.
+  EXPECT_EQ("7", Record(id).Buffer("7").Format());
+  EXPECT_EQ("NaN", Record(id).Buffer("\x01\x02").Format());
+}
+
+TEST(LogFormatTest, IntegerConversion) {
+  uint32_t id = RegisterLogFormat("%i");
+  EXPECT_EQ("1", Record(id).Number(1.9).Format());
+  EXPECT_EQ("-1", Record(id).Number(-1.9).Format());
+  EXPECT_EQ("3", Record(id).String("3.7").Format());
+  EXPECT_EQ("NaN", Record(id).String("x").Format());
+}
+
+TEST(LogFormatTest, Buffers) {
+  uint32_t id = RegisterLogFormat("%s");
+  // %s prints String(buffer), the text in it.
+  EXPECT_EQ("hi", Record(id).Buffer("hi").Format());
+  // Buffers left over are shown like util.inspect() does.
+  EXPECT_EQ("a <Buffer 68 69>", Record(id).String("a").Buffer("hi").Format());
+  EXPECT_EQ("a -0", Record(id).String("a").Number(-0.0).Format());
+
+  std::string big(60, 'x');
+  std::string expected = "a <Buffer";
+  for (int i = 0; i < 50; i++)
+    expected += " 78";
+  expected += " ... >";
+  EXPECT_EQ(expected, Record(id).String("a").Buffer(big).Format());
+}
+
+TEST(LogFormatTest, Truncated) {
+  uint32_t id = RegisterLogFormat("%s %s");
+  EXPECT_EQ("complete cut",
+            Record(id).String("complete").String("cut").Format());
+
+  // A record that ends in the middle of an argument stops there.
+  char data[64];
+  char* end = EncodeLogFormatId(data, id);
+  end = EncodeLogBytes(end, LogArgTag::String, 3);
+  memcpy(end, "abc", 3);
+  end += 3;
+  end = EncodeLogBytes(end, LogArgTag::String, 10);
+  memcpy(end, "de", 2);
+  end += 2;
+  std::string text;
+  FormatLogRecord(data, end - data, &text);
+  EXPECT_EQ("abc %s", text);
+
+  FormatLogRecord(data, 2, &text);
+  EXPECT_EQ("", text);
+}
@@ -0,0 +1,36 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const fs = require('fs');
+const async_wrap = process.binding('async_wrap');
+
+const keys = ['fastPath', 'slowPath', 'domainCallbacks', 'hookCallbacks',
+              'tickCallbacks'];
+const before = async_wrap.getCallbackStats();
+assert.deepStrictEqual(Object.keys(before), keys);
+
+// Without domains and async hooks, callbacks take the fast path.
+fs.stat(__filename, common.mustCall(function(err) {
+  assert.ifError(err);
+  process.nextTick(common.mustCall(function() {
+    const stats = async_wrap.getCallbackStats();
+    assert(stats.fastPath > before.fastPath);
+    assert.strictEqual(stats.slowPath, before.slowPath);
+    assert(stats.tickCallbacks > before.tickCallbacks);
+    withDomain(stats);
+  }));
+}));
+
+// Once domains are in use, callbacks take the slow path.
+function withDomain(before) {
+  const d = require('domain').create();
+  d.run(function() {
+    fs.stat(__filename, common.mustCall(function(err) {
+      assert.ifError(err);
+      const stats = async_wrap.getCallbackStats();
+      assert(stats.slowPath > before.slowPath);
+      assert(stats.domainCallbacks > before.domainCallbacks);
+      assert.strictEqual(stats.fastPath, before.fastPath);
+    }));
+  });
+}
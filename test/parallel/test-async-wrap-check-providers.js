@@ -46,7 +46,7 @@ async_wrap.setupHooks({ init });
 async_wrap.enable();
 
 
-setTimeout(function() { });
+new (process.binding('timer_wrap').Timer)();
 
 fs.stat(__filename, noop);
 
@@ -0,0 +1,108 @@
+'use strict';
+require('../common');
+const assert = require('assert');
+const Searcher = require('buffer').Searcher;
+
+const b = Buffer.from('abc\r\n--boundary\r\n--boundary--');
+
+// Single needle.
+{
+  const searcher = new Searcher('--boundary');
+  assert.strictEqual(searcher.indexOf(b), 5);
+  assert.strictEqual(searcher.indexOf(b, 6), 17);
+  assert.strictEqual(searcher.indexOf(b, -13), 17);
+  assert.strictEqual(searcher.indexOf(b, 18), -1);
+  assert.strictEqual(searcher.indexOf(b, 1000), -1);
+  assert.strictEqual(searcher.indexOf(b, 'foo'), 5);
+  assert.strictEqual(searcher.indexOf(Buffer.alloc(0)), -1);
+  assert.strictEqual(searcher.includes(b), true);
+  assert.strictEqual(searcher.includes(Buffer.from('--bound')), false);
+  assert.deepStrictEqual(searcher.search(b, 6), { index: 17, needle: 0 });
+  assert.strictEqual(searcher.search(b, 18), null);
+
+  // The tables are reused, results must not depend on earlier searches.
+  for (let i = 0; i < 3; i++)
+    assert.strictEqual(searcher.indexOf(b), 5);
+
+  const bytes = new Uint8Array(b.buffer, b.byteOffset, b.length);
+  assert.strictEqual(new Searcher(Buffer.from('\r\n')).indexOf(bytes), 3);
+  assert.strictEqual(new Searcher('6263', 'hex').indexOf(b), 1);
+}
+
+// Several needles.
+{
+  const searcher = new Searcher(['--', '\r\n', 'boundary--']);
+  assert.deepStrictEqual(searcher.search(b), { index: 3, needle: 1 });
+  assert.deepStrictEqual(searcher.search(b, 4), { index: 5, needle: 0 });
+  assert.deepStrictEqual(searcher.search(b, 6), { index: 15, needle: 1 });
+  assert.deepStrictEqual(searcher.search(b, 19), { index: 19, needle: 2 });
+  assert.deepStrictEqual(searcher.search(b, 20), { index: 27, needle: 0 });
+  assert.strictEqual(searcher.search(b, 28), null);
+  assert.strictEqual(searcher.indexOf(b, 7), 15);
+
+  // The leftmost match wins, then the first needle in the Array.
+  const s = Buffer.from('xabcd');
+  assert.deepStrictEqual(new Searcher(['bcd', 'abc']).search(s),
+                         { index: 1, needle: 1 });
+  assert.deepStrictEqual(new Searcher(['ab', 'abcd']).search(s),
+                         { index: 1, needle: 0 });
+  assert.deepStrictEqual(new Searcher(['abcd', 'ab']).search(s),
+                         { index: 1, needle: 0 });
+  assert.deepStrictEqual(new Searcher(['c', 'c']).search(s),
+                         { index: 3, needle: 0 });
+}
+
+assert.throws(() => new Searcher([]), TypeError);
+assert.throws(() => new Searcher(''), TypeError);
+assert.throws(() => new Searcher(['a', Buffer.alloc(0)]), TypeError);
+assert.throws(() => new Searcher(42), TypeError);
+assert.throws(() => new Searcher('a').indexOf('abc'), TypeError);
+
+// Compare Buffer#indexOf() and Searcher with a naive search on random data
+// from a small alphabet, which has many partial matches.
+function naiveIndexOf(haystack, needle, from) {
+  outer:
+  for (let i = from; i + needle.length <= haystack.length; i++) {
+    for (let j = 0; j < needle.length; j++) {
+      if (haystack[i + j] !== needle[j])
+        continue outer;
+    }
+    return i;
+  }
+  return -1;
+}
+
+function randomBuffer(length) {
+  const buf = Buffer.allocUnsafe(length);
+  for (let i = 0; i < length; i++)
+    buf[i] = 97 + Math.floor(Math.random() * 3);
+  return buf;
+}
+
+for (let i = 0; i < 500; i++) {
+  const haystack = randomBuffer(1 + Math.floor(Math.random() * 300));
+  const needles = [];
+  for (let j = 0; j < 1 + i % 4; j++)
+    needles.push(randomBuffer(1 + Math.floor(Math.random() * 40)));
+  const from = Math.floor(Math.random() * haystack.length);
+
+  let expected = -1;
+  let expectedNeedle = -1;
+  for (let j = 0; j < needles.length; j++) {
+    const index = naiveIndexOf(haystack, needles[j], from);
+    assert.strictEqual(haystack.indexOf(needles[j], from), index);
+    assert.strictEqual(new Searcher(needles[j]).indexOf(haystack, from), index);
+    if (index !== -1 && (expected === -1 || index < expected)) {
+      expected = index;
+      expectedNeedle = j;
+    }
+  }
+
+  const result = new Searcher(needles).search(haystack, from);
+  if (expected === -1) {
+    assert.strictEqual(result, null);
+  } else {
+    assert.strictEqual(result.index, expected);
+    assert.strictEqual(result.needle, expectedNeedle);
+  }
+}
@@ -0,0 +1,139 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const child_process = require('child_process');
+const net = require('net');
+
+if (process.argv[2] === 'child') {
+  process.on('message', function(message, handle) {
+    if (handle) {
+      handle.close();
+      process.send({ gotHandle: message });
+    } else {
+      process.send(message);
+    }
+  });
+  return;
+}
+
+assert.throws(function() {
+  child_process.fork(__filename, ['child'], { serialization: 'xml' });
+}, /"serialization" must be "json" or "advanced"/);
+
+// Only IPC pipes write messages with writev().
+{
+  const Pipe = process.binding('pipe_wrap').Pipe;
+  const pipe = new Pipe(false);
+  const ipc = new Pipe(true);
+  assert.strictEqual(pipe.writev, undefined);
+  assert.strictEqual(typeof ipc.writev, 'function');
+  pipe.close();
+  ipc.close();
+}
+
+const circular = { name: 'circular' };
+circular.self = circular;
+const big = Buffer.alloc(64 * 1024, 'big');
+// Changed right after send(), which must not affect the message.
+const mutable = Buffer.alloc(8192, 'a');
+
+// An own "__proto__" property, not a different prototype.
+const ownProto = JSON.parse('{"__proto__":{"x":1}}');
+
+const holes = [1, 2, 3];
+delete holes[1];
+
+const values = [
+  null,
+  -0,
+  NaN,
+  -Infinity,
+  2147483647,
+  -2147483648,
+  4294967296.5,
+  'string \u00e9\ud83d\ude00',
+  'x'.repeat(100000),
+  holes,
+  new Date(1478000000000),
+  /ab+c/gi,
+  new Map([[1, 'one'], ['two', { two: 2 }]]),
+  new Set(['a', 1]),
+  Buffer.from('small'),
+  big,
+  mutable,
+  [big, big],
+  new Float64Array([1.5, -2.5]),
+  new Uint16Array(5000).fill(7),
+  { nested: { array: [true, false], u: undefined } },
+  ownProto,
+  circular
+];
+
+const child = child_process.fork(__filename, ['child'], {
+  serialization: 'advanced'
+});
+
+var index = 0;
+child.on('message', common.mustCall(function(message) {
+  const expected = values[index++];
+
+  if (expected === mutable) {
+    assert(message.equals(Buffer.alloc(8192, 'a')));
+  } else if (expected === ownProto) {
+    assert.strictEqual(Object.getPrototypeOf(message), Object.prototype);
+    assert.deepStrictEqual(Object.keys(message), ['__proto__']);
+    assert.deepStrictEqual(
+        Object.getOwnPropertyDescriptor(message, '__proto__').value, { x: 1 });
+    assert.strictEqual(message.x, undefined);
+  } else if (expected === circular) {
+    assert.strictEqual(message.self, message);
+    assert.strictEqual(message.name, 'circular');
+  } else if (Buffer.isBuffer(expected)) {
+    assert(Buffer.isBuffer(message));
+    assert(message.equals(expected));
+  } else if (Array.isArray(expected) && Buffer.isBuffer(expected[0])) {
+    assert.strictEqual(message[0], message[1]);
+    assert(message[0].equals(big));
+  } else if (Object.is(expected, -0) || Number.isNaN(expected)) {
+    assert(Object.is(message, expected));
+  } else if (ArrayBuffer.isView(expected)) {
+    assert.strictEqual(message.constructor, expected.constructor);
+    assert.deepStrictEqual(Array.from(message), Array.from(expected));
+  } else if (expected instanceof Map || expected instanceof Set) {
+    assert.strictEqual(message.constructor, expected.constructor);
+    assert.deepStrictEqual(Array.from(message), Array.from(expected));
+  } else if (Array.isArray(expected)) {
+    assert.strictEqual(message.length, 3);
+    assert.strictEqual(1 in message, false);
+  } else if (expected instanceof Date || expected instanceof RegExp) {
+    assert.strictEqual(message.constructor, expected.constructor);
+    assert.strictEqual(String(message), String(expected));
+  } else if (expected !== null && typeof expected === 'object') {
+    assert.deepStrictEqual(message, expected);
+    assert('u' in message.nested);
+  } else {
+    assert.strictEqual(message, expected);
+  }
+
+  if (index === values.length) {
+    // Handles are delivered together with their message.
+    const server = net.createServer();
+    server.listen(0, common.mustCall(function() {
+      child.send('server', server);
+      server.close();
+    }));
+  } else if (index > values.length) {
+    assert.deepStrictEqual(message, { gotHandle: 'server' });
+    child.disconnect();
+  }
+}, values.length + 1));
+
+assert.throws(function() {
+  child.send({ fn: function() {} });
+}, /^TypeError: function could not be cloned$/);
+
+values.forEach((value) => child.send(value));
+mutable.fill('b');
+child.on('exit', common.mustCall(function(code) {
+  assert.strictEqual(code, 0);
+}));
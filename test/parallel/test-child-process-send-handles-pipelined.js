@@ -0,0 +1,63 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const child_process = require('child_process');
+const net = require('net');
+
+if (process.argv[2] === 'child') {
+  var expected = 0;
+  process.on('message', function(message, socket) {
+    // Handles are delivered in order and together with their message.
+    assert.strictEqual(message, expected++);
+    assert(socket instanceof net.Socket);
+    socket.end(String(message));
+  });
+  return;
+}
+
+const kSockets = 20;
+const sockets = [];
+const child = child_process.fork(__filename, ['child']);
+
+const server = net.createServer(function(socket) {
+  sockets.push(socket);
+  if (sockets.length !== kSockets)
+    return;
+
+  // Send all of the sockets back to back.
+  sockets.forEach(function(socket, i) {
+    child.send(i, socket, common.mustCall(function(err) {
+      assert.ifError(err);
+    }));
+  });
+  // Only Windows waits for the child to acknowledge every handle.
+  assert.strictEqual(child._handleQueue !== null, common.isWindows);
+  server.close();
+});
+
+server.listen(0, common.mustCall(function() {
+  const received = [];
+  for (var i = 0; i < kSockets; i++)
+    connect(this.address().port, received);
+
+  process.on('exit', function() {
+    received.sort((a, b) => a - b);
+    assert.deepStrictEqual(received, sockets.map((socket, i) => i));
+  });
+}));
+
+function connect(port, received) {
+  var data = '';
+  net.connect(port)
+    .setEncoding('utf8')
+    .on('data', (chunk) => data += chunk)
+    .on('end', common.mustCall(function() {
+      received.push(+data);
+      if (received.length === kSockets)
+        child.disconnect();
+    }));
+}
+
+child.on('exit', common.mustCall(function(code) {
+  assert.strictEqual(code, 0);
+}));
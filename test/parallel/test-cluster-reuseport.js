@@ -0,0 +1,64 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const cluster = require('cluster');
+const net = require('net');
+
+// SO_REUSEPORT balances connections on Linux only, elsewhere the cluster
+// falls back to round-robin.
+const reusePort = process.platform === 'linux';
+
+if (cluster.isWorker) {
+  const server = net.createServer(function(socket) {
+    socket.end(String(cluster.worker.id));
+  });
+  server.listen(0, common.mustCall(function() {
+    // With SO_REUSEPORT, every worker listens on a socket of its own.
+    assert.strictEqual(server._handle.fd >= 0, reusePort);
+  }));
+  return;
+}
+
+cluster.schedulingPolicy = cluster.SCHED_REUSEPORT;
+assert.strictEqual(cluster.SCHED_REUSEPORT, 3);
+
+const kWorkers = 2;
+const kConnections = 40;
+const seen = {};
+var port = -1;
+var listening = 0;
+
+for (var i = 0; i < kWorkers; i++)
+  cluster.fork();
+
+cluster.on('listening', common.mustCall(function(worker, address) {
+  assert(address.port > 0);
+  if (port === -1)
+    port = address.port;
+  assert.strictEqual(address.port, port);
+  if (++listening === kWorkers)
+    connect(kConnections);
+}, kWorkers));
+
+function connect(left) {
+  if (left === 0)
+    return done();
+
+  net.connect(port, common.localhostIPv4, function() {
+    var data = '';
+    this.setEncoding('utf8');
+    this.on('data', (chunk) => data += chunk);
+    this.on('end', function() {
+      seen[data] = (seen[data] | 0) + 1;
+      connect(left - 1);
+    });
+  });
+}
+
+function done() {
+  const ids = Object.keys(seen);
+  ids.forEach((id) => assert(id in cluster.workers, `unknown worker ${id}`));
+  if (reusePort)
+    assert.strictEqual(ids.length, kWorkers);
+  cluster.disconnect();
+}
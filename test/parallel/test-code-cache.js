@@ -0,0 +1,76 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+const spawnSync = require('child_process').spawnSync;
+
+if (common.isChakraEngine) {
+  common.skip('the code cache is V8 specific');
+  return;
+}
+
+// Compiles the core modules `ids` from their source the way NativeModule does,
+// with `cache[id]` as the cached data, in a fresh process.  A different file
+// name keeps V8 from finding the scripts compiled during bootstrap in its
+// compilation cache.  Returns the ids whose cached data V8 rejected.
+function rejected(cache, ids) {
+  const input = {};
+  for (const id of ids)
+    input[id] = Buffer.from(cache[id]).toString('base64');
+
+  // The caches are too big for the command line, they go through stdin.
+  const child = spawnSync(process.execPath, ['-e', `
+    const vm = require('vm');
+    const Module = require('module');
+    const sources = process.binding('natives');
+    var json = '';
+    process.stdin.setEncoding('utf8');
+    process.stdin.on('data', (chunk) => json += chunk);
+    process.stdin.on('end', () => {
+      const cache = JSON.parse(json);
+      const rejected = [];
+      for (const id of Object.keys(cache)) {
+        const script = new vm.Script(Module.wrap(sources[id]), {
+          filename: 'code-cache-test-' + id + '.js',
+          cachedData: Buffer.from(cache[id], 'base64')
+        });
+        if (script.cachedDataRejected !== false)
+          rejected.push(id);
+      }
+      console.log(JSON.stringify(rejected));
+    });
+  `], { input: JSON.stringify(input) });
+  assert.strictEqual(child.status, 0, child.stderr.toString());
+  return JSON.parse(child.stdout);
+}
+
+// The cache built into this binary, empty unless built with
+// `make code-cache`, matches the V8 version and flags in use.
+const embedded = process.binding('code_cache');
+assert.deepStrictEqual(rejected(embedded, Object.keys(embedded)), []);
+
+// The generator produces a cache for the core modules that V8 accepts.
+common.refreshTmpDir();
+const output = path.join(common.tmpDir, 'node_code_cache.cc');
+const generator = path.join(__dirname, '..', '..', 'tools',
+                            'generate_code_cache.js');
+const child = spawnSync(process.execPath, [generator, output]);
+assert.strictEqual(child.status, 0, child.stderr.toString());
+
+const source = fs.readFileSync(output, 'utf8');
+const arrays = {};
+const arrayRe = /static uint8_t (\w+)\[\] = \{([^}]*)\};/g;
+for (let m; (m = arrayRe.exec(source)) !== null;) {
+  const bytes = m[2].split(',').filter((b) => b.trim() !== '');
+  arrays[m[1]] = Buffer.from(bytes.map(Number));
+}
+
+const generated = {};
+const entryRe = /\{ "([^"]+)", (\w+), sizeof\(\2\) \}/g;
+for (let m; (m = entryRe.exec(source)) !== null;)
+  generated[m[1]] = arrays[m[2]];
+
+for (const id of ['events', 'fs', 'net', 'util'])
+  assert(generated[id] && generated[id].length > 0, `no code cache for ${id}`);
+assert.deepStrictEqual(rejected(generated, Object.keys(generated)), []);
@@ -0,0 +1,77 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const dgram = require('dgram');
+
+const kBatch = 8;
+const kMessages = 20;
+
+assert.throws(() => dgram.createSocket({ type: 'udp4', recvBatchSize: 0 }),
+              /"recvBatchSize" must be an integer from 1 to 64/);
+assert.throws(() => dgram.createSocket({ type: 'udp4', recvBatchSize: 65 }),
+              /"recvBatchSize" must be an integer from 1 to 64/);
+
+const messages = [];
+for (var i = 0; i < kMessages; i++)
+  messages.push(i % 2 ? Buffer.from(`message ${i}`) : `message ${i}`);
+// Empty datagrams are delivered too.
+messages.push('');
+
+const server = dgram.createSocket({ type: 'udp4', recvBatchSize: kBatch });
+const client = dgram.createSocket('udp4');
+const received = [];
+
+assert.throws(() => client.sendBatch('message', 1), /must be an array/);
+assert.throws(() => client.sendBatch([{}], 1), /must be buffers or strings/);
+assert.throws(() => client.sendBatch(['message'], 0), /Port should be/);
+
+server.on('message', common.mustCall(function(buf, rinfo) {
+  assert(buf instanceof Buffer);
+  assert.strictEqual(rinfo.address, common.localhostIPv4);
+  assert.strictEqual(rinfo.family, 'IPv4');
+  assert.strictEqual(rinfo.port, client.address().port);
+  assert.strictEqual(rinfo.size, buf.length);
+  received.push(buf.toString());
+
+  if (received.length === messages.length) {
+    // Datagrams over loopback arrive in order.
+    assert.deepStrictEqual(received, messages.map(String));
+    server.close();
+    client.close();
+  }
+}, messages.length));
+
+server.bind(0, common.localhostIPv4, common.mustCall(function() {
+  const port = server.address().port;
+  const bytes = messages.reduce((n, m) => n + Buffer.byteLength(m), 0);
+
+  client.sendBatch([], port, common.mustCall(function(err, sent) {
+    assert.ifError(err);
+    assert.strictEqual(sent, 0);
+  }));
+
+  client.sendBatch(messages, port, common.localhostIPv4,
+                   common.mustCall(function(err, sent) {
+                     assert.ifError(err);
+                     assert.strictEqual(sent, bytes);
+                   }));
+}));
+
+// A datagram that is too big fails the batch, the callback still learns how
+// many bytes went out.
+{
+  const sink = dgram.createSocket('udp4');
+  const sender = dgram.createSocket('udp4');
+  sink.bind(0, common.localhostIPv4, common.mustCall(function() {
+    const batch = ['a', Buffer.alloc(70000), 'b'];
+    sender.sendBatch(batch, sink.address().port, common.localhostIPv4,
+                     common.mustCall(function(err, sent) {
+                       assert(err instanceof Error);
+                       assert.strictEqual(err.syscall, 'send');
+                       assert.strictEqual(typeof sent, 'number');
+                       assert(sent >= 0 && sent <= 2, String(sent));
+                       sink.close();
+                       sender.close();
+                     }));
+  }));
+}
@@ -0,0 +1,46 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const dgram = require('dgram');
+
+const messages = [
+  Buffer.alloc(100, 'a'),
+  Buffer.alloc(7, 'b'),
+  Buffer.alloc(5000, 'c'),  // Bigger than half of the pool.
+  Buffer.alloc(100, 'd')
+];
+const received = [];
+
+const server = dgram.createSocket('udp4');
+
+server.on('message', common.mustCall(function(buf) {
+  received.push(buf);
+  if (received.length !== messages.length)
+    return;
+
+  // The datagrams weren't overwritten by the ones that were read after them.
+  assert.deepStrictEqual(received, messages);
+
+  // Small datagrams are slices of the same pool, 8-byte aligned.
+  assert.strictEqual(received[0].buffer, received[1].buffer);
+  assert.strictEqual(received[0].buffer, received[3].buffer);
+  assert.strictEqual(received[1].byteOffset % 8, 0);
+  assert.strictEqual(received[3].byteOffset % 8, 0);
+
+  // Big ones get a buffer of their own.
+  assert.notStrictEqual(received[2].buffer, received[0].buffer);
+  assert.strictEqual(received[2].buffer.byteLength, messages[2].length);
+
+  server.close();
+  client.close();
+}, messages.length));
+
+const client = dgram.createSocket('udp4');
+
+server.bind(0, common.localhostIPv4, common.mustCall(function() {
+  const port = server.address().port;
+  (function next(i) {
+    if (i < messages.length)
+      client.send(messages[i], port, common.localhostIPv4, () => next(i + 1));
+  })(0);
+}));
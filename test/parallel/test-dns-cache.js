@@ -0,0 +1,84 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const dns = require('dns');
+
+assert.strictEqual(dns.getCacheStats(), null);
+
+assert.throws(() => dns.enableCache(null), /"options" argument must be/);
+assert.throws(() => dns.enableCache({ ttl: -1 }), /"ttl" must be/);
+assert.throws(() => dns.enableCache({ maxTtl: 1.5 }), /"maxTtl" must be/);
+assert.throws(() => dns.enableCache({ maxEntries: '1' }),
+              /"maxEntries" must be/);
+
+dns.enableCache({ ttl: 60 * 1000 });
+assert.deepStrictEqual(dns.getCacheStats(),
+                       { hits: 0, misses: 0, coalesced: 0, size: 0 });
+
+// Identical lookups share a single getaddrinfo() request.
+var pending = 2;
+const results = [];
+for (var i = 0; i < pending; i++) {
+  dns.lookup('localhost', { all: true }, common.mustCall(function(err, res) {
+    assert.ifError(err);
+    results.push(res);
+    if (--pending === 0)
+      lookupAgain();
+  }));
+}
+
+const stats = dns.getCacheStats();
+assert.strictEqual(stats.misses, 1);
+assert.strictEqual(stats.coalesced, 1);
+
+function lookupAgain() {
+  assert.deepStrictEqual(results[0], results[1]);
+
+  var sync = true;
+  dns.lookup('localhost', { all: true }, common.mustCall(function(err, res) {
+    // Answers from the cache are delivered asynchronously too.
+    assert.strictEqual(sync, false);
+    assert.ifError(err);
+    assert.deepStrictEqual(res, results[0]);
+
+    const stats = dns.getCacheStats();
+    assert.strictEqual(stats.hits, 1);
+    assert.strictEqual(stats.misses, 1);
+    assert.strictEqual(stats.size, 1);
+
+    // Lookups with other options are cached separately.
+    dns.lookup('localhost', 4, common.mustCall(function(err) {
+      assert.ifError(err);
+      assert.strictEqual(dns.getCacheStats().misses, 2);
+
+      dns.clearCache();
+      assert.strictEqual(dns.getCacheStats().size, 0);
+      dns.disableCache();
+      assert.strictEqual(dns.getCacheStats(), null);
+
+      testEviction();
+    }));
+  }));
+  sync = false;
+}
+
+// A full cache makes room by dropping the entry that expires first.
+function testEviction() {
+  dns.enableCache({ maxEntries: 1, ttl: 60 * 1000 });
+  dns.lookup('localhost', 4, common.mustCall(function(err) {
+    assert.ifError(err);
+    dns.lookup('localhost', 0, common.mustCall(function(err) {
+      assert.ifError(err);
+      assert.strictEqual(dns.getCacheStats().size, 1);
+
+      // The newer entry was kept.
+      dns.lookup('localhost', 0, common.mustCall(function(err) {
+        assert.ifError(err);
+        const stats = dns.getCacheStats();
+        assert.strictEqual(stats.hits, 1);
+        assert.strictEqual(stats.misses, 2);
+        dns.disableCache();
+      }));
+    }));
+  }));
+}
@@ -0,0 +1,99 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const dgram = require('dgram');
+const dns = require('dns');
+
+// A stub DNS server that knows the IPv4 address of a single name.
+const kName = 'stub.node-test.example';
+const kAddress = [1, 2, 3, 4];
+const kTypeA = 1;
+var queries = 0;
+
+function reply(query) {
+  // Skip the header and the labels of the question.
+  var offset = 12;
+  var name = [];
+  while (query[offset] !== 0) {
+    name.push(query.toString('ascii', offset + 1, offset + 1 + query[offset]));
+    offset += query[offset] + 1;
+  }
+  const type = query.readUInt16BE(offset + 1);
+  const question = query.slice(12, offset + 5);
+  const found = name.join('.') === kName;
+  const answers = found && type === kTypeA ? 1 : 0;
+
+  const header = Buffer.alloc(12);
+  query.copy(header, 0, 0, 2);  // ID
+  header.writeUInt16BE(0x8180 | (found ? 0 : 3), 2);  // NXDOMAIN
+  header.writeUInt16BE(1, 4);
+  header.writeUInt16BE(answers, 6);
+
+  const answer = Buffer.from([
+    0xc0, 12,  // The name in the question.
+    0, kTypeA,
+    0, 1,  // IN
+    0, 0, 0, 60,  // TTL
+    0, 4
+  ].concat(kAddress));
+
+  return Buffer.concat(answers ? [header, question, answer]
+                               : [header, question]);
+}
+
+const server = dgram.createSocket('udp4');
+server.on('message', function(msg, rinfo) {
+  queries++;
+  server.send(reply(msg), rinfo.port, rinfo.address);
+});
+
+assert.strictEqual(dns.getLookupMode(), 'getaddrinfo');
+assert.throws(() => dns.setLookupMode('nss'),
+              /"mode" must be "getaddrinfo" or "cares"/);
+
+server.bind(0, common.localhostIPv4, common.mustCall(function() {
+  const servers = dns.getServers();
+  const stub = `${common.localhostIPv4}:${server.address().port}`;
+  dns.setServers([stub]);
+  assert.deepStrictEqual(dns.getServers(), [stub]);
+
+  dns.setLookupMode('cares');
+  dns.lookup(kName, common.mustCall(function(err, address, family) {
+    assert.ifError(err);
+    assert.strictEqual(address, kAddress.join('.'));
+    assert.strictEqual(family, 4);
+    // At least an A and an AAAA query, more with search domains.
+    assert(queries >= 2);
+    lookupAll();
+  }));
+
+  function lookupAll() {
+    dns.lookup(kName, { all: true }, common.mustCall(function(err, res) {
+      assert.ifError(err);
+      assert.deepStrictEqual(res, [{ address: kAddress.join('.'), family: 4 }]);
+      lookupMapped();
+    }));
+  }
+
+  function lookupMapped() {
+    const options = { family: 6, hints: dns.V4MAPPED };
+    dns.lookup(kName, options, common.mustCall(function(err, address) {
+      assert.ifError(err);
+      assert.strictEqual(address, '::ffff:' + kAddress.join('.'));
+      lookupMissing();
+    }));
+  }
+
+  function lookupMissing() {
+    dns.lookup('missing.node-test.example', 4, common.mustCall(function(err) {
+      // The same error as with getaddrinfo().
+      assert.strictEqual(err.code, 'ENOTFOUND');
+      assert.strictEqual(err.syscall, 'getaddrinfo');
+      assert.strictEqual(err.hostname, 'missing.node-test.example');
+
+      dns.setLookupMode('getaddrinfo');
+      dns.setServers(servers);
+      server.close();
+    }));
+  }
+}));
@@ -0,0 +1,77 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+const { COPYFILE_EXCL } = fs.constants;
+
+common.refreshTmpDir();
+
+const src = path.join(common.tmpDir, 'copyfile-src.txt');
+const data = Buffer.alloc(3 * 1024 * 1024 + 7, 'copyfile');
+fs.writeFileSync(src, data, { mode: 0o640 });
+
+function verify(dest) {
+  assert(fs.readFileSync(dest).equals(data));
+  if (!common.isWindows)
+    assert.strictEqual(fs.statSync(dest).mode & 0o777, 0o640);
+}
+
+assert.strictEqual(typeof COPYFILE_EXCL, 'number');
+
+// Sync copy, then overwrite a longer existing file.
+const dest = path.join(common.tmpDir, 'copyfile-dest.txt');
+fs.copyFileSync(src, dest);
+verify(dest);
+fs.writeFileSync(dest, Buffer.alloc(data.length * 2, 'x'));
+fs.copyFileSync(Buffer.from(src), Buffer.from(dest));
+assert(fs.readFileSync(dest).equals(data));
+
+// COPYFILE_EXCL refuses to overwrite.
+assert.throws(function() {
+  fs.copyFileSync(src, dest, COPYFILE_EXCL);
+}, /^Error: EEXIST: file already exists, open/);
+
+// Copying a file onto itself leaves it intact.
+fs.copyFileSync(src, src);
+assert(fs.readFileSync(src).equals(data));
+
+// Empty files.
+const empty = path.join(common.tmpDir, 'copyfile-empty.txt');
+fs.writeFileSync(empty, '');
+fs.copyFileSync(empty, dest);
+assert.strictEqual(fs.readFileSync(dest).length, 0);
+
+assert.throws(function() {
+  fs.copyFileSync(path.join(common.tmpDir, 'does-not-exist.txt'), dest);
+}, /^Error: ENOENT: no such file or directory, open/);
+
+assert.throws(function() {
+  fs.copyFileSync(common.tmpDir, dest);
+}, /^Error: EISDIR/);
+
+assert.throws(function() {
+  fs.copyFileSync('foo\u0000bar', dest);
+}, /string without null bytes/);
+
+assert.throws(function() {
+  fs.copyFile(src, dest);
+}, /"callback" argument must be a function/);
+
+// Async copy.
+const asyncDest = path.join(common.tmpDir, 'copyfile-async.txt');
+fs.copyFile(src, asyncDest, common.mustCall(function(err) {
+  assert.ifError(err);
+  verify(asyncDest);
+
+  fs.copyFile(src, asyncDest, COPYFILE_EXCL, common.mustCall(function(err) {
+    assert(err);
+    assert.strictEqual(err.code, 'EEXIST');
+    assert.strictEqual(err.syscall, 'open');
+  }));
+}));
+
+fs.copyFile('foo\u0000bar', dest, common.mustCall(function(err) {
+  assert(err);
+  assert(/string without null bytes/.test(err.message));
+}));
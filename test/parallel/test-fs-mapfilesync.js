@@ -0,0 +1,37 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+
+common.refreshTmpDir();
+
+const file = path.join(common.tmpDir, 'mapped.txt');
+const data = Buffer.alloc(64 * 1024 + 13, 'mapped');
+fs.writeFileSync(file, data);
+
+const buf = fs.mapFileSync(file);
+assert(Buffer.isBuffer(buf));
+assert(buf.equals(data));
+
+// Writes go to a private copy of the page, not to the file.
+buf[0] = 0x41;
+assert.strictEqual(buf[0], 0x41);
+assert(fs.readFileSync(file).equals(data));
+
+// Mapping the same file twice yields independent copies on write.
+const other = fs.mapFileSync(Buffer.from(file));
+assert.strictEqual(other[0], data[0]);
+
+// Empty files can't be mmap()ed but still produce an (empty) Buffer.
+const empty = path.join(common.tmpDir, 'empty.txt');
+fs.writeFileSync(empty, '');
+assert.strictEqual(fs.mapFileSync(empty).length, 0);
+
+assert.throws(function() {
+  fs.mapFileSync(path.join(common.tmpDir, 'does-not-exist.txt'));
+}, /^Error: ENOENT: no such file or directory, open/);
+
+assert.throws(function() {
+  fs.mapFileSync('foo\u0000bar');
+}, /string without null bytes/);
@@ -0,0 +1,52 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+
+common.refreshTmpDir();
+
+// fs.readFile() opens, stats, reads and closes the file in one go. Check the
+// result matches the chunked fs.readFileSync() for sizes around the 8 KB chunk
+// size and for a file that is larger than a single chunk.
+[0, 1, 8191, 8192, 8193, 1024 * 1024].forEach(function(size) {
+  const file = path.join(common.tmpDir, `readfile-${size}.txt`);
+  const data = Buffer.alloc(size, 'abc');
+  fs.writeFileSync(file, data);
+
+  fs.readFile(file, common.mustCall(function(err, buf) {
+    assert.ifError(err);
+    assert(Buffer.isBuffer(buf));
+    assert(buf.equals(data));
+    assert(buf.equals(fs.readFileSync(file)));
+  }));
+
+  fs.readFile(file, 'latin1', common.mustCall(function(err, str) {
+    assert.ifError(err);
+    assert.strictEqual(typeof str, 'string');
+    assert.strictEqual(str, data.toString('latin1'));
+  }));
+
+  fs.readFile(file, { encoding: 'hex' }, common.mustCall(function(err, str) {
+    assert.ifError(err);
+    assert.strictEqual(str, data.toString('hex'));
+  }));
+});
+
+// Errors carry the failing syscall and path.
+const missing = path.join(common.tmpDir, 'does-not-exist.txt');
+fs.readFile(missing, common.mustCall(function(err, buf) {
+  assert(err instanceof Error);
+  assert.strictEqual(err.code, 'ENOENT');
+  assert.strictEqual(err.syscall, 'open');
+  assert.strictEqual(err.path, missing);
+  assert.strictEqual(buf, undefined);
+}));
+
+// The flag option is passed on to open(2).
+const created = path.join(common.tmpDir, 'created.txt');
+fs.readFile(created, { flag: 'a+' }, common.mustCall(function(err, buf) {
+  assert.ifError(err);
+  assert.strictEqual(buf.length, 0);
+  assert(fs.existsSync(created));
+}));
@@ -0,0 +1,90 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+const constants = fs.constants;
+
+common.refreshTmpDir();
+
+const dir = path.join(common.tmpDir, 'scandir');
+fs.mkdirSync(dir);
+fs.writeFileSync(path.join(dir, 'file.txt'), 'hello');
+fs.mkdirSync(path.join(dir, 'subdir'));
+
+const expected = {
+  'file.txt': constants.UV_DIRENT_FILE,
+  'subdir': constants.UV_DIRENT_DIR
+};
+
+if (!common.isWindows) {
+  fs.symlinkSync('file.txt', path.join(dir, 'link'));
+  expected.link = constants.UV_DIRENT_LINK;
+}
+
+function check(entries, withStats) {
+  assert.strictEqual(entries.length, Object.keys(expected).length);
+  assert(entries.types instanceof Uint8Array);
+  assert.deepStrictEqual(entries.names.slice().sort(),
+                         fs.readdirSync(dir).sort());
+
+  for (var i = 0; i < entries.length; i++) {
+    const name = entries.names[i];
+    assert.strictEqual(entries.types[i], expected[name]);
+    assert.strictEqual(entries.isFile(i), name === 'file.txt');
+    assert.strictEqual(entries.isDirectory(i), name === 'subdir');
+    assert.strictEqual(entries.isSymbolicLink(i), name === 'link');
+
+    if (!withStats) {
+      assert.strictEqual(entries.getStats(i), undefined);
+      continue;
+    }
+
+    const stats = entries.getStats(i);
+    const lstats = fs.lstatSync(path.join(dir, name));
+    assert(stats instanceof fs.Stats);
+    for (const key of Object.keys(lstats)) {
+      if (lstats[key] instanceof Date)
+        assert.strictEqual(stats[key].getTime(), lstats[key].getTime(), key);
+      else
+        assert.strictEqual(stats[key], lstats[key], key);
+    }
+    assert.strictEqual(entries.stats[i * 14 + 8], lstats.size);
+  }
+
+  if (withStats)
+    assert(entries.stats instanceof Float64Array);
+  else
+    assert.strictEqual(entries.stats, undefined);
+  assert.strictEqual(entries.getStats(entries.length), undefined);
+}
+
+check(fs.scandirSync(dir), false);
+check(fs.scandirSync(dir, { stats: true }), true);
+
+const buffers = fs.scandirSync(dir, 'buffer');
+assert(buffers.names.every(Buffer.isBuffer));
+
+fs.scandir(dir, common.mustCall(function(err, entries) {
+  assert.ifError(err);
+  check(entries, false);
+}));
+
+fs.scandir(dir, { stats: true }, common.mustCall(function(err, entries) {
+  assert.ifError(err);
+  check(entries, true);
+}));
+
+fs.scandir(path.join(dir, 'nonexistent'), common.mustCall(function(err) {
+  assert(err);
+  assert.strictEqual(err.code, 'ENOENT');
+  assert.strictEqual(err.syscall, 'scandir');
+}));
+
+assert.throws(function() {
+  fs.scandirSync(path.join(dir, 'file.txt'));
+}, /^Error: ENOTDIR: not a directory, scandir/);
+
+assert.throws(function() {
+  fs.scandirSync('foo\u0000bar');
+}, /string without null bytes/);
@@ -0,0 +1,58 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+const Module = require('module');
+
+common.refreshTmpDir();
+
+const dir = fs.realpathSync(common.tmpDir);
+const js = path.join(dir, 'bundled.js');
+const json = path.join(dir, 'bundled.json');
+const touched = path.join(dir, 'touched.js');
+const other = path.join(dir, 'not-bundled.js');
+const bundle = path.join(dir, 'app.bundle');
+// Whole seconds, so that the mtime survives utimes() exactly.
+const mtime = new Date(1e12);
+
+fs.writeFileSync(js, '#!/usr/bin/env node\n' +
+                     'module.exports = require("./bundled.json").value;');
+fs.writeFileSync(json, '\ufeff{"value":"bundle"}');
+fs.writeFileSync(touched, 'module.exports = "bundle";');
+fs.writeFileSync(other, 'module.exports = "disk";');
+fs.utimesSync(js, mtime, mtime);
+fs.utimesSync(touched, mtime, mtime);
+
+assert.throws(function() {
+  Module.createBundle(bundle, js);
+}, /"filenames" argument must be an array/);
+
+Module.createBundle(bundle, [js, json, touched], { codeCache: true });
+
+// Files with the size and mtime recorded in the bundle are read from it.
+const jsSize = fs.statSync(js).size;
+const fake = 'module.exports = "disk";';
+fs.writeFileSync(js, fake + ' '.repeat(jsSize - fake.length));
+fs.utimesSync(js, mtime, mtime);
+fs.writeFileSync(json, '\ufeff{"value":"bundle, still"}');
+
+// Files that changed since are read from disk.
+fs.writeFileSync(touched, 'module.exports = "disk!!";');
+fs.utimesSync(touched, mtime, new Date(mtime.getTime() + 1000));
+
+Module.loadBundle(bundle);
+assert.strictEqual(require(js), 'bundle, still');
+assert.strictEqual(require(touched), 'disk!!');
+assert.strictEqual(require(other), 'disk');
+
+assert.throws(function() {
+  Module.loadBundle(js);
+}, /^Error: Invalid module bundle/);
+
+// Truncated bundles are rejected.
+const data = fs.readFileSync(bundle);
+fs.writeFileSync(bundle, data.slice(0, 40));
+assert.throws(function() {
+  Module.loadBundle(bundle);
+}, /^Error: Invalid module bundle/);
@@ -0,0 +1,37 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const fs = require('fs');
+const Module = require('module');
+const path = require('path');
+
+// Clearing Module._pathCache makes modules resolve again, also when the
+// native resolver did the lookup.
+common.refreshTmpDir();
+
+const dir = path.join(common.tmpDir, 'node_modules', 'pkg');
+fs.mkdirSync(path.join(common.tmpDir, 'node_modules'));
+fs.mkdirSync(dir);
+fs.writeFileSync(path.join(dir, 'package.json'), '{"main":"a.js"}');
+fs.writeFileSync(path.join(dir, 'a.js'), 'module.exports = "a";');
+fs.writeFileSync(path.join(dir, 'b.js'), 'module.exports = "b";');
+
+const request = path.join(common.tmpDir, 'node_modules', 'pkg');
+const a = fs.realpathSync(path.join(dir, 'a.js'));
+const b = fs.realpathSync(path.join(dir, 'b.js'));
+
+assert.strictEqual(require.resolve(request), a);
+fs.unlinkSync(path.join(dir, 'a.js'));
+fs.renameSync(path.join(dir, 'b.js'), path.join(dir, 'a.json'));
+// Resolved filenames are cached.
+assert.strictEqual(require.resolve(request), a);
+
+// Both ways of clearing the cache are honoured.
+Module._pathCache = {};
+assert.strictEqual(require.resolve(request), b.replace(/b\.js$/, 'a.json'));
+
+fs.writeFileSync(path.join(dir, 'a.js'), 'module.exports = "a";');
+Object.keys(Module._pathCache).forEach((key) => {
+  delete Module._pathCache[key];
+});
+assert.strictEqual(require.resolve(request), a);
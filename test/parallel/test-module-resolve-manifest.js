@@ -0,0 +1,57 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const child_process = require('child_process');
+const fs = require('fs');
+const path = require('path');
+
+if (common.isWindows) {
+  common.skip('the native module resolver is not available on Windows');
+  return;
+}
+
+common.refreshTmpDir();
+
+const app = path.join(common.tmpDir, 'app');
+const pkg = path.join(app, 'node_modules', 'pkg');
+const manifest = path.join(common.tmpDir, 'resolve-manifest');
+fs.mkdirSync(app);
+fs.mkdirSync(path.join(app, 'node_modules'));
+fs.mkdirSync(pkg);
+fs.mkdirSync(path.join(pkg, 'lib'));
+fs.writeFileSync(path.join(pkg, 'package.json'),
+                 '{"name":"pkg","main":"./lib/main"}');
+fs.writeFileSync(path.join(pkg, 'lib', 'main.js'),
+                 'module.exports = "main.js";');
+// The manifest is saved without an 'exit' listener.
+fs.writeFileSync(path.join(app, 'index.js'), `
+  console.log(require.resolve("pkg") + " " + require("pkg"));
+  require("assert").strictEqual(process.listenerCount("exit"), 0);
+`);
+
+function run() {
+  const env = Object.assign({}, process.env,
+                            { NODE_RESOLVE_MANIFEST: manifest });
+  const result = child_process.spawnSync(process.execPath,
+                                         [path.join(app, 'index.js')],
+                                         { env });
+  assert.strictEqual(result.status, 0, result.stderr.toString());
+  return result.stdout.toString().trim();
+}
+
+const main = fs.realpathSync(path.join(pkg, 'lib', 'main.js'));
+
+// The first run writes the manifest, the second one reads it.
+assert.strictEqual(run(), main + ' main.js');
+assert(fs.statSync(manifest).size > 0);
+assert.strictEqual(run(), main + ' main.js');
+
+// Stale entries are detected and resolved again.
+fs.unlinkSync(path.join(pkg, 'lib', 'main.js'));
+fs.writeFileSync(path.join(pkg, 'lib', 'main.json'), '"main.json"');
+assert.strictEqual(run(), main.replace(/\.js$/, '.json') + ' main.json');
+
+// A corrupt manifest is ignored and replaced.
+fs.writeFileSync(manifest, 'garbage');
+assert.strictEqual(run(), main.replace(/\.js$/, '.json') + ' main.json');
+assert.notStrictEqual(fs.readFileSync(manifest, 'latin1'), 'garbage');
@@ -0,0 +1,27 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+
+// The stat cache of a top-level require() does not outlive a module that
+// throws, so files created afterwards are found.
+common.refreshTmpDir();
+
+const later = path.join(common.tmpDir, 'later.js');
+const throws = path.join(common.tmpDir, 'throws.js');
+fs.writeFileSync(throws, `
+  try {
+    require('./later');
+  } catch (e) {}
+  throw new Error('throws.js');
+`);
+
+// The main module is still being loaded until this callback runs.
+setImmediate(common.mustCall(function() {
+  assert.throws(() => require(throws), /^Error: throws\.js$/);
+
+  fs.writeFileSync(later, 'module.exports = "later";');
+  assert.strictEqual(require.resolve(later), fs.realpathSync(later));
+  assert.strictEqual(require(later), 'later');
+}));
@@ -0,0 +1,72 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const net = require('net');
+
+const kBatch = 4;
+const kConnections = 10;
+
+// Batching is opt-in.
+assert.strictEqual(net.createServer()._acceptBatch, 1);
+
+[0, -1, 1.5, '4', NaN, 0x100000000].forEach((acceptBatch) => {
+  assert.throws(() => net.createServer({ acceptBatch }),
+                /"acceptBatch" must be a positive integer/);
+});
+
+// Opens kConnections connections at once, so they are all pending by the time
+// the server gets to accept them.
+function connectAll(server) {
+  var closed = 0;
+  for (var i = 0; i < kConnections; i++) {
+    net.connect(server.address().port, common.localhostIPv4)
+      .on('close', function() {
+        if (++closed === kConnections)
+          server.close();
+      })
+      .resume();
+  }
+}
+
+{
+  const batches = [];
+  const server = net.createServer({ acceptBatch: kBatch }, common.mustCall(
+    (socket) => socket.end(), kConnections));
+
+  server.listen(0, common.localhostIPv4, common.mustCall(function() {
+    const handle = server._handle;
+    const onconnections = handle.onconnections;
+    assert.strictEqual(typeof onconnections, 'function');
+
+    handle.onconnections = function(clients) {
+      batches.push(clients.length);
+      return onconnections.apply(this, arguments);
+    };
+
+    connectAll(server);
+  }));
+
+  process.on('exit', function() {
+    assert(batches.every((n) => n >= 1 && n <= kBatch), String(batches));
+    assert.strictEqual(batches.reduce((a, b) => a + b, 0), kConnections);
+    // Connections are accepted through IOCP on Windows, one at a time.
+    if (!common.isWindows)
+      assert(batches.some((n) => n > 1), String(batches));
+  });
+}
+
+{
+  // A replaced onconnection sees every connection of a batch.
+  const server = net.createServer({ acceptBatch: kBatch }, common.mustCall(
+    (socket) => socket.end(), kConnections));
+
+  server.listen(0, common.localhostIPv4, common.mustCall(function() {
+    const handle = server._handle;
+    const onconnection = handle.onconnection;
+    handle.onconnection = common.mustCall(function(err, client) {
+      return onconnection.call(this, err, client);
+    }, kConnections);
+
+    connectAll(server);
+  }));
+}
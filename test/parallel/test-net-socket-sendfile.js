@@ -0,0 +1,58 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const fs = require('fs');
+const net = require('net');
+const path = require('path');
+
+common.refreshTmpDir();
+
+const file = path.join(common.tmpDir, 'sendfile.txt');
+const data = Buffer.alloc(1024 * 1024 + 3, 'sendfile');
+fs.writeFileSync(file, data);
+const fd = fs.openSync(file, 'r');
+
+const expected = Buffer.concat([
+  Buffer.from('head\n'),
+  data,
+  Buffer.from('middle\n'),
+  data.slice(100, 100 + 5000),
+  data.slice(data.length - 10),
+  Buffer.from('tail\n')
+]);
+
+const server = net.createServer(common.mustCall(function(socket) {
+  assert.throws(function() {
+    socket.sendFile(-1);
+  }, /"fd" argument must be a non-negative integer/);
+  assert.throws(function() {
+    socket.sendFile(fd, -1, 1);
+  }, /"offset" argument must be a non-negative integer/);
+  assert.throws(function() {
+    socket.sendFile(fd, 0, 1.5);
+  }, /"length" argument must be a non-negative integer/);
+
+  socket.write('head\n');
+  socket.sendFile(fd, common.mustCall(function(err) {
+    assert.ifError(err);
+  }));
+  // Corked writes go through _writev() and must stay in order.
+  socket.cork();
+  socket.write('middle\n');
+  socket.sendFile(fd, 100, 5000);
+  socket.sendFile(fd, data.length - 10, 100);  // stops at EOF
+  socket.write('tail\n');
+  socket.uncork();
+  socket.end();
+}));
+
+server.listen(0, common.mustCall(function() {
+  const chunks = [];
+  const client = net.connect(this.address().port);
+  client.on('data', (chunk) => chunks.push(chunk));
+  client.on('end', common.mustCall(function() {
+    assert(Buffer.concat(chunks).equals(expected));
+    fs.closeSync(fd);
+    server.close();
+  }));
+}));
@@ -0,0 +1,32 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+
+// The tick queue starts small and grows while ticks are queued, including
+// while it wraps around and while it is being processed. Ticks run in order
+// and all of them run before promise reactions.
+const N = 5000;
+const order = [];
+
+Promise.resolve().then(common.mustCall(function() {
+  assert.strictEqual(order.length, N + N / 2);
+  order.push('promise');
+}));
+
+for (var i = 0; i < N / 2; i++)
+  process.nextTick(order.push.bind(order), i);
+
+process.nextTick(function() {
+  // Processing has started, the queue wraps around from here.
+  for (var i = N / 2; i < N; i++)
+    process.nextTick(order.push.bind(order), i);
+  for (i = 0; i < N / 2; i++)
+    process.nextTick(order.push.bind(order), -1);
+});
+
+process.on('exit', function() {
+  assert.strictEqual(order.length, N + N / 2 + 1);
+  for (var i = 0; i < N; i++)
+    assert.strictEqual(order[i], i);
+  assert.strictEqual(order[N + N / 2], 'promise');
+});
@@ -0,0 +1,71 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const child_process = require('child_process');
+const fs = require('fs');
+const http = require('http');
+const os = require('os');
+
+if (!common.isLinux || process.config.variables.node_use_perfctr !== 'true') {
+  common.skip('performance counters are not published on this platform');
+  return;
+}
+
+// Offsets of the fields of struct NodeCounters.
+const kMagic = 0;
+const kVersion = 4;
+const kSize = 8;
+const kPid = 12;
+const kHttpServerRequests = 16;
+const kHttpClientRequests = 32;
+const kNetBytesRecv = 64;
+
+const segment = `/dev/shm/node-perfctr.${process.pid}`;
+const LE = os.endianness() === 'LE';
+
+function read32(offset) {
+  const buf = fs.readFileSync(segment);
+  return LE ? buf.readUInt32LE(offset) : buf.readUInt32BE(offset);
+}
+
+function read64(offset) {
+  const buf = fs.readFileSync(segment);
+  const lo = LE ? buf.readUInt32LE(offset) : buf.readUInt32BE(offset + 4);
+  const hi = LE ? buf.readUInt32LE(offset + 4) : buf.readUInt32BE(offset);
+  return hi * 0x100000000 + lo;
+}
+
+assert.strictEqual(read32(kMagic), 0x6e6f6463);
+assert.strictEqual(read32(kVersion), 1);
+assert(read32(kSize) >= 160);
+assert.strictEqual(read32(kPid), process.pid);
+
+const server = http.createServer(function(req, res) {
+  res.end('ok');
+});
+
+server.listen(0, common.mustCall(function() {
+  http.get({ port: this.address().port }, common.mustCall(function(res) {
+    res.resume();
+    res.on('end', common.mustCall(function() {
+      assert.strictEqual(read64(kHttpServerRequests), 1);
+      assert.strictEqual(read64(kHttpClientRequests), 1);
+      assert(read64(kNetBytesRecv) > 0);
+      server.close();
+    }));
+  }));
+}));
+
+// The segment goes away with the process.
+const child = child_process.spawnSync(process.execPath,
+                                      ['-e', 'console.log(process.pid)']);
+const pid = +child.stdout;
+assert(pid > 0);
+assert(!fs.existsSync(`/dev/shm/node-perfctr.${pid}`));
+
+// A segment left behind by a process that is gone, e.g. one that was
+// SIGKILLed, is removed by the next node that starts.
+const stale = `/dev/shm/node-perfctr.${pid}`;
+fs.writeFileSync(stale, Buffer.alloc(read32(kSize)));
+child_process.spawnSync(process.execPath, ['-e', '0']);
+assert(!fs.existsSync(stale));
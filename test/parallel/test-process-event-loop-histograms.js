@@ -0,0 +1,61 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+
+assert.strictEqual(process.eventLoopHistograms(), null);
+
+process.startEventLoopMonitor();
+process.startEventLoopMonitor();  // Starting it twice is a no-op.
+
+let pending = 5;
+function tick() {
+  // Block inside a callback so the callback histogram sees it.
+  const start = Date.now();
+  while (Date.now() - start < 5);
+
+  if (--pending > 0)
+    return setTimeout(common.mustCall(tick), 10);
+
+  setImmediate(common.mustCall(check));
+}
+setTimeout(common.mustCall(tick), 10);
+
+function check() {
+  const result = process.eventLoopHistograms(true);
+  validateResult(result);
+  assert(result.iteration.count >= 5);
+  assert(result.pollWait.count >= 5);
+  assert(result.callback.count >= 5);
+  assert(result.callback.max >= 5000);
+  assert(result.pollWait.max >= 5000);
+
+  const cleared = process.eventLoopHistograms();
+  validateResult(cleared);
+  assert(cleared.callback.count <= 1);
+
+  process.stopEventLoopMonitor();
+  assert.strictEqual(process.eventLoopHistograms(), null);
+}
+
+function sum(buckets) {
+  return buckets.reduce((a, b) => a + b, 0);
+}
+
+function validateResult(result) {
+  assert(Array.isArray(result.bucketBounds));
+  assert.strictEqual(result.bucketBounds[0], 0);
+  for (let i = 1; i < result.bucketBounds.length; i++)
+    assert(result.bucketBounds[i] > result.bucketBounds[i - 1]);
+
+  for (const name of ['iteration', 'pollWait', 'callback']) {
+    const h = result[name];
+    assert(Array.isArray(h.buckets));
+    assert.strictEqual(h.buckets.length, result.bucketBounds.length);
+    assert.strictEqual(sum(h.buckets), h.count);
+    if (h.count === 0)
+      continue;
+    assert(h.min <= h.mean && h.mean <= h.max);
+    assert(h.min <= h.p50 && h.p50 <= h.p90 && h.p90 <= h.p99);
+    assert(h.p99 <= h.max);
+  }
+}
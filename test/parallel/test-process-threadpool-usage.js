@@ -0,0 +1,91 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const cp = require('child_process');
+const fs = require('fs');
+
+if (process.argv[2] === 'child') {
+  // Queue more work than the minimum pool size can pick up at once.
+  let pending = 32;
+  for (let i = 0; i < 32; i++) {
+    fs.stat(__filename, common.mustCall(() => {
+      if (--pending === 0) {
+        const usage = process.threadpoolUsage();
+        validateResult(usage);
+        assert.strictEqual(usage.minThreads, 1);
+        assert.strictEqual(usage.maxThreads, 8);
+        assert(usage.threads <= 8);
+        assert(sum(usage.waitTime.fastIO) >= 32);
+        if (common.hasCrypto)
+          growUnderLoad();
+      }
+    }));
+  }
+  return;
+}
+
+if (process.argv[2] === 'unused') {
+  // Nothing has been queued, asking doesn't start the pool.
+  const usage = process.threadpoolUsage();
+  assert.strictEqual(usage.minThreads, 0);
+  assert.strictEqual(usage.maxThreads, 0);
+  assert.strictEqual(usage.threads, 0);
+  assert.strictEqual(usage.queued, 0);
+  return;
+}
+
+validateResult(process.threadpoolUsage());
+
+for (const mode of ['child', 'unused']) {
+  const child = cp.spawnSync(process.execPath, [__filename, mode], {
+    env: Object.assign({}, process.env, {
+      UV_THREADPOOL_SIZE: '1',
+      UV_THREADPOOL_MAX_SIZE: '8',
+      UV_THREADPOOL_IDLE_TIMEOUT: '60000'
+    })
+  });
+  assert.strictEqual(child.stderr.toString(), '');
+  assert.strictEqual(child.status, 0);
+}
+
+// Every pbkdf2() call keeps a thread busy for a while, so the ones queued
+// behind the first can only start if the pool grows past its one thread.
+function growUnderLoad() {
+  const crypto = require('crypto');
+  let pending = 8;
+  for (let i = 0; i < 8; i++) {
+    crypto.pbkdf2('password', 'salt', 1e5, 32, 'sha1', common.mustCall(() => {
+      if (--pending === 0) {
+        const usage = process.threadpoolUsage();
+        assert(usage.threads > usage.minThreads);
+        assert(sum(usage.waitTime.cpu) >= 8);
+      }
+    }));
+  }
+}
+
+function sum(histogram) {
+  return histogram.reduce((a, b) => a + b, 0);
+}
+
+function validateResult(usage) {
+  if (usage.threads === 0) {
+    // The pool hasn't been started yet.
+    assert.strictEqual(usage.minThreads, 0);
+    assert.strictEqual(usage.queued, 0);
+  } else {
+    assert(usage.minThreads >= 1);
+    assert(usage.maxThreads >= usage.minThreads);
+    assert(usage.threads >= usage.minThreads);
+    assert(usage.threads <= usage.maxThreads);
+  }
+  assert(usage.idleThreads <= usage.threads);
+  assert.strictEqual(usage.activeThreads, usage.threads - usage.idleThreads);
+  assert(usage.queued >= 0);
+
+  for (const kind of ['cpu', 'fastIO', 'slowIO']) {
+    assert(Array.isArray(usage.waitTime[kind]));
+    assert.strictEqual(usage.waitTime[kind].length, 24);
+    usage.waitTime[kind].forEach((count) => assert(count >= 0));
+  }
+}
@@ -15,8 +15,7 @@ legitTimers.forEach(function(legit) {
   // active() should mutate these objects
   assert(legit._idleTimeout === savedTimeout);
   assert(Number.isInteger(legit._idleStart));
-  assert(legit._idleNext);
-  assert(legit._idlePrev);
+  assert(legit._timerId >= 0);
 });
 
 
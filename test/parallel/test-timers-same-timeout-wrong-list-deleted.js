@@ -14,6 +14,7 @@
 const common = require('../common');
 const assert = require('assert');
 const Timer = process.binding('timer_wrap').Timer;
+const TimerWheel = process.binding('timer_wrap').TimerWheel;
 
 const TIMEOUT = common.platformTimeout(100);
 const start = Timer.now();
@@ -28,53 +29,35 @@ process.on('exit', function() {
 });
 
 const handle1 = setTimeout(common.mustCall(function() {
-  // Cause the old TIMEOUT list to be deleted
+  // Cancel the timer that is currently running
   clearTimeout(handle1);
 
-  // Cause a new list with the same key (TIMEOUT) to be created for this timer
+  // Schedule a new timer with the same timeout
   const handle2 = setTimeout(function() {
     common.fail('Inner callback is not called');
   }, TIMEOUT);
 
   setTimeout(common.mustCall(function() {
-    // Attempt to cancel the second timer. Fix for this bug will keep the
-    // newer timer from being dereferenced by keeping its list from being
-    // erroneously deleted. If we are able to cancel the timer successfully,
-    // the bug is fixed.
+    // Attempt to cancel the second timer. If clearing the first timer had
+    // dropped the reference to the second one, it could not be canceled and
+    // would keep the event loop alive for the duration of its timeout.
     clearTimeout(handle2);
     setImmediate(common.mustCall(function() {
       setImmediate(common.mustCall(function() {
-        const activeHandles = process._getActiveHandles();
-        const activeTimers = activeHandles.filter(function(handle) {
-          return handle instanceof Timer;
-        });
-
         // Make sure our clearTimeout succeeded. One timer finished and
         // the other was canceled, so none should be active.
-        assert.equal(activeTimers.length, 0, 'No Timers remain.');
+        assert.equal(activeTimers().length, 0, 'No Timers remain.');
       }));
     }));
   }), 10);
 
-  // Make sure our timers got added to the list.
-  const activeHandles = process._getActiveHandles();
-  const activeTimers = activeHandles.filter(function(handle) {
-    return handle instanceof Timer;
-  });
-  const shortTimer = activeTimers.find(function(handle) {
-    return handle._list.msecs === 10;
-  });
-  const longTimers = activeTimers.filter(function(handle) {
-    return handle._list.msecs === TIMEOUT;
-  });
-
-  // Make sure our clearTimeout succeeded. One timer finished and
-  // the other was canceled, so none should be active.
-  assert.equal(activeTimers.length, 3, 'There are 3 timers in the list.');
-  assert(shortTimer instanceof Timer, 'The shorter timer is in the list.');
-  assert.equal(longTimers.length, 2, 'Both longer timers are in the list.');
-
-  // When this callback completes, `listOnTimeout` should now look at the
-  // correct list and refrain from removing the new TIMEOUT list which
-  // contains the reference to the newer timer.
+  // All timers share the handle of the timer wheel, which keeps the event
+  // loop alive while there are timers.
+  assert.equal(activeTimers().length, 1, 'The timer wheel is active.');
 }), TIMEOUT);
+
+function activeTimers() {
+  return process._getActiveHandles().filter(function(handle) {
+    return handle instanceof TimerWheel;
+  });
+}
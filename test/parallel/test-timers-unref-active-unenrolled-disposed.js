@@ -24,8 +24,7 @@ someTimer._onTimeout = function() {
 };
 
 endTest._onTimeout = common.mustCall(function() {
-  assert.strictEqual(someTimer._idlePrev, null);
-  assert.strictEqual(someTimer._idleNext, null);
+  assert.strictEqual(someTimer._timerId, -1);
   clearTimeout(keepOpen);
 });
 
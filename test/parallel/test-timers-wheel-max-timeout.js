@@ -0,0 +1,23 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const timers = require('timers');
+
+// Timeouts that are set directly on an item bypass the TIMEOUT_MAX check of
+// enroll().  The timer wheel clamps them as well instead of relinking them
+// into the same slot of its top level forever.
+const huge = [Math.pow(2, 31), Math.pow(2, 32), Math.pow(2, 32) + 1,
+              Math.pow(2, 40), Number.MAX_SAFE_INTEGER, Infinity];
+const items = huge.map(function(msecs) {
+  const item = { _idleTimeout: msecs, _onTimeout: common.mustNotCall() };
+  timers.active(item);
+  assert(item._timerId >= 0);
+  assert(Number.isInteger(item._idleStart));
+  return item;
+});
+
+// Shorter timers still fire, and the process exits once the huge ones are
+// gone.
+setTimeout(common.mustCall(function() {
+  items.forEach(timers.unenroll);
+}), 10);
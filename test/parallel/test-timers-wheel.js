@@ -0,0 +1,54 @@
+'use strict';
+const common = require('../common');
+const assert = require('assert');
+const timers = require('timers');
+const Timer = process.binding('timer_wrap').Timer;
+
+// Timers of many different durations, some of which are cascaded from the
+// higher levels of the timer wheel, fire in the order in which they are due
+// and never early.
+const durations = [1, 7, 50, 255, 256, 257, 300, 511, 700, 1100];
+const start = Timer.now();
+const fired = [];
+
+durations.slice().reverse().forEach(function(msecs) {
+  setTimeout(common.mustCall(function() {
+    assert(Timer.now() - start >= msecs,
+           `${msecs}ms timer fired after ${Timer.now() - start}ms`);
+    fired.push(msecs);
+  }), msecs);
+});
+
+// Timers that are due at the same time fire in the order they were created.
+const sameTime = [];
+for (var i = 0; i < 5; i++)
+  setTimeout(sameTime.push.bind(sameTime, i), 300);
+
+// Re-scheduling a timer pushes its timeout back.
+const idle = {};
+timers.enroll(idle, 100);
+idle._onTimeout = common.mustCall(function() {
+  assert(Timer.now() - start >= 200);
+});
+timers._unrefActive(idle);
+setTimeout(common.mustCall(function() {
+  timers._unrefActive(idle);
+}), 100);
+
+// Timers scheduled with _unrefActive() do not keep the process alive.
+const unrefed = {};
+timers.enroll(unrefed, 60 * 60 * 1000);
+unrefed._onTimeout = common.fail;
+timers._unrefActive(unrefed);
+
+// A cancelled timer does not fire, even if it expires in the same batch as
+// the timer that cancels it.
+setTimeout(common.mustCall(function() {
+  clearTimeout(cancelled);
+}), 50);
+const cancelled = setTimeout(common.fail, 50);
+
+process.on('exit', function() {
+  assert.deepStrictEqual(fired, durations);
+  assert.deepStrictEqual(sameTime, [0, 1, 2, 3, 4]);
+});
@@ -0,0 +1,164 @@
+'use strict';
+require('../common');
+const assert = require('assert');
+const vm = require('vm');
+
+// Errors thrown by scripts come from the context's own constructors.
+const innerTypeError = /^TypeError: /;
+
+// Lightweight contexts.
+{
+  const sandbox = { x: 1 };
+  const context = vm.createContext(sandbox, { lightweight: true });
+  assert.notStrictEqual(context, sandbox);
+  assert.strictEqual(vm.isContext(context), true);
+  assert.strictEqual(vm.isContext(sandbox), false);
+  assert.strictEqual(vm.createContext(context), context);
+
+  assert.strictEqual(vm.runInContext('x', context), 1);
+  assert.strictEqual(vm.runInContext('this', context), context);
+  vm.runInContext('var a = 1; b = 2; x = 3; function f() { return a; }',
+                  context);
+  assert.strictEqual(context.a, 1);
+  assert.strictEqual(context.b, 2);
+  assert.strictEqual(context.x, 3);
+  assert.strictEqual(context.f(), 1);
+  assert.deepStrictEqual(sandbox, { x: 1 });
+
+  assert.strictEqual(typeof context.Array, 'function');
+  assert.notStrictEqual(context.Array, Array);
+
+  // The same sandbox can seed any number of contexts.
+  const other = vm.createContext(sandbox, { lightweight: true });
+  assert.strictEqual(vm.runInContext('x + typeof a', other), '1undefined');
+
+  assert.throws(() => vm.createContext(42, { lightweight: true }), TypeError);
+}
+
+// Context pools.
+{
+  const pool = new vm.ContextPool({ max: 1 });
+  assert.strictEqual(pool.size, 0);
+
+  const first = pool.acquire({ name: 'a' });
+  assert.strictEqual(vm.isContext(first), true);
+  assert.strictEqual(pool.run('return name', first), 'a');
+
+  // Builtins are frozen and their global bindings are read-only.
+  pool.run('g = 2; Array.prototype.evil = 1; Array = null;', first);
+  assert.strictEqual(pool.run('return [].evil', first), undefined);
+  assert.strictEqual(pool.run('return typeof Array', first), 'function');
+  assert.throws(() => pool.run('"use strict"; Object.prototype.p = 1', first),
+                innerTypeError);
+
+  const second = pool.acquire();
+  assert.notStrictEqual(second, first);
+
+  pool.release(first);
+  assert.strictEqual(pool.size, 1);
+  pool.release(second);  // The pool is full, second is dropped.
+  assert.strictEqual(pool.size, 1);
+
+  const third = pool.acquire({ name: 'b' });
+  assert.strictEqual(third, first);
+  assert.strictEqual(pool.size, 0);
+  assert.strictEqual(pool.run('return name', third), 'b');
+  assert.strictEqual(pool.run('return typeof g', third), 'undefined');
+
+  assert.throws(() => pool.run('', second), TypeError);
+  assert.throws(() => pool.release(second), TypeError);
+  assert.throws(() => pool.release({}), TypeError);
+  assert.throws(() => pool.acquire(42), TypeError);
+  assert.throws(() => new vm.ContextPool({ max: -1 }), RangeError);
+  assert.throws(() => new vm.ContextPool({ max: 1.5 }), RangeError);
+}
+
+// Declarations in pool.run() stay local to the call.
+{
+  const pool = new vm.ContextPool();
+  const context = pool.acquire();
+  assert.strictEqual(pool.run('let x = 1; return x;', context), 1);
+  pool.release(context);
+  assert.strictEqual(pool.acquire(), context);
+  assert.strictEqual(pool.run('let x = 2; return x;', context), 2);
+  assert.strictEqual(pool.run('return typeof x', context), 'undefined');
+
+  // Code can't close the function it is wrapped in.
+  assert.throws(() => pool.run('}).call(this); let y = 1; (function() {',
+                               context),
+                SyntaxError);
+  assert.strictEqual(pool.run('return typeof y', context), 'undefined');
+
+  // Globals declared by eval() can be deleted again.
+  pool.run('(0, eval)("var z = 1; function f() {}");', context);
+  pool.release(context);
+  assert.strictEqual(pool.size, 1);
+  assert.strictEqual(pool.acquire(), context);
+  assert.strictEqual(pool.run('return typeof z + typeof f', context),
+                     'undefinedundefined');
+}
+
+// Top-level let, const and class declarations of scripts run directly in a
+// pooled context can't be removed, so the context is not reused.
+{
+  const pool = new vm.ContextPool();
+  const context = pool.acquire();
+  vm.runInContext('let x = 1;', context);
+  pool.release(context);
+  assert.strictEqual(pool.size, 0);
+
+  const next = pool.acquire();
+  assert.notStrictEqual(next, context);
+  vm.runInContext('let x = 1;', next);
+  assert.strictEqual(vm.runInContext('x', next), 1);
+
+}
+
+// Contexts that can't be reset to a fresh state are not reused.
+{
+  const pool = new vm.ContextPool();
+  const leaks = [
+    'Object.defineProperty(this, "secret", { value: "s" });',
+    'Object.setPrototypeOf(this, { secret: "s" });',
+    'Object.preventExtensions(this);',
+    'Object.freeze(this);'
+  ];
+  for (const code of leaks) {
+    const context = pool.acquire();
+    pool.run(code, context);
+    pool.release(context);
+    assert.strictEqual(pool.size, 0, code);
+
+    const next = pool.acquire({ token: 1 });
+    assert.notStrictEqual(next, context, code);
+    assert.strictEqual(pool.run('return typeof secret', next), 'undefined');
+    assert.strictEqual(next.token, 1);
+    pool.release(next);
+    assert.strictEqual(pool.size, 1, code);
+    pool.acquire();  // Empty the pool again.
+  }
+}
+
+// Sandbox properties are copied as plain data properties, so they can be
+// removed however they were defined on the sandbox.
+{
+  const pool = new vm.ContextPool();
+  const context = pool.acquire(Object.freeze({ token: 1 }));
+  const desc = Object.getOwnPropertyDescriptor(context, 'token');
+  assert.deepStrictEqual(desc, {
+    value: 1, writable: true, enumerable: true, configurable: true
+  });
+  pool.release(context);
+  assert.strictEqual(pool.size, 1);
+
+  const sandbox = {};
+  Object.defineProperty(sandbox, 'token', { value: 2 });
+  Object.defineProperty(sandbox, 'getter', { get: () => 3 });
+  assert.strictEqual(pool.acquire(sandbox), context);
+  assert.strictEqual(context.token, 2);
+  assert.strictEqual(context.getter, 3);
+  pool.release(context);
+  assert.strictEqual(pool.acquire({ token: 4 }), context);
+  assert.strictEqual(pool.run('return token + typeof getter', context),
+                     '4undefined');
+}
@@ -0,0 +1,88 @@
+'use strict';
+
+// Generates the C++ source with the V8 code cache of every core module,
+// which `make code-cache` compiles into node so that the core modules don't
+// have to be compiled from source on every startup.
+//
+// Usage: node tools/generate_code_cache.js <output.cc>
+//
+// The cache must be generated by a node binary with the same V8 version and
+// flags as the one it is compiled into; V8 rejects it otherwise and node
+// falls back to compiling the sources.
+
+const fs = require('fs');
+const vm = require('vm');
+const Module = require('module');
+
+if (process.argv.length !== 3) {
+  console.error('Usage: node tools/generate_code_cache.js <output.cc>');
+  process.exit(1);
+}
+
+const sources = process.binding('natives');
+const ids = Object.keys(sources).sort();
+const entries = [];
+const arrays = [];
+
+ids.forEach((id) => {
+  // Must match NativeModule.prototype.compile() in bootstrap_node.js.
+  const script = new vm.Script(Module.wrap(sources[id]), {
+    filename: `${id}.js`,
+    produceCachedData: true
+  });
+  if (!script.cachedDataProduced)
+    return;
+
+  const name = `code_cache_${entries.length}`;
+  const data = script.cachedData;
+  const lines = [];
+  for (var i = 0; i < data.length; i += 16)
+    lines.push('  ' + Array.from(data.slice(i, i + 16)).join(',') + ',');
+  arrays.push(`static uint8_t ${name}[] = {\n${lines.join('\n')}\n};\n`);
+  entries.push(`  { "${id}", ${name}, sizeof(${name}) },`);
+});
+
+// Arrays can't be empty, hence the terminating entry.
+entries.push('  { nullptr, nullptr, 0 }');
+
+const source = `// This file is generated by tools/generate_code_cache.js, do not edit.
+
+#include "node_code_cache.h"
+#include "env-inl.h"
+#include "util.h"
+#include "util-inl.h"
+
+namespace node {
+
+using v8::ArrayBuffer;
+using v8::Local;
+using v8::Object;
+using v8::Uint8Array;
+
+${arrays.join('\n')}
+static const struct {
+  const char* id;
+  uint8_t* data;
+  size_t length;
+} code_cache[] = {
+${entries.join('\n')}
+};
+
+void DefineCodeCache(Environment* env, Local<Object> target) {
+  for (size_t i = 0; code_cache[i].id != nullptr; i++) {
+    const auto& entry = code_cache[i];
+    // The memory is not owned by V8 and never freed.
+    Local<ArrayBuffer> buffer =
+        ArrayBuffer::New(env->isolate(), entry.data, entry.length);
+    target->Set(env->context(),
+                OneByteString(env->isolate(), entry.id),
+                Uint8Array::New(buffer, 0, entry.length)).FromJust();
+  }
+}
+
+}  // namespace node
+`;
+
+fs.writeFileSync(process.argv[2], source);
+console.log(`Wrote the code cache of ${entries.length - 1} of ${ids.length} ` +
+            `modules to ${process.argv[2]}`);